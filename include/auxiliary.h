@@ -31,6 +31,13 @@ void sigil_zeroize(void *a, size_t bytes);
  */
 int is_digit(const char c);
 
+/** @brief Decides whether the character is a delimiter according to PDF standard
+ *
+ * @param c character provided for comparison
+ * @return 1 if true, 0 otherwise
+ */
+int is_delimiter(const char c);
+
 /** @brief Decides whether the character is a whitespace according to PDF standard
  *
  * @param c character provided for comparison
@@ -38,6 +45,18 @@ int is_digit(const char c);
  */
 int is_whitespace(const char c);
 
+/** @brief Finds the first occurrence of the needle inside of the haystack
+ *         (vectorized where available)
+ *
+ * @param haystack data to be searched
+ * @param haystack_len number of bytes of the haystack
+ * @param needle searched sequence
+ * @param needle_len number of bytes of the needle
+ * @return pointer to the first occurrence inside of the haystack or NULL
+ */
+const char *sigil_memmem(const char *haystack, size_t haystack_len,
+                         const char *needle, size_t needle_len);
+
 /** @brief Reads *size* bytes from PDF to *result* and adds a terminating null.
  *         Does move the position in PDF.
  *
@@ -73,7 +92,8 @@ sigil_err_t pdf_peek_char(sigil_t *sgl, char *result);
  */
 sigil_err_t pdf_move_pos_rel(sigil_t *sgl, ssize_t shift_bytes);
 
-/** @brief Moves position in the PDF to the specified value
+/** @brief Moves position in the PDF to the specified value, also to the
+ *         virtual position inside of an object stream
  *
  * @param sgl context
  * @param position final position in the PDF
@@ -81,8 +101,39 @@ sigil_err_t pdf_move_pos_rel(sigil_t *sgl, ssize_t shift_bytes);
  */
 sigil_err_t pdf_move_pos_abs(sigil_t *sgl, size_t position);
 
+/** @brief Provides the PDF data from the specified position without copying
+ *         them - points directly into the buffer or the mapped file. Does not
+ *         move the position in PDF
+ *
+ * @param sgl context
+ * @param position position in the PDF, not inside of an object stream
+ * @param length requested number of bytes
+ * @param data output - pointer to the data
+ * @param data_len output - number of bytes available (can be lower than length
+ *                 at the end of the PDF)
+ * @return ERR_NONE if success, ERR_NO_DATA if nothing is available,
+ *         ERR_PARAMETER if the data are not in memory
+ */
+sigil_err_t pdf_span(const sigil_t *sgl, size_t position, size_t length,
+                     const char **data, size_t *data_len);
+
+/** @brief Maps the whole PDF file to memory and uses the mapping as the buffer,
+ *         the file stays open. Not available on Windows
+ *
+ * @param sgl context with the file and its size
+ * @return ERR_NONE if success
+ */
+sigil_err_t pdf_map_file(sigil_t *sgl);
+
+/** @brief Releases the mapping of the PDF file created by pdf_map_file
+ *
+ * @param sgl context
+ */
+void pdf_unmap_file(sigil_t *sgl);
+
 /** @brief Moves position to the object specified as an indirect reference.
- *         Skips leading object identifiers (X Y obj)
+ *         Skips leading object identifiers (X Y obj), the objects from object
+ *         streams have none
  *
  * @param sgl context
  * @param ref object indirect reference
@@ -155,14 +206,62 @@ sigil_err_t parse_number(sigil_t *sgl, size_t *number);
  */
 sigil_err_t parse_indirect_reference(sigil_t *sgl, reference_t *ref);
 
+/** @brief Parses the array of non-negative integers from the current position
+ *
+ * @param sgl context
+ * @param values output - the numbers
+ * @param max capacity of the values array
+ * @param count output - number of the numbers parsed
+ * @return ERR_NONE if success, ERR_PDF_CONTENT also if there are more than max
+ *         numbers
+ */
+sigil_err_t parse_number_array(sigil_t *sgl, size_t *values, size_t max,
+                               size_t *count);
+
+/** @brief Loads a name object (/Name) from the current position in the PDF.
+ *         The name is terminated by a whitespace or a delimiter. Names longer
+ *         than the provided buffer are skipped and returned empty
+ *
+ * @param sgl context
+ * @param name output - the name without the leading slash, null terminated
+ * @param size size of the name buffer
+ * @return ERR_NONE if success
+ */
+sigil_err_t parse_name(sigil_t *sgl, char *name, size_t size);
+
 /** @brief Loads a dictionary key from the current position in the PDF
  *
  * @param sgl context
  * @param dict_key output - loaded key
- * @return ERR_NONE if success
+ * @return ERR_NONE if success, ERR_END_OF_DICT at the end of the dictionary
  */
 sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key);
 
+/** @brief Goes through the dictionary from the current position (after the
+ *         leading "<<") and records the position of the value of each wanted
+ *         key. Stops right after all the wanted keys are found, otherwise at
+ *         the end of the dictionary
+ *
+ * @param sgl context
+ * @param entries input/output - the wanted keys, the positions of the values
+ *                are filled in
+ * @param count number of the entries
+ * @return ERR_NONE if success (also if some of the keys were not found)
+ */
+sigil_err_t parse_dict_projection(sigil_t *sgl, dict_entry_t *entries, size_t count);
+
+/** @brief Moves position in the PDF to the value of the key recorded by
+ *         parse_dict_projection
+ *
+ * @param sgl context
+ * @param entries entries filled by parse_dict_projection
+ * @param count number of the entries
+ * @param dict_key the key of the wanted value
+ * @return ERR_NONE if success, ERR_NO_DATA if the key was not present
+ */
+sigil_err_t dict_projection_goto(sigil_t *sgl, const dict_entry_t *entries,
+                                 size_t count, dict_key_t dict_key);
+
 /** @brief Loads an array of indirect references from the current position in
  *         the PDF. The leading '[' needs to be included
  *
@@ -172,11 +271,43 @@ sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key);
  */
 sigil_err_t parse_ref_array(sigil_t *sgl, ref_array_t *ref_array);
 
-/** @brief Resolves the offset of an object according to the xref section
+/** @brief Frees the references of the array loaded by parse_ref_array and the
+ *         array itself, the array is left empty
+ *
+ * @param ref_array the array to be freed
+ */
+void ref_array_free(ref_array_t *ref_array);
+
+/** @brief Decides whether the number is in the set
+ *
+ * @param set the set of numbers
+ * @param number the number to look for
+ * @return 1 if present, 0 otherwise
+ */
+int number_set_contains(const number_set_t *set, size_t number);
+
+/** @brief Inserts the number into the set, nothing happens if already present.
+ *         The set grows as needed
+ *
+ * @param set the set of numbers
+ * @param number the number to be inserted, less than SIZE_MAX
+ * @return ERR_NONE if success
+ */
+sigil_err_t number_set_insert(number_set_t *set, size_t number);
+
+/** @brief Frees the set, it is left empty and usable
+ *
+ * @param set the set of numbers
+ */
+void number_set_clear(number_set_t *set);
+
+/** @brief Resolves the offset of an object according to the xref section,
+ *         objects compressed in an object stream get the virtual position
+ *         inside of the decoded stream
  *
  * @param sgl context
  * @param ref input - indirect reference to be resolved
- * @param result output - the byte offset
+ * @param result output - the byte offset or the virtual position
  * @return ERR_NONE if success
  */
 sigil_err_t reference_to_offset(sigil_t *sgl, const reference_t *ref, size_t *result);
@@ -7,7 +7,8 @@
 
 #include "types.h"
 
-/** @brief Process the catalog dictionary, get value of the AcroForm entry
+/** @brief Process the catalog dictionary, get values of the AcroForm
+ *         and DSS entries
  *
  * @param sgl context
  * @return ERR_NONE if success
@@ -11,9 +11,11 @@
  *         and the following are for verifying the authenticity of the signing one
  *
  * @param sgl context
+ * @param certificates output - the list of certificates, replaced if already
+ *                     set
  * @return ERR_NONE if success
  */
-sigil_err_t parse_certs(sigil_t *sgl);
+sigil_err_t parse_certs(sigil_t *sgl, cert_t **certificates);
 
 /** @brief Cleans-up the provided cert_t structure
  *
@@ -0,0 +1,71 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_CMS_H
+#define PDF_SIGIL_CMS_H
+
+#include "types.h"
+
+/** @brief Decodes the CMS signed data from the Contents of the signature with
+ *         the only signer. The content is detached, except for adbe.pkcs7.sha1
+ *         encapsulating the SHA-1 digest of the byte range and the document
+ *         timestamp (ETSI.RFC3161) encapsulating the timestamp info. The certificates
+ *         embedded in the signed data are stored with the signer's certificate
+ *         first, the algorithm for the byte range digest is stored as well
+ *
+ * @param signature the signature with the parsed Contents
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the signed data are not
+ *         usable for the detached signature
+ */
+sigil_err_t cms_load(signature_t *signature);
+
+/** @brief Decodes the timestamp info encapsulated in the timestamp token
+ *
+ * @param cms the timestamp token
+ * @return the allocated timestamp info or NULL if the content is not
+ *         the timestamp info
+ */
+TS_TST_INFO *cms_decode_tst_info(CMS_ContentInfo *cms);
+
+/** @brief Checks the binding of the signer's certificate to the signed
+ *         attributes (signingCertificateV2 or signingCertificate) as required
+ *         by CAdES. The certificate verification result is set to failed if
+ *         the attribute is missing or refers to another certificate
+ *
+ * @param signature the signature loaded by cms_load
+ * @return ERR_NONE if success (also if the binding does not hold)
+ */
+sigil_err_t cms_verify_signing_cert_binding(signature_t *signature);
+
+/** @brief Checks that the signer's certificate of the document timestamp is
+ *         allowed to sign the timestamps. The certificate verification result
+ *         is set to failed otherwise
+ *
+ * @param signature the signature loaded by cms_load
+ * @return ERR_NONE if success (also if the certificate is not allowed)
+ */
+sigil_err_t cms_verify_tsa_certificate(signature_t *signature);
+
+/** @brief Checks the signer info against the digest computed over the byte
+ *         range - the messageDigest attribute and the signature of the signed
+ *         attributes, or the signature of the digest itself if there are no
+ *         signed attributes. Both need to hold for the digests to match. The
+ *         encapsulated digest and the message imprint of the timestamp are
+ *         compared and signed the same way
+ *
+ * @param signature the signature loaded by cms_load with the computed digest
+ * @return ERR_NONE if success (also if the digests differ)
+ */
+sigil_err_t cms_verify_digest(signature_t *signature);
+
+/** @brief Tests for the cms module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_cms_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_CMS_H */
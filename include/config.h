@@ -21,11 +21,110 @@
  */
 #define XREF_PREALLOCATION          10
 
+/** @brief capacity to choose for the first allocation of the xref side table
+ *         for objects with multiple generations
+ *
+ */
+#define XREF_EXTRA_PREALLOCATION    4
+
+/** @brief capacity to choose for the first allocation of the array of lazily
+ *         decoded xref subsections
+ *
+ */
+#define XREF_SUBSECTION_PREALLOCATION 4
+
+/** @brief number of the xref records read at once when decoding a table from
+ *         a file
+ *
+ */
+#define XREF_DECODE_CHUNK           1024
+
+/** @brief maximum number of the threads used for the parallel processing
+ *
+ */
+#define MAX_THREAD_COUNT            64
+
+/** @brief size of the chunk of encoded stream data read at once from a file,
+ *         and of the decoded data processed at once
+ *
+ */
+#define STREAM_CHUNK_SIZE           16384
+
+/** @brief maximum size of one row of the stream data with a PNG predictor
+ *
+ */
+#define STREAM_ROW_MAX              65536
+
+/** @brief number of the decoded object streams kept in the cache of one
+ *         document, at least 2
+ *
+ */
+#define OBJSTM_CACHE_SIZE           8
+
+/** @brief maximum size of one decoded object stream
+ *
+ */
+#define OBJSTM_SIZE_MAX             67108864
+
+/** @brief number of bytes scanned by one task of the parallel reconstruction
+ *         of the damaged cross-reference table
+ *
+ */
+#define RECONSTRUCT_CHUNK_SIZE      4194304
+
+/** @brief number of bytes at the end of the PDF file, whose digest identifies
+ *         the file together with its size and modification time for the
+ *         cached document structure
+ *
+ */
+#define SIDECAR_TAIL_SIZE           4096
+
+/** @brief number of the verified chains of the timestamping authorities kept
+ *         for all the documents verified by the process
+ *
+ */
+#define TSA_CACHE_SIZE              32
+
+/** @brief maximum size of one decoded stream of the Document Security Store
+ *         (certificate, CRL or OCSP response)
+ *
+ */
+#define DSS_OBJECT_SIZE_MAX         67108864
+
+/** @brief number of the decoded CRLs and OCSP responses kept for all the
+ *         documents verified by the process
+ *
+ */
+#define DSS_CACHE_SIZE              64
+
+/** @brief capacity to choose for the first allocation of the references to
+ *         the streams of one kind of the Document Security Store
+ *
+ */
+#define DSS_REFS_PREALLOCATION      8
+
 /** @brief capacity to choose for the first allocation in array of fields
  *
  */
 #define REF_ARRAY_PREALLOCATION     10
 
+/** @brief capacity to choose for the first allocation of array for signatures
+ *
+ */
+#define SIGNATURE_PREALLOCATION     4
+
+/** @brief capacity to choose for the first allocation of the hashed set of
+ *         numbers, needs to be a power of two
+ *
+ */
+#define NUMBER_SET_PREALLOCATION    16
+
+/** @brief capacity to choose for the first allocation of the queue of the
+ *         field tree nodes waiting for the visit
+ *
+ */
+#define FIELD_TREE_PREALLOCATION    16
+
 /** @brief capacity to choose for the first allocation of array for certificates
  *
  */
@@ -41,16 +140,31 @@
  */
 #define THRESHOLD_FILE_BUFFERING    10485760
 
-/** @brief maximum number of file updates, preventing forever loop in processing
- *         previous cross-reference sections (caused by cyclic links)
+/** @brief maximum size we give to hash function at once
  *
  */
-#define MAX_FILE_UPDATES            1024
+#define HASH_UPDATE_SIZE            1024
 
-/** @brief maximum size we give to hash function at once
+/** @brief maximum size we give to hash function at once when the data are
+ *         in memory - the buffer or the mapped file
  *
  */
-#define HASH_UPDATE_SIZE            1024
+#define HASH_SPAN_SIZE              262144
+
+/** @brief size of one buffer of the reading thread of the PDF file
+ *
+ */
+#define READER_BUFFER_SIZE          1048576
+
+/** @brief number of the buffers the reading thread can fill in advance
+ *
+ */
+#define READER_BUFFER_COUNT         4
+
+/** @brief size of the chunks used while scanning the raw PDF data
+ *
+ */
+#define SCAN_CHUNK_SIZE             65536
 
 /** @brief Tests for the config module
  *
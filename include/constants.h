@@ -21,6 +21,16 @@
 #define XREF_TYPE_TABLE                 1
 #define XREF_TYPE_STREAM                2
 
+#define XREF_ENTRY_EMPTY                0
+#define XREF_ENTRY_IN_USE               1
+#define XREF_ENTRY_COMPRESSED           2
+
+#define XREF_MODE_EAGER                 0
+#define XREF_MODE_LAZY                  1
+
+#define CHAIN_MODE_SERIAL               0
+#define CHAIN_MODE_CONCURRENT           1
+
 #define DICT_KEY_UNKNOWN                0
 #define DICT_KEY_Size                   1
 #define DICT_KEY_Prev                   2
@@ -34,9 +44,48 @@
 #define DICT_KEY_Cert                   10
 #define DICT_KEY_Contents               11
 #define DICT_KEY_ByteRange              12
+#define DICT_KEY_Type                   13
+#define DICT_KEY_W                      14
+#define DICT_KEY_Index                  15
+#define DICT_KEY_Filter                 16
+#define DICT_KEY_DecodeParms            17
+#define DICT_KEY_Length                 18
+#define DICT_KEY_Predictor              19
+#define DICT_KEY_Colors                 20
+#define DICT_KEY_BitsPerComponent       21
+#define DICT_KEY_Columns                22
+#define DICT_KEY_N                      23
+#define DICT_KEY_First                  24
+#define DICT_KEY_XRefStm                25
+#define DICT_KEY_Kids                   26
+#define DICT_KEY_T                      27
+#define DICT_KEY_DSS                    28
+#define DICT_KEY_Certs                  29
+#define DICT_KEY_OCSPs                  30
+#define DICT_KEY_CRLs                   31
+#define DICT_KEY_VRI                    32
+#define DICT_KEY_OCSP                   33
+#define DICT_KEY_CRL                    34
+
+#define STREAM_FILTER_NONE              0
+#define STREAM_FILTER_FLATE             1
+
+#define PREDICTOR_NONE                  1
+#define PREDICTOR_TIFF                  2
+#define PREDICTOR_PNG                   10
+
+#define PNG_FILTER_NONE                 0
+#define PNG_FILTER_SUB                  1
+#define PNG_FILTER_UP                   2
+#define PNG_FILTER_AVERAGE              3
+#define PNG_FILTER_PAETH                4
 
 #define SUBFILTER_UNKNOWN               0
 #define SUBFILTER_adbe_x509_rsa_sha1    1
+#define SUBFILTER_adbe_pkcs7_detached   2
+#define SUBFILTER_ETSI_CAdES_detached   3
+#define SUBFILTER_adbe_pkcs7_sha1       4
+#define SUBFILTER_ETSI_RFC3161          5
 
 #define HASH_FN_UNKNOWN                 0
 #define HASH_FN_sha1                    1
@@ -53,11 +102,23 @@
 #define HASH_CMP_RESULT_MATCH           1
 #define HASH_CMP_RESULT_DIFFER          2
 
+#define TIMESTAMP_STATUS_NONE           0
+#define TIMESTAMP_STATUS_VERIFIED       1
+#define TIMESTAMP_STATUS_FAILED         2
+
 #define VERIFY_SUCCESS                  0
 #define VERIFY_FAILED                   1
 
+#define RAW_SCAN_DISABLED               0
+#define RAW_SCAN_FALLBACK               1
+#define RAW_SCAN_ONLY                   2
+
+#define XREF_RECONSTRUCT_DISABLED       0
+#define XREF_RECONSTRUCT_FALLBACK       1
+
 #define DEALLOCATE_FILE                 0x01
 #define DEALLOCATE_BUFFER               0x02
+#define DEALLOCATE_MAPPING              0x04
 
 #define ERR_NONE                        0
 #define ERR_ALLOCATION                  1
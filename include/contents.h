@@ -10,15 +10,16 @@
 /** @brief Load the data from Contents entry in the signature dictionary
  *
  * @param sgl context
+ * @param contents output - the contents, replaced if already set
  * @return ERR_NONE if success
  */
-sigil_err_t parse_contents(sigil_t *sgl);
+sigil_err_t parse_contents(sigil_t *sgl, contents_t **contents);
 
-/** Cleans-up the contents entry from the context
+/** Cleans-up the contents entry
  *
- * @param sgl context
+ * @param contents the contents to be freed
  */
-void contents_free(sigil_t *sgl);
+void contents_free(contents_t *contents);
 
 /** @brief Tests for the contents module
  *
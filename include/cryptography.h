@@ -8,44 +8,97 @@
 #include "types.h"
 
 
-/** @brief Compute a message digest (hash) for the PKCS#1 signature type
+/** @brief Converts hexadecimal characters to the binary value, 2 chars on the
+ *         input produce 1 byte on the output. Whitespaces between the digits
+ *         are skipped and the odd number of digits is completed with the final
+ *         0 as defined for the hexadecimal strings in PDF. The output buffer
+ *         needs to have space for (in_len + 1) / 2 + 1 bytes
+ *
+ * @param in input - hexadecimal characters
+ * @param in_len length of the input
+ * @param out output buffer, terminated with null
+ * @param out_len length of the output written (without the terminating null)
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_hex_to_dec(const char *in, size_t in_len, unsigned char *out, size_t *out_len);
+
+/** @brief Compute a message digest (hash) over the byte range of the signature
+ *         with its digest algorithm, the data are streamed from the PDF in
+ *         chunks. If the PDF is only in the file and more threads are
+ *         allowed, the chunks are read ahead on the reading thread
  *
  * @param sgl context
+ * @param signature the signature with the digest algorithm loaded
  * @return ERR_NONE if success
  */
-sigil_err_t compute_digest_pkcs1(sigil_t *sgl);
+sigil_err_t compute_digest(sigil_t *sgl, signature_t *signature);
 
-/** @brief Load certificates from the hex form to the X.509 object
+/** @brief Compute the message digests of all the signatures of the context
+ *         without an error in one read pass through the PDF. The nested byte
+ *         ranges of the signatures beginning at the start of the file share
+ *         one digest context per algorithm, copied for each signature at the
+ *         end of its first range, the data outside of all the ranges are not
+ *         read. The file is read ahead on the reading thread as for
+ *         compute_digest. The signatures with the ranges going backward or
+ *         outside of the PDF are hashed separately, as are all of them again
+ *         if the pass fails, so that the error stays with its signature
  *
  * @param sgl context
+ * @return ERR_NONE if success (the errors of the signatures are kept in them)
+ */
+sigil_err_t compute_digests(sigil_t *sgl);
+
+/** @brief Load certificates from the hex form to the X.509 object
+ *
+ * @param signature the signature
  * @return ERR_NONE if success
  */
-sigil_err_t load_certificates(sigil_t *sgl);
+sigil_err_t load_certificates(signature_t *signature);
 
 /** @brief Get the original message digest from the loaded hexadecimal form of the
  *         Contents entry from the signature dictionary
  *
- * @param sgl context
+ * @param signature the signature
  * @return ERR_NONE if success
  */
-sigil_err_t load_digest(sigil_t *sgl);
+sigil_err_t load_digest(signature_t *signature);
+
+/** @brief Fills the cache of the extensions of the certificate before it is
+ *         shared by the concurrent validations of the chains. OpenSSL 3.0
+ *         fills it on the first use and does not check it again under the
+ *         lock, the second thread can replace the values read by the first
+ *
+ * @param x509 the certificate
+ */
+void cache_certificate_extensions(X509 *x509);
+
+/** @brief Fills the caches of the extensions of the trusted certificates
+ *         loaded so far (see cache_certificate_extensions), the certificates
+ *         looked up lazily from the directory are loaded only later
+ *
+ * @param sgl context with the trusted certificates
+ */
+void cache_trusted_certificates(sigil_t *sgl);
 
 /** @brief Verify validity of the signing certificate. If present, it is using
- *         the other provided certificates to build the chain of trust. Does
- *         save the result inside of the context (NOT the return value)
+ *         the other provided certificates and the certificates of the DSS to
+ *         build the chain of trust, the chain is checked against the CRLs and
+ *         OCSP responses of the DSS. Does save the result inside of the
+ *         signature (NOT the return value)
  *
- * @param sgl context
+ * @param sgl context with the trusted certificates
+ * @param signature the signature
  * @return ERR_NONE if success
  */
-sigil_err_t verify_signing_certificate(sigil_t *sgl);
+sigil_err_t verify_signing_certificate(sigil_t *sgl, signature_t *signature);
 
 /** @brief Compare the message digest from the signature with the computed one.
- *         Does save the result inside of the context (NOT the return value)
+ *         Does save the result inside of the signature (NOT the return value)
  *
- * @param sgl context
+ * @param signature the signature
  * @return ERR_NONE if success
  */
-sigil_err_t compare_digest(sigil_t *sgl);
+sigil_err_t compare_digest(signature_t *signature);
 
 /** @brief Tests for the cryptography module
  *
@@ -0,0 +1,56 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_DSS_H
+#define PDF_SIGIL_DSS_H
+
+#include "types.h"
+
+/** @brief Loads the Document Security Store referenced from the catalog - the
+ *         streams of Certs, OCSPs and CRLs of the dictionary and of all its
+ *         VRI entries. The certificates are decoded for the document, the CRLs
+ *         and OCSP responses are shared through the cache of the process,
+ *         keyed by the digest of their content. Unusable streams are skipped.
+ *         The later calls only return the result of the first one
+ *
+ * @param sgl context
+ * @return ERR_NONE if success (also if there is no DSS)
+ */
+sigil_err_t dss_load(sigil_t *sgl);
+
+/** @brief Checks the certificates of the verified chain against the OCSP
+ *         responses of the DSS. Only the responses signed by the issuer of
+ *         the certificate or by its delegated responder are used
+ *
+ * @param sgl context with the loaded DSS
+ * @param chain the verified chain, the trust anchor last
+ * @param check_time the time of the verification or NULL for the current time,
+ *                   the certificate revoked after it is not considered revoked
+ * @return 1 if some certificate of the chain is revoked, 0 otherwise
+ */
+int dss_ocsp_revoked(sigil_t *sgl, STACK_OF(X509) *chain, const time_t *check_time);
+
+/** @brief Frees the loaded DSS of the context, the shared revocation data
+ *         stay in the cache
+ *
+ * @param sgl context
+ */
+void dss_free(sigil_t *sgl);
+
+/** @brief Removes all the revocation data from the cache of the process, the
+ *         data still used by some context are freed with it
+ *
+ */
+void dss_cache_clear(void);
+
+/** @brief Tests for the dss module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_dss_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_DSS_H */
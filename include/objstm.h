@@ -0,0 +1,69 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_OBJSTM_H
+#define PDF_SIGIL_OBJSTM_H
+
+#include "types.h"
+
+/** @brief Positions inside of the decoded object streams are virtual - the
+ *         highest bit is set, the object stream number is in bits 32-62 and
+ *         the offset inside of the decoded stream in bits 0-31. Such position
+ *         can be stored and used by pdf_move_pos_abs as any other one
+ *
+ */
+#define OBJSTM_POSITION_FLAG            ((size_t)1 << 63)
+#define OBJSTM_POSITION_OFFSET_BITS     32
+#define OBJSTM_POSITION_OFFSET_MASK     (((size_t)1 << OBJSTM_POSITION_OFFSET_BITS) - 1)
+#define OBJSTM_STREAM_MAX               (((size_t)1 << (63 - OBJSTM_POSITION_OFFSET_BITS)) - 1)
+
+#define OBJSTM_POSITION(stream, offset) \
+    (OBJSTM_POSITION_FLAG | ((size_t)(stream) << OBJSTM_POSITION_OFFSET_BITS) | \
+     ((size_t)(offset) & OBJSTM_POSITION_OFFSET_MASK))
+#define IS_OBJSTM_POSITION(position) \
+    (((position) & OBJSTM_POSITION_FLAG) != 0)
+#define OBJSTM_POSITION_STREAM(position) \
+    (((position) & ~OBJSTM_POSITION_FLAG) >> OBJSTM_POSITION_OFFSET_BITS)
+#define OBJSTM_POSITION_OFFSET(position) \
+    ((position) & OBJSTM_POSITION_OFFSET_MASK)
+
+/** @brief Finds the virtual position of the object compressed in the object
+ *         stream. The stream is decoded only once and kept in the cache, the
+ *         current position is preserved
+ *
+ * @param sgl context
+ * @param stream_num object number of the object stream
+ * @param index index of the object in the stream (from the xref entry)
+ * @param object_num number of the object looked up
+ * @param position output - virtual position of the object data
+ * @return ERR_NONE if success
+ */
+sigil_err_t objstm_object_position(sigil_t *sgl, size_t stream_num, size_t index,
+                                   size_t object_num, size_t *position);
+
+/** @brief Moves to the virtual position inside of the object stream, decodes
+ *         the stream if it is not in the cache
+ *
+ * @param sgl context
+ * @param position virtual position
+ * @return ERR_NONE if success
+ */
+sigil_err_t objstm_move_pos(sigil_t *sgl, size_t position);
+
+/** @brief Clean-up of all the cached object streams of the context
+ *
+ * @param sgl context
+ */
+void objstm_cache_free(sigil_t *sgl);
+
+/** @brief Tests for the objstm module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_objstm_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_OBJSTM_H */
@@ -0,0 +1,58 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_READER_H
+#define PDF_SIGIL_READER_H
+
+#include "types.h"
+
+/** @brief Reader of the ranges of the PDF file on its own thread
+ *
+ */
+typedef struct reader_t reader_t;
+
+/** @brief Starts reading the ranges of the PDF file in their order into the
+ *         ring of READER_BUFFER_COUNT buffers on a separate thread, the
+ *         reading waits while all the buffers are full. The PDF data must
+ *         not be used by the caller until the reader is stopped. Without the
+ *         thread support the data are read by reader_next itself
+ *
+ * @param sgl context with the PDF file
+ * @param ranges the ranges to be read, they can go in any order
+ * @param reader output - the started reader
+ * @return ERR_NONE if success
+ */
+sigil_err_t reader_start(sigil_t *sgl, const range_t *ranges, reader_t **reader);
+
+/** @brief Provides the next chunk of the data, waits for the reading thread
+ *         if necessary. The chunk is at most READER_BUFFER_SIZE bytes long,
+ *         never crosses the end of a range and stays valid until the next
+ *         call. The buffer of the previous chunk is returned to the reading
+ *         thread
+ *
+ * @param reader the reader
+ * @param data output - pointer to the data
+ * @param length output - number of bytes
+ * @return ERR_NONE if success, ERR_NO_DATA after the last range, or the
+ *         error of the reading after all the chunks read before it
+ */
+sigil_err_t reader_next(reader_t *reader, const char **data, size_t *length);
+
+/** @brief Stops the reading thread, also before all the data were read, and
+ *         frees the reader
+ *
+ * @param reader the reader, set to NULL
+ */
+void reader_stop(reader_t **reader);
+
+/** @brief Tests for the reader module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_reader_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_READER_H */
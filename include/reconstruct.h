@@ -0,0 +1,31 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_RECONSTRUCT_H
+#define PDF_SIGIL_RECONSTRUCT_H
+
+#include "types.h"
+
+/** @brief Rebuilds the cross-reference table of the damaged PDF by scanning
+ *         the whole data for the object headers "<num> <gen> obj" and the
+ *         trailers. The later definition of an object wins, the catalog is
+ *         taken from the newest usable trailer (or the newest object of type
+ *         Catalog). The buffered data are scanned in chunks in parallel
+ *         (see sigil_set_thread_count)
+ *
+ * @param sgl context
+ * @return ERR_NONE if success, ERR_NO_DATA if no catalog was found
+ */
+sigil_err_t reconstruct_xref(sigil_t *sgl);
+
+/** @brief Tests for the reconstruct module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_reconstruct_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_RECONSTRUCT_H */
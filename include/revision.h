@@ -0,0 +1,56 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_REVISION_H
+#define PDF_SIGIL_REVISION_H
+
+#include "types.h"
+
+/** @brief Decides whether the cross-reference section at the offset was
+ *         already read - the /Prev chain leading to it is cyclic
+ *
+ * @param sgl context
+ * @param section_offset position of the section
+ * @return 1 if visited, 0 otherwise
+ */
+int revision_is_visited(const sigil_t *sgl, size_t section_offset);
+
+/** @brief Appends the revision known in advance (e.g. from the cache)
+ *
+ * @param sgl context
+ * @param revision the revision to be copied to the list
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the section was already
+ *         visited
+ */
+sigil_err_t revision_append(sigil_t *sgl, const revision_t *revision);
+
+/** @brief Appends the revision of the section which was just processed, its
+ *         end is looked up shortly after the current position (the trailer or
+ *         the data of the cross-reference stream), its /XRefStm is taken from
+ *         the table being read
+ *
+ * @param sgl context
+ * @param section_offset position of the section
+ * @param trailer_offset position of the trailer
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the section was already
+ *         visited
+ */
+sigil_err_t revision_add(sigil_t *sgl, size_t section_offset, size_t trailer_offset);
+
+/** @brief Forgets all the revisions
+ *
+ * @param sgl context
+ */
+void revisions_clear(sigil_t *sgl);
+
+/** @brief Tests for the revision module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_revision_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_REVISION_H */
@@ -0,0 +1,39 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_SIDECAR_H
+#define PDF_SIGIL_SIDECAR_H
+
+#include "types.h"
+
+/** @brief Loads the document structure stored by the previous run for the same
+ *         unchanged file - the header, the cross-reference table and the
+ *         positions of the catalog, AcroForm, signature fields and signature
+ *         dictionaries. The file is identified by the device, inode, size,
+ *         modification time and the digest of its tail
+ *
+ * @param sgl context
+ * @return ERR_NONE if loaded, ERR_NO_DATA if there is no valid cache entry (or
+ *         no cache directory, or the PDF is not a file)
+ */
+sigil_err_t sidecar_load(sigil_t *sgl);
+
+/** @brief Stores the document structure found in the PDF file into the cache
+ *         directory, replacing the entry for the previous state of the file
+ *
+ * @param sgl context
+ * @return ERR_NONE if success, ERR_NO_DATA if there is nothing to store
+ */
+sigil_err_t sidecar_store(sigil_t *sgl);
+
+/** @brief Tests for the sidecar module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_sidecar_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_SIDECAR_H */
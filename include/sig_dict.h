@@ -11,9 +11,11 @@
  *         position in the PDF
  *
  * @param sgl context
+ * @param signature the signature with the position of its dictionary, the
+ *                  parsed parts are saved in it
  * @return ERR_NONE if success
  */
-sigil_err_t process_sig_dict(sigil_t *sgl);
+sigil_err_t process_sig_dict(sigil_t *sgl, signature_t *signature);
 
 /** @brief Tests for the sig_dict module
  *
@@ -7,23 +7,18 @@
 
 #include "types.h"
 
-/** @brief Go through all the objects mentioned in the Fields entry from the
- *         interactive form dictionary (AcroForm) and look for the signature
- *         field. If found, save the object reference inside the context
+/** @brief Goes through the field tree of the interactive form dictionary
+ *         (AcroForm) - the Fields entry and all the /Kids below, and looks for
+ *         the terminal signature fields. The /FT and /V entries are inherited
+ *         from the ancestors, reference cycles are skipped. The objects are
+ *         visited in the order of their positions in the file, so are the
+ *         signatures added to the context, with the position of the signature
+ *         dictionary (left unset for the unsigned field)
  *
  * @param sgl context
- * @return ERR_NONE if success
+ * @return ERR_NONE if success, ERR_NO_DATA if there is no signature field
  */
-sigil_err_t find_sig_field(sigil_t *sgl);
-
-/** @brief Does processing of the signature field and saves the position of the
- *         signature dictionary (V entry). Doesn't depend on the current
- *         position in the PDF
- *
- * @param sgl context
- * @return ERR_NONE if success
- */
-sigil_err_t process_sig_field(sigil_t *sgl);
+sigil_err_t find_sig_fields(sigil_t *sgl);
 
 /** @brief Tests for the sig_field module
  *
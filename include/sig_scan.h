@@ -0,0 +1,53 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_SIG_SCAN_H
+#define PDF_SIGIL_SIG_SCAN_H
+
+#include "types.h"
+
+/** @brief Finds the next occurrence of the provided sequence in the PDF data,
+ *         without any parsing of the PDF structure
+ *
+ * @param sgl context
+ * @param from position in the PDF where to start the search
+ * @param needle the searched sequence
+ * @param result output - position of the found sequence
+ * @return ERR_NONE if success, ERR_NO_DATA if not found
+ */
+sigil_err_t scan_find(sigil_t *sgl, size_t from, const char *needle, size_t *result);
+
+/** @brief Finds the next signature dictionary by scanning the raw PDF data for
+ *         the ByteRange entry instead of following the trailer, catalog,
+ *         AcroForm and Fields references. Works also with a damaged
+ *         cross-reference section
+ *
+ * @param sgl context
+ * @param from position in the PDF where to start the search
+ * @param sig_dict_offset output - position of the signature dictionary
+ * @param next output - position where to continue with the next search
+ * @return ERR_NONE if success, ERR_NO_SIGNATURE if there is no other one
+ */
+sigil_err_t scan_sig_dict(sigil_t *sgl, size_t from, size_t *sig_dict_offset,
+                          size_t *next);
+
+/** @brief Decides quickly whether the PDF contains a signature, the data are
+ *         only scanned for the ByteRange entry
+ *
+ * @param sgl context
+ * @param result output - 1 if the signature was found, 0 otherwise
+ * @return ERR_NONE if success
+ */
+sigil_err_t scan_is_signed(sigil_t *sgl, int *result);
+
+/** @brief Tests for the sig_scan module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_sig_scan_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_SIG_SCAN_H */
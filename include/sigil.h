@@ -70,15 +70,127 @@ sigil_err_t sigil_set_trusted_file(sigil_t *sgl, const char *path_to_file);
  */
 sigil_err_t sigil_set_trusted_dir(sigil_t *sgl, const char *path_to_dir);
 
-/** @brief Verifies the digital signature and saves the result in the context.
- *         In order to get the result, call sigil_get_result
+/** @brief Sets the way of looking for the signature dictionary.
+ *         RAW_SCAN_DISABLED follows only the document structure,
+ *         RAW_SCAN_FALLBACK (default) scans the raw PDF data if the document
+ *         structure is damaged and RAW_SCAN_ONLY skips the document structure
+ *         completely and uses only the scanning (constants.h)
  *
  * @param sgl context
- * @return ERR_NONE if success (NOT the result of actual verification)
+ * @param mode one of the RAW_SCAN_* values
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_raw_scan_mode(sigil_t *sgl, int mode);
+
+/** @brief Sets whether the damaged cross-reference table is rebuilt by
+ *         scanning the whole PDF for the objects and trailers.
+ *         XREF_RECONSTRUCT_FALLBACK (default) does it when following the
+ *         document structure fails, before the raw scanning for the signature
+ *         (see sigil_set_raw_scan_mode), XREF_RECONSTRUCT_DISABLED never
+ *         (constants.h)
+ *
+ * @param sgl context
+ * @param mode one of the XREF_RECONSTRUCT_* values
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_xref_reconstruction(sigil_t *sgl, int mode);
+
+/** @brief Sets the way of reading the cross-reference tables.
+ *         XREF_MODE_LAZY (default) records only the position of each
+ *         subsection and decodes the entries when they are looked up,
+ *         XREF_MODE_EAGER decodes all the entries in advance (constants.h)
+ *
+ * @param sgl context
+ * @param mode one of the XREF_MODE_* values
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_xref_mode(sigil_t *sgl, int mode);
+
+/** @brief Sets the way of validating the certificate chains of the signatures.
+ *         CHAIN_MODE_SERIAL (default) validates them before the digests are
+ *         computed, CHAIN_MODE_CONCURRENT validates them, including the
+ *         revocation checks, on helper threads while the digests are
+ *         computed on the calling thread (constants.h). The chains are
+ *         validated in parallel in both modes (see sigil_set_thread_count)
+ *
+ * @param sgl context
+ * @param mode one of the CHAIN_MODE_* values
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_chain_mode(sigil_t *sgl, int mode);
+
+/** @brief Sets the number of threads used for the parallel processing, by
+ *         default everything runs on the calling thread. With more threads,
+ *         the eagerly loaded cross-reference sections of the buffered PDF are
+ *         decoded in parallel (see sigil_set_xref_mode), the damaged
+ *         buffered PDF is scanned in parallel for the reconstruction of its
+ *         cross-reference table (see sigil_set_xref_reconstruction), the
+ *         certificate chains of the signatures are validated in parallel and
+ *         the digests of the signatures are compared in parallel
+ *
+ * @param sgl context
+ * @param count number of threads, 0 for the number of online processors
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_thread_count(sigil_t *sgl, size_t count);
+
+/** @brief Sets the directory for caching the document structure (the
+ *         cross-reference table and the position of the signature dictionary)
+ *         of the verified PDF files. The next verification of the unchanged
+ *         file skips parsing the structure. NULL (default) disables the cache
+ *
+ * @param sgl context
+ * @param path_to_dir existing directory or NULL
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_cache_dir(sigil_t *sgl, const char *path_to_dir);
+
+/** @brief Quickly decides whether the PDF contains a signature, without
+ *         parsing the document structure or verifying anything
+ *
+ * @param sgl context
+ * @param result output - 1 if the PDF appears to be signed, 0 otherwise
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_is_signed(sigil_t *sgl, int *result);
+
+/** @brief Verifies all the digital signatures of the document and saves the
+ *         results in the context. In order to get the result, call
+ *         sigil_get_result for each signature (see sigil_select_signature)
+ *
+ * @param sgl context
+ * @return ERR_NONE if success (NOT the result of actual verification), the
+ *         error of the first signature which could not be verified otherwise
  */
 sigil_err_t sigil_verify(sigil_t *sgl);
 
-/** @brief Get the result from the provided context
+/** @brief Get the number of the signatures found in the document
+ *
+ * @param sgl context
+ * @param count output - number of the signatures
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_get_signature_count(sigil_t *sgl, size_t *count);
+
+/** @brief Selects the signature the results and information are taken from,
+ *         the first one (index 0) is selected by default
+ *
+ * @param sgl context
+ * @param index index of the signature, less than the signature count
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_select_signature(sigil_t *sgl, size_t index);
+
+/** @brief Get the error which stopped the verification of the selected
+ *         signature, ERR_NONE if it was verified
+ *
+ * @param sgl context
+ * @param error output - the error of the signature
+ * @return ERR_NONE if success, ERR_NO_DATA if there is no signature
+ */
+sigil_err_t sigil_get_signature_error(sigil_t *sgl, sigil_err_t *error);
+
+/** @brief Get the result of the selected signature from the provided context
  *
  * @param sgl context
  * @param result output - the result of digital signature verification,
@@ -87,8 +199,8 @@ sigil_err_t sigil_verify(sigil_t *sgl);
  */
 sigil_err_t sigil_get_result(sigil_t *sgl, int *result);
 
-/** @brief Get the result of a certificate validation phase from the provided
- *         context, CERT_STATUS_VERIFIED or CERT_STATUS_FAILED (constants.h)
+/** @brief Get the result of a certificate validation phase of the selected
+ *         signature, CERT_STATUS_VERIFIED or CERT_STATUS_FAILED (constants.h)
  *
  * @param sgl context
  * @param result output - result of the certificate validation
@@ -97,7 +209,7 @@ sigil_err_t sigil_get_result(sigil_t *sgl, int *result);
 sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result);
 
 /** @brief Get the result of a data integrity (message digest comparison) phase
- *         from the provided context, HASH_CMP_RESULT_MATCH or
+ *         of the selected signature, HASH_CMP_RESULT_MATCH or
  *         HASH_CMP_RESULT_DIFFER (constants.h)
  *
  * @param sgl context
@@ -106,7 +218,30 @@ sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result);
  */
 sigil_err_t sigil_get_data_integrity_result(sigil_t *sgl, int *result);
 
-/** @brief Get the subfilter value from the provided context
+/** @brief Get the result of the signature timestamp embedded in the selected
+ *         signature, TIMESTAMP_STATUS_VERIFIED, TIMESTAMP_STATUS_FAILED or
+ *         TIMESTAMP_STATUS_NONE without the timestamp (constants.h). The
+ *         certificate of the signer is verified at the time of the verified
+ *         timestamp
+ *
+ * @param sgl context
+ * @param result output - result of the timestamp verification
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_get_timestamp_result(sigil_t *sgl, int *result);
+
+/** @brief Get the revisions of the document read through the chain of the
+ *         cross-reference sections, the newest one first
+ *
+ * @param sgl context
+ * @param revisions output - the revisions, owned by the context
+ * @param count output - number of the revisions
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_get_revisions(sigil_t *sgl, const revision_t **revisions,
+                                size_t *count);
+
+/** @brief Get the subfilter value of the selected signature
  *
  * @param sgl context
  * @param subfilter output - the subfiter value
@@ -114,7 +249,8 @@ sigil_err_t sigil_get_data_integrity_result(sigil_t *sgl, int *result);
  */
 sigil_err_t sigil_get_subfilter(sigil_t *sgl, int *subfilter);
 
-/** @brief Get the hash function used for the integrity check
+/** @brief Get the hash function used for the integrity check of the selected
+ *         signature
  *
  * @param sgl context
  * @param hash_fn output - used message digest function
@@ -122,8 +258,7 @@ sigil_err_t sigil_get_subfilter(sigil_t *sgl, int *subfilter);
  */
 sigil_err_t sigil_get_hash_fn(sigil_t *sgl, int *hash_fn);
 
-/** @brief Get the original message digest (from the signature) from the
- *         provided context
+/** @brief Get the original message digest (from the selected signature)
  *
  * @param sgl context
  * @param digest output - the original message digest (from the signature)
@@ -131,7 +266,7 @@ sigil_err_t sigil_get_hash_fn(sigil_t *sgl, int *hash_fn);
  */
 sigil_err_t sigil_get_original_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest);
 
-/** @brief Get the computed message digest from the provided context
+/** @brief Get the computed message digest of the selected signature
  *
  * @param sgl context
  * @param digest output - the computed message digest
@@ -170,7 +305,8 @@ void sigil_print_subfilter(sigil_t *sgl);
  */
 void sigil_print_hash_fn(sigil_t *sgl);
 
-/** @brief Print information about the signing certificate to the standard output
+/** @brief Print information about the signing certificate of the selected
+ *         signature to the standard output
  *
  * @param sgl context
  */
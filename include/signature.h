@@ -0,0 +1,42 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_SIGNATURE_H
+#define PDF_SIGIL_SIGNATURE_H
+
+#include "types.h"
+
+/** @brief Appends a new signature with the default values to the context
+ *
+ * @param sgl context
+ * @param signature output - the new signature, valid until the next one is
+ *                  added
+ * @return ERR_NONE if success
+ */
+sigil_err_t signature_add(sigil_t *sgl, signature_t **signature);
+
+/** @brief Removes the signatures of the unsigned fields - without the
+ *         signature dictionary, the order of the others is kept
+ *
+ * @param sgl context
+ * @return ERR_NONE if some signature remains, ERR_NO_SIGNATURE otherwise
+ */
+sigil_err_t signatures_remove_unsigned(sigil_t *sgl);
+
+/** @brief Frees all the signatures of the context
+ *
+ * @param sgl context
+ */
+void signatures_clear(sigil_t *sgl);
+
+/** @brief Tests for the signature module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_signature_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_SIGNATURE_H */
@@ -0,0 +1,99 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_STREAM_H
+#define PDF_SIGIL_STREAM_H
+
+#include "types.h"
+
+/** @brief Type of the reader decoding the stream data on the fly, only a
+ *         bounded part of the decoded data is held in memory
+ *
+ */
+typedef struct stream_reader_t stream_reader_t;
+
+/** @brief Sets the default values of the stream information - no filter and
+ *         no predictor
+ *
+ * @param info stream information
+ */
+void stream_info_init(stream_info_t *info);
+
+/** @brief Parses the value of the /Filter entry from the current position,
+ *         only FlateDecode (possibly as a single item of an array) is supported
+ *
+ * @param sgl context
+ * @param info output - the filter is set
+ * @return ERR_NONE if success, ERR_NOT_IMPLEMENTED for other filters
+ */
+sigil_err_t parse_stream_filter(sigil_t *sgl, stream_info_t *info);
+
+/** @brief Parses the value of the /DecodeParms entry from the current position
+ *         - the predictor parameters
+ *
+ * @param sgl context
+ * @param info output - the predictor parameters are set
+ * @return ERR_NONE if success
+ */
+sigil_err_t parse_stream_decode_parms(sigil_t *sgl, stream_info_t *info);
+
+/** @brief Parses the value of the /Length entry from the current position,
+ *         resolves also the indirect reference, if there is one. The position
+ *         after the call is undefined
+ *
+ * @param sgl context
+ * @param info output - the length is set
+ * @return ERR_NONE if success
+ */
+sigil_err_t parse_stream_length(sigil_t *sgl, stream_info_t *info);
+
+/** @brief Finds the beginning of the stream data. Initial position needs to be
+ *         right after the stream dictionary
+ *
+ * @param sgl context
+ * @param info output - the data offset is set
+ * @return ERR_NONE if success
+ */
+sigil_err_t locate_stream_data(sigil_t *sgl, stream_info_t *info);
+
+/** @brief Prepares the reader of the stream described by the provided
+ *         information
+ *
+ * @param sgl context
+ * @param info stream information
+ * @param reader output - the reader, to be freed by stream_reader_free
+ * @return ERR_NONE if success
+ */
+sigil_err_t stream_reader_open(sigil_t *sgl, const stream_info_t *info,
+                               stream_reader_t **reader);
+
+/** @brief Reads the next part of the decoded stream data. Does not depend on
+ *         the current position in the PDF, but changes it
+ *
+ * @param reader stream reader
+ * @param out output - the decoded data
+ * @param size number of bytes requested
+ * @param read_size output - number of bytes read, lower than size only at the
+ *                  end of the stream
+ * @return ERR_NONE if success
+ */
+sigil_err_t stream_read(stream_reader_t *reader, unsigned char *out, size_t size,
+                        size_t *read_size);
+
+/** @brief Clean-up of the stream reader
+ *
+ * @param reader the reader to be freed
+ */
+void stream_reader_free(stream_reader_t **reader);
+
+/** @brief Tests for the stream module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_stream_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_STREAM_H */
@@ -0,0 +1,38 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_TIMESTAMP_H
+#define PDF_SIGIL_TIMESTAMP_H
+
+#include "types.h"
+
+/** @brief Verifies the signature timestamp token embedded in the unsigned
+ *         attributes of the signer info - its message imprint over the
+ *         signature value, the signature of the token and the chain of the
+ *         timestamping authority. The verified genTime is stored to be used
+ *         as the time of the signer's certificate verification. The verified
+ *         chains are cached for all the documents of the process
+ *
+ * @param sgl context
+ * @param signature the signature loaded by cms_load
+ * @return ERR_NONE if success (also if there is no token or it does not hold)
+ */
+sigil_err_t timestamp_verify_embedded(sigil_t *sgl, signature_t *signature);
+
+/** @brief Removes all the verified chains of the timestamping authorities
+ *         from the cache of the process
+ *
+ */
+void timestamp_cache_clear(void);
+
+/** @brief Tests for the timestamp module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_timestamp_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_TIMESTAMP_H */
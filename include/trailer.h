@@ -15,6 +15,18 @@
  */
 sigil_err_t process_trailer(sigil_t *sgl);
 
+/** @brief Process the trailer entries (Size, Prev, Root and XRefStm) from the already
+ *         projected dictionary - the trailer itself, or the dictionary of the
+ *         cross-reference stream
+ *
+ * @param sgl context
+ * @param entries dictionary entries from parse_dict_projection
+ * @param count number of entries
+ * @return ERR_NONE if success
+ */
+sigil_err_t process_trailer_entries(sigil_t *sgl, dict_entry_t *entries,
+                                    size_t count);
+
 /** @brief Tests for trailer module
  *
  * @param verbosity output level - 0 means nothing, 1 prints module names with
@@ -5,10 +5,13 @@
 #ifndef PDF_SIGIL_TYPES_H
 #define PDF_SIGIL_TYPES_H
 
+#include <openssl/cms.h>
 #include <openssl/evp.h> // EVP_MAX_MD_SIZE
+#include <openssl/ts.h>
 #include <openssl/x509.h>
 #include <stdint.h> // uint32_t
 #include <stdio.h>
+#include <time.h> // time_t
 
 
 #ifdef _WIN32
@@ -26,6 +29,16 @@ typedef uint32_t sigil_err_t;
  */
 typedef uint32_t dict_key_t;
 
+/** @brief Type for one wanted entry of the dictionary projection, holds the
+ *         position of the value if the key was found
+ *
+ */
+typedef struct {
+    dict_key_t key;
+    size_t     offset;
+    int        found;
+} dict_entry_t;
+
 /** @brief Type used as an indirect reference to object
  *
  */
@@ -67,36 +80,225 @@ typedef struct {
     size_t capacity;
 } ref_array_t;
 
-/** @brief Type for one entry from a cross-reference section and pointer to the
- *         next one (linked list)
+/** @brief Type for one signature of the document - the position of its
+ *         dictionary, the extracted parts, partial results and the final
+ *         result of its verification
  *
  */
-typedef struct xref_entry_t {
-    size_t byte_offset;
-    size_t generation_num;
-    struct xref_entry_t *next;
-} xref_entry_t;
+typedef struct {
+    // indirect reference to signature parts
+    reference_t        ref_sig_field;
+    reference_t        ref_sig_dict;
+    // offset to signature parts
+    size_t             offset_sig_dict;
+    // signature information
+    int                subfilter_type;
+    int                hash_fn;
+    // message digest
+    X509_ALGOR        *digest_algorithm;
+    ASN1_OCTET_STRING *digest_computed;
+    ASN1_OCTET_STRING *digest_original;
+    // extracted parts
+    range_t           *byte_range;
+    cert_t            *certificates;
+    contents_t        *contents;
+    // decoded CMS signed data, the signer info is owned by it
+    CMS_ContentInfo   *cms;
+    CMS_SignerInfo    *signer_info;
+    // timestamp info of the document timestamp
+    TS_TST_INFO       *tst_info;
+    // time of the verified signature timestamp, used for the certificate
+    time_t             timestamp_time;
+    // results of verification process
+    sigil_err_t        error;
+    int                result_cert_verification;
+    int                result_digest_comparison;
+    int                result_timestamp;
+} signature_t;
 
-/** @brief Type for storing the entries from a cross-reference section
+/** @brief Type for one packed entry from a cross-reference section - the entry
+ *         type in bits 62-63, the generation number in bits 46-61 and the byte
+ *         offset in bits 0-45 (see macros in xref.h)
+ *
+ */
+typedef uint64_t xref_entry_t;
+
+/** @brief Type for an entry of the object with more than one generation in
+ *         the cross-reference sections, these are stored aside
+ *
+ */
+typedef struct {
+    size_t       object_num;
+    xref_entry_t entry;
+} xref_extra_t;
+
+/** @brief Type for a subsection of the cross-reference table, which is not
+ *         decoded in advance (lazy mode) - the entries are decoded on demand
+ *         from the fixed-size records starting at the offset
  *
  */
 typedef struct {
-    xref_entry_t **entry;
-    size_t         capacity;
-    size_t         size_from_trailer;
-    size_t         prev_section;
+    size_t first_object;
+    size_t count;
+    size_t offset;
+} xref_subsection_t;
+
+/** @brief Type for storing the entries from a cross-reference section, indexed
+ *         directly by the object number, and the subsections to be decoded
+ *         on demand. The cross-reference streams of the hybrid sections
+ *         (/XRefStm) are merged only after some lookup misses. The direct
+ *         index does not grow beyond the number of objects fitting into the
+ *         data (object_limit, 0 if not limited) nor the size from the trailer,
+ *         the objects above are kept aside with the other generations
+ *
+ */
+typedef struct {
+    xref_entry_t      *entry;
+    size_t             capacity;
+    xref_extra_t      *extra;
+    size_t             extra_count;
+    size_t             extra_capacity;
+    xref_subsection_t *subsection;
+    size_t             subsection_count;
+    size_t             subsection_capacity;
+    int                materialized;
+    size_t             size_from_trailer;
+    size_t             object_limit;
+    size_t             prev_section;
+    size_t             stream_section;
+    int                hybrid_merged;
 } xref_t;
 
+/** @brief Type for one revision of the document - its cross-reference section,
+ *         the trailer (the cross-reference stream object itself for the
+ *         stream), the cross-reference stream of the hybrid section (0 if
+ *         none) and the end of the revision right after its "%%EOF" marker
+ *         and the end-of-line (0 if the marker was not found)
+ *
+ */
+typedef struct {
+    size_t section_offset;
+    size_t trailer_offset;
+    size_t xref_stream_offset;
+    size_t end_offset;
+} revision_t;
+
+/** @brief Type for the set of numbers (offsets, object numbers) hashed with the
+ *         open addressing, the slots hold the number + 1 and zero is empty
+ *
+ */
+typedef struct {
+    size_t *slot;
+    size_t  count;
+    size_t  capacity;
+} number_set_t;
+
+/** @brief Type for the list of the revisions read through the /Prev chain, the
+ *         newest one first, with the hashed section offsets for detecting
+ *         the cyclic chain
+ *
+ */
+typedef struct {
+    revision_t  *entry;
+    size_t       count;
+    size_t       capacity;
+    number_set_t visited;
+} revision_list_t;
+
+/** @brief Type for the information about the stream, needed for decoding
+ *         of its data
+ *
+ */
+typedef struct {
+    size_t data_offset;
+    size_t length;
+    int    filter;
+    size_t predictor;
+    size_t colors;
+    size_t bits_per_component;
+    size_t columns;
+} stream_info_t;
+
+/** @brief Type for one object stored in the object stream - its number and
+ *         the offset of its data in the decoded stream
+ *
+ */
+typedef struct {
+    size_t object_num;
+    size_t offset;
+} objstm_object_t;
+
+/** @brief Type for the decoded object stream with the parsed table of its
+ *         objects
+ *
+ */
+typedef struct {
+    size_t           stream_num;
+    char            *data;
+    size_t           size;
+    objstm_object_t *object;
+    size_t           object_count;
+    size_t           last_use;
+} objstm_t;
+
+/** @brief Type for the cache of the decoded object streams of one document,
+ *         the least recently used stream is replaced when it is full
+ *
+ */
+typedef struct {
+    objstm_t *entry;
+    size_t    count;
+    size_t    capacity;
+    size_t    clock;
+    size_t    depth;
+} objstm_cache_t;
+
+/** @brief Type for the references to the streams of one kind collected from
+ *         the DSS dictionary and its VRI entries, each object is present once
+ *
+ */
+typedef struct {
+    reference_t *entry;
+    size_t       count;
+    size_t       capacity;
+    number_set_t seen;
+} dss_refs_t;
+
+/** @brief Type for the decoded revocation data (CRL or OCSP response) shared
+ *         by the documents through the cache of the process
+ *
+ */
+typedef struct dss_object_t dss_object_t;
+
+/** @brief Type for the Document Security Store of the document - the
+ *         references collected from the dictionary, the decoded data and
+ *         the error of the load, the incomplete data are never used
+ *
+ */
+typedef struct {
+    dss_refs_t           certs;
+    dss_refs_t           ocsps;
+    dss_refs_t           crls;
+    STACK_OF(X509)      *x509s;
+    STACK_OF(X509_CRL)  *x509_crls;
+    dss_object_t       **objects;
+    size_t               object_count;
+    sigil_err_t          error;
+} dss_t;
+
 /** @brief Type for storing the PDF data. Allowing both - the file pointer
- *         and the buffer
+ *         and the buffer. While the position is inside of a decoded object
+ *         stream, the data are read from that stream instead
  *
  */
 typedef struct {
-    FILE    *file;
-    char    *buffer;
-    size_t   buf_pos;
-    size_t   size;
-    uint32_t deallocation_info;
+    FILE     *file;
+    char     *buffer;
+    size_t    buf_pos;
+    size_t    size;
+    uint32_t  deallocation_info;
+    objstm_t *objstm;
+    size_t    objstm_pos;
 } pdf_data_t;
 
 /** @brief Sigil context for saving all the configuration, partial results during
@@ -110,33 +312,34 @@ typedef struct {
     int                pdf_x; // version from PDF header - <x>.<y>
     int                pdf_y;
     size_t             sig_flags;
-    int                subfilter_type;
     int                xref_type;
-    int                hash_fn;
+    int                raw_scan_mode;
+    int                xref_reconstruction;
+    int                xref_mode;
+    int                chain_mode;
+    size_t             thread_count;
+    char              *cache_dir;
     // indirect reference to pdf parts
     reference_t        ref_acroform;
     reference_t        ref_catalog_dict;
-    reference_t        ref_sig_dict;
-    reference_t        ref_sig_field;
+    reference_t        ref_dss;
     // offset to pdf parts
     size_t             offset_acroform;
+    size_t             offset_dss;
     size_t             offset_pdf_start;
-    size_t             offset_sig_dict;
     size_t             offset_startxref;
-    // message digest
-    X509_ALGOR        *digest_algorithm;
-    ASN1_OCTET_STRING *digest_computed;
-    ASN1_OCTET_STRING *digest_original;
     // extracted parts
     ref_array_t        fields;
-    range_t           *byte_range;
-    cert_t            *certificates;
-    contents_t        *contents;
     xref_t            *xref;
+    revision_list_t    revisions;
+    objstm_cache_t    *objstm_cache;
+    dss_t             *dss;
     X509_STORE        *trusted_store;
-    // results of verification process
-    int                result_cert_verification;
-    int                result_digest_comparison;
+    // signatures of the document with the results of verification process
+    signature_t       *signatures;
+    size_t             signature_count;
+    size_t             signature_capacity;
+    size_t             signature_selected;
 } sigil_t;
 
 #endif /* PDF_SIGIL_TYPES_H */
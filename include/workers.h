@@ -0,0 +1,46 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_WORKERS_H
+#define PDF_SIGIL_WORKERS_H
+
+#include "types.h"
+
+/** @brief Type of the function processing one task
+ *
+ */
+typedef void (*worker_fn_t)(void *task);
+
+/** @brief Number of the threads to be used when the caller asks for the
+ *         automatic choice - the number of online processors
+ *
+ * @return number of threads, at least 1
+ */
+size_t workers_default_count(void);
+
+/** @brief Processes all the tasks from the array by the provided function on
+ *         a pool of threads, the calling thread takes part as well. Returns
+ *         after all the tasks are done. Without the thread support (or with
+ *         thread_count 1) the tasks are processed serially
+ *
+ * @param thread_count maximum number of threads to be used
+ * @param fn function processing one task
+ * @param tasks array of tasks
+ * @param task_size size of one task in bytes
+ * @param task_count number of tasks in the array
+ * @return ERR_NONE if success
+ */
+sigil_err_t workers_run(size_t thread_count, worker_fn_t fn, void *tasks,
+                        size_t task_size, size_t task_count);
+
+/** @brief Tests for the workers module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_workers_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_WORKERS_H */
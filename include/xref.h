@@ -7,11 +7,32 @@
 
 #include "types.h"
 
+#define XREF_RECORD_SIZE            20
+
+#define XREF_ENTRY_OFFSET_BITS      46
+#define XREF_ENTRY_GENERATION_BITS  16
+#define XREF_ENTRY_TYPE_SHIFT       (XREF_ENTRY_OFFSET_BITS + XREF_ENTRY_GENERATION_BITS)
+#define XREF_ENTRY_OFFSET_MAX       ((UINT64_C(1) << XREF_ENTRY_OFFSET_BITS) - 1)
+#define XREF_ENTRY_GENERATION_MAX   ((UINT64_C(1) << XREF_ENTRY_GENERATION_BITS) - 1)
+
+#define XREF_ENTRY_PACK(type, offset, generation)                        \
+    (((xref_entry_t)(type) << XREF_ENTRY_TYPE_SHIFT) |                   \
+     (((xref_entry_t)(generation) & XREF_ENTRY_GENERATION_MAX)           \
+         << XREF_ENTRY_OFFSET_BITS) |                                    \
+     ((xref_entry_t)(offset) & XREF_ENTRY_OFFSET_MAX))
+
+#define XREF_ENTRY_TYPE(entry)       ((int)((entry) >> XREF_ENTRY_TYPE_SHIFT))
+#define XREF_ENTRY_GENERATION(entry) \
+    ((size_t)(((entry) >> XREF_ENTRY_OFFSET_BITS) & XREF_ENTRY_GENERATION_MAX))
+#define XREF_ENTRY_OFFSET(entry)     ((size_t)((entry) & XREF_ENTRY_OFFSET_MAX))
+
 /** @brief Allocates a new xref structure and sets default values
  *
+ * @param data_size size of the PDF data the table belongs to, it limits the
+ *                  directly indexed objects (0 - no limit)
  * @return valid xref_t structure or NULL if error occured
  */
-xref_t *xref_init(void);
+xref_t *xref_init(size_t data_size);
 
 /** @brief Clean-up of the provided xref structure
  *
@@ -19,6 +40,54 @@ xref_t *xref_init(void);
  */
 void xref_free(xref_t *xref);
 
+/** @brief Makes sure the xref table is able to hold at least the provided
+ *         number of objects without further reallocation, not more than the
+ *         limit of the directly indexed objects though
+ *
+ * @param xref cross-reference table
+ * @param count number of objects
+ * @return ERR_NONE if success
+ */
+sigil_err_t xref_reserve(xref_t *xref, size_t count);
+
+/** @brief Adds an entry into the cross-reference table, the sections are read
+ *         from the newest one, so the entry already present for the same object
+ *         and generation is kept. The object number above both the size from
+ *         the trailer and the number of objects fitting into the data is
+ *         refused
+ *
+ * @param xref cross-reference table
+ * @param obj object number
+ * @param type one of XREF_ENTRY_IN_USE, XREF_ENTRY_COMPRESSED
+ * @param offset byte offset of the object
+ * @param generation generation number of the object
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the entry is not valid
+ */
+sigil_err_t xref_add_entry(xref_t *xref, size_t obj, int type, size_t offset,
+                           size_t generation);
+
+/** @brief Finds the entry for the provided reference
+ *
+ * @param xref cross-reference table
+ * @param ref reference to the object
+ * @param result output - the packed entry
+ * @return ERR_NONE if success, ERR_NO_DATA if the object is not present
+ */
+sigil_err_t xref_lookup(const xref_t *xref, const reference_t *ref,
+                        xref_entry_t *result);
+
+/** @brief Finds the entry for the provided reference, decoding it from the
+ *         lazily read subsections if needed. The first miss in a document
+ *         with the hybrid sections reads the chain again with their
+ *         cross-reference streams (/XRefStm)
+ *
+ * @param sgl context
+ * @param ref reference to the object
+ * @param result output - the packed entry
+ * @return ERR_NONE if success, ERR_NO_DATA if the object is not present
+ */
+sigil_err_t xref_find(sigil_t *sgl, const reference_t *ref, xref_entry_t *result);
+
 /** @brief Read the offset of the last cross-reference section
  *
  * @param sgl context
@@ -34,6 +103,16 @@ sigil_err_t read_startxref(sigil_t *sgl);
  */
 sigil_err_t process_xref(sigil_t *sgl);
 
+/** @brief Reads all the cross-reference sections with their trailers,
+ *         starting with the one at offset_startxref and following the /Prev
+ *         entries. With more threads set and XREF_MODE_EAGER, the sections
+ *         of the buffered PDF are decoded in parallel
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+sigil_err_t process_xref_chain(sigil_t *sgl);
+
 /** @brief For debugging purposes - print all the data from the provided
  *         cross-reference table
  *
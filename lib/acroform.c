@@ -8,7 +8,11 @@
 sigil_err_t process_acroform(sigil_t *sgl)
 {
     sigil_err_t err;
-    dict_key_t dict_key;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Fields,   0, 0 },
+        { DICT_KEY_SigFlags, 0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
 
     if (sgl == NULL)
         return ERR_PARAMETER;
@@ -27,32 +31,23 @@ sigil_err_t process_acroform(sigil_t *sgl)
     if (err != ERR_NONE)
         return err;
 
-    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-        switch (dict_key) {
-            case DICT_KEY_Fields:
-                err = parse_ref_array(sgl, &(sgl->fields));
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_SigFlags:
-                err = parse_number(sgl, &(sgl->sig_flags));
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_UNKNOWN:
-                err = skip_dict_unknown_value(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            default:
-                return ERR_PDF_CONTENT;
-        }
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Fields) == ERR_NONE) {
+        err = parse_ref_array(sgl, &(sgl->fields));
+        if (err != ERR_NONE)
+            return err;
     }
 
-    if (err == ERR_END_OF_DICT)
-        return ERR_NONE;
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_SigFlags) == ERR_NONE) {
+        err = parse_number(sgl, &(sgl->sig_flags));
+        if (err != ERR_NONE)
+            return err;
+    }
 
-    return err;
+    return ERR_NONE;
 }
 
 int sigil_acroform_self_test(int verbosity)
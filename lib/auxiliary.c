@@ -1,12 +1,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+    #include <sys/mman.h>
+#endif
 #include <types.h>
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
+#include "objstm.h"
 #include "sigil.h"
 #include "types.h"
+#include "xref.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SIGIL_MEMMEM_SSE2
+#endif
 
 #define DICT_KEY_MAX   20
 
@@ -28,6 +39,15 @@ int is_digit(const char c)
     return (c >= '0' && c <= '9');
 }
 
+int is_delimiter(const char c)
+{
+    return (c == '(' || c == ')' ||
+            c == '<' || c == '>' ||
+            c == '[' || c == ']' ||
+            c == '{' || c == '}' ||
+            c == '/' || c == '%');
+}
+
 int is_whitespace(const char c)
 {
     return (c == 0x00 || // null
@@ -38,6 +58,84 @@ int is_whitespace(const char c)
             c == 0x20);  // space
 }
 
+#ifdef SIGIL_MEMMEM_SSE2
+static int lowest_bit_index(unsigned int mask)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(mask);
+    #else
+        int index = 0;
+
+        while ((mask & 1) == 0) {
+            mask >>= 1;
+            index++;
+        }
+
+        return index;
+    #endif
+}
+#endif /* SIGIL_MEMMEM_SSE2 */
+
+const char *sigil_memmem(const char *haystack, size_t haystack_len,
+                         const char *needle, size_t needle_len)
+{
+    const char *candidate,
+               *end;
+
+    if (haystack == NULL || needle == NULL || needle_len == 0 ||
+        needle_len > haystack_len)
+    {
+        return NULL;
+    }
+
+    end = haystack + haystack_len - needle_len + 1;
+
+    #ifdef SIGIL_MEMMEM_SSE2
+        if (needle_len >= 2) {
+            const __m128i first = _mm_set1_epi8(needle[0]);
+            const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+            __m128i block_first,
+                    block_last;
+            unsigned int mask;
+            int bit;
+
+            // compare the first and the last character of the needle with 16
+            // positions at once, the rest is compared only for the candidates
+            for (; end - haystack >= 16; haystack += 16) {
+                block_first = _mm_loadu_si128((const __m128i *)haystack);
+                block_last = _mm_loadu_si128(
+                    (const __m128i *)(haystack + needle_len - 1));
+
+                mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(block_first, first),
+                    _mm_cmpeq_epi8(block_last, last)));
+
+                while (mask != 0) {
+                    bit = lowest_bit_index(mask);
+
+                    if (memcmp(haystack + bit + 1, needle + 1, needle_len - 2) == 0)
+                        return haystack + bit;
+
+                    mask &= mask - 1;
+                }
+            }
+        }
+    #endif
+
+    while (haystack < end) {
+        candidate = memchr(haystack, needle[0], (size_t)(end - haystack));
+        if (candidate == NULL)
+            return NULL;
+
+        if (memcmp(candidate + 1, needle + 1, needle_len - 1) == 0)
+            return candidate;
+
+        haystack = candidate + 1;
+    }
+
+    return NULL;
+}
+
 sigil_err_t pdf_read(sigil_t *sgl, size_t size, char *result, size_t *res_size)
 {
     size_t read_size;
@@ -47,6 +145,21 @@ sigil_err_t pdf_read(sigil_t *sgl, size_t size, char *result, size_t *res_size)
     if (sgl == NULL || size == 0 || result == NULL || res_size == NULL)
         return ERR_PARAMETER;
 
+    if (sgl->pdf_data.objstm != NULL) {
+        read_size = MIN(size, sgl->pdf_data.objstm->size - sgl->pdf_data.objstm_pos);
+        if (read_size <= 0)
+            return ERR_NO_DATA;
+
+        memcpy(result, sgl->pdf_data.objstm->data + sgl->pdf_data.objstm_pos,
+               read_size);
+        result[read_size] = '\0';
+        sgl->pdf_data.objstm_pos += read_size;
+
+        *res_size = read_size;
+
+        return ERR_NONE;
+    }
+
     if (sgl->pdf_data.buffer != NULL) {
         read_size = MIN(size, sgl->pdf_data.size - sgl->pdf_data.buf_pos);
         if (read_size <= 0)
@@ -68,13 +181,18 @@ sigil_err_t pdf_read(sigil_t *sgl, size_t size, char *result, size_t *res_size)
     if (sgl->pdf_data.file != NULL) {
         total_processed = 0;
 
+        // fread can return less than requested, only the rest is read again
         while (total_processed < size) {
-            processed = fread(result + total_processed, sizeof(char), size,
-                              sgl->pdf_data.file);
+            processed = fread(result + total_processed, sizeof(char),
+                              size - total_processed, sgl->pdf_data.file);
+            if (processed == 0)
+                break;
             total_processed += processed;
-            if (processed <= 0 || total_processed * sizeof(char) > size)
-                return ERR_IO;
         }
+
+        if (total_processed == 0)
+            return ferror(sgl->pdf_data.file) ? ERR_IO : ERR_NO_DATA;
+
         result[total_processed] = '\0';
 
         *res_size = total_processed;
@@ -90,6 +208,14 @@ sigil_err_t pdf_get_char(sigil_t *sgl, char *result)
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
+    if (sgl->pdf_data.objstm != NULL) {
+        if (sgl->pdf_data.objstm_pos >= sgl->pdf_data.objstm->size)
+            return ERR_NO_DATA;
+
+        *result = sgl->pdf_data.objstm->data[(sgl->pdf_data.objstm_pos)++];
+        return ERR_NONE;
+    }
+
     if (sgl->pdf_data.buffer != NULL) {
         if (sgl->pdf_data.buf_pos >= sgl->pdf_data.size)
             return ERR_NO_DATA;
@@ -119,6 +245,11 @@ sigil_err_t pdf_peek_char(sigil_t *sgl, char *result)
     if (err != ERR_NONE)
         return err;
 
+    if (sgl->pdf_data.objstm != NULL) {
+        sgl->pdf_data.objstm_pos--;
+        return ERR_NONE;
+    }
+
     if (sgl->pdf_data.buffer != NULL) {
         if (--(sgl->pdf_data.buf_pos) < 0)
             return ERR_IO;
@@ -144,6 +275,21 @@ sigil_err_t pdf_move_pos_rel(sigil_t *sgl, ssize_t shift_bytes)
     if (shift_bytes == 0)
         return ERR_NONE;
 
+    // the end of the object stream is a valid position, reading from there
+    // reports no more data
+    if (sgl->pdf_data.objstm != NULL) {
+        final_position = sgl->pdf_data.objstm_pos + shift_bytes;
+        if (final_position < 0) {
+            final_position = 0;
+        } else if ((size_t)final_position > sgl->pdf_data.objstm->size) {
+            final_position = sgl->pdf_data.objstm->size;
+        }
+
+        sgl->pdf_data.objstm_pos = (size_t)final_position;
+
+        return ERR_NONE;
+    }
+
     if (sgl->pdf_data.buffer != NULL) {
         final_position = sgl->pdf_data.buf_pos + shift_bytes;
         if (final_position < sgl->offset_pdf_start) {
@@ -174,6 +320,11 @@ sigil_err_t pdf_move_pos_abs(sigil_t *sgl, size_t position)
     if (sgl == NULL)
         return ERR_PARAMETER;
 
+    if (IS_OBJSTM_POSITION(position))
+        return objstm_move_pos(sgl, position);
+
+    sgl->pdf_data.objstm = NULL;
+
     final_position = position + sgl->offset_pdf_start;
 
     if (sgl->pdf_data.buffer != NULL) {
@@ -195,6 +346,75 @@ sigil_err_t pdf_move_pos_abs(sigil_t *sgl, size_t position)
     return ERR_NO_DATA;
 }
 
+sigil_err_t pdf_span(const sigil_t *sgl, size_t position, size_t length,
+                     const char **data, size_t *data_len)
+{
+    size_t available;
+
+    if (sgl == NULL || data == NULL || data_len == NULL ||
+        IS_OBJSTM_POSITION(position))
+    {
+        return ERR_PARAMETER;
+    }
+
+    // the data only in the file are provided just by pdf_read
+    if (sgl->pdf_data.buffer == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->pdf_data.size <= sgl->offset_pdf_start + position)
+        return ERR_NO_DATA;
+
+    available = sgl->pdf_data.size - sgl->offset_pdf_start - position;
+    length = MIN(length, available);
+
+    if (length == 0)
+        return ERR_NO_DATA;
+
+    *data = sgl->pdf_data.buffer + sgl->offset_pdf_start + position;
+    *data_len = length;
+
+    return ERR_NONE;
+}
+
+sigil_err_t pdf_map_file(sigil_t *sgl)
+{
+#ifndef _WIN32
+    void *mapping;
+
+    if (sgl == NULL || sgl->pdf_data.file == NULL || sgl->pdf_data.size == 0)
+        return ERR_PARAMETER;
+
+    mapping = mmap(NULL, sgl->pdf_data.size, PROT_READ, MAP_PRIVATE,
+                   fileno(sgl->pdf_data.file), 0);
+    if (mapping == MAP_FAILED)
+        return ERR_IO;
+
+    sgl->pdf_data.buffer = mapping;
+    sgl->pdf_data.buf_pos = 0;
+    sgl->pdf_data.deallocation_info |= DEALLOCATE_MAPPING;
+
+    return ERR_NONE;
+#else
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+void pdf_unmap_file(sigil_t *sgl)
+{
+    if (sgl == NULL || !(sgl->pdf_data.deallocation_info & DEALLOCATE_MAPPING))
+        return;
+
+#ifndef _WIN32
+    munmap(sgl->pdf_data.buffer, sgl->pdf_data.size);
+#endif
+
+    sgl->pdf_data.buffer = NULL;
+    sgl->pdf_data.deallocation_info ^= DEALLOCATE_MAPPING;
+}
+
 sigil_err_t pdf_goto_obj(sigil_t *sgl, reference_t *ref)
 {
     sigil_err_t err;
@@ -218,6 +438,10 @@ sigil_err_t pdf_goto_obj(sigil_t *sgl, reference_t *ref)
     if (err != ERR_NONE)
         return err;
 
+    // objects in the object stream have no header
+    if (IS_OBJSTM_POSITION(offset))
+        return ERR_NONE;
+
     err = parse_number(sgl, &tmp);
     if (err != ERR_NONE)
         return err;
@@ -244,6 +468,13 @@ sigil_err_t get_curr_position(sigil_t *sgl, size_t *result)
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
+    if (sgl->pdf_data.objstm != NULL) {
+        *result = OBJSTM_POSITION(sgl->pdf_data.objstm->stream_num,
+                                  sgl->pdf_data.objstm_pos);
+
+        return ERR_NONE;
+    }
+
     if (sgl->pdf_data.buffer != NULL) {
         if (sgl->offset_pdf_start > sgl->pdf_data.buf_pos)
             return ERR_IO;
@@ -343,6 +574,59 @@ sigil_err_t skip_dictionary(sigil_t *sgl)
     return err;
 }
 
+/** @brief Move position in the PDF after the hexadecimal string from the current
+ *         position. The initial position needs to be after the leading '<'
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t skip_hex_string(sigil_t *sgl)
+{
+    sigil_err_t err;
+    char c;
+
+    while ((err = pdf_get_char(sgl, &c)) == ERR_NONE) {
+        if (c == '>')
+            return ERR_NONE;
+    }
+
+    return err;
+}
+
+/** @brief Move position in the PDF after the literal string from the current
+ *         position, respecting the balanced and escaped parentheses. The initial
+ *         position needs to be after the leading '('
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t skip_literal_string(sigil_t *sgl)
+{
+    sigil_err_t err;
+    int depth = 1;
+    char c;
+
+    while ((err = pdf_get_char(sgl, &c)) == ERR_NONE) {
+        switch (c) {
+            case '\\':
+                if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
+                    return err;
+                break;
+            case '(':
+                depth++;
+                break;
+            case ')':
+                if (--depth == 0)
+                    return ERR_NONE;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return err;
+}
+
 sigil_err_t skip_dict_unknown_value(sigil_t *sgl)
 {
     sigil_err_t err;
@@ -370,10 +654,14 @@ sigil_err_t skip_dict_unknown_value(sigil_t *sgl)
                     if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
                         return err;
                     if (c != '<')
-                        break;
+                        return skip_hex_string(sgl);
                     if ((err = skip_dictionary(sgl)) != ERR_NONE)
                         return err;
                     return ERR_NONE;
+                case '(':
+                    if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
+                        return err;
+                    return skip_literal_string(sgl);
                 default:
                     break;
             }
@@ -461,9 +749,46 @@ sigil_err_t parse_number(sigil_t *sgl, size_t *number)
         digits++;
     }
 
+    // the number at the very end of the data (e.g. of an object stream)
+    if (err == ERR_NO_DATA && digits > 0)
+        return ERR_NONE;
+
     return err;
 }
 
+sigil_err_t parse_number_array(sigil_t *sgl, size_t *values, size_t max,
+                               size_t *count)
+{
+    sigil_err_t err;
+    char c;
+
+    if (sgl == NULL || values == NULL || count == NULL)
+        return ERR_PARAMETER;
+
+    *count = 0;
+
+    if ((err = skip_word(sgl, "[")) != ERR_NONE)
+        return err;
+
+    while (1) {
+        if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+            return err;
+        if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+            return err;
+
+        if (c == ']')
+            return pdf_move_pos_rel(sgl, 1);
+
+        if (*count >= max)
+            return ERR_PDF_CONTENT;
+
+        if ((err = parse_number(sgl, &(values[*count]))) != ERR_NONE)
+            return err;
+
+        (*count)++;
+    }
+}
+
 sigil_err_t parse_indirect_reference(sigil_t *sgl, reference_t *ref)
 {
     sigil_err_t err;
@@ -483,72 +808,109 @@ sigil_err_t parse_indirect_reference(sigil_t *sgl, reference_t *ref)
     return ERR_NONE;
 }
 
-// parse the key of the pair key - value in the dictionary
-sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key)
+sigil_err_t parse_name(sigil_t *sgl, char *name, size_t size)
 {
     sigil_err_t err;
-    int count = 0;
-    char tmp[DICT_KEY_MAX],
-         c;
+    size_t count = 0;
+    int too_long = 0;
+    char c;
 
-    if (sgl == NULL || dict_key == NULL)
+    if (sgl == NULL || name == NULL || size == 0)
         return ERR_PARAMETER;
 
-    sigil_zeroize(tmp, DICT_KEY_MAX * sizeof(*tmp));
-
-    if (skip_word(sgl, ">>") == ERR_NONE)
-        return ERR_END_OF_DICT;
-
     err = skip_word(sgl, "/");
     if (err != ERR_NONE)
         return err;
 
     while ((err = pdf_peek_char(sgl, &c)) == ERR_NONE) {
-        if (is_whitespace(c)) {
-            if (count <= 0)
-                return ERR_PDF_CONTENT;
+        if (is_whitespace(c) || is_delimiter(c))
             break;
+
+        if (count >= size - 1) {
+            too_long = 1;
         } else {
-            if (count >= DICT_KEY_MAX - 1)
-                return ERR_PDF_CONTENT;
-            tmp[count++] = c;
+            name[count++] = c;
         }
 
         if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
             return err;
     }
 
-    tmp[count] = '\0';
+    // name at the very end of the data
+    if (err == ERR_NO_DATA && count > 0)
+        err = ERR_NONE;
+
+    name[too_long ? 0 : count] = '\0';
+
+    return err;
+}
+
+/** @brief Names of the dictionary keys recognized by parse_dict_key
+ *
+ */
+static const struct {
+    const char *name;
+    dict_key_t  key;
+} dict_key_names[] = {
+    { "Size",             DICT_KEY_Size             },
+    { "Prev",             DICT_KEY_Prev             },
+    { "Root",             DICT_KEY_Root             },
+    { "AcroForm",         DICT_KEY_AcroForm         },
+    { "Fields",           DICT_KEY_Fields           },
+    { "SigFlags",         DICT_KEY_SigFlags         },
+    { "FT",               DICT_KEY_FT               },
+    { "V",                DICT_KEY_V                },
+    { "SubFilter",        DICT_KEY_SubFilter        },
+    { "Cert",             DICT_KEY_Cert             },
+    { "Contents",         DICT_KEY_Contents         },
+    { "ByteRange",        DICT_KEY_ByteRange        },
+    { "Type",             DICT_KEY_Type             },
+    { "W",                DICT_KEY_W                },
+    { "Index",            DICT_KEY_Index            },
+    { "Filter",           DICT_KEY_Filter           },
+    { "DecodeParms",      DICT_KEY_DecodeParms      },
+    { "Length",           DICT_KEY_Length           },
+    { "Predictor",        DICT_KEY_Predictor        },
+    { "Colors",           DICT_KEY_Colors           },
+    { "BitsPerComponent", DICT_KEY_BitsPerComponent },
+    { "Columns",          DICT_KEY_Columns          },
+    { "N",                DICT_KEY_N                },
+    { "First",            DICT_KEY_First            },
+    { "XRefStm",          DICT_KEY_XRefStm          },
+    { "Kids",             DICT_KEY_Kids             },
+    { "T",                DICT_KEY_T                },
+    { "DSS",              DICT_KEY_DSS              },
+    { "Certs",            DICT_KEY_Certs            },
+    { "OCSPs",            DICT_KEY_OCSPs            },
+    { "CRLs",             DICT_KEY_CRLs             },
+    { "VRI",              DICT_KEY_VRI              },
+    { "OCSP",             DICT_KEY_OCSP             },
+    { "CRL",              DICT_KEY_CRL              },
+};
+
+// parse the key of the pair key - value in the dictionary
+sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key)
+{
+    sigil_err_t err;
+    char tmp[DICT_KEY_MAX];
+
+    if (sgl == NULL || dict_key == NULL)
+        return ERR_PARAMETER;
 
+    if (skip_word(sgl, ">>") == ERR_NONE)
+        return ERR_END_OF_DICT;
+
+    err = parse_name(sgl, tmp, DICT_KEY_MAX);
     if (err != ERR_NONE)
         return err;
 
-    if (strncmp(tmp, "Size", 4) == 0) {
-        *dict_key = DICT_KEY_Size;
-    } else if (strncmp(tmp, "Prev", 4) == 0) {
-        *dict_key = DICT_KEY_Prev;
-    } else if (strncmp(tmp, "Root", 4) == 0) {
-        *dict_key = DICT_KEY_Root;
-    } else if (strncmp(tmp, "AcroForm", 8) == 0) {
-        *dict_key = DICT_KEY_AcroForm;
-    } else if (strncmp(tmp, "Fields", 6) == 0) {
-        *dict_key = DICT_KEY_Fields;
-    } else if (strncmp(tmp, "SigFlags", 8) == 0) {
-        *dict_key = DICT_KEY_SigFlags;
-    } else if (strncmp(tmp, "FT", 2) == 0) {
-        *dict_key = DICT_KEY_FT;
-    } else if (strncmp(tmp, "V", 1) == 0) {
-        *dict_key = DICT_KEY_V;
-    } else if (strncmp(tmp, "SubFilter", 9) == 0) {
-        *dict_key = DICT_KEY_SubFilter;
-    } else if (strncmp(tmp, "Cert", 4) == 0) {
-        *dict_key = DICT_KEY_Cert;
-    } else if (strncmp(tmp, "Contents", 8) == 0) {
-        *dict_key = DICT_KEY_Contents;
-    } else if (strncmp(tmp, "ByteRange", 9) == 0) {
-        *dict_key = DICT_KEY_ByteRange;
-    } else {
-        *dict_key = DICT_KEY_UNKNOWN;
+    *dict_key = DICT_KEY_UNKNOWN;
+
+    for (size_t i = 0; i < sizeof(dict_key_names) / sizeof(*dict_key_names); i++) {
+        if (strcmp(tmp, dict_key_names[i].name) == 0) {
+            *dict_key = dict_key_names[i].key;
+            break;
+        }
     }
 
     sigil_zeroize(tmp, DICT_KEY_MAX * sizeof(*tmp));
@@ -556,6 +918,72 @@ sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key)
     return ERR_NONE;
 }
 
+sigil_err_t parse_dict_projection(sigil_t *sgl, dict_entry_t *entries, size_t count)
+{
+    sigil_err_t err;
+    dict_key_t dict_key;
+    size_t remaining;
+
+    if (sgl == NULL || entries == NULL || count == 0)
+        return ERR_PARAMETER;
+
+    for (size_t i = 0; i < count; i++) {
+        entries[i].found = 0;
+        entries[i].offset = 0;
+    }
+
+    remaining = count;
+
+    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
+        if (dict_key != DICT_KEY_UNKNOWN) {
+            for (size_t i = 0; i < count; i++) {
+                if (entries[i].key != dict_key || entries[i].found)
+                    continue;
+
+                if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+                    return err;
+
+                if ((err = get_curr_position(sgl, &(entries[i].offset))) != ERR_NONE)
+                    return err;
+
+                entries[i].found = 1;
+                remaining--;
+                break;
+            }
+        }
+
+        // everything found, the rest of the dictionary is not needed
+        if (remaining == 0)
+            return ERR_NONE;
+
+        if ((err = skip_dict_unknown_value(sgl)) != ERR_NONE)
+            return err;
+    }
+
+    if (err == ERR_END_OF_DICT)
+        return ERR_NONE;
+
+    return err;
+}
+
+sigil_err_t dict_projection_goto(sigil_t *sgl, const dict_entry_t *entries,
+                                 size_t count, dict_key_t dict_key)
+{
+    if (sgl == NULL || entries == NULL)
+        return ERR_PARAMETER;
+
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].key == dict_key) {
+            if (!entries[i].found)
+                return ERR_NO_DATA;
+
+            return pdf_move_pos_abs(sgl, entries[i].offset);
+        }
+    }
+
+    return ERR_NO_DATA;
+}
+
 // parsing array of indirect references into ref_array
 sigil_err_t parse_ref_array(sigil_t *sgl, ref_array_t *ref_array)
 {
@@ -614,28 +1042,135 @@ sigil_err_t parse_ref_array(sigil_t *sgl, ref_array_t *ref_array)
     return err;
 }
 
-sigil_err_t reference_to_offset(sigil_t *sgl, const reference_t *ref, size_t *result)
+void ref_array_free(ref_array_t *ref_array)
 {
-    xref_entry_t *xref_entry;
+    if (ref_array == NULL || ref_array->entry == NULL)
+        return;
 
-    if (sgl == NULL || ref == NULL || sgl->xref == NULL || result == NULL)
+    for (size_t i = 0; i < ref_array->capacity; i++) {
+        if (ref_array->entry[i] != NULL) {
+            sigil_zeroize(ref_array->entry[i], sizeof(*ref_array->entry[i]));
+            free(ref_array->entry[i]);
+        }
+    }
+
+    sigil_zeroize(ref_array->entry, sizeof(*ref_array->entry) * ref_array->capacity);
+    free(ref_array->entry);
+
+    ref_array->entry = NULL;
+    ref_array->capacity = 0;
+}
+
+static size_t number_set_slot(size_t number, size_t capacity)
+{
+    // Fibonacci hashing, capacity is a power of two
+    return (size_t)(((uint64_t)number * 0x9E3779B97F4A7C15ULL) >> 32) &
+           (capacity - 1);
+}
+
+int number_set_contains(const number_set_t *set, size_t number)
+{
+    size_t slot;
+
+    if (set == NULL || set->capacity == 0)
+        return 0;
+
+    slot = number_set_slot(number, set->capacity);
+    while (set->slot[slot] != 0) {
+        if (set->slot[slot] == number + 1)
+            return 1;
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+
+    return 0;
+}
+
+static void number_set_place(size_t *slots, size_t capacity, size_t stored)
+{
+    size_t slot = number_set_slot(stored - 1, capacity);
+
+    while (slots[slot] != 0) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    slots[slot] = stored;
+}
+
+sigil_err_t number_set_insert(number_set_t *set, size_t number)
+{
+    size_t *slots,
+            capacity;
+
+    if (set == NULL || number == SIZE_MAX)
         return ERR_PARAMETER;
 
-    if (sgl->xref->capacity <= ref->object_num)
-        return ERR_NO_DATA;
+    if (number_set_contains(set, number))
+        return ERR_NONE;
 
-    xref_entry = sgl->xref->entry[ref->object_num];
+    // kept at most half full, everything rehashed into the bigger table
+    if (2 * (set->count + 1) > set->capacity) {
+        capacity = MAX(2 * set->capacity, NUMBER_SET_PREALLOCATION);
 
-    while (xref_entry != NULL) {
-        if (xref_entry->generation_num == ref->generation_num) {
-            *result = xref_entry->byte_offset;
-            return ERR_NONE;
+        slots = calloc(capacity, sizeof(size_t));
+        if (slots == NULL)
+            return ERR_ALLOCATION;
+
+        for (size_t i = 0; i < set->capacity; i++) {
+            if (set->slot[i] != 0)
+                number_set_place(slots, capacity, set->slot[i]);
         }
 
-        xref_entry = xref_entry->next;
+        free(set->slot);
+        set->slot = slots;
+        set->capacity = capacity;
     }
 
-    return ERR_NO_DATA;
+    number_set_place(set->slot, set->capacity, number + 1);
+    set->count++;
+
+    return ERR_NONE;
+}
+
+void number_set_clear(number_set_t *set)
+{
+    if (set == NULL)
+        return;
+
+    free(set->slot);
+
+    set->slot = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+sigil_err_t reference_to_offset(sigil_t *sgl, const reference_t *ref, size_t *result)
+{
+    sigil_err_t err;
+    xref_entry_t entry;
+
+    if (sgl == NULL || ref == NULL || sgl->xref == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    err = xref_find(sgl, ref, &entry);
+    if (err != ERR_NONE)
+        return err;
+
+    // compressed objects have the generation number 0, the entry holds the
+    // object stream number and the index in the stream
+    if (XREF_ENTRY_TYPE(entry) == XREF_ENTRY_COMPRESSED) {
+        if (ref->generation_num != 0)
+            return ERR_NO_DATA;
+
+        return objstm_object_position(sgl, XREF_ENTRY_OFFSET(entry),
+                                      XREF_ENTRY_GENERATION(entry),
+                                      ref->object_num, result);
+    }
+
+    if (XREF_ENTRY_TYPE(entry) != XREF_ENTRY_IN_USE)
+        return ERR_NO_DATA;
+
+    *result = XREF_ENTRY_OFFSET(entry);
+
+    return ERR_NONE;
 }
 
 void print_module_name(const char *module_name, int verbosity)
@@ -782,6 +1317,34 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn sigil_memmem
+    print_test_item("fn sigil_memmem", verbosity);
+
+    {
+        char *haystack = "/Type /Sig /Filter /Adobe.PPKLite /SubFilter "    \
+                         "/adbe.x509.rsa_sha1 /ByteRange [0 10 20 30] /B";
+
+        if (sigil_memmem(haystack, strlen(haystack), "/ByteRange", 10) !=
+                strstr(haystack, "/ByteRange")                          ||
+            sigil_memmem(haystack, strlen(haystack), "/B", 2) !=
+                strstr(haystack, "/ByteRange")                          ||
+            sigil_memmem(haystack, strlen(haystack), "/", 1) != haystack ||
+            sigil_memmem(haystack, strlen(haystack), "/Bx", 3) != NULL  ||
+            sigil_memmem(haystack, 10, "/ByteRange", 10) != NULL)
+        {
+            goto failed;
+        }
+
+        // the match at the very end, after the vectorized part
+        if (sigil_memmem(haystack, strlen(haystack), "] /B", 4) !=
+                haystack + strlen(haystack) - 4)
+        {
+            goto failed;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn pdf_read
     print_test_item("fn pdf_read", verbosity);
 
@@ -807,6 +1370,99 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn pdf_read - from the file, the last read is partial
+    print_test_item("fn pdf_read from file", verbosity);
+
+    {
+        char output[11];
+        size_t output_size;
+        FILE *file;
+
+        if ((file = tmpfile()) == NULL || fputs("abbbcx", file) < 0 ||
+            (sgl = test_prepare_sgl_buffer("", 1)) == NULL)
+        {
+            if (file != NULL)
+                fclose(file);
+            goto failed;
+        }
+
+        // the data are not buffered
+        sgl->pdf_data.buffer = NULL;
+        sgl->pdf_data.file = file;
+        sgl->pdf_data.size = 6;
+        sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+
+        if (pdf_move_pos_abs(sgl, 0) != ERR_NONE ||
+            pdf_read(sgl, 4, output, &output_size) != ERR_NONE ||
+            output_size != 4 || strcmp(output, "abbb") != 0 ||
+            pdf_read(sgl, 10, output, &output_size) != ERR_NONE ||
+            output_size != 2 || strcmp(output, "cx") != 0 ||
+            pdf_read(sgl, 10, output, &output_size) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn pdf_span and fn pdf_map_file
+    print_test_item("fn pdf_span", verbosity);
+
+    {
+        const char *data;
+        size_t data_len;
+        FILE *file;
+
+        char *sstream = "abbbcx";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream))) == NULL)
+            goto failed;
+
+        if (pdf_span(sgl, 1, 3, &data, &data_len) != ERR_NONE ||
+            data != sstream + 1 || data_len != 3 ||
+            pdf_span(sgl, 4, 10, &data, &data_len) != ERR_NONE ||
+            data != sstream + 4 || data_len != 2 ||
+            pdf_span(sgl, 6, 1, &data, &data_len) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        if ((file = tmpfile()) == NULL || fputs(sstream, file) < 0 || fflush(file) != 0 ||
+            (sgl = test_prepare_sgl_buffer("", 1)) == NULL)
+        {
+            if (file != NULL)
+                fclose(file);
+            goto failed;
+        }
+
+        sgl->pdf_data.buffer = NULL;
+        sgl->pdf_data.file = file;
+        sgl->pdf_data.size = strlen(sstream);
+        sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+
+        // only the data in memory are provided
+        if (pdf_span(sgl, 0, 1, &data, &data_len) != ERR_PARAMETER)
+            goto failed;
+
+        #ifndef _WIN32
+            if (pdf_map_file(sgl) != ERR_NONE ||
+                pdf_span(sgl, 2, 4, &data, &data_len) != ERR_NONE ||
+                data_len != 4 || memcmp(data, "bbcx", 4) != 0 ||
+                pdf_move_pos_abs(sgl, 5) != ERR_NONE ||
+                pdf_get_char(sgl, &c) != ERR_NONE || c != 'x')
+            {
+                goto failed;
+            }
+        #endif
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn skip_leading_whitespaces
     print_test_item("fn skip_leading_whitespaces", verbosity);
 
@@ -876,6 +1532,75 @@ int sigil_auxiliary_self_test(int verbosity)
             goto failed;
 
         sigil_free(&sgl);
+
+        char *sstream_strings = " <0A1b>x (a/b (c) \\) >>)x";
+        if ((sgl = test_prepare_sgl_buffer(sstream_strings,
+                                           strlen(sstream_strings) + 1)) == NULL)
+        {
+            goto failed;
+        }
+
+        if (skip_dict_unknown_value(sgl) != ERR_NONE ||
+            pdf_get_char(sgl, &c) != ERR_NONE || c != 'x')
+        {
+            goto failed;
+        }
+
+        if (skip_dict_unknown_value(sgl) != ERR_NONE ||
+            pdf_get_char(sgl, &c) != ERR_NONE || c != 'x')
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn parse_dict_projection
+    print_test_item("fn parse_dict_projection", verbosity);
+
+    {
+        dict_entry_t entries[] = {
+            { DICT_KEY_Size, 0, 0 },
+            { DICT_KEY_Root, 0, 0 },
+            { DICT_KEY_Prev, 0, 0 },
+        };
+        size_t result = 0;
+
+        // /SizeX must not be taken for /Size, projection stops after /Root
+        char *sstream = "/SizeX 1 /Info <</Size 2>> /Size 3 /Root 4 0 R ]x";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (parse_dict_projection(sgl, entries, 2) != ERR_NONE ||
+            dict_projection_goto(sgl, entries, 2, DICT_KEY_Size) != ERR_NONE ||
+            parse_number(sgl, &result) != ERR_NONE || result != 3 ||
+            dict_projection_goto(sgl, entries, 2, DICT_KEY_Root) != ERR_NONE ||
+            parse_number(sgl, &result) != ERR_NONE || result != 4)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        char *sstream_missing = "/Size 5 /Other (x>>) >> /Prev 6";
+        if ((sgl = test_prepare_sgl_buffer(sstream_missing,
+                                           strlen(sstream_missing) + 1)) == NULL)
+        {
+            goto failed;
+        }
+
+        entries[2].key = DICT_KEY_Prev;
+        if (parse_dict_projection(sgl, entries, 3) != ERR_NONE ||
+            entries[0].found != 1 || entries[1].found != 0 ||
+            entries[2].found != 0 ||
+            dict_projection_goto(sgl, entries, 3, DICT_KEY_Prev) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
     }
 
     print_test_result(1, verbosity);
@@ -901,6 +1626,43 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn number_set_insert - the table is rehashed, duplicates ignored
+    print_test_item("fn number_set_insert", verbosity);
+
+    {
+        number_set_t set = { NULL, 0, 0 };
+
+        for (size_t i = 0; i < 1000; i++) {
+            if (number_set_insert(&set, 3 * i) != ERR_NONE ||
+                number_set_insert(&set, 3 * i) != ERR_NONE)
+            {
+                number_set_clear(&set);
+                goto failed;
+            }
+        }
+
+        for (size_t i = 0; i < 3000; i++) {
+            if (number_set_contains(&set, i) != (i % 3 == 0)) {
+                number_set_clear(&set);
+                goto failed;
+            }
+        }
+
+        if (set.count != 1000 || 2 * set.count > set.capacity ||
+            number_set_insert(&set, SIZE_MAX) != ERR_PARAMETER)
+        {
+            number_set_clear(&set);
+            goto failed;
+        }
+
+        number_set_clear(&set);
+
+        if (set.slot != NULL || number_set_contains(&set, 0))
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: UTF-8 filepath support
     print_test_item("UTF-8 filepath support", verbosity);
 
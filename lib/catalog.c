@@ -7,8 +7,11 @@
 sigil_err_t process_catalog(sigil_t *sgl)
 {
     sigil_err_t err;
-    size_t offset;
-    dict_key_t dict_key;
+    dict_entry_t entries[] = {
+        { DICT_KEY_AcroForm, 0, 0 },
+        { DICT_KEY_DSS,      0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
     char c;
 
     if (sgl == NULL)
@@ -28,47 +31,40 @@ sigil_err_t process_catalog(sigil_t *sgl)
     if (err != ERR_NONE)
         return err;
 
-    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-        switch (dict_key) {
-            case DICT_KEY_AcroForm:
-                if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
-                    return err;
-
-                if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
-                    return err;
-
-                if (c == '<') {
-                    if ((err = get_curr_position(sgl, &offset)) != ERR_NONE)
-                        return err;
-
-                    sgl->offset_acroform = offset;
-
-                    if ((err = skip_word(sgl, "<<")) != ERR_NONE)
-                        return err;
-
-                    err = skip_dictionary(sgl);
-                    if (err != ERR_NONE)
-                        return err;
-                } else {
-                    err = parse_indirect_reference(sgl, &(sgl->ref_acroform));
-                    if (err != ERR_NONE)
-                        return err;
-                }
-                break;
-            case DICT_KEY_UNKNOWN:
-                err = skip_dict_unknown_value(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            default:
-                return ERR_PDF_CONTENT;
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    // the Document Security Store is optional, it is read only for the
+    // verification of the certificates
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_DSS) == ERR_NONE) {
+        if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+            return err;
+
+        if (c == '<') {
+            sgl->offset_dss = entries[1].offset;
+        } else {
+            err = parse_indirect_reference(sgl, &(sgl->ref_dss));
+            if (err != ERR_NONE)
+                return err;
         }
     }
 
-    if (err == ERR_END_OF_DICT)
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_AcroForm) != ERR_NONE)
         return ERR_NONE;
 
-    return err;
+    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+        return err;
+
+    if (c == '<') {
+        sgl->offset_acroform = entries[0].offset;
+    } else {
+        err = parse_indirect_reference(sgl, &(sgl->ref_acroform));
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    return ERR_NONE;
 }
 
 int sigil_catalog_self_test(int verbosity)
@@ -73,14 +73,14 @@ static sigil_err_t parse_one_cert(sigil_t *sgl, cert_t **result)
     }
 }
 
-sigil_err_t parse_certs(sigil_t *sgl)
+sigil_err_t parse_certs(sigil_t *sgl, cert_t **certificates)
 {
     sigil_err_t err;
     int additional_certs;
     cert_t **next_cert;
     char c;
 
-    if (sgl == NULL)
+    if (sgl == NULL || certificates == NULL)
         return ERR_PARAMETER;
 
     additional_certs = 0;
@@ -98,14 +98,14 @@ sigil_err_t parse_certs(sigil_t *sgl)
         return err;
 
     // read signing certificate
-    err = parse_one_cert(sgl, &(sgl->certificates));
+    err = parse_one_cert(sgl, certificates);
     if (err != ERR_NONE)
         return err;
 
     if (!additional_certs)
         return ERR_NONE;
 
-    next_cert = &(sgl->certificates);
+    next_cert = certificates;
 
     // read other following certs for verifying authenticity of the signing one
     while (1) {
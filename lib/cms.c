@@ -0,0 +1,787 @@
+#include <openssl/cms.h>
+#include <openssl/ess.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <types.h>
+#include "auxiliary.h"
+#include "cert.h"
+#include "cms.h"
+#include "constants.h"
+#include "contents.h"
+#include "cryptography.h"
+#include "sigil.h"
+#include "signature.h"
+
+
+/** @brief Decodes the hexadecimal Contents of the signature into the DER data
+ *
+ * @param signature the signature with the parsed Contents
+ * @param der output - allocated DER data
+ * @param der_len output - length of the DER data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t decode_contents(const signature_t *signature, unsigned char **der,
+                                   size_t *der_len)
+{
+    sigil_err_t err;
+    const char *contents;
+    size_t contents_len;
+
+    contents = signature->contents->contents_hex;
+    contents_len = strlen(contents);
+
+    *der = malloc((contents_len + 1) / 2 + 1);
+    if (*der == NULL)
+        return ERR_ALLOCATION;
+
+    err = sigil_hex_to_dec(contents, contents_len, *der, der_len);
+    if (err != ERR_NONE) {
+        free(*der);
+        *der = NULL;
+    }
+
+    return err;
+}
+
+/** @brief Appends the certificate to the list of the signature, the reference
+ *         count of the certificate is increased
+ *
+ */
+static sigil_err_t append_certificate(cert_t ***last, X509 *x509)
+{
+    cert_t *cert;
+
+    cert = malloc(sizeof(*cert));
+    if (cert == NULL)
+        return ERR_ALLOCATION;
+
+    sigil_zeroize(cert, sizeof(*cert));
+
+    if (X509_up_ref(x509) != 1) {
+        free(cert);
+        return ERR_OPENSSL;
+    }
+
+    cert->x509 = x509;
+
+    **last = cert;
+    *last = &(cert->next);
+
+    return ERR_NONE;
+}
+
+/** @brief Stores the certificates of the signed data to the signature, the
+ *         certificate of the signer goes first
+ *
+ */
+static sigil_err_t load_cms_certificates(signature_t *signature)
+{
+    sigil_err_t err = ERR_NONE;
+    STACK_OF(X509) *certs;
+    X509 *signer = NULL,
+         *x509;
+    cert_t **last;
+
+    certs = CMS_get1_certs(signature->cms);
+    if (certs == NULL)
+        return ERR_PDF_CONTENT;
+
+    for (int i = 0; i < sk_X509_num(certs); i++) {
+        x509 = sk_X509_value(certs, i);
+        if (CMS_SignerInfo_cert_cmp(signature->signer_info, x509) == 0) {
+            signer = x509;
+            break;
+        }
+    }
+
+    if (signer == NULL) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    CMS_SignerInfo_set1_signer_cert(signature->signer_info, signer);
+
+    if (signature->certificates != NULL) {
+        cert_free(signature->certificates);
+        signature->certificates = NULL;
+    }
+
+    last = &(signature->certificates);
+
+    err = append_certificate(&last, signer);
+
+    for (int i = 0; err == ERR_NONE && i < sk_X509_num(certs); i++) {
+        x509 = sk_X509_value(certs, i);
+        if (x509 != signer)
+            err = append_certificate(&last, x509);
+    }
+
+end:
+    sk_X509_pop_free(certs, X509_free);
+
+    return err;
+}
+
+TS_TST_INFO *cms_decode_tst_info(CMS_ContentInfo *cms)
+{
+    ASN1_OCTET_STRING **content;
+    const unsigned char *const_data;
+
+    if (OBJ_obj2nid(CMS_get0_eContentType(cms)) != NID_id_smime_ct_TSTInfo)
+        return NULL;
+
+    content = CMS_get0_content(cms);
+    if (content == NULL || *content == NULL)
+        return NULL;
+
+    const_data = ASN1_STRING_get0_data(*content);
+
+    return d2i_TS_TST_INFO(NULL, &const_data, ASN1_STRING_length(*content));
+}
+
+/** @brief Stores the algorithm for the byte range digest - the algorithm of
+ *         the signer, SHA-1 for the encapsulated digest or the algorithm of the
+ *         message imprint of the document timestamp
+ *
+ */
+static sigil_err_t load_digest_algorithm(signature_t *signature)
+{
+    X509_ALGOR *digest_algorithm = NULL;
+
+    if (signature->digest_algorithm != NULL) {
+        X509_ALGOR_free(signature->digest_algorithm);
+        signature->digest_algorithm = NULL;
+    }
+
+    switch (signature->subfilter_type) {
+        case SUBFILTER_adbe_pkcs7_sha1:
+            signature->digest_algorithm = X509_ALGOR_new();
+            if (signature->digest_algorithm == NULL)
+                return ERR_ALLOCATION;
+
+            X509_ALGOR_set_md(signature->digest_algorithm, EVP_sha1());
+            return ERR_NONE;
+        case SUBFILTER_ETSI_RFC3161:
+            if (signature->tst_info != NULL)
+                TS_TST_INFO_free(signature->tst_info);
+
+            signature->tst_info = cms_decode_tst_info(signature->cms);
+            if (signature->tst_info == NULL)
+                return ERR_PDF_CONTENT;
+
+            digest_algorithm = TS_MSG_IMPRINT_get_algo(
+                TS_TST_INFO_get_msg_imprint(signature->tst_info));
+            break;
+        default:
+            CMS_SignerInfo_get0_algs(signature->signer_info, NULL, NULL,
+                                     &digest_algorithm, NULL);
+            break;
+    }
+
+    if (digest_algorithm == NULL)
+        return ERR_PDF_CONTENT;
+
+    signature->digest_algorithm = X509_ALGOR_dup(digest_algorithm);
+    if (signature->digest_algorithm == NULL)
+        return ERR_ALLOCATION;
+
+    return ERR_NONE;
+}
+
+sigil_err_t cms_load(signature_t *signature)
+{
+    sigil_err_t err;
+    STACK_OF(CMS_SignerInfo) *signer_infos;
+    unsigned char *der = NULL;
+    const unsigned char *const_der;
+    size_t der_len;
+
+    if (signature == NULL || signature->contents == NULL)
+        return ERR_PARAMETER;
+
+    err = decode_contents(signature, &der, &der_len);
+    if (err != ERR_NONE)
+        return err;
+
+    if (signature->cms != NULL) {
+        CMS_ContentInfo_free(signature->cms);
+        signature->cms = NULL;
+        signature->signer_info = NULL;
+    }
+
+    // the Contents are padded with zeros after the DER encoded data
+    const_der = der;
+    signature->cms = d2i_CMS_ContentInfo(NULL, &const_der, (long)der_len);
+    if (signature->cms == NULL) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    // the encapsulated digest or timestamp info is signed, the others are
+    // detached
+    if (OBJ_obj2nid(CMS_get0_type(signature->cms)) != NID_pkcs7_signed ||
+        CMS_is_detached(signature->cms) !=
+            (signature->subfilter_type != SUBFILTER_adbe_pkcs7_sha1 &&
+             signature->subfilter_type != SUBFILTER_ETSI_RFC3161))
+    {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    // only one signer is allowed in the PDF signature
+    signer_infos = CMS_get0_SignerInfos(signature->cms);
+    if (signer_infos == NULL || sk_CMS_SignerInfo_num(signer_infos) != 1) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    signature->signer_info = sk_CMS_SignerInfo_value(signer_infos, 0);
+
+    err = load_cms_certificates(signature);
+    if (err != ERR_NONE)
+        goto end;
+
+    err = load_digest_algorithm(signature);
+
+end:
+    free(der);
+
+    return err;
+}
+
+sigil_err_t cms_verify_signing_cert_binding(signature_t *signature)
+{
+    sigil_err_t err = ERR_NONE;
+    ESS_SIGNING_CERT *ess = NULL;
+    ESS_SIGNING_CERT_V2 *ess_v2 = NULL;
+    ASN1_STRING *value;
+    const unsigned char *const_data;
+    STACK_OF(X509) *chain;
+    cert_t *cert;
+
+    if (signature == NULL || signature->signer_info == NULL ||
+        signature->certificates == NULL)
+    {
+        return ERR_PARAMETER;
+    }
+
+    chain = sk_X509_new_null();
+    if (chain == NULL)
+        return ERR_ALLOCATION;
+
+    // the chosen signer's certificate is the first one
+    for (cert = signature->certificates; cert != NULL; cert = cert->next) {
+        if (sk_X509_push(chain, cert->x509) == 0) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+    }
+
+    value = CMS_signed_get0_data_by_OBJ(signature->signer_info,
+                                        OBJ_nid2obj(NID_id_smime_aa_signingCertificateV2),
+                                        -3, V_ASN1_SEQUENCE);
+    if (value != NULL) {
+        const_data = ASN1_STRING_get0_data(value);
+        ess_v2 = d2i_ESS_SIGNING_CERT_V2(NULL, &const_data, ASN1_STRING_length(value));
+    }
+
+    value = CMS_signed_get0_data_by_OBJ(signature->signer_info,
+                                        OBJ_nid2obj(NID_id_smime_aa_signingCertificate),
+                                        -3, V_ASN1_SEQUENCE);
+    if (value != NULL) {
+        const_data = ASN1_STRING_get0_data(value);
+        ess = d2i_ESS_SIGNING_CERT(NULL, &const_data, ASN1_STRING_length(value));
+    }
+
+    // one of the attributes is required, the present ones need to match
+    if (OSSL_ESS_check_signing_certs(ess, ess_v2, chain, 1) <= 0)
+        signature->result_cert_verification = CERT_STATUS_FAILED;
+
+end:
+    ESS_SIGNING_CERT_free(ess);
+    ESS_SIGNING_CERT_V2_free(ess_v2);
+    sk_X509_free(chain);
+
+    return err;
+}
+
+sigil_err_t cms_verify_tsa_certificate(signature_t *signature)
+{
+    if (signature == NULL || signature->certificates == NULL)
+        return ERR_PARAMETER;
+
+    // the critical extended key usage with only the timestamping
+    if (X509_check_purpose(signature->certificates->x509, X509_PURPOSE_TIMESTAMP_SIGN, 0) != 1)
+        signature->result_cert_verification = CERT_STATUS_FAILED;
+
+    return ERR_NONE;
+}
+
+/** @brief Verifies the signature value of the signer info without the signed
+ *         attributes - it is computed directly over the digest of the content
+ *
+ * @return 1 if the signature is valid, 0 otherwise
+ */
+static int verify_digest_signature(signature_t *signature)
+{
+    const ASN1_OBJECT *md_obj = NULL;
+    const EVP_MD *evp_md;
+    EVP_PKEY_CTX *ctx;
+    EVP_PKEY *pub_key;
+    ASN1_OCTET_STRING *value;
+    int valid = 0;
+
+    if (signature->certificates == NULL ||
+        (pub_key = X509_get0_pubkey(signature->certificates->x509)) == NULL ||
+        (value = CMS_SignerInfo_get0_signature(signature->signer_info)) == NULL)
+    {
+        return 0;
+    }
+
+    X509_ALGOR_get0(&md_obj, NULL, NULL, signature->digest_algorithm);
+    if ((evp_md = EVP_get_digestbyobj(md_obj)) == NULL)
+        return 0;
+
+    if ((ctx = EVP_PKEY_CTX_new(pub_key, NULL)) == NULL)
+        return 0;
+
+    if (EVP_PKEY_verify_init(ctx) == 1 &&
+        EVP_PKEY_CTX_set_signature_md(ctx, evp_md) == 1 &&
+        EVP_PKEY_verify(ctx, ASN1_STRING_get0_data(value), (size_t)ASN1_STRING_length(value),
+                        ASN1_STRING_get0_data(signature->digest_computed),
+                        (size_t)ASN1_STRING_length(signature->digest_computed)) == 1)
+    {
+        valid = 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+
+    return valid;
+}
+
+/** @brief Compares the encapsulated digest (or the message imprint of the
+ *         timestamp info) with the computed one and verifies the signer info
+ *         over the encapsulated content. The certificate of the signer is
+ *         verified separately
+ *
+ * @return ERR_NONE if success (also if the digests differ)
+ */
+static sigil_err_t verify_encapsulated_digest(signature_t *signature)
+{
+    sigil_err_t err;
+    ASN1_OCTET_STRING **content;
+    const ASN1_OCTET_STRING *original;
+
+    // the message imprint of the timestamp or the digest itself
+    if (signature->tst_info != NULL) {
+        original = TS_MSG_IMPRINT_get_msg(TS_TST_INFO_get_msg_imprint(signature->tst_info));
+    } else {
+        content = CMS_get0_content(signature->cms);
+        if (content == NULL || *content == NULL)
+            return ERR_PDF_CONTENT;
+
+        original = *content;
+    }
+
+    if (signature->digest_original != NULL)
+        ASN1_OCTET_STRING_free(signature->digest_original);
+
+    signature->digest_original = ASN1_OCTET_STRING_dup(original);
+    if (signature->digest_original == NULL)
+        return ERR_ALLOCATION;
+
+    err = compare_digest(signature);
+    if (err != ERR_NONE)
+        return err;
+
+    if (signature->result_digest_comparison == HASH_CMP_RESULT_MATCH &&
+        CMS_verify(signature->cms, NULL, NULL, NULL, NULL,
+                   CMS_BINARY | CMS_NO_SIGNER_CERT_VERIFY) != 1)
+    {
+        signature->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t cms_verify_digest(signature_t *signature)
+{
+    sigil_err_t err;
+    ASN1_OCTET_STRING *message_digest;
+
+    if (signature == NULL || signature->signer_info == NULL ||
+        signature->digest_computed == NULL)
+    {
+        return ERR_PARAMETER;
+    }
+
+    signature->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
+
+    if (CMS_is_detached(signature->cms) != 1)
+        return verify_encapsulated_digest(signature);
+
+    if (CMS_signed_get_attr_count(signature->signer_info) < 0) {
+        if (verify_digest_signature(signature))
+            signature->result_digest_comparison = HASH_CMP_RESULT_MATCH;
+
+        return ERR_NONE;
+    }
+
+    message_digest = CMS_signed_get0_data_by_OBJ(signature->signer_info,
+                                                 OBJ_nid2obj(NID_pkcs9_messageDigest),
+                                                 -3, V_ASN1_OCTET_STRING);
+    if (message_digest == NULL)
+        return ERR_PDF_CONTENT;
+
+    if (signature->digest_original != NULL)
+        ASN1_OCTET_STRING_free(signature->digest_original);
+
+    signature->digest_original = ASN1_OCTET_STRING_dup(message_digest);
+    if (signature->digest_original == NULL)
+        return ERR_ALLOCATION;
+
+    err = compare_digest(signature);
+    if (err != ERR_NONE)
+        return err;
+
+    // the signed attributes holding the digest need to be signed by the signer
+    if (signature->result_digest_comparison == HASH_CMP_RESULT_MATCH &&
+        CMS_SignerInfo_verify(signature->signer_info) != 1)
+    {
+        signature->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Loads the whole file
+ *
+ * @param path path to the file
+ * @param size output - size of the data
+ * @return allocated data or NULL
+ */
+static char *test_read_file(const char *path, size_t *size)
+{
+    FILE *file;
+    char *data = NULL;
+    long file_size;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0 ||
+        (data = malloc((size_t)file_size + 1)) == NULL ||
+        fread(data, 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+        fclose(file);
+        free(data);
+        return NULL;
+    }
+    fclose(file);
+
+    *size = (size_t)file_size;
+    data[*size] = '\0';
+
+    return data;
+}
+
+/** @brief Fills the Contents and the byte range of the only signature of the
+ *         PDF to the signature, as the signature dictionary would
+ *
+ * @param pdf the PDF data, null terminated
+ * @param size size of the PDF data
+ * @param signature output - the signature with the Contents and byte range
+ * @return 1 if success, 0 otherwise
+ */
+static int test_fill_signature(const char *pdf, size_t size, signature_t *signature)
+{
+    const char *start,
+               *end;
+    size_t range[4];
+
+    start = sigil_memmem(pdf, size, "/ByteRange [", 12);
+    if (start == NULL ||
+        sscanf(start + 12, "%zu %zu %zu %zu", &range[0], &range[1], &range[2], &range[3]) != 4 ||
+        range[1] + 1 >= range[2] || range[2] + range[3] > size)
+    {
+        return 0;
+    }
+
+    // the hexadecimal string between the ranges, without the brackets
+    start = pdf + range[1] + 1;
+    end = pdf + range[2] - 1;
+
+    if ((signature->contents = malloc(sizeof(contents_t))) == NULL)
+        return 0;
+
+    sigil_zeroize(signature->contents, sizeof(contents_t));
+
+    if ((signature->contents->contents_hex = malloc((size_t)(end - start) + 1)) == NULL)
+        return 0;
+
+    memcpy(signature->contents->contents_hex, start, (size_t)(end - start));
+    signature->contents->contents_hex[end - start] = '\0';
+    signature->contents->size = (size_t)(end - start) + 1;
+
+    if ((signature->byte_range = malloc(sizeof(range_t))) == NULL ||
+        (signature->byte_range->next = malloc(sizeof(range_t))) == NULL)
+    {
+        return 0;
+    }
+
+    signature->byte_range->start = range[0];
+    signature->byte_range->length = range[1];
+    signature->byte_range->next->start = range[2];
+    signature->byte_range->next->length = range[3];
+    signature->byte_range->next->next = NULL;
+
+    return 1;
+}
+
+int sigil_cms_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    signature_t *signature;
+    char *pdf = NULL;
+    size_t size;
+
+    print_module_name("cms", verbosity);
+
+    // TEST: fn cms_load
+    print_test_item("fn cms_load", verbosity);
+
+    {
+        const ASN1_OBJECT *md_obj = NULL;
+        char name[64];
+
+        pdf = test_read_file("test/subtype_adbe.pkcs7.detached.pdf", &size);
+        if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+            signature_add(sgl, &signature) != ERR_NONE ||
+            !test_fill_signature(pdf, size, signature) ||
+            cms_load(signature) != ERR_NONE ||
+            signature->signer_info == NULL || signature->certificates == NULL ||
+            signature->certificates->next != NULL)
+        {
+            goto failed;
+        }
+
+        X509_NAME_get_text_by_NID(X509_get_subject_name(signature->certificates->x509),
+                                  NID_commonName, name, sizeof(name));
+        X509_ALGOR_get0(&md_obj, NULL, NULL, signature->digest_algorithm);
+
+        if (strcmp(name, "pdf-sigil test signer") != 0 ||
+            OBJ_obj2nid(md_obj) != NID_sha256)
+        {
+            goto failed;
+        }
+
+        // loading again replaces the previous data
+        if (cms_load(signature) != ERR_NONE || signature->certificates->next != NULL)
+            goto failed;
+
+        // the detached content where the encapsulated digest is expected
+        signature->subfilter_type = SUBFILTER_adbe_pkcs7_sha1;
+        if (cms_load(signature) != ERR_PDF_CONTENT)
+            goto failed;
+
+        signature->subfilter_type = SUBFILTER_adbe_pkcs7_detached;
+
+        // not the signed data
+        strcpy(signature->contents->contents_hex, "3003020101");
+        if (cms_load(signature) != ERR_PDF_CONTENT)
+            goto failed;
+
+        sigil_free(&sgl);
+        free(pdf);
+        pdf = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn cms_verify_digest - with and without the signed attributes
+    print_test_item("fn cms_verify_digest", verbosity);
+
+    {
+        const char *paths[] = {
+            "test/subtype_adbe.pkcs7.detached.pdf",
+            "test/subtype_adbe.pkcs7.detached_noattr.pdf",
+            "test/subtype_adbe.pkcs7.sha1.pdf",
+            "test/subtype_ETSI.RFC3161.pdf",
+        };
+        const int subfilters[] = {
+            SUBFILTER_adbe_pkcs7_detached,
+            SUBFILTER_adbe_pkcs7_detached,
+            SUBFILTER_adbe_pkcs7_sha1,
+            SUBFILTER_ETSI_RFC3161,
+        };
+
+        for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+            pdf = test_read_file(paths[i], &size);
+            if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+                signature_add(sgl, &signature) != ERR_NONE)
+            {
+                goto failed;
+            }
+
+            signature->subfilter_type = subfilters[i];
+
+            if (!test_fill_signature(pdf, size, signature) ||
+                cms_load(signature) != ERR_NONE ||
+                compute_digest(sgl, signature) != ERR_NONE ||
+                cms_verify_digest(signature) != ERR_NONE ||
+                signature->result_digest_comparison != HASH_CMP_RESULT_MATCH)
+            {
+                goto failed;
+            }
+
+            // one byte of the signed data changed
+            pdf[10] ^= 0x01;
+
+            ASN1_OCTET_STRING_free(signature->digest_computed);
+            signature->digest_computed = NULL;
+
+            if (compute_digest(sgl, signature) != ERR_NONE ||
+                cms_verify_digest(signature) != ERR_NONE ||
+                signature->result_digest_comparison != HASH_CMP_RESULT_DIFFER)
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+            free(pdf);
+            pdf = NULL;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn cms_verify_signing_cert_binding
+    print_test_item("signing certificate binding", verbosity);
+
+    {
+        X509 *other;
+        FILE *file;
+
+        pdf = test_read_file("test/subtype_ETSI.CAdES.detached.pdf", &size);
+        if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+            signature_add(sgl, &signature) != ERR_NONE ||
+            !test_fill_signature(pdf, size, signature) ||
+            cms_load(signature) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        signature->result_cert_verification = CERT_STATUS_VERIFIED;
+
+        if (cms_verify_signing_cert_binding(signature) != ERR_NONE ||
+            signature->result_cert_verification != CERT_STATUS_VERIFIED)
+        {
+            goto failed;
+        }
+
+        // the signer's certificate replaced by another one
+        if ((file = fopen("test/test_ca.pem", "rb")) == NULL)
+            goto failed;
+
+        other = PEM_read_X509(file, NULL, NULL, NULL);
+        fclose(file);
+
+        if (other == NULL)
+            goto failed;
+
+        X509_free(signature->certificates->x509);
+        signature->certificates->x509 = other;
+
+        if (cms_verify_signing_cert_binding(signature) != ERR_NONE ||
+            signature->result_cert_verification != CERT_STATUS_FAILED)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+        free(pdf);
+        pdf = NULL;
+
+        // no signing certificate attribute at all
+        pdf = test_read_file("test/subtype_adbe.pkcs7.detached.pdf", &size);
+        if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+            signature_add(sgl, &signature) != ERR_NONE ||
+            !test_fill_signature(pdf, size, signature) ||
+            cms_load(signature) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        signature->result_cert_verification = CERT_STATUS_VERIFIED;
+
+        if (cms_verify_signing_cert_binding(signature) != ERR_NONE ||
+            signature->result_cert_verification != CERT_STATUS_FAILED)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+        free(pdf);
+        pdf = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn cms_verify_tsa_certificate
+    print_test_item("fn cms_verify_tsa_certificate", verbosity);
+
+    {
+        const char *paths[] = {
+            "test/subtype_ETSI.RFC3161.pdf",
+            "test/subtype_adbe.pkcs7.detached.pdf",
+        };
+        const int subfilters[] = { SUBFILTER_ETSI_RFC3161, SUBFILTER_adbe_pkcs7_detached };
+        const int expected[] = { CERT_STATUS_VERIFIED, CERT_STATUS_FAILED };
+
+        for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+            pdf = test_read_file(paths[i], &size);
+            if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+                signature_add(sgl, &signature) != ERR_NONE)
+            {
+                goto failed;
+            }
+
+            signature->subfilter_type = subfilters[i];
+            signature->result_cert_verification = CERT_STATUS_VERIFIED;
+
+            if (!test_fill_signature(pdf, size, signature) ||
+                cms_load(signature) != ERR_NONE ||
+                (signature->tst_info != NULL) != (i == 0) ||
+                cms_verify_tsa_certificate(signature) != ERR_NONE ||
+                signature->result_cert_verification != expected[i])
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+            free(pdf);
+            pdf = NULL;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    sigil_free(&sgl);
+    free(pdf);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -29,6 +29,119 @@ int sigil_config_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: XREF_EXTRA_PREALLOCATION
+    print_test_item("XREF_EXTRA_PREALLOCATION", verbosity);
+
+    if (XREF_EXTRA_PREALLOCATION < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: XREF_SUBSECTION_PREALLOCATION
+    print_test_item("XREF_SUBSECTION_PREALLOCATION", verbosity);
+
+    if (XREF_SUBSECTION_PREALLOCATION < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: XREF_DECODE_CHUNK
+    print_test_item("XREF_DECODE_CHUNK", verbosity);
+
+    if (XREF_DECODE_CHUNK < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: MAX_THREAD_COUNT
+    print_test_item("MAX_THREAD_COUNT", verbosity);
+
+    if (MAX_THREAD_COUNT < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: STREAM_CHUNK_SIZE
+    print_test_item("STREAM_CHUNK_SIZE", verbosity);
+
+    if (STREAM_CHUNK_SIZE < 64)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: STREAM_ROW_MAX
+    print_test_item("STREAM_ROW_MAX", verbosity);
+
+    if (STREAM_ROW_MAX < 64)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: OBJSTM_CACHE_SIZE
+    print_test_item("OBJSTM_CACHE_SIZE", verbosity);
+
+    if (OBJSTM_CACHE_SIZE < 2)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: OBJSTM_SIZE_MAX
+    print_test_item("OBJSTM_SIZE_MAX", verbosity);
+
+    // the offset inside of the stream has 32 bits in the position
+    if (OBJSTM_SIZE_MAX < STREAM_CHUNK_SIZE || OBJSTM_SIZE_MAX > 0xffffffffUL)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: RECONSTRUCT_CHUNK_SIZE
+    print_test_item("RECONSTRUCT_CHUNK_SIZE", verbosity);
+
+    if (RECONSTRUCT_CHUNK_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: SIDECAR_TAIL_SIZE
+    print_test_item("SIDECAR_TAIL_SIZE", verbosity);
+
+    if (SIDECAR_TAIL_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: TSA_CACHE_SIZE
+    print_test_item("TSA_CACHE_SIZE", verbosity);
+
+    if (TSA_CACHE_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: DSS_OBJECT_SIZE_MAX
+    print_test_item("DSS_OBJECT_SIZE_MAX", verbosity);
+
+    if (DSS_OBJECT_SIZE_MAX < STREAM_CHUNK_SIZE)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: DSS_CACHE_SIZE
+    print_test_item("DSS_CACHE_SIZE", verbosity);
+
+    if (DSS_CACHE_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: DSS_REFS_PREALLOCATION
+    print_test_item("DSS_REFS_PREALLOCATION", verbosity);
+
+    if (DSS_REFS_PREALLOCATION < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
     // TEST: REF_ARRAY_PREALLOCATION
     print_test_item("REF_ARRAY_PREALLOCATION", verbosity);
 
@@ -37,6 +150,33 @@ int sigil_config_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: SIGNATURE_PREALLOCATION
+    print_test_item("SIGNATURE_PREALLOCATION", verbosity);
+
+    if (SIGNATURE_PREALLOCATION < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: NUMBER_SET_PREALLOCATION
+    print_test_item("NUMBER_SET_PREALLOCATION", verbosity);
+
+    if (NUMBER_SET_PREALLOCATION < 1 ||
+        (NUMBER_SET_PREALLOCATION & (NUMBER_SET_PREALLOCATION - 1)) != 0)
+    {
+        goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: FIELD_TREE_PREALLOCATION
+    print_test_item("FIELD_TREE_PREALLOCATION", verbosity);
+
+    if (FIELD_TREE_PREALLOCATION < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
     // TEST: CERT_HEX_PREALLOCATION
     print_test_item("CERT_HEX_PREALLOCATION", verbosity);
 
@@ -61,18 +201,42 @@ int sigil_config_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
-    // TEST: MAX_FILE_UPDATES
-    print_test_item("MAX_FILE_UPDATES", verbosity);
+    // TEST: HASH_UPDATE_SIZE
+    print_test_item("HASH_UPDATE_SIZE", verbosity);
 
-    if (MAX_FILE_UPDATES < 1)
+    if (HASH_UPDATE_SIZE < 1)
         goto failed;
 
     print_test_result(1, verbosity);
 
-    // TEST: HASH_UPDATE_SIZE
-    print_test_item("HASH_UPDATE_SIZE", verbosity);
+    // TEST: HASH_SPAN_SIZE
+    print_test_item("HASH_SPAN_SIZE", verbosity);
 
-    if (HASH_UPDATE_SIZE < 1)
+    if (HASH_SPAN_SIZE < HASH_UPDATE_SIZE)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: READER_BUFFER_SIZE
+    print_test_item("READER_BUFFER_SIZE", verbosity);
+
+    if (READER_BUFFER_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: READER_BUFFER_COUNT
+    print_test_item("READER_BUFFER_COUNT", verbosity);
+
+    if (READER_BUFFER_COUNT < 2)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: SCAN_CHUNK_SIZE
+    print_test_item("SCAN_CHUNK_SIZE", verbosity);
+
+    if (SCAN_CHUNK_SIZE < 64)
         goto failed;
 
     print_test_result(1, verbosity);
@@ -9,32 +9,34 @@
 #include "sigil.h"
 
 
-sigil_err_t parse_contents(sigil_t *sgl)
+sigil_err_t parse_contents(sigil_t *sgl, contents_t **contents)
 {
     sigil_err_t err;
     char **data;
     char c;
     size_t position;
 
-    if (sgl == NULL)
+    if (sgl == NULL || contents == NULL)
         return ERR_PARAMETER;
 
     if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
         return err;
 
-    if (sgl->contents != NULL)
-        contents_free(sgl);
+    if (*contents != NULL) {
+        contents_free(*contents);
+        *contents = NULL;
+    }
 
     if ((err = skip_word(sgl, "<")) != ERR_NONE)
         return err;
 
-    sgl->contents = malloc(sizeof(*(sgl->contents)));
-    if (sgl->contents == NULL)
+    *contents = malloc(sizeof(**contents));
+    if (*contents == NULL)
         return ERR_ALLOCATION;
 
-    sigil_zeroize(sgl->contents, sizeof(*(sgl->contents)));
+    sigil_zeroize(*contents, sizeof(**contents));
 
-    data = &(sgl->contents->contents_hex);
+    data = &((*contents)->contents_hex);
 
     *data = malloc(sizeof(**data) * CONTENTS_PREALLOCATION);
     if (*data == NULL)
@@ -42,7 +44,7 @@ sigil_err_t parse_contents(sigil_t *sgl)
 
     sigil_zeroize(*data, sizeof(**data) * CONTENTS_PREALLOCATION);
 
-    sgl->contents->size = CONTENTS_PREALLOCATION;
+    (*contents)->size = CONTENTS_PREALLOCATION;
 
     position = 0;
 
@@ -51,15 +53,15 @@ sigil_err_t parse_contents(sigil_t *sgl)
             return err;
 
         // not enough space, allocate double
-        if (position >= sgl->contents->size) {
-            *data = realloc(*data, sizeof(**data) * sgl->contents->size * 2);
+        if (position >= (*contents)->size) {
+            *data = realloc(*data, sizeof(**data) * (*contents)->size * 2);
             if (*data == NULL)
                 return ERR_ALLOCATION;
 
-            sigil_zeroize(*data + sgl->contents->size,
-                          sizeof(**data) * sgl->contents->size);
+            sigil_zeroize(*data + (*contents)->size,
+                          sizeof(**data) * (*contents)->size);
 
-            sgl->contents->size *= 2;
+            (*contents)->size *= 2;
         }
 
         if (c == '>') {
@@ -73,20 +75,19 @@ sigil_err_t parse_contents(sigil_t *sgl)
     }
 }
 
-void contents_free(sigil_t *sgl)
+void contents_free(contents_t *contents)
 {
-    if (sgl == NULL || sgl->contents == NULL)
+    if (contents == NULL)
         return;
 
-    if (sgl->contents->contents_hex != NULL) {
-        sigil_zeroize(sgl->contents->contents_hex,
-                      sizeof(*sgl->contents->contents_hex) * sgl->contents->size);
-        free(sgl->contents->contents_hex);
+    if (contents->contents_hex != NULL) {
+        sigil_zeroize(contents->contents_hex,
+                      sizeof(*contents->contents_hex) * contents->size);
+        free(contents->contents_hex);
     }
 
-    sigil_zeroize(sgl->contents, sizeof(*sgl->contents));
-    free(sgl->contents);
-    sgl->contents = NULL;
+    sigil_zeroize(contents, sizeof(*contents));
+    free(contents);
 }
 
 int sigil_contents_self_test(int verbosity)
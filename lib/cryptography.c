@@ -1,6 +1,7 @@
 #include <openssl/asn1.h>
 #include <openssl/evp.h>
 #include <openssl/x509.h>
+#include <openssl/x509v3.h>
 #include <types.h>
 #include <string.h>
 #include <sigil.h>
@@ -8,75 +9,351 @@
 #include "config.h"
 #include "constants.h"
 #include "cryptography.h"
+#include "dss.h"
+#include "reader.h"
+#include "signature.h"
 #include "types.h"
 
 
-/** @brief Converts hexadecimal characters to the decimal value. Operates with
- *         characters both on input and output, 2 chars on the input produces
- *         1 char on the output
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define HEX_TO_DEC_SSE2
+#endif
+
+#define HEX_INVALID      0
+#define HEX_WHITESPACE   17
+#define HEX_BLOCK_SIZE   32
+
+/** @brief Lookup table for the hexadecimal decoding. Holds the value of the
+ *         hexadecimal digit increased by one, HEX_WHITESPACE for the characters
+ *         allowed between digits and HEX_INVALID for everything else
  *
- * @param in input - hexadecimal characters
- * @param in_len length of the input
- * @param out output buffer
- * @param out_len length of the output written (without the terminating null)
- * @return ERR_NONE if success
  */
-static sigil_err_t hex_to_dec(const char *in, size_t in_len, unsigned char *out, size_t *out_len)
+static const unsigned char hex_table[256] = {
+    [0x00] = HEX_WHITESPACE, [0x09] = HEX_WHITESPACE, [0x0a] = HEX_WHITESPACE,
+    [0x0c] = HEX_WHITESPACE, [0x0d] = HEX_WHITESPACE, [0x20] = HEX_WHITESPACE,
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+    ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
+
+#ifdef HEX_TO_DEC_SSE2
+/** @brief Decodes 16 hexadecimal characters into 8 bytes stored in the lower
+ *         halves of 16-bit lanes
+ *
+ * @param in input - exactly 16 characters
+ * @param valid output - 0xffff if all the characters were hexadecimal digits
+ * @return decoded lanes
+ */
+static __m128i hex_decode_16(const char *in, int *valid)
 {
-    int first,
-        second;
+    __m128i chars,
+            digit,
+            letter,
+            is_digit,
+            is_letter,
+            nibbles;
+
+    chars = _mm_loadu_si128((const __m128i *)in);
+
+    // unsigned comparison x <= n done as min(x, n) == x
+    digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
 
-    if (in == NULL || (in_len % 2) != 0 || out == NULL || out_len == NULL)
+    letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                          _mm_set1_epi8('a'));
+    is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    letter = _mm_add_epi8(letter, _mm_set1_epi8(10));
+
+    *valid = _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter));
+
+    nibbles = _mm_or_si128(_mm_and_si128(digit, is_digit),
+                           _mm_and_si128(letter, is_letter));
+
+    // lane = first | second << 8  ->  first << 4 | second
+    return _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4),
+        _mm_srli_epi16(nibbles, 8));
+}
+
+/** @brief Decodes HEX_BLOCK_SIZE hexadecimal characters at once
+ *
+ * @param in input - HEX_BLOCK_SIZE characters
+ * @param out output - HEX_BLOCK_SIZE / 2 bytes
+ * @return 1 if decoded, 0 if the block contains other characters than
+ *         hexadecimal digits (nothing is written to the output)
+ */
+static int hex_decode_block(const char *in, unsigned char *out)
+{
+    __m128i low,
+            high;
+    int valid_low,
+        valid_high;
+
+    low = hex_decode_16(in, &valid_low);
+    high = hex_decode_16(in + 16, &valid_high);
+
+    if ((valid_low & valid_high) != 0xffff)
+        return 0;
+
+    _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(low, high));
+
+    return 1;
+}
+#endif /* HEX_TO_DEC_SSE2 */
+
+sigil_err_t sigil_hex_to_dec(const char *in, size_t in_len, unsigned char *out, size_t *out_len)
+{
+    unsigned char value,
+                  first = 0;
+    int half = 0;
+    size_t pos,
+           limit;
+
+    if (in == NULL || out == NULL || out_len == NULL)
         return ERR_PARAMETER;
 
     *out_len = 0;
-
-    for (size_t i = 0; i < in_len; i += 2) {
-        if (is_digit(in[i])) {
-            first = (in[i] - '0') << 4;
-        } else if (in[i] >= 'A' && in[i] <= 'F') {
-            first = (in[i] - 55) << 4;
-        } else if (in[i] >= 'a' && in[i] <= 'f') {
-            first = (in[i] - 87) << 4;
-        } else {
-            return ERR_PDF_CONTENT;
+    pos = 0;
+
+    while (pos < in_len) {
+        limit = in_len;
+
+        #ifdef HEX_TO_DEC_SSE2
+            // odd number of digits so far, the pair straddling the end of the
+            // slow run is completed char by char, then the blocks follow again
+            if (half) {
+                limit = pos + 1;
+            } else if (in_len - pos >= HEX_BLOCK_SIZE) {
+                if (hex_decode_block(in + pos, out + *out_len)) {
+                    pos += HEX_BLOCK_SIZE;
+                    *out_len += HEX_BLOCK_SIZE / 2;
+                    continue;
+                }
+
+                // whitespace or invalid character inside, go through it slowly
+                limit = pos + HEX_BLOCK_SIZE;
+            }
+        #endif
+
+        for (; pos < limit; pos++) {
+            value = hex_table[(unsigned char)in[pos]];
+
+            if (value == HEX_WHITESPACE)
+                continue;
+            if (value == HEX_INVALID)
+                return ERR_PDF_CONTENT;
+
+            if (half) {
+                out[(*out_len)++] = (unsigned char)(first | (value - 1));
+                half = 0;
+            } else {
+                first = (unsigned char)((value - 1) << 4);
+                half = 1;
+            }
         }
+    }
 
-        if (is_digit(in[i + 1])) {
-            second = in[i + 1] - '0';
-        } else if (in[i + 1] >= 'A' && in[i + 1] <= 'F') {
-            second = in[i + 1] - 55;
-        } else if (in[i + 1] >= 'a' && in[i + 1] <= 'f') {
-            second = in[i + 1] - 87;
-        } else {
-            return ERR_PDF_CONTENT;
+    // odd number of digits, the missing one is considered to be 0
+    if (half)
+        out[(*out_len)++] = first;
+
+    out[*out_len] = '\0';
+
+    return ERR_NONE;
+}
+
+/** @brief Selects the message digest of the signature by its digest algorithm,
+ *         only the allowed algorithms are accepted
+ *
+ * @param signature the signature with the digest algorithm loaded
+ * @param evp_md output - the message digest
+ * @return ERR_NONE if success
+ */
+static sigil_err_t select_digest(signature_t *signature, const EVP_MD **evp_md)
+{
+    const ASN1_OBJECT *md_obj = NULL;
+
+    if (signature->digest_algorithm == NULL)
+        return ERR_PARAMETER;
+
+    X509_ALGOR_get0(&md_obj, NULL, NULL, signature->digest_algorithm);
+    *evp_md = EVP_get_digestbyobj(md_obj);
+    if (*evp_md == NULL)
+        return ERR_OPENSSL;
+
+    // only allowed algorithms
+    switch (EVP_MD_type(*evp_md)) {
+        case NID_sha1:
+            signature->hash_fn = HASH_FN_sha1;
+            break;
+        case NID_sha256:
+            signature->hash_fn = HASH_FN_sha256;
+            break;
+        case NID_sha384:
+            signature->hash_fn = HASH_FN_sha384;
+            break;
+        case NID_sha512:
+            signature->hash_fn = HASH_FN_sha512;
+            break;
+        case NID_ripemd160:
+            signature->hash_fn = HASH_FN_ripemd160;
+            break;
+        default:
+            return ERR_DIGEST_TYPE;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Finishes the digest context and stores the result as the computed
+ *         digest of the signature
+ *
+ * @param signature the signature
+ * @param ctx digest context with all the data of the byte range
+ * @return ERR_NONE if success
+ */
+static sigil_err_t store_digest(signature_t *signature, EVP_MD_CTX *ctx)
+{
+    unsigned char tmp_hash[EVP_MAX_MD_SIZE];
+    unsigned int tmp_hash_len;
+
+    // process last pieces of data from context
+    if (EVP_DigestFinal_ex(ctx, tmp_hash, &tmp_hash_len) != 1)
+        return ERR_OPENSSL;
+
+    if (signature->digest_computed != NULL)
+        ASN1_OCTET_STRING_free(signature->digest_computed);
+
+    signature->digest_computed = ASN1_OCTET_STRING_new();
+    if (signature->digest_computed == NULL)
+        return ERR_ALLOCATION;
+
+    if (ASN1_OCTET_STRING_set(signature->digest_computed, tmp_hash, tmp_hash_len) == 0)
+        return ERR_OPENSSL;
+
+    return ERR_NONE;
+}
+
+/** @brief Feeds the part of the PDF data to all the digest contexts. The data
+ *         in memory are passed directly in the slices of HASH_SPAN_SIZE bytes,
+ *         still hot in the cache for the other contexts. The data of the file
+ *         are taken from the reading thread if there is one, otherwise the
+ *         file is read in chunks
+ *
+ * @param sgl context
+ * @param reader the reading thread of the ranges of the caller or NULL
+ * @param ctxs the digest contexts
+ * @param ctx_count number of the digest contexts
+ * @param start position of the data
+ * @param length length of the data
+ * @param update_data buffer of HASH_UPDATE_SIZE + 1 bytes for the file reading
+ * @return ERR_NONE if success
+ */
+static sigil_err_t update_digests(sigil_t *sgl, reader_t *reader, EVP_MD_CTX **ctxs,
+                                  size_t ctx_count, size_t start, size_t length,
+                                  char *update_data)
+{
+    sigil_err_t err;
+    const char *data;
+    size_t current_length;
+    size_t read_size;
+
+    if (sgl->pdf_data.buffer != NULL) {
+        while (length > 0) {
+            err = pdf_span(sgl, start, MIN(HASH_SPAN_SIZE, length), &data, &read_size);
+            if (err == ERR_NO_DATA)
+                return ERR_IO;
+            if (err != ERR_NONE)
+                return err;
+
+            for (size_t i = 0; i < ctx_count; i++) {
+                if (EVP_DigestUpdate(ctxs[i], data, read_size) != 1)
+                    return ERR_OPENSSL;
+            }
+
+            start += read_size;
+            length -= read_size;
         }
 
-        out[*out_len] = (unsigned char)(first + second);
+        return ERR_NONE;
+    }
+
+    // the chunks never cross the end of the range being hashed
+    if (reader != NULL) {
+        while (length > 0) {
+            err = reader_next(reader, &data, &read_size);
+            if (err == ERR_NO_DATA || (err == ERR_NONE && read_size > length))
+                return ERR_IO;
+            if (err != ERR_NONE)
+                return err;
+
+            for (size_t i = 0; i < ctx_count; i++) {
+                if (EVP_DigestUpdate(ctxs[i], data, read_size) != 1)
+                    return ERR_OPENSSL;
+            }
 
-        (*out_len)++;
+            length -= read_size;
+        }
+
+        return ERR_NONE;
     }
 
-    out[*out_len] = '\0';
+    err = pdf_move_pos_abs(sgl, start);
+    if (err != ERR_NONE)
+        return err;
+
+    while (length > 0) {
+        current_length = MIN(HASH_UPDATE_SIZE, length);
+
+        err = pdf_read(sgl, current_length, update_data, &read_size);
+        if (err != ERR_NONE)
+            return err;
+        if (current_length != read_size)
+            return ERR_IO;
+
+        for (size_t i = 0; i < ctx_count; i++) {
+            if (EVP_DigestUpdate(ctxs[i], update_data, current_length) != 1)
+                return ERR_OPENSSL;
+        }
+
+        length -= current_length;
+    }
 
     return ERR_NONE;
 }
 
-sigil_err_t compute_digest_pkcs1(sigil_t *sgl)
+/** @brief Starts the reading thread of the ranges if the data are only in the
+ *         file and more threads are allowed, the blocking reads then overlap
+ *         with the hashing
+ *
+ * @param sgl context
+ * @param ranges the ranges in the order they will be hashed
+ * @param reader output - the started reader or NULL
+ * @return ERR_NONE if success
+ */
+static sigil_err_t start_reader(sigil_t *sgl, const range_t *ranges, reader_t **reader)
+{
+    *reader = NULL;
+
+    if (sgl->pdf_data.buffer != NULL || sgl->thread_count < 2 || ranges == NULL)
+        return ERR_NONE;
+
+    return reader_start(sgl, ranges, reader);
+}
+
+sigil_err_t compute_digest(sigil_t *sgl, signature_t *signature)
 {
     sigil_err_t err;
     char *update_data = NULL;
     EVP_MD_CTX *ctx = NULL;
     const EVP_MD *evp_md;
-    const ASN1_OBJECT *md_obj = NULL;
+    reader_t *reader = NULL;
     range_t *range;
-    size_t bytes_left;
-    size_t current_length;
-    size_t read_size;
-    unsigned char tmp_hash[EVP_MAX_MD_SIZE];
-    unsigned int tmp_hash_len;
 
-    if (sgl == NULL || sgl->byte_range == NULL)
+    if (sgl == NULL || signature == NULL || signature->byte_range == NULL)
         return ERR_PARAMETER;
 
     update_data = malloc(sizeof(*update_data) * (HASH_UPDATE_SIZE + 1));
@@ -88,96 +365,442 @@ sigil_err_t compute_digest_pkcs1(sigil_t *sgl)
     sigil_zeroize(update_data, sizeof(*update_data) * (HASH_UPDATE_SIZE + 1));
 
     // initialize digest context
-    if ((ctx = EVP_MD_CTX_create()) == NULL)
-        return ERR_ALLOCATION;
-
-    X509_ALGOR_get0(&md_obj, NULL, NULL, sgl->digest_algorithm);
-    evp_md = EVP_get_digestbyobj(md_obj);
-    if (evp_md == NULL) {
-        err = ERR_OPENSSL;
+    if ((ctx = EVP_MD_CTX_create()) == NULL) {
+        err = ERR_ALLOCATION;
         goto end;
     }
 
-    // only allowed algorithms
-    switch (EVP_MD_type(evp_md)) {
-        case NID_sha1:
-            sgl->hash_fn = HASH_FN_sha1;
-            break;
-        case NID_sha256:
-            sgl->hash_fn = HASH_FN_sha256;
-            break;
-        case NID_sha384:
-            sgl->hash_fn = HASH_FN_sha384;
-            break;
-        case NID_sha512:
-            sgl->hash_fn = HASH_FN_sha512;
-            break;
-        case NID_ripemd160:
-            sgl->hash_fn = HASH_FN_ripemd160;
-            break;
-        default:
-            err = ERR_DIGEST_TYPE;
-            goto end;
-    }
+    err = select_digest(signature, &evp_md);
+    if (err != ERR_NONE)
+        goto end;
 
     if (EVP_DigestInit_ex(ctx, evp_md, NULL) != 1) {
         err = ERR_OPENSSL;
         goto end;
     }
 
-    range = sgl->byte_range;
+    err = start_reader(sgl, signature->byte_range, &reader);
+    if (err != ERR_NONE)
+        goto end;
+
+    range = signature->byte_range;
 
     while (range != NULL) {
-        err = pdf_move_pos_abs(sgl, range->start);
+        err = update_digests(sgl, reader, &ctx, 1, range->start, range->length,
+                             update_data);
         if (err != ERR_NONE)
-            return err;
+            goto end;
 
-        bytes_left = range->length;
+        range = range->next;
+    }
 
-        while (bytes_left > 0) {
-            current_length = MIN(HASH_UPDATE_SIZE, bytes_left);
+    err = store_digest(signature, ctx);
 
-            err = pdf_read(sgl, current_length, update_data, &read_size);
-            if (err != ERR_NONE)
-                return err;
-            if (current_length != read_size)
-                return ERR_IO;
+end:
+    reader_stop(&reader);
+    if (update_data != NULL)
+        free(update_data);
+    if (ctx != NULL)
+        EVP_MD_CTX_destroy(ctx);
 
-            if (EVP_DigestUpdate(ctx, update_data, current_length) != 1) {
-                err = ERR_OPENSSL;
-                goto end;
+    return err;
+}
+
+/** @brief Digest context shared by the signatures with the same algorithm
+ *         whose byte ranges begin at the start of the file - the data
+ *         covered by the nested first ranges are hashed only once
+ *
+ */
+typedef struct {
+    const EVP_MD *evp_md;
+    EVP_MD_CTX   *ctx;
+    size_t        end;
+} digest_trunk_t;
+
+/** @brief Digest context of one signature in the single pass. Until the
+ *         position of the fork it is represented by its trunk, then it
+ *         continues from the copy of the trunk's state
+ *
+ */
+typedef struct {
+    signature_t    *signature;
+    EVP_MD_CTX     *ctx;
+    digest_trunk_t *trunk;
+    size_t          fork;
+    const range_t  *range;
+} digest_branch_t;
+
+static int compare_positions(const void *a, const void *b)
+{
+    size_t first = *(const size_t *)a,
+           second = *(const size_t *)b;
+
+    return (first > second) - (first < second);
+}
+
+/** @brief Checks that the byte ranges can be hashed in one pass through the
+ *         file - they go forward and do not overlap
+ *
+ * @param range the first of the byte ranges
+ * @return 1 if they can, 0 otherwise
+ */
+static int ranges_ascending(const range_t *range)
+{
+    if (range == NULL)
+        return 0;
+
+    for (; range->next != NULL; range = range->next) {
+        if (range->next->start < range->start + range->length)
+            return 0;
+    }
+
+    return 1;
+}
+
+/** @brief Checks that the byte ranges lie inside of the PDF data, without
+ *         overflowing on the unreasonable values
+ *
+ * @param sgl context
+ * @param range the first of the byte ranges
+ * @return 1 if they do, 0 otherwise
+ */
+static int ranges_in_pdf(const sigil_t *sgl, const range_t *range)
+{
+    size_t available = 0;
+
+    if (sgl->pdf_data.size > sgl->offset_pdf_start)
+        available = sgl->pdf_data.size - sgl->offset_pdf_start;
+
+    for (; range != NULL; range = range->next) {
+        if (range->start > available || range->length > available - range->start)
+            return 0;
+    }
+
+    return 1;
+}
+
+/** @brief Adds the signature to the plan of the single pass - it gets its own
+ *         digest context and either joins the trunk of its algorithm with the
+ *         first range beginning at the start of the file, or is hashed on its
+ *         own from the beginning
+ *
+ * @param signature the signature
+ * @param evp_md the message digest of the signature
+ * @param trunks the trunks of the plan
+ * @param trunk_count number of the trunks, updated if a trunk is added
+ * @param branch output - the planned signature
+ * @return ERR_NONE if success
+ */
+static sigil_err_t plan_branch(signature_t *signature, const EVP_MD *evp_md,
+                               digest_trunk_t *trunks, size_t *trunk_count,
+                               digest_branch_t *branch)
+{
+    const range_t *first = signature->byte_range;
+    digest_trunk_t *trunk = NULL;
+
+    branch->signature = signature;
+    branch->trunk = NULL;
+    branch->fork = 0;
+    branch->range = first;
+
+    if ((branch->ctx = EVP_MD_CTX_create()) == NULL)
+        return ERR_ALLOCATION;
+
+    if (first->start != 0 || first->length == 0) {
+        if (EVP_DigestInit_ex(branch->ctx, evp_md, NULL) != 1)
+            return ERR_OPENSSL;
+
+        return ERR_NONE;
+    }
+
+    for (size_t i = 0; i < *trunk_count; i++) {
+        if (EVP_MD_type(trunks[i].evp_md) == EVP_MD_type(evp_md))
+            trunk = &(trunks[i]);
+    }
+
+    if (trunk == NULL) {
+        trunk = &(trunks[*trunk_count]);
+        trunk->evp_md = evp_md;
+        trunk->end = 0;
+
+        if ((trunk->ctx = EVP_MD_CTX_create()) == NULL)
+            return ERR_ALLOCATION;
+
+        (*trunk_count)++;
+
+        if (EVP_DigestInit_ex(trunk->ctx, evp_md, NULL) != 1)
+            return ERR_OPENSSL;
+    }
+
+    trunk->end = MAX(trunk->end, first->length);
+
+    branch->trunk = trunk;
+    branch->fork = first->length;
+    branch->range = first->next;
+
+    return ERR_NONE;
+}
+
+/** @brief Checks whether the segment between two planned positions is covered
+ *         by some range of the planned signatures, the segments never cross
+ *         the boundaries of the ranges
+ *
+ * @param branches the planned signatures
+ * @param branch_count number of the planned signatures
+ * @param start start of the segment
+ * @param end end of the segment
+ * @return 1 if it is covered, 0 otherwise
+ */
+static int segment_covered(const digest_branch_t *branches, size_t branch_count,
+                           size_t start, size_t end)
+{
+    const range_t *range;
+
+    for (size_t i = 0; i < branch_count; i++) {
+        for (range = branches[i].signature->byte_range; range != NULL; range = range->next) {
+            if (range->start <= start && range->start + range->length >= end)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/** @brief Reads the data between the planned positions once in the order of
+ *         the file. Every segment is fed to the trunks still covering it and
+ *         to the forked branches whose current range covers it, a branch
+ *         leaves its trunk by copying the trunk's state at the end of its
+ *         first range
+ *
+ * @param sgl context
+ * @param trunks the trunks of the plan
+ * @param trunk_count number of the trunks
+ * @param branches the planned signatures
+ * @param branch_count number of the planned signatures
+ * @param positions the sorted unique boundaries of all the ranges
+ * @param position_count number of the boundaries
+ * @return ERR_NONE if success
+ */
+static sigil_err_t run_digest_plan(sigil_t *sgl, digest_trunk_t *trunks, size_t trunk_count,
+                                   digest_branch_t *branches, size_t branch_count,
+                                   const size_t *positions, size_t position_count)
+{
+    sigil_err_t err;
+    EVP_MD_CTX **active = NULL;
+    char *update_data = NULL;
+    range_t *reads = NULL;
+    reader_t *reader = NULL;
+    digest_branch_t *branch;
+    size_t active_count,
+           read_count = 0,
+           start,
+           end;
+
+    active = malloc(sizeof(*active) * (trunk_count + branch_count));
+    update_data = malloc(sizeof(*update_data) * (HASH_UPDATE_SIZE + 1));
+    reads = malloc(sizeof(*reads) * (position_count + 1));
+    if (active == NULL || update_data == NULL || reads == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    // the segments read by the pass are known in advance for the reading
+    // thread, they are the ones covered by some range of the signatures
+    for (size_t k = 0; k + 1 < position_count; k++) {
+        if (!segment_covered(branches, branch_count, positions[k], positions[k + 1]))
+            continue;
+
+        reads[read_count].start = positions[k];
+        reads[read_count].length = positions[k + 1] - positions[k];
+        reads[read_count].next = NULL;
+        if (read_count > 0)
+            reads[read_count - 1].next = &(reads[read_count]);
+        read_count++;
+    }
+
+    err = start_reader(sgl, (read_count > 0) ? reads : NULL, &reader);
+    if (err != ERR_NONE)
+        goto end;
+
+    for (size_t k = 0; k < position_count; k++) {
+        start = positions[k];
+
+        for (size_t i = 0; i < branch_count; i++) {
+            branch = &(branches[i]);
+
+            if (branch->trunk != NULL && branch->fork == start) {
+                if (EVP_MD_CTX_copy_ex(branch->ctx, branch->trunk->ctx) != 1) {
+                    err = ERR_OPENSSL;
+                    goto end;
+                }
+                branch->trunk = NULL;
             }
+        }
 
-            bytes_left -= current_length;
+        if (k + 1 == position_count)
+            break;
+
+        end = positions[k + 1];
+        active_count = 0;
+
+        for (size_t i = 0; i < trunk_count; i++) {
+            if (trunks[i].end > start)
+                active[active_count++] = trunks[i].ctx;
         }
 
-        range = range->next;
+        for (size_t i = 0; i < branch_count; i++) {
+            branch = &(branches[i]);
+
+            if (branch->trunk == NULL && branch->range != NULL &&
+                branch->range->start <= start &&
+                branch->range->start + branch->range->length >= end)
+            {
+                active[active_count++] = branch->ctx;
+            }
+        }
+
+        // gaps between the ranges, e.g. the Contents, are not read at all
+        if (active_count > 0) {
+            err = update_digests(sgl, reader, active, active_count, start, end - start,
+                                 update_data);
+            if (err != ERR_NONE)
+                goto end;
+        }
+
+        for (size_t i = 0; i < branch_count; i++) {
+            branch = &(branches[i]);
+
+            while (branch->trunk == NULL && branch->range != NULL &&
+                   branch->range->start + branch->range->length <= end)
+            {
+                branch->range = branch->range->next;
+            }
+        }
     }
 
-    // process last pieces of data from context
-    if (EVP_DigestFinal_ex(ctx, tmp_hash, &tmp_hash_len) != 1) {
-        err = ERR_OPENSSL;
+    err = ERR_NONE;
+
+end:
+    reader_stop(&reader);
+    free(active);
+    free(update_data);
+    free(reads);
+
+    return err;
+}
+
+sigil_err_t compute_digests(sigil_t *sgl)
+{
+    sigil_err_t err;
+    signature_t *signature;
+    const EVP_MD *evp_md;
+    digest_trunk_t *trunks = NULL;
+    digest_branch_t *branches = NULL;
+    size_t *positions = NULL;
+    size_t trunk_count = 0,
+           branch_count = 0,
+           position_count = 0,
+           unique_count = 0;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->signature_count == 0)
+        return ERR_NONE;
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        for (const range_t *range = sgl->signatures[i].byte_range; range != NULL; range = range->next)
+            position_count += 2;
+    }
+
+    trunks = malloc(sizeof(*trunks) * sgl->signature_count);
+    branches = malloc(sizeof(*branches) * sgl->signature_count);
+    positions = malloc(sizeof(*positions) * (position_count + 1));
+    if (trunks == NULL || branches == NULL || positions == NULL) {
+        err = ERR_ALLOCATION;
         goto end;
     }
 
-    sgl->digest_computed = ASN1_OCTET_STRING_new();
-    if (ASN1_OCTET_STRING_set(sgl->digest_computed, tmp_hash, tmp_hash_len) == 0) {
-        err = ERR_OPENSSL;
+    position_count = 0;
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        signature = &(sgl->signatures[i]);
+
+        if (signature->error != ERR_NONE)
+            continue;
+
+        // the unusual ranges are hashed separately, the error of the range
+        // outside of the PDF stays only with its signature
+        if (!ranges_in_pdf(sgl, signature->byte_range) ||
+            !ranges_ascending(signature->byte_range))
+        {
+            signature->error = compute_digest(sgl, signature);
+            if (signature->error == ERR_ALLOCATION) {
+                err = ERR_ALLOCATION;
+                goto end;
+            }
+            continue;
+        }
+
+        signature->error = select_digest(signature, &evp_md);
+        if (signature->error != ERR_NONE)
+            continue;
+
+        err = plan_branch(signature, evp_md, trunks, &trunk_count,
+                          &(branches[branch_count]));
+        branch_count++;
+        if (err != ERR_NONE)
+            goto end;
+
+        for (const range_t *range = signature->byte_range; range != NULL; range = range->next) {
+            positions[position_count++] = range->start;
+            positions[position_count++] = range->start + range->length;
+        }
+    }
+
+    qsort(positions, position_count, sizeof(*positions), compare_positions);
+
+    for (size_t i = 0; i < position_count; i++) {
+        if (unique_count == 0 || positions[unique_count - 1] != positions[i])
+            positions[unique_count++] = positions[i];
+    }
+
+    err = run_digest_plan(sgl, trunks, trunk_count, branches, branch_count,
+                          positions, unique_count);
+    if (err == ERR_ALLOCATION)
         goto end;
+
+    // after the failed pass, each signature is hashed again on its own so
+    // that only the one with the unreadable data fails
+    for (size_t i = 0; i < branch_count; i++) {
+        signature = branches[i].signature;
+
+        if (err != ERR_NONE) {
+            signature->error = compute_digest(sgl, signature);
+            if (signature->error == ERR_ALLOCATION) {
+                err = ERR_ALLOCATION;
+                goto end;
+            }
+        } else {
+            signature->error = store_digest(signature, branches[i].ctx);
+        }
     }
 
     err = ERR_NONE;
 
 end:
-    if (update_data != NULL)
-        free(update_data);
-    if (ctx != NULL)
-        EVP_MD_CTX_destroy(ctx);
+    for (size_t i = 0; i < trunk_count; i++)
+        EVP_MD_CTX_destroy(trunks[i].ctx);
+    for (size_t i = 0; i < branch_count; i++)
+        EVP_MD_CTX_destroy(branches[i].ctx);
+    free(trunks);
+    free(branches);
+    free(positions);
 
     return err;
 }
 
-sigil_err_t load_certificates(sigil_t *sgl)
+sigil_err_t load_certificates(signature_t *signature)
 {
     sigil_err_t err;
     cert_t *certificate;
@@ -186,10 +809,10 @@ sigil_err_t load_certificates(sigil_t *sgl)
     size_t cert_length;
     size_t tmp_cert_len;
 
-    if (sgl == NULL)
+    if (signature == NULL)
         return ERR_PARAMETER;
 
-    certificate = sgl->certificates;
+    certificate = signature->certificates;
 
     while (certificate != NULL) {
         if (certificate->x509 != NULL) {
@@ -206,7 +829,7 @@ sigil_err_t load_certificates(sigil_t *sgl)
         sigil_zeroize(tmp_cert,
                       sizeof(*(certificate->cert_hex)) * ((cert_length + 1) / 2 + 1));
 
-        err = hex_to_dec(certificate->cert_hex, cert_length, tmp_cert, &tmp_cert_len);
+        err = sigil_hex_to_dec(certificate->cert_hex, cert_length, tmp_cert, &tmp_cert_len);
         if (err != ERR_NONE)
             return err;
 
@@ -226,7 +849,7 @@ sigil_err_t load_certificates(sigil_t *sgl)
     return ERR_NONE;
 }
 
-sigil_err_t load_digest(sigil_t *sgl)
+sigil_err_t load_digest(signature_t *signature)
 {
     sigil_err_t              err;
     char                    *contents;
@@ -245,10 +868,10 @@ sigil_err_t load_digest(sigil_t *sgl)
     const X509_ALGOR        *tmp_alg = NULL;
     const ASN1_OCTET_STRING *tmp_hash = NULL;
 
-    if (sgl == NULL || sgl->contents == NULL || sgl->certificates == NULL)
+    if (signature == NULL || signature->contents == NULL || signature->certificates == NULL)
         return ERR_PARAMETER;
 
-    contents = sgl->contents->contents_hex;
+    contents = signature->contents->contents_hex;
     contents_len = strlen(contents);
 
     tmp_contents = malloc(sizeof(*contents) * ((contents_len + 1) / 2 + 1));
@@ -259,7 +882,7 @@ sigil_err_t load_digest(sigil_t *sgl)
 
     sigil_zeroize(tmp_contents, sizeof(*contents) * ((contents_len + 1) / 2 + 1));
 
-    err = hex_to_dec(contents, contents_len, tmp_contents, &tmp_contents_len);
+    err = sigil_hex_to_dec(contents, contents_len, tmp_contents, &tmp_contents_len);
     if (err != ERR_NONE)
         goto end;
 
@@ -271,7 +894,7 @@ sigil_err_t load_digest(sigil_t *sgl)
         goto end;
     }
 
-    pub_key = X509_get_pubkey(sgl->certificates->x509);
+    pub_key = X509_get_pubkey(signature->certificates->x509);
     if (pub_key == NULL) {
         err = ERR_OPENSSL;
         goto end;
@@ -315,8 +938,8 @@ sigil_err_t load_digest(sigil_t *sgl)
 
     X509_SIG_get0(const_sig, &tmp_alg, &tmp_hash);
 
-    sgl->digest_algorithm = X509_ALGOR_dup((X509_ALGOR *)tmp_alg);
-    sgl->digest_original = ASN1_OCTET_STRING_dup(tmp_hash);
+    signature->digest_algorithm = X509_ALGOR_dup((X509_ALGOR *)tmp_alg);
+    signature->digest_original = ASN1_OCTET_STRING_dup(tmp_hash);
 
     err = ERR_NONE;
 
@@ -337,37 +960,104 @@ end:
     return err;
 }
 
-/* How to add support for CRL checking:
- *
- * X509_VERIFY_PARAM *param;
- *
- * param = X509_VERIFY_PARAM_new();
- * if (param == NULL)
- *     return ERR_OPENSSL;
- *
- * // set verify flags -> X509_V_FLAG_CRL_CHECK or X509_V_FLAG_CRL_CHECK_ALL
- * X509_VERIFY_PARAM_set_flags(param, X509_V_FLAG_CRL_CHECK_ALL);
- *
- * // after X509_STORE_CTX_init(...)
- * X509_VERIFY_PARAM_set1(ctx->param, param);
+/** @brief Verification callback accepting the gaps of the revocation data from
+ *         the DSS - the certificates without the CRL (they can be covered by
+ *         OCSP), and the archived CRLs issued outside of the verification time.
+ *         The certificate revoked after the verification time is accepted too
  *
- * // before call to X509_verify_cert(...) add the CRLs
- *
- * // at the end
- * X509_VERIFY_PARAM_free(param);
-*/
-sigil_err_t verify_signing_certificate(sigil_t *sgl)
+ */
+static int revocation_verify_cb(int ok, X509_STORE_CTX *ctx)
 {
+    STACK_OF(X509_CRL) *crls;
+    X509_CRL *crl;
+    X509_REVOKED *revoked;
+    X509_VERIFY_PARAM *param;
+    X509 *cert;
+    time_t check_time;
+
+    if (ok)
+        return ok;
+
+    switch (X509_STORE_CTX_get_error(ctx)) {
+        case X509_V_ERR_UNABLE_TO_GET_CRL:
+        case X509_V_ERR_CRL_HAS_EXPIRED:
+        case X509_V_ERR_CRL_NOT_YET_VALID:
+            return 1;
+        case X509_V_ERR_CERT_REVOKED:
+            param = X509_STORE_CTX_get0_param(ctx);
+            if ((X509_VERIFY_PARAM_get_flags(param) & X509_V_FLAG_USE_CHECK_TIME) == 0)
+                return ok;
+
+            check_time = X509_VERIFY_PARAM_get_time(param);
+            crls = X509_STORE_CTX_get_app_data(ctx);
+            cert = X509_STORE_CTX_get_current_cert(ctx);
+
+            // the CRLs of the issuer agree on the date of the revocation
+            for (int i = 0; i < sk_X509_CRL_num(crls); i++) {
+                crl = sk_X509_CRL_value(crls, i);
+
+                if (X509_NAME_cmp(X509_CRL_get_issuer(crl), X509_get_issuer_name(cert)) == 0 &&
+                    X509_CRL_get0_by_cert(crl, &revoked, cert) == 1 &&
+                    X509_cmp_time(X509_REVOKED_get0_revocationDate(revoked), &check_time) <= 0)
+                {
+                    return ok;
+                }
+            }
+            return 1;
+        default:
+            return ok;
+    }
+}
+
+void cache_certificate_extensions(X509 *x509)
+{
+    // only the extensions are cached with the purpose -1
+    X509_check_purpose(x509, -1, 0);
+}
+
+void cache_trusted_certificates(sigil_t *sgl)
+{
+    STACK_OF(X509_OBJECT) *objects;
+    X509 *x509;
+
+    if (sgl == NULL || sgl->trusted_store == NULL)
+        return;
+
+    if (X509_STORE_lock(sgl->trusted_store) != 1)
+        return;
+
+    objects = X509_STORE_get0_objects(sgl->trusted_store);
+
+    for (int i = 0; i < sk_X509_OBJECT_num(objects); i++) {
+        x509 = X509_OBJECT_get0_X509(sk_X509_OBJECT_value(objects, i));
+        if (x509 != NULL)
+            cache_certificate_extensions(x509);
+    }
+
+    X509_STORE_unlock(sgl->trusted_store);
+}
+
+sigil_err_t verify_signing_certificate(sigil_t *sgl, signature_t *signature)
+{
+    sigil_err_t err;
     X509_STORE_CTX *ctx;
     cert_t *additional_cert;
     STACK_OF(X509) *trusted_chain;
+    const time_t *check_time = NULL;
 
-    if (sgl == NULL || sgl->certificates == NULL)
+    if (sgl == NULL || signature == NULL || signature->certificates == NULL)
         return ERR_PARAMETER;
 
-    trusted_chain = sk_X509_new_null();
+    // the certificates and revocation data embedded in the document
+    err = dss_load(sgl);
+    if (err != ERR_NONE)
+        return err;
+
+    trusted_chain = sk_X509_dup(sgl->dss->x509s);
+    if (trusted_chain == NULL)
+        return ERR_ALLOCATION;
 
-    additional_cert = sgl->certificates->next;
+    additional_cert = signature->certificates->next;
 
     while (additional_cert != NULL) {
         if (sk_X509_push(trusted_chain, additional_cert->x509) == 0) {
@@ -385,21 +1075,39 @@ sigil_err_t verify_signing_certificate(sigil_t *sgl)
     }
 
     // initialize store context
-    if (X509_STORE_CTX_init(ctx, sgl->trusted_store, sgl->certificates->x509, trusted_chain) != 1) {
+    if (X509_STORE_CTX_init(ctx, sgl->trusted_store, signature->certificates->x509, trusted_chain) != 1) {
         sk_X509_free(trusted_chain);
+        X509_STORE_CTX_free(ctx);
         return ERR_OPENSSL;
     }
 
+    // the certificate was valid at the time proved by the signature timestamp
+    if (signature->result_timestamp == TIMESTAMP_STATUS_VERIFIED) {
+        X509_STORE_CTX_set_time(ctx, 0, signature->timestamp_time);
+        check_time = &(signature->timestamp_time);
+    }
+
+    // the whole chain is checked against the CRLs from the DSS
+    if (sk_X509_CRL_num(sgl->dss->x509_crls) > 0) {
+        X509_STORE_CTX_set0_crls(ctx, sgl->dss->x509_crls);
+        X509_STORE_CTX_set_app_data(ctx, sgl->dss->x509_crls);
+        X509_VERIFY_PARAM_set_flags(X509_STORE_CTX_get0_param(ctx),
+                                    X509_V_FLAG_CRL_CHECK | X509_V_FLAG_CRL_CHECK_ALL);
+        X509_STORE_CTX_set_verify_cb(ctx, revocation_verify_cb);
+    }
+
     // signing certificate to be verified
-    X509_STORE_CTX_set_cert(ctx, sgl->certificates->x509);
+    X509_STORE_CTX_set_cert(ctx, signature->certificates->x509);
 
-    // verify
-    if (X509_verify_cert(ctx) == 1) {
+    // verify, the OCSP responses from the DSS are checked for the built chain
+    if (X509_verify_cert(ctx) == 1 &&
+        !dss_ocsp_revoked(sgl, X509_STORE_CTX_get0_chain(ctx), check_time))
+    {
         // verification successful
-        sgl->result_cert_verification = CERT_STATUS_VERIFIED;
+        signature->result_cert_verification = CERT_STATUS_VERIFIED;
     } else {
         // verification not successful
-        sgl->result_cert_verification = CERT_STATUS_FAILED;
+        signature->result_cert_verification = CERT_STATUS_FAILED;
     }
 
     sk_X509_free(trusted_chain);
@@ -409,22 +1117,57 @@ sigil_err_t verify_signing_certificate(sigil_t *sgl)
     return ERR_NONE;
 }
 
-sigil_err_t compare_digest(sigil_t *sgl)
+sigil_err_t compare_digest(signature_t *signature)
 {
-    if (sgl == NULL)
+    if (signature == NULL)
         return ERR_PARAMETER;
 
-    sgl->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
+    signature->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
 
-    if (sgl->digest_original == NULL || sgl->digest_computed == NULL)
+    if (signature->digest_original == NULL || signature->digest_computed == NULL)
         return ERR_PARAMETER;
 
-    if (ASN1_STRING_cmp(sgl->digest_original, sgl->digest_computed) == 0)
-        sgl->result_digest_comparison = HASH_CMP_RESULT_MATCH;
+    if (ASN1_STRING_cmp(signature->digest_original, signature->digest_computed) == 0)
+        signature->result_digest_comparison = HASH_CMP_RESULT_MATCH;
 
     return ERR_NONE;
 }
 
+/** @brief Adds the signature with two byte ranges and the SHA-256 digest
+ *         algorithm to the context
+ *
+ * @param sgl context
+ * @param ranges the pairs of ranges (start, length)
+ * @return 1 if success, 0 otherwise
+ */
+static int test_add_signature(sigil_t *sgl, const size_t ranges[4])
+{
+    signature_t *signature;
+    range_t **range;
+
+    if (signature_add(sgl, &signature) != ERR_NONE)
+        return 0;
+
+    range = &(signature->byte_range);
+
+    for (size_t j = 0; j < 4; j += 2) {
+        *range = malloc(sizeof(**range));
+        if (*range == NULL)
+            return 0;
+
+        sigil_zeroize(*range, sizeof(**range));
+        (*range)->start = ranges[j];
+        (*range)->length = ranges[j + 1];
+        range = &((*range)->next);
+    }
+
+    signature->digest_algorithm = X509_ALGOR_new();
+
+    return signature->digest_algorithm != NULL &&
+           X509_ALGOR_set0(signature->digest_algorithm, OBJ_nid2obj(NID_sha256),
+                           V_ASN1_NULL, NULL) == 1;
+}
+
 int sigil_cryptography_self_test(int verbosity)
 {
     sigil_t *sgl;
@@ -432,30 +1175,117 @@ int sigil_cryptography_self_test(int verbosity)
 
     print_module_name("cryptography", verbosity);
 
+    sgl = NULL;
+
+    // TEST: fn sigil_hex_to_dec
+    print_test_item("fn sigil_hex_to_dec", verbosity);
+
+    {
+        unsigned char out[40];
+        size_t out_len;
+
+        char *hex_long = "000102030405060708090a0b0c0d0e0f" \
+                         "F0E1D2C3B4A5968778695A4B3C2D1E0F" \
+                         "aB";
+        const unsigned char expected[] = {
+            0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+            0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+            0xf0, 0xe1, 0xd2, 0xc3, 0xb4, 0xa5, 0x96, 0x87,
+            0x78, 0x69, 0x5a, 0x4b, 0x3c, 0x2d, 0x1e, 0x0f,
+            0xab
+        };
+
+        if (sigil_hex_to_dec(hex_long, strlen(hex_long), out, &out_len) != ERR_NONE ||
+            out_len != sizeof(expected) ||
+            memcmp(out, expected, sizeof(expected)) != 0)
+        {
+            goto failed;
+        }
+
+        // whitespaces inside of the block falling back to the slow path
+        char *hex_spaces = "0001020304050607 08090a0b0c0d0e0f\r\n" \
+                           "f0e1d2c3b4a59687\t78695a4b3c2d1e0f ab";
+
+        if (sigil_hex_to_dec(hex_spaces, strlen(hex_spaces), out, &out_len) != ERR_NONE ||
+            out_len != sizeof(expected) ||
+            memcmp(out, expected, sizeof(expected)) != 0)
+        {
+            goto failed;
+        }
+
+        // odd number of digits
+        if (sigil_hex_to_dec("a1b", 3, out, &out_len) != ERR_NONE ||
+            out_len != 2 || out[0] != 0xa1 || out[1] != 0xb0)
+        {
+            goto failed;
+        }
+
+        // whitespace anywhere in the long input, the odd run of digits before
+        // it is completed after the end of the block
+        char hex_moved[2 * 128 + 2];
+        unsigned char moved_out[128 + 2];
+
+        for (size_t i = 0; i < 128; i++) {
+            hex_moved[2 * i] = "0123456789abcdef"[((i * 7 + 3) >> 4) & 0x0f];
+            hex_moved[2 * i + 1] = "0123456789abcdef"[(i * 7 + 3) & 0x0f];
+        }
+        hex_moved[2 * 128] = '\0';
+
+        for (size_t space = 0; space <= 2 * 128; space++) {
+            memmove(hex_moved + space + 1, hex_moved + space, 2 * 128 - space + 1);
+            hex_moved[space] = ' ';
+
+            if (sigil_hex_to_dec(hex_moved, 2 * 128 + 1, moved_out, &out_len) != ERR_NONE ||
+                out_len != 128)
+            {
+                goto failed;
+            }
+            for (size_t i = 0; i < 128; i++) {
+                if (moved_out[i] != (unsigned char)(i * 7 + 3))
+                    goto failed;
+            }
+
+            memmove(hex_moved + space, hex_moved + space + 1, 2 * 128 - space + 1);
+        }
+
+        // invalid character inside of the block
+        char *hex_invalid = "000102030405060708090a0b0c0d0e0g" \
+                            "000102030405060708090a0b0c0d0e0f";
+
+        if (sigil_hex_to_dec(hex_invalid, strlen(hex_invalid), out, &out_len) == ERR_NONE)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn compare_digest
     print_test_item("fn compare_digest", verbosity);
 
     {
         const unsigned char *str_1 = (const unsigned char *)"123456789abcdef";
         const unsigned char *str_2 = (const unsigned char *)"fedcba987654321";
+        signature_t *signature;
         int result;
 
         err = sigil_init(&sgl);
         if (err != ERR_NONE || sgl == NULL)
             goto failed;
 
-        sgl->digest_original = ASN1_OCTET_STRING_new();
-        if (sgl->digest_original == NULL)
+        if (signature_add(sgl, &signature) != ERR_NONE)
             goto failed;
 
-        sgl->digest_computed = ASN1_OCTET_STRING_new();
-        if (sgl->digest_computed == NULL)
+        signature->digest_original = ASN1_OCTET_STRING_new();
+        if (signature->digest_original == NULL)
             goto failed;
 
-        ASN1_OCTET_STRING_set(sgl->digest_original, str_1, -1);
-        ASN1_OCTET_STRING_set(sgl->digest_computed, str_1, -1);
+        signature->digest_computed = ASN1_OCTET_STRING_new();
+        if (signature->digest_computed == NULL)
+            goto failed;
 
-        if (compare_digest(sgl) != ERR_NONE)
+        ASN1_OCTET_STRING_set(signature->digest_original, str_1, -1);
+        ASN1_OCTET_STRING_set(signature->digest_computed, str_1, -1);
+
+        if (compare_digest(signature) != ERR_NONE)
             goto failed;
 
         if (sigil_get_data_integrity_result(sgl, &result) != ERR_NONE)
@@ -464,15 +1294,15 @@ int sigil_cryptography_self_test(int verbosity)
         if (result != HASH_CMP_RESULT_MATCH)
             goto failed;
 
-        ASN1_OCTET_STRING_free(sgl->digest_computed);
+        ASN1_OCTET_STRING_free(signature->digest_computed);
 
-        sgl->digest_computed = ASN1_OCTET_STRING_new();
-        if (sgl->digest_computed == NULL)
+        signature->digest_computed = ASN1_OCTET_STRING_new();
+        if (signature->digest_computed == NULL)
             goto failed;
 
-        ASN1_OCTET_STRING_set(sgl->digest_computed, str_2, -1);
+        ASN1_OCTET_STRING_set(signature->digest_computed, str_2, -1);
 
-        if (compare_digest(sgl) != ERR_NONE)
+        if (compare_digest(signature) != ERR_NONE)
             goto failed;
 
         if (sigil_get_data_integrity_result(sgl, &result) != ERR_NONE)
@@ -486,6 +1316,216 @@ int sigil_cryptography_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn compute_digests - nested, separate, backward and unsupported
+    print_test_item("fn compute_digests", verbosity);
+
+    {
+        // the pairs of ranges (start, length), the digest NID
+        const size_t ranges[][4] = {
+            { 0,    1000,  1100,  18900 },
+            { 0,    30000, 30100, 9900 },
+            { 0,    30000, 30100, 19900 },
+            { 500,  2500,  3100,  1900 },
+            { 5000, 100,   0,     200 },
+            { 0,    1000,  1100,  100 },
+        };
+        const int nids[] = {
+            NID_sha256, NID_sha256, NID_sha1, NID_sha256, NID_sha384, NID_md5
+        };
+        const size_t count = sizeof(nids) / sizeof(*nids);
+        const size_t size = 50000;
+        unsigned char expected[EVP_MAX_MD_SIZE];
+        unsigned int expected_len;
+        signature_t *signature;
+        range_t **range;
+        EVP_MD_CTX *ctx;
+        char *pdf;
+        int ok;
+
+        pdf = malloc(size);
+        if (pdf == NULL)
+            goto failed;
+
+        for (size_t i = 0; i < size; i++)
+            pdf[i] = (char)((i * 7919) >> 3);
+
+        ok = 1;
+
+        // the buffer, the file read in chunks and on the reading thread
+        for (size_t mode = 0; ok && mode < 3; mode++) {
+            if (mode == 0) {
+                sgl = test_prepare_sgl_buffer(pdf, size);
+            } else {
+                FILE *file = tmpfile();
+
+                if (file == NULL || fwrite(pdf, 1, size, file) != size ||
+                    sigil_init(&sgl) != ERR_NONE)
+                {
+                    if (file != NULL)
+                        fclose(file);
+                    sgl = NULL;
+                } else {
+                    sgl->pdf_data.file = file;
+                    sgl->pdf_data.size = size;
+                    sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+                    sigil_set_thread_count(sgl, (mode == 1) ? 1 : 4);
+                }
+            }
+            ok = (sgl != NULL);
+
+            for (size_t i = 0; ok && i < count; i++)
+                ok = (signature_add(sgl, &signature) == ERR_NONE);
+
+            for (size_t i = 0; ok && i < count; i++) {
+                signature = &(sgl->signatures[i]);
+                range = &(signature->byte_range);
+
+                for (size_t j = 0; ok && j < 4; j += 2) {
+                    *range = malloc(sizeof(**range));
+                    if ((ok = (*range != NULL))) {
+                        sigil_zeroize(*range, sizeof(**range));
+                        (*range)->start = ranges[i][j];
+                        (*range)->length = ranges[i][j + 1];
+                        range = &((*range)->next);
+                    }
+                }
+
+                signature->digest_algorithm = X509_ALGOR_new();
+                ok = ok && signature->digest_algorithm != NULL &&
+                     X509_ALGOR_set0(signature->digest_algorithm, OBJ_nid2obj(nids[i]),
+                                     V_ASN1_NULL, NULL) == 1;
+            }
+
+            ok = ok && compute_digests(sgl) == ERR_NONE &&
+                 sgl->signatures[count - 1].error == ERR_DIGEST_TYPE &&
+                 sgl->signatures[count - 1].digest_computed == NULL;
+
+            // every other digest is the same as computed directly from the ranges
+            for (size_t i = 0; ok && i + 1 < count; i++) {
+                signature = &(sgl->signatures[i]);
+
+                ctx = EVP_MD_CTX_create();
+                ok = ctx != NULL &&
+                     EVP_DigestInit_ex(ctx, EVP_get_digestbynid(nids[i]), NULL) == 1 &&
+                     EVP_DigestUpdate(ctx, pdf + ranges[i][0], ranges[i][1]) == 1 &&
+                     EVP_DigestUpdate(ctx, pdf + ranges[i][2], ranges[i][3]) == 1 &&
+                     EVP_DigestFinal_ex(ctx, expected, &expected_len) == 1;
+                EVP_MD_CTX_destroy(ctx);
+
+                ok = ok && signature->error == ERR_NONE &&
+                     signature->digest_computed != NULL &&
+                     ASN1_STRING_length(signature->digest_computed) == (int)expected_len &&
+                     memcmp(ASN1_STRING_get0_data(signature->digest_computed),
+                            expected, expected_len) == 0;
+            }
+
+            if (sgl != NULL)
+                sigil_free(&sgl);
+        }
+
+        free(pdf);
+
+        if (!ok)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn compute_digests - only the signature with the broken range fails
+    print_test_item("fn compute_digests broken range", verbosity);
+
+    {
+        const size_t size = 50000,
+                     written = 40000,
+                     offset = 100;
+        // valid, overflowing, past the end with the offset, past the written
+        // data of the truncated file
+        const size_t ranges[][4] = {
+            { 0, 1000, 1100, 900 },
+            { 0, 1000, 1100, SIZE_MAX - 1000 },
+            { 0, 1000, written - offset - 50, 100 },
+            { 0, 1000, written - offset + 100, 1000 },
+        };
+        const size_t count = sizeof(ranges) / sizeof(*ranges);
+        unsigned char expected[EVP_MAX_MD_SIZE];
+        unsigned int expected_len;
+        signature_t *signature;
+        EVP_MD_CTX *ctx;
+        char *pdf;
+        int ok;
+
+        pdf = malloc(size);
+        if (pdf == NULL)
+            goto failed;
+
+        for (size_t i = 0; i < size; i++)
+            pdf[i] = (char)((i * 7919) >> 3);
+
+        ctx = EVP_MD_CTX_create();
+        ok = ctx != NULL &&
+             EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+             EVP_DigestUpdate(ctx, pdf + offset + ranges[0][0], ranges[0][1]) == 1 &&
+             EVP_DigestUpdate(ctx, pdf + offset + ranges[0][2], ranges[0][3]) == 1 &&
+             EVP_DigestFinal_ex(ctx, expected, &expected_len) == 1;
+        EVP_MD_CTX_destroy(ctx);
+
+        // the buffer with the written data, the file larger than its data
+        // read in chunks and on the reading thread
+        for (size_t mode = 0; ok && mode < 3; mode++) {
+            if (mode == 0) {
+                sgl = test_prepare_sgl_buffer(pdf, written);
+            } else {
+                FILE *file = tmpfile();
+
+                if (file == NULL || fwrite(pdf, 1, written, file) != written ||
+                    sigil_init(&sgl) != ERR_NONE)
+                {
+                    if (file != NULL)
+                        fclose(file);
+                    sgl = NULL;
+                } else {
+                    sgl->pdf_data.file = file;
+                    sgl->pdf_data.size = size;
+                    sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+                    sigil_set_thread_count(sgl, (mode == 1) ? 1 : 4);
+                }
+            }
+            ok = (sgl != NULL);
+
+            if (ok)
+                sgl->offset_pdf_start = offset;
+
+            for (size_t i = 0; ok && i < count; i++)
+                ok = test_add_signature(sgl, ranges[i]);
+
+            ok = ok && compute_digests(sgl) == ERR_NONE;
+
+            for (size_t i = 1; ok && i < count; i++) {
+                signature = &(sgl->signatures[i]);
+                ok = signature->error != ERR_NONE && signature->digest_computed == NULL;
+            }
+
+            if (ok) {
+                signature = &(sgl->signatures[0]);
+                ok = signature->error == ERR_NONE &&
+                     signature->digest_computed != NULL &&
+                     ASN1_STRING_length(signature->digest_computed) == (int)expected_len &&
+                     memcmp(ASN1_STRING_get0_data(signature->digest_computed),
+                            expected, expected_len) == 0;
+            }
+
+            if (sgl != NULL)
+                sigil_free(&sgl);
+        }
+
+        free(pdf);
+
+        if (!ok)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
     // all tests done
     print_module_result(1, verbosity);
     return 0;
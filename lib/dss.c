@@ -0,0 +1,872 @@
+#include <openssl/ocsp.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "cryptography.h"
+#include "dss.h"
+#include "sigil.h"
+#include "stream.h"
+
+#ifdef _WIN32
+    #define DSS_CACHE_UNLOCKED
+#else
+    #include <pthread.h>
+#endif
+
+#define DSS_OBJECT_CERT 0
+#define DSS_OBJECT_CRL  1
+#define DSS_OBJECT_OCSP 2
+
+/** @brief Decoded revocation data identified by the digest of its content.
+ *         Each context using it and the cache hold one reference
+ *
+ */
+struct dss_object_t {
+    unsigned char   id[SHA256_DIGEST_LENGTH];
+    int             type;
+    X509_CRL       *crl;
+    OCSP_BASICRESP *ocsp;
+    size_t          refs;
+};
+
+/** @brief Revocation data shared by all the contexts of the process, the
+ *         oldest entry is replaced when full
+ *
+ */
+static dss_object_t *dss_cache[DSS_CACHE_SIZE];
+static size_t dss_cache_count = 0;
+static size_t dss_cache_next = 0;
+
+#ifndef DSS_CACHE_UNLOCKED
+    static pthread_mutex_t dss_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void dss_cache_acquire(void)
+{
+    #ifndef DSS_CACHE_UNLOCKED
+        pthread_mutex_lock(&dss_cache_lock);
+    #endif
+}
+
+static void dss_cache_release(void)
+{
+    #ifndef DSS_CACHE_UNLOCKED
+        pthread_mutex_unlock(&dss_cache_lock);
+    #endif
+}
+
+static void dss_object_free(dss_object_t *object)
+{
+    X509_CRL_free(object->crl);
+    OCSP_BASICRESP_free(object->ocsp);
+
+    sigil_zeroize(object, sizeof(*object));
+    free(object);
+}
+
+/** @brief Drops one reference of the object, the last one frees it
+ *
+ */
+static void dss_object_release(dss_object_t *object)
+{
+    size_t refs;
+
+    dss_cache_acquire();
+    refs = --(object->refs);
+    dss_cache_release();
+
+    if (refs == 0)
+        dss_object_free(object);
+}
+
+void dss_cache_clear(void)
+{
+    dss_object_t *removed[DSS_CACHE_SIZE];
+    size_t count;
+
+    dss_cache_acquire();
+
+    count = dss_cache_count;
+    memcpy(removed, dss_cache, count * sizeof(*removed));
+
+    dss_cache_count = 0;
+    dss_cache_next = 0;
+
+    dss_cache_release();
+
+    for (size_t i = 0; i < count; i++) {
+        dss_object_release(removed[i]);
+    }
+}
+
+/** @brief Decodes the revocation data of the provided type
+ *
+ * @return the allocated object with one reference or NULL if not decodable
+ */
+static dss_object_t *decode_object(const unsigned char *data, size_t size, int type,
+                                   const unsigned char *id)
+{
+    dss_object_t *object;
+    OCSP_RESPONSE *response;
+    const unsigned char *const_data = data;
+
+    object = malloc(sizeof(*object));
+    if (object == NULL)
+        return NULL;
+
+    sigil_zeroize(object, sizeof(*object));
+    memcpy(object->id, id, SHA256_DIGEST_LENGTH);
+    object->type = type;
+    object->refs = 1;
+
+    if (type == DSS_OBJECT_CRL) {
+        object->crl = d2i_X509_CRL(NULL, &const_data, (long)size);
+        // OpenSSL sorts the revoked entries on the first lookup and checks
+        // the order without the lock, the shared CRL is only read afterwards
+        if (object->crl != NULL)
+            sk_X509_REVOKED_sort(X509_CRL_get_REVOKED(object->crl));
+    } else {
+        // the DSS holds the whole responses, only the successful ones are usable
+        response = d2i_OCSP_RESPONSE(NULL, &const_data, (long)size);
+        if (response != NULL &&
+            OCSP_response_status(response) == OCSP_RESPONSE_STATUS_SUCCESSFUL)
+        {
+            object->ocsp = OCSP_response_get1_basic(response);
+        }
+        OCSP_RESPONSE_free(response);
+
+        // the certificates of the responders are shared by the validations
+        // as well (see cache_certificate_extensions)
+        if (object->ocsp != NULL) {
+            const STACK_OF(X509) *certs = OCSP_resp_get0_certs(object->ocsp);
+
+            for (int i = 0; i < sk_X509_num(certs); i++)
+                cache_certificate_extensions(sk_X509_value(certs, i));
+        }
+    }
+
+    if (object->crl == NULL && object->ocsp == NULL) {
+        dss_object_free(object);
+        return NULL;
+    }
+
+    return object;
+}
+
+/** @brief Provides the decoded revocation data - from the cache, or decodes
+ *         them and stores them to the cache
+ *
+ * @return the object with a reference for the caller or NULL if not decodable
+ */
+static dss_object_t *dss_cache_get(const unsigned char *data, size_t size, int type)
+{
+    dss_object_t *object = NULL,
+                 *decoded,
+                 *evicted = NULL;
+    unsigned char id[SHA256_DIGEST_LENGTH];
+
+    if (SHA256(data, size, id) == NULL)
+        return NULL;
+
+    dss_cache_acquire();
+
+    for (size_t i = 0; i < dss_cache_count; i++) {
+        if (dss_cache[i]->type == type &&
+            memcmp(dss_cache[i]->id, id, SHA256_DIGEST_LENGTH) == 0)
+        {
+            object = dss_cache[i];
+            object->refs++;
+            break;
+        }
+    }
+
+    dss_cache_release();
+
+    if (object != NULL)
+        return object;
+
+    // the large CRLs are decoded without blocking the others
+    decoded = decode_object(data, size, type, id);
+    if (decoded == NULL)
+        return NULL;
+
+    dss_cache_acquire();
+
+    // the same data could be stored meanwhile
+    for (size_t i = 0; i < dss_cache_count; i++) {
+        if (dss_cache[i]->type == type &&
+            memcmp(dss_cache[i]->id, id, SHA256_DIGEST_LENGTH) == 0)
+        {
+            object = dss_cache[i];
+            object->refs++;
+            break;
+        }
+    }
+
+    if (object == NULL) {
+        object = decoded;
+        decoded = NULL;
+        object->refs++;
+
+        if (dss_cache_count < DSS_CACHE_SIZE) {
+            dss_cache[dss_cache_count++] = object;
+        } else {
+            evicted = dss_cache[dss_cache_next];
+            dss_cache[dss_cache_next] = object;
+            dss_cache_next = (dss_cache_next + 1) % DSS_CACHE_SIZE;
+        }
+    }
+
+    dss_cache_release();
+
+    if (decoded != NULL)
+        dss_object_free(decoded);
+    if (evicted != NULL)
+        dss_object_release(evicted);
+
+    return object;
+}
+
+/** @brief Appends the reference to the collected ones, unless already present
+ *
+ */
+static sigil_err_t dss_refs_add(dss_refs_t *refs, const reference_t *ref)
+{
+    sigil_err_t err;
+    reference_t *entry;
+    size_t capacity;
+
+    if (number_set_contains(&(refs->seen), ref->object_num))
+        return ERR_NONE;
+
+    if (refs->count >= refs->capacity) {
+        capacity = MAX(2 * refs->capacity, DSS_REFS_PREALLOCATION);
+
+        entry = realloc(refs->entry, capacity * sizeof(*entry));
+        if (entry == NULL)
+            return ERR_ALLOCATION;
+
+        refs->entry = entry;
+        refs->capacity = capacity;
+    }
+
+    if ((err = number_set_insert(&(refs->seen), ref->object_num)) != ERR_NONE)
+        return err;
+
+    refs->entry[refs->count++] = *ref;
+
+    return ERR_NONE;
+}
+
+static void dss_refs_clear(dss_refs_t *refs)
+{
+    free(refs->entry);
+    number_set_clear(&(refs->seen));
+
+    sigil_zeroize(refs, sizeof(*refs));
+}
+
+/** @brief Follows the indirect reference at the current position, if the value
+ *         does not start with the provided character right there
+ *
+ * @param sgl context
+ * @param first the first character of the direct value - '<' or '['
+ * @return ERR_NONE if success
+ */
+static sigil_err_t resolve_value(sigil_t *sgl, char first)
+{
+    sigil_err_t err;
+    reference_t ref;
+    char c;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE ||
+        (err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (c == first)
+        return ERR_NONE;
+
+    if ((err = parse_indirect_reference(sgl, &ref)) != ERR_NONE)
+        return err;
+
+    return pdf_goto_obj(sgl, &ref);
+}
+
+/** @brief Collects the references from the array value of the key, if present
+ *
+ */
+static sigil_err_t collect_refs(sigil_t *sgl, const dict_entry_t *entries, size_t count,
+                                dict_key_t dict_key, dss_refs_t *refs)
+{
+    sigil_err_t err;
+    ref_array_t array = { NULL, 0 };
+
+    if (dict_projection_goto(sgl, entries, count, dict_key) != ERR_NONE)
+        return ERR_NONE;
+
+    if ((err = resolve_value(sgl, '[')) != ERR_NONE ||
+        (err = parse_ref_array(sgl, &array)) != ERR_NONE)
+    {
+        goto end;
+    }
+
+    for (size_t i = 0; i < array.capacity && array.entry[i] != NULL; i++) {
+        if ((err = dss_refs_add(refs, array.entry[i])) != ERR_NONE)
+            goto end;
+    }
+
+end:
+    ref_array_free(&array);
+
+    return err;
+}
+
+/** @brief Parses one entry of the VRI dictionary - the data for one signature
+ *         from the current position (after the leading "<<")
+ *
+ */
+static sigil_err_t parse_vri_entry(sigil_t *sgl, dss_t *dss)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Cert, 0, 0 },
+        { DICT_KEY_OCSP, 0, 0 },
+        { DICT_KEY_CRL,  0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+
+    if ((err = parse_dict_projection(sgl, entries, count)) != ERR_NONE ||
+        (err = collect_refs(sgl, entries, count, DICT_KEY_Cert, &(dss->certs))) != ERR_NONE ||
+        (err = collect_refs(sgl, entries, count, DICT_KEY_OCSP, &(dss->ocsps))) != ERR_NONE)
+    {
+        return err;
+    }
+
+    return collect_refs(sgl, entries, count, DICT_KEY_CRL, &(dss->crls));
+}
+
+/** @brief Parses the VRI dictionary from the current position, its keys are
+ *         the digests of the signatures. The data of all the signatures are
+ *         collected, they are checked against the verified chains anyway
+ *
+ */
+static sigil_err_t parse_vri(sigil_t *sgl, dss_t *dss)
+{
+    sigil_err_t err;
+    dict_key_t dict_key;
+    size_t value_position,
+           next_position;
+
+    if ((err = resolve_value(sgl, '<')) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE)
+    {
+        return err;
+    }
+
+    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
+        if ((err = get_curr_position(sgl, &value_position)) != ERR_NONE ||
+            (err = skip_dict_unknown_value(sgl)) != ERR_NONE ||
+            (err = get_curr_position(sgl, &next_position)) != ERR_NONE ||
+            (err = pdf_move_pos_abs(sgl, value_position)) != ERR_NONE ||
+            (err = resolve_value(sgl, '<')) != ERR_NONE ||
+            (err = skip_word(sgl, "<<")) != ERR_NONE ||
+            (err = parse_vri_entry(sgl, dss)) != ERR_NONE ||
+            (err = pdf_move_pos_abs(sgl, next_position)) != ERR_NONE)
+        {
+            return err;
+        }
+    }
+
+    return (err == ERR_END_OF_DICT) ? ERR_NONE : err;
+}
+
+/** @brief Parses the DSS dictionary and collects the references to its streams
+ *
+ */
+static sigil_err_t parse_dss(sigil_t *sgl, dss_t *dss)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Certs, 0, 0 },
+        { DICT_KEY_OCSPs, 0, 0 },
+        { DICT_KEY_CRLs,  0, 0 },
+        { DICT_KEY_VRI,   0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+
+    if (sgl->offset_dss > 0) {
+        err = pdf_move_pos_abs(sgl, sgl->offset_dss);
+    } else {
+        err = pdf_goto_obj(sgl, &(sgl->ref_dss));
+    }
+
+    if (err != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE ||
+        (err = parse_dict_projection(sgl, entries, count)) != ERR_NONE ||
+        (err = collect_refs(sgl, entries, count, DICT_KEY_Certs, &(dss->certs))) != ERR_NONE ||
+        (err = collect_refs(sgl, entries, count, DICT_KEY_OCSPs, &(dss->ocsps))) != ERR_NONE ||
+        (err = collect_refs(sgl, entries, count, DICT_KEY_CRLs, &(dss->crls))) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_VRI) != ERR_NONE)
+        return ERR_NONE;
+
+    return parse_vri(sgl, dss);
+}
+
+/** @brief Decodes the whole data of the stream object
+ *
+ * @param sgl context
+ * @param ref the stream object
+ * @param data output - allocated decoded data
+ * @param size output - size of the decoded data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_stream_object(sigil_t *sgl, const reference_t *ref,
+                                      unsigned char **data, size_t *size)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Filter,      0, 0 },
+        { DICT_KEY_DecodeParms, 0, 0 },
+        { DICT_KEY_Length,      0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+    stream_info_t info;
+    stream_reader_t *reader = NULL;
+    reference_t obj = *ref;
+    size_t dict_position,
+           capacity = 0,
+           requested,
+           read_size;
+    unsigned char *buffer;
+
+    stream_info_init(&info);
+
+    *data = NULL;
+    *size = 0;
+
+    if ((err = pdf_goto_obj(sgl, &obj)) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE ||
+        (err = get_curr_position(sgl, &dict_position)) != ERR_NONE ||
+        (err = parse_dict_projection(sgl, entries, count)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Filter) == ERR_NONE &&
+        (err = parse_stream_filter(sgl, &info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_DecodeParms) == ERR_NONE &&
+        (err = parse_stream_decode_parms(sgl, &info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Length)) != ERR_NONE ||
+        (err = parse_stream_length(sgl, &info)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+
+    // the data follow the end of the dictionary
+    if ((err = pdf_move_pos_abs(sgl, dict_position)) != ERR_NONE ||
+        (err = skip_dictionary(sgl)) != ERR_NONE ||
+        (err = locate_stream_data(sgl, &info)) != ERR_NONE ||
+        (err = stream_reader_open(sgl, &info, &reader)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    do {
+        if (*size == capacity) {
+            if (capacity >= DSS_OBJECT_SIZE_MAX) {
+                err = ERR_PDF_CONTENT;
+                goto end;
+            }
+
+            capacity = MIN(2 * capacity + STREAM_CHUNK_SIZE, DSS_OBJECT_SIZE_MAX);
+            buffer = realloc(*data, capacity);
+            if (buffer == NULL) {
+                err = ERR_ALLOCATION;
+                goto end;
+            }
+            *data = buffer;
+        }
+
+        requested = MIN(STREAM_CHUNK_SIZE, capacity - *size);
+        err = stream_read(reader, *data + *size, requested, &read_size);
+        if (err != ERR_NONE)
+            goto end;
+
+        *size += read_size;
+    } while (read_size == requested);
+
+end:
+    stream_reader_free(&reader);
+
+    if (err != ERR_NONE) {
+        free(*data);
+        *data = NULL;
+        *size = 0;
+    }
+
+    return err;
+}
+
+/** @brief Decodes the collected streams of one kind. The streams that can
+ *         not be read or decoded are skipped, only the allocation error is
+ *         returned
+ *
+ */
+static sigil_err_t decode_refs(sigil_t *sgl, dss_t *dss, const dss_refs_t *refs, int type)
+{
+    sigil_err_t err;
+    dss_object_t *object,
+                **objects;
+    X509 *x509;
+    unsigned char *data;
+    const unsigned char *const_data;
+    size_t size;
+
+    for (size_t i = 0; i < refs->count; i++) {
+        err = read_stream_object(sgl, &(refs->entry[i]), &data, &size);
+        if (err == ERR_ALLOCATION)
+            return err;
+        if (err != ERR_NONE)
+            continue;
+
+        // the certificates are small and needed only by the document
+        if (type == DSS_OBJECT_CERT) {
+            const_data = data;
+            x509 = d2i_X509(NULL, &const_data, (long)size);
+            free(data);
+
+            if (x509 != NULL)
+                cache_certificate_extensions(x509);
+
+            if (x509 != NULL && sk_X509_push(dss->x509s, x509) == 0) {
+                X509_free(x509);
+                return ERR_ALLOCATION;
+            }
+            continue;
+        }
+
+        object = dss_cache_get(data, size, type);
+        free(data);
+
+        if (object == NULL)
+            continue;
+
+        objects = realloc(dss->objects, (dss->object_count + 1) * sizeof(*objects));
+        if (objects == NULL) {
+            dss_object_release(object);
+            return ERR_ALLOCATION;
+        }
+        dss->objects = objects;
+        dss->objects[dss->object_count++] = object;
+
+        if (object->crl != NULL && sk_X509_CRL_push(dss->x509_crls, object->crl) == 0)
+            return ERR_ALLOCATION;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Reads the DSS into the provided structure
+ *
+ */
+static sigil_err_t read_dss(sigil_t *sgl, dss_t *dss)
+{
+    sigil_err_t err;
+
+    dss->x509s = sk_X509_new_null();
+    dss->x509_crls = sk_X509_CRL_new_null();
+    if (dss->x509s == NULL || dss->x509_crls == NULL)
+        return ERR_ALLOCATION;
+
+    if (sgl->offset_dss == 0 && sgl->ref_dss.object_num == 0)
+        return ERR_NONE;
+
+    // the damaged DSS does not prevent the verification without it
+    err = parse_dss(sgl, dss);
+    if (err == ERR_ALLOCATION)
+        return err;
+
+    if ((err = decode_refs(sgl, dss, &(dss->certs), DSS_OBJECT_CERT)) != ERR_NONE ||
+        (err = decode_refs(sgl, dss, &(dss->crls), DSS_OBJECT_CRL)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    return decode_refs(sgl, dss, &(dss->ocsps), DSS_OBJECT_OCSP);
+}
+
+sigil_err_t dss_load(sigil_t *sgl)
+{
+    dss_t *dss;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    // the failed load is not repeated, all signatures get its error
+    if (sgl->dss != NULL)
+        return sgl->dss->error;
+
+    dss = malloc(sizeof(*dss));
+    if (dss == NULL)
+        return ERR_ALLOCATION;
+
+    sigil_zeroize(dss, sizeof(*dss));
+    sgl->dss = dss;
+
+    dss->error = read_dss(sgl, dss);
+
+    return dss->error;
+}
+
+/** @brief Decides whether the response holds the revoked status of the
+ *         certificate, the identifiers are compared with the digest algorithm
+ *         chosen by the responder
+ *
+ */
+static int ocsp_response_revoked(OCSP_BASICRESP *basic, X509 *cert, X509 *issuer,
+                                 const time_t *check_time)
+{
+    OCSP_SINGLERESP *single;
+    OCSP_CERTID *cert_id;
+    ASN1_OBJECT *md_obj = NULL;
+    ASN1_GENERALIZEDTIME *revoked_at = NULL;
+    const EVP_MD *evp_md;
+    int reason,
+        revoked = 0;
+
+    for (int i = 0; !revoked && i < OCSP_resp_count(basic); i++) {
+        single = OCSP_resp_get0(basic, i);
+
+        if (OCSP_id_get0_info(NULL, &md_obj, NULL, NULL,
+                              (OCSP_CERTID *)OCSP_SINGLERESP_get0_id(single)) != 1 ||
+            (evp_md = EVP_get_digestbyobj(md_obj)) == NULL ||
+            (cert_id = OCSP_cert_to_id(evp_md, cert, issuer)) == NULL)
+        {
+            continue;
+        }
+
+        if (OCSP_id_cmp(cert_id, OCSP_SINGLERESP_get0_id(single)) == 0 &&
+            OCSP_single_get0_status(single, &reason, &revoked_at, NULL, NULL) ==
+                V_OCSP_CERTSTATUS_REVOKED)
+        {
+            revoked = 1;
+
+            // revoked only after the time of the verification
+            if (check_time != NULL && revoked_at != NULL &&
+                X509_cmp_time(revoked_at, (time_t *)check_time) > 0)
+            {
+                revoked = 0;
+            }
+        }
+
+        OCSP_CERTID_free(cert_id);
+    }
+
+    return revoked;
+}
+
+int dss_ocsp_revoked(sigil_t *sgl, STACK_OF(X509) *chain, const time_t *check_time)
+{
+    STACK_OF(X509) *untrusted;
+    OCSP_BASICRESP *basic;
+    int revoked = 0;
+
+    if (sgl == NULL || sgl->dss == NULL || chain == NULL)
+        return 0;
+
+    untrusted = sk_X509_dup(sgl->dss->x509s);
+    if (untrusted == NULL)
+        return 0;
+
+    for (int i = 0; i < sk_X509_num(chain); i++) {
+        if (sk_X509_push(untrusted, sk_X509_value(chain, i)) == 0)
+            goto end;
+    }
+
+    // the response needs to be signed by the issuer or by its responder
+    for (int i = 0; !revoked && i + 1 < sk_X509_num(chain); i++) {
+        for (size_t j = 0; !revoked && j < sgl->dss->object_count; j++) {
+            basic = sgl->dss->objects[j]->ocsp;
+
+            if (basic != NULL &&
+                ocsp_response_revoked(basic, sk_X509_value(chain, i),
+                                      sk_X509_value(chain, i + 1), check_time) &&
+                OCSP_basic_verify(basic, untrusted, sgl->trusted_store, 0) == 1)
+            {
+                revoked = 1;
+            }
+        }
+    }
+
+end:
+    sk_X509_free(untrusted);
+
+    return revoked;
+}
+
+void dss_free(sigil_t *sgl)
+{
+    dss_t *dss;
+
+    if (sgl == NULL || sgl->dss == NULL)
+        return;
+
+    dss = sgl->dss;
+
+    dss_refs_clear(&(dss->certs));
+    dss_refs_clear(&(dss->ocsps));
+    dss_refs_clear(&(dss->crls));
+
+    sk_X509_pop_free(dss->x509s, X509_free);
+    sk_X509_CRL_free(dss->x509_crls);
+
+    for (size_t i = 0; i < dss->object_count; i++) {
+        dss_object_release(dss->objects[i]);
+    }
+    free(dss->objects);
+
+    sigil_zeroize(dss, sizeof(*dss));
+    free(dss);
+
+    sgl->dss = NULL;
+}
+
+int sigil_dss_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    dss_object_t *shared;
+
+    print_module_name("dss", verbosity);
+
+    dss_cache_clear();
+
+    // TEST: the streams of the dictionary and of the VRI entries
+    print_test_item("fn dss_load", verbosity);
+
+    sgl = test_prepare_sgl_path("test/dss_valid.pdf");
+    if (sgl == NULL ||
+        sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+        sigil_verify(sgl) != ERR_NONE ||
+        sgl->dss == NULL)
+    {
+        goto failed;
+    }
+
+    // the VRI entry refers to the same streams
+    if (sgl->dss->certs.count != 1 || sgl->dss->crls.count != 1 ||
+        sgl->dss->ocsps.count != 1 || sk_X509_num(sgl->dss->x509s) != 1 ||
+        sk_X509_CRL_num(sgl->dss->x509_crls) != 1 || sgl->dss->object_count != 2 ||
+        dss_cache_count != 2)
+    {
+        goto failed;
+    }
+
+    // repeated call does nothing
+    if (dss_load(sgl) != ERR_NONE || sgl->dss->object_count != 2)
+        goto failed;
+
+    // error of the load is reported by the repeated call
+    sgl->dss->error = ERR_ALLOCATION;
+    if (dss_load(sgl) != ERR_ALLOCATION || sgl->dss->object_count != 2)
+        goto failed;
+
+    sigil_free(&sgl);
+
+    // only the VRI entry refers to the CRL
+    sgl = test_prepare_sgl_path("test/dss_revoked_crl.pdf");
+    if (sgl == NULL || sigil_verify(sgl) != ERR_NONE || sgl->dss == NULL ||
+        sgl->dss->crls.count != 1 || sgl->dss->ocsps.count != 0 ||
+        sk_X509_CRL_num(sgl->dss->x509_crls) != 1)
+    {
+        goto failed;
+    }
+
+    sigil_free(&sgl);
+
+    // without the DSS
+    sgl = test_prepare_sgl_path("test/subtype_adbe.pkcs7.detached.pdf");
+    if (sgl == NULL || sigil_verify(sgl) != ERR_NONE || sgl->dss == NULL ||
+        sgl->dss->object_count != 0 || sk_X509_num(sgl->dss->x509s) != 0)
+    {
+        goto failed;
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // TEST: the same content is decoded once and shared
+    print_test_item("revocation data cache", verbosity);
+
+    {
+        const unsigned char garbage[] = { 0x30, 0x03, 0x02, 0x01, 0x00 };
+        sigil_t *other = NULL;
+
+        dss_cache_clear();
+
+        sgl = test_prepare_sgl_path("test/dss_valid.pdf");
+        other = test_prepare_sgl_path("test/dss_valid.pdf");
+        if (sgl == NULL || other == NULL ||
+            sigil_verify(sgl) != ERR_NONE || sigil_verify(other) != ERR_NONE ||
+            dss_cache_count != 2 ||
+            sgl->dss->objects[0] != other->dss->objects[0] ||
+            sgl->dss->objects[0]->refs != 3)
+        {
+            sigil_free(&other);
+            goto failed;
+        }
+
+        sigil_free(&other);
+
+        // the data used by the context outlive the cache
+        shared = sgl->dss->objects[0];
+        dss_cache_clear();
+
+        if (dss_cache_count != 0 || shared->refs != 1 || shared->crl == NULL)
+            goto failed;
+
+        sigil_free(&sgl);
+
+        // not decodable data are not cached
+        if (dss_cache_get(garbage, sizeof(garbage), DSS_OBJECT_CRL) != NULL ||
+            dss_cache_get(garbage, sizeof(garbage), DSS_OBJECT_OCSP) != NULL ||
+            dss_cache_count != 0)
+        {
+            goto failed;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    sigil_free(&sgl);
+    dss_cache_clear();
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -0,0 +1,688 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "objstm.h"
+#include "sigil.h"
+#include "stream.h"
+#include "xref.h"
+
+#define OBJSTM_TYPE_NAME_MAX    10
+// object stream with /Length stored in another object stream, which has it
+// in another one... limits also the cyclic references
+#define OBJSTM_NESTING_MAX      2
+
+static void objstm_clear(objstm_t *objstm)
+{
+    if (objstm == NULL)
+        return;
+
+    if (objstm->data != NULL) {
+        sigil_zeroize(objstm->data, objstm->size);
+        free(objstm->data);
+    }
+    free(objstm->object);
+
+    memset(objstm, 0, sizeof(*objstm));
+}
+
+void objstm_cache_free(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return;
+
+    sgl->pdf_data.objstm = NULL;
+
+    if (sgl->objstm_cache == NULL)
+        return;
+
+    for (size_t i = 0; i < sgl->objstm_cache->count; i++) {
+        objstm_clear(&(sgl->objstm_cache->entry[i]));
+    }
+
+    free(sgl->objstm_cache->entry);
+    free(sgl->objstm_cache);
+    sgl->objstm_cache = NULL;
+}
+
+static sigil_err_t objstm_cache_init(sigil_t *sgl)
+{
+    objstm_cache_t *cache;
+
+    cache = malloc(sizeof(objstm_cache_t));
+    if (cache == NULL)
+        return ERR_ALLOCATION;
+
+    cache->entry = calloc(OBJSTM_CACHE_SIZE, sizeof(objstm_t));
+    if (cache->entry == NULL) {
+        free(cache);
+        return ERR_ALLOCATION;
+    }
+
+    cache->count = 0;
+    cache->capacity = OBJSTM_CACHE_SIZE;
+    cache->clock = 0;
+    cache->depth = 0;
+
+    sgl->objstm_cache = cache;
+
+    return ERR_NONE;
+}
+
+/** @brief Parses the dictionary of the object stream and locates its data
+ *
+ * @param sgl context
+ * @param stream_num object number of the object stream
+ * @param info output - information for decoding of the stream
+ * @param n output - number of the objects in the stream
+ * @param first output - offset of the first object in the decoded data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t parse_objstm_dict(sigil_t *sgl, size_t stream_num,
+                                     stream_info_t *info, size_t *n, size_t *first)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Type,        0, 0 },
+        { DICT_KEY_N,           0, 0 },
+        { DICT_KEY_First,       0, 0 },
+        { DICT_KEY_Filter,      0, 0 },
+        { DICT_KEY_DecodeParms, 0, 0 },
+        { DICT_KEY_Length,      0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+    reference_t ref;
+    xref_entry_t entry;
+    size_t dict_position;
+    char type[OBJSTM_TYPE_NAME_MAX];
+
+    ref.object_num = stream_num;
+    ref.generation_num = 0;
+
+    // the object stream itself can not be compressed
+    if ((err = xref_find(sgl, &ref, &entry)) != ERR_NONE)
+        return err;
+    if (XREF_ENTRY_TYPE(entry) != XREF_ENTRY_IN_USE)
+        return ERR_PDF_CONTENT;
+
+    if ((err = pdf_goto_obj(sgl, &ref)) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE ||
+        (err = get_curr_position(sgl, &dict_position)) != ERR_NONE ||
+        (err = parse_dict_projection(sgl, entries, count)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Type)) != ERR_NONE ||
+        (err = parse_name(sgl, type, OBJSTM_TYPE_NAME_MAX)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+    if (strcmp(type, "ObjStm") != 0)
+        return ERR_PDF_CONTENT;
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_N)) != ERR_NONE ||
+        (err = parse_number(sgl, n)) != ERR_NONE ||
+        (err = dict_projection_goto(sgl, entries, count, DICT_KEY_First)) != ERR_NONE ||
+        (err = parse_number(sgl, first)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Filter) == ERR_NONE &&
+        (err = parse_stream_filter(sgl, info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_DecodeParms) == ERR_NONE &&
+        (err = parse_stream_decode_parms(sgl, info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Length)) != ERR_NONE ||
+        (err = parse_stream_length(sgl, info)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+
+    // the data follow the end of the dictionary
+    if ((err = pdf_move_pos_abs(sgl, dict_position)) != ERR_NONE ||
+        (err = skip_dictionary(sgl)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    return locate_stream_data(sgl, info);
+}
+
+/** @brief Decodes the whole data of the object stream
+ *
+ * @param sgl context
+ * @param info information for decoding of the stream
+ * @param objstm output - the data and size are set
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_objstm_data(sigil_t *sgl, const stream_info_t *info,
+                                    objstm_t *objstm)
+{
+    sigil_err_t err;
+    stream_reader_t *reader = NULL;
+    size_t capacity = 0,
+           requested,
+           read_size;
+    char *data;
+
+    if ((err = stream_reader_open(sgl, info, &reader)) != ERR_NONE)
+        return err;
+
+    do {
+        if (objstm->size == capacity) {
+            if (capacity >= OBJSTM_SIZE_MAX) {
+                err = ERR_PDF_CONTENT;
+                goto end;
+            }
+
+            capacity = MIN(2 * capacity + STREAM_CHUNK_SIZE, OBJSTM_SIZE_MAX);
+            data = realloc(objstm->data, capacity);
+            if (data == NULL) {
+                err = ERR_ALLOCATION;
+                goto end;
+            }
+            objstm->data = data;
+        }
+
+        requested = MIN(STREAM_CHUNK_SIZE, capacity - objstm->size);
+        err = stream_read(reader, (unsigned char *)objstm->data + objstm->size,
+                          requested, &read_size);
+        if (err != ERR_NONE)
+            goto end;
+
+        objstm->size += read_size;
+    } while (read_size == requested);
+
+end:
+    stream_reader_free(&reader);
+
+    return err;
+}
+
+/** @brief Parses the pairs of the object number and offset at the beginning
+ *         of the decoded object stream. The stream is active after the call
+ *
+ * @param sgl context
+ * @param objstm the decoded object stream
+ * @param n number of the objects in the stream
+ * @param first offset of the first object in the decoded data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t parse_objstm_header(sigil_t *sgl, objstm_t *objstm, size_t n,
+                                       size_t first)
+{
+    sigil_err_t err;
+    size_t offset;
+
+    // every pair takes at least 4 bytes, do not trust the count blindly
+    if (first > objstm->size || n > first / 4 + 1)
+        return ERR_PDF_CONTENT;
+
+    if (n > 0) {
+        objstm->object = malloc(n * sizeof(objstm_object_t));
+        if (objstm->object == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    sgl->pdf_data.objstm = objstm;
+    sgl->pdf_data.objstm_pos = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if ((err = parse_number(sgl, &(objstm->object[i].object_num))) != ERR_NONE ||
+            (err = parse_number(sgl, &offset)) != ERR_NONE)
+        {
+            return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+        }
+
+        if (offset >= objstm->size - first)
+            return ERR_PDF_CONTENT;
+
+        objstm->object[i].offset = first + offset;
+        objstm->object_count++;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Decodes the object stream and parses its table of objects
+ *
+ * @param sgl context
+ * @param stream_num object number of the object stream
+ * @param objstm output - the decoded stream, to be cleared by the caller
+ * @return ERR_NONE if success
+ */
+static sigil_err_t load_objstm(sigil_t *sgl, size_t stream_num, objstm_t *objstm)
+{
+    sigil_err_t err;
+    stream_info_t info;
+    size_t n,
+           first;
+
+    stream_info_init(&info);
+
+    objstm->stream_num = stream_num;
+
+    if ((err = parse_objstm_dict(sgl, stream_num, &info, &n, &first)) != ERR_NONE ||
+        (err = read_objstm_data(sgl, &info, objstm)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    err = parse_objstm_header(sgl, objstm, n, first);
+    sgl->pdf_data.objstm = NULL;
+
+    return err;
+}
+
+/** @brief Provides the decoded object stream - from the cache, or decodes it
+ *         and replaces the least recently used stream, other than the active
+ *         one. The current position is preserved
+ *
+ * @param sgl context
+ * @param stream_num object number of the object stream
+ * @param result output - the decoded stream, owned by the cache
+ * @return ERR_NONE if success
+ */
+static sigil_err_t objstm_get(sigil_t *sgl, size_t stream_num, objstm_t **result)
+{
+    sigil_err_t err;
+    objstm_cache_t *cache;
+    objstm_t loaded,
+            *slot,
+            *active = sgl->pdf_data.objstm;
+    size_t original_position;
+
+    if (stream_num > OBJSTM_STREAM_MAX)
+        return ERR_PDF_CONTENT;
+
+    if (sgl->objstm_cache == NULL && (err = objstm_cache_init(sgl)) != ERR_NONE)
+        return err;
+    cache = sgl->objstm_cache;
+
+    for (size_t i = 0; i < cache->count; i++) {
+        if (cache->entry[i].stream_num == stream_num) {
+            cache->entry[i].last_use = ++(cache->clock);
+            *result = &(cache->entry[i]);
+            return ERR_NONE;
+        }
+    }
+
+    if (cache->depth >= OBJSTM_NESTING_MAX)
+        return ERR_PDF_CONTENT;
+
+    if ((err = get_curr_position(sgl, &original_position)) != ERR_NONE)
+        return err;
+
+    memset(&loaded, 0, sizeof(loaded));
+
+    cache->depth++;
+    err = load_objstm(sgl, stream_num, &loaded);
+    cache->depth--;
+
+    if (err != ERR_NONE) {
+        objstm_clear(&loaded);
+        return err;
+    }
+
+    if (cache->count < cache->capacity) {
+        slot = &(cache->entry[cache->count++]);
+    } else {
+        slot = NULL;
+        for (size_t i = 0; i < cache->count; i++) {
+            if (&(cache->entry[i]) == active)
+                continue;
+            if (slot == NULL || cache->entry[i].last_use < slot->last_use)
+                slot = &(cache->entry[i]);
+        }
+        objstm_clear(slot);
+    }
+
+    *slot = loaded;
+    slot->last_use = ++(cache->clock);
+    *result = slot;
+
+    // the active stream may have been replaced while decoding a nested one,
+    // then it is decoded again
+    return pdf_move_pos_abs(sgl, original_position);
+}
+
+sigil_err_t objstm_object_position(sigil_t *sgl, size_t stream_num, size_t index,
+                                   size_t object_num, size_t *position)
+{
+    sigil_err_t err;
+    objstm_t *objstm;
+
+    if (sgl == NULL || position == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = objstm_get(sgl, stream_num, &objstm)) != ERR_NONE)
+        return err;
+
+    // the index from the xref entry is used, if it matches the table
+    if (index >= objstm->object_count || objstm->object[index].object_num != object_num) {
+        for (index = 0; index < objstm->object_count; index++) {
+            if (objstm->object[index].object_num == object_num)
+                break;
+        }
+        if (index >= objstm->object_count)
+            return ERR_PDF_CONTENT;
+    }
+
+    *position = OBJSTM_POSITION(stream_num, objstm->object[index].offset);
+
+    return ERR_NONE;
+}
+
+sigil_err_t objstm_move_pos(sigil_t *sgl, size_t position)
+{
+    sigil_err_t err;
+    objstm_t *objstm;
+    size_t stream_num = OBJSTM_POSITION_STREAM(position),
+           offset = OBJSTM_POSITION_OFFSET(position);
+
+    if (sgl == NULL || !IS_OBJSTM_POSITION(position))
+        return ERR_PARAMETER;
+
+    objstm = sgl->pdf_data.objstm;
+    if (objstm == NULL || objstm->stream_num != stream_num) {
+        if ((err = objstm_get(sgl, stream_num, &objstm)) != ERR_NONE)
+            return err;
+    }
+
+    // the end of the stream is valid, as for pdf_move_pos_rel
+    if (offset > objstm->size)
+        return ERR_IO;
+
+    sgl->pdf_data.objstm = objstm;
+    sgl->pdf_data.objstm_pos = offset;
+
+    return ERR_NONE;
+}
+
+/** @brief Appends the object stream with two objects - numbers 10 * k and
+ *         10 * k + 1, the first stream is compressed
+ *
+ * @return the number of bytes appended
+ */
+static size_t test_append_objstm(char *pdf, size_t stream_num, size_t first_object,
+                                 int compressed)
+{
+    char plain[128];
+    unsigned char data[128];
+    uLongf data_len = sizeof(data);
+    size_t header_len,
+           plain_len,
+           second_offset,
+           size;
+
+    // the second object follows the first one and the newline
+    second_offset = (size_t)sprintf(plain, "%zd\n", 10 * stream_num);
+    header_len = (size_t)sprintf(plain, "%zd 0 %zd %zd ", first_object,
+                                 first_object + 1, second_offset);
+    plain_len = header_len + (size_t)sprintf(plain + header_len, "%zd\n%zd",
+                                             10 * stream_num, 10 * stream_num + 1);
+
+    if (compressed) {
+        if (compress(data, &data_len, (unsigned char *)plain, plain_len) != Z_OK)
+            return 0;
+    } else {
+        memcpy(data, plain, plain_len);
+        data_len = plain_len;
+    }
+
+    size = (size_t)sprintf(pdf, "%zd 0 obj\n<</Type/ObjStm/N 2/First %zd%s"
+                           "/Length %lu>>\nstream\n", stream_num, header_len,
+                           compressed ? "/Filter/FlateDecode" : "",
+                           (unsigned long)data_len);
+    memcpy(pdf + size, data, data_len);
+    size += data_len;
+    size += (size_t)sprintf(pdf + size, "\nendstream\nendobj\n");
+
+    return size;
+}
+
+/** @brief Builds the PDF with the object streams 1..stream_count, each with
+ *         two compressed objects (stream_count + 2k - 1 and stream_count + 2k),
+ *         and the cross-reference stream without filter
+ *
+ * @return the PDF data or NULL
+ */
+static char *test_build_objstm_pdf(size_t stream_count, size_t *size)
+{
+    char *pdf;
+    size_t xref_num = 3 * stream_count + 1,
+           xref_offset,
+           stream_offset[OBJSTM_CACHE_SIZE + 2];
+    unsigned char entry[7];
+
+    if (stream_count > OBJSTM_CACHE_SIZE + 1)
+        return NULL;
+
+    pdf = malloc(256 * stream_count + 7 * (xref_num + 1) + 256);
+    if (pdf == NULL)
+        return NULL;
+
+    *size = (size_t)sprintf(pdf, "%%PDF-1.5\n");
+    for (size_t k = 1; k <= stream_count; k++) {
+        stream_offset[k] = *size;
+        *size += test_append_objstm(pdf + *size, k, stream_count + 2 * k - 1, k == 1);
+    }
+
+    xref_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "%zd 0 obj\n<</Type/XRef/Size %zd"
+                             "/W[1 4 2]/Root %zd 0 R/Length %zd>>\nstream\n",
+                             xref_num, xref_num + 1, stream_count + 1,
+                             7 * (xref_num + 1));
+
+    for (size_t i = 0; i <= xref_num; i++) {
+        size_t type = 0,
+               field2 = 0,
+               field3 = 0;
+
+        if (i >= 1 && i <= stream_count) {
+            type = 1;
+            field2 = stream_offset[i];
+        } else if (i > stream_count && i < xref_num) {
+            type = 2;
+            field2 = (i - stream_count + 1) / 2;
+            field3 = (i - stream_count + 1) % 2;
+        } else if (i == xref_num) {
+            type = 1;
+            field2 = xref_offset;
+        }
+
+        entry[0] = (unsigned char)type;
+        for (int b = 0; b < 4; b++) {
+            entry[1 + b] = (unsigned char)(field2 >> (8 * (3 - b)));
+        }
+        entry[5] = (unsigned char)(field3 >> 8);
+        entry[6] = (unsigned char)field3;
+
+        memcpy(pdf + *size, entry, sizeof(entry));
+        *size += sizeof(entry);
+    }
+
+    *size += (size_t)sprintf(pdf + *size, "\nendstream\nendobj\nstartxref\n%zd\n"
+                             "%%%%EOF\n", xref_offset);
+
+    return pdf;
+}
+
+/** @brief Goes to the compressed object and checks its value
+ *
+ * @return 0 if success, 1 if failed
+ */
+static int test_goto_value(sigil_t *sgl, size_t object_num, size_t value)
+{
+    reference_t ref;
+    size_t number;
+
+    ref.object_num = object_num;
+    ref.generation_num = 0;
+
+    if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+        parse_number(sgl, &number) != ERR_NONE || number != value)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+int sigil_objstm_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    char *pdf = NULL;
+    size_t size = 0;
+
+    print_module_name("objstm", verbosity);
+
+    // TEST: virtual positions
+    print_test_item("virtual positions", verbosity);
+
+    {
+        size_t position = OBJSTM_POSITION(OBJSTM_STREAM_MAX, 123456);
+
+        if (!IS_OBJSTM_POSITION(position) || IS_OBJSTM_POSITION((size_t)123456) ||
+            OBJSTM_POSITION_STREAM(position) != OBJSTM_STREAM_MAX ||
+            OBJSTM_POSITION_OFFSET(position) != 123456)
+        {
+            goto failed;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: objects from the compressed stream
+    print_test_item("fn objstm_object_position", verbosity);
+
+    pdf = test_build_objstm_pdf(2, &size);
+    if (pdf == NULL || (sgl = test_prepare_sgl_buffer(pdf, size)) == NULL)
+        goto failed;
+    sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+    pdf = NULL;
+
+    if (read_startxref(sgl) != ERR_NONE || process_xref_chain(sgl) != ERR_NONE ||
+        sgl->ref_catalog_dict.object_num != 3)
+    {
+        goto failed;
+    }
+
+    // both objects of the first stream, then the second stream
+    if (test_goto_value(sgl, 3, 10) != 0 || test_goto_value(sgl, 4, 11) != 0 ||
+        sgl->objstm_cache == NULL || sgl->objstm_cache->count != 1 ||
+        test_goto_value(sgl, 6, 21) != 0 || test_goto_value(sgl, 5, 20) != 0 ||
+        sgl->objstm_cache->count != 2)
+    {
+        goto failed;
+    }
+
+    {
+        reference_t ref;
+        size_t position,
+               result;
+
+        // wrong generation, and the object stream itself is not compressed
+        ref.object_num = 3;
+        ref.generation_num = 1;
+        if (pdf_goto_obj(sgl, &ref) == ERR_NONE)
+            goto failed;
+
+        ref.object_num = 1;
+        ref.generation_num = 0;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE ||
+            IS_OBJSTM_POSITION(result))
+        {
+            goto failed;
+        }
+
+        // stored virtual position is usable later, from the other data
+        ref.object_num = 4;
+        if (reference_to_offset(sgl, &ref, &position) != ERR_NONE ||
+            pdf_move_pos_abs(sgl, 0) != ERR_NONE ||
+            pdf_move_pos_abs(sgl, position) != ERR_NONE ||
+            get_curr_position(sgl, &result) != ERR_NONE || result != position ||
+            parse_number(sgl, &result) != ERR_NONE || result != 11)
+        {
+            goto failed;
+        }
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // TEST: cache bounded by OBJSTM_CACHE_SIZE
+    print_test_item("object stream cache", verbosity);
+
+    pdf = test_build_objstm_pdf(OBJSTM_CACHE_SIZE + 1, &size);
+    if (pdf == NULL || (sgl = test_prepare_sgl_buffer(pdf, size)) == NULL)
+        goto failed;
+    sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+    pdf = NULL;
+
+    if (read_startxref(sgl) != ERR_NONE || process_xref_chain(sgl) != ERR_NONE)
+        goto failed;
+
+    {
+        const size_t streams = OBJSTM_CACHE_SIZE + 1;
+        reference_t ref;
+        size_t position,
+               result;
+
+        for (size_t k = 1; k <= streams; k++) {
+            if (test_goto_value(sgl, streams + 2 * k - 1, 10 * k) != 0)
+                goto failed;
+        }
+        if (sgl->objstm_cache->count != OBJSTM_CACHE_SIZE)
+            goto failed;
+
+        // the least recently used first stream was replaced, decoding it again
+        // keeps the current position in the active stream
+        if (test_goto_value(sgl, streams + 2 * streams, 10 * streams + 1) != 0 ||
+            pdf_move_pos_rel(sgl, -1) != ERR_NONE ||
+            get_curr_position(sgl, &position) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.object_num = streams + 1;
+        ref.generation_num = 0;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE ||
+            OBJSTM_POSITION_STREAM(result) != 1 ||
+            get_curr_position(sgl, &result) != ERR_NONE || result != position ||
+            sgl->objstm_cache->count != OBJSTM_CACHE_SIZE)
+        {
+            goto failed;
+        }
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    free(pdf);
+    sigil_free(&sgl);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
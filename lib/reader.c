@@ -0,0 +1,437 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "reader.h"
+#include "sigil.h"
+#include "types.h"
+
+#ifdef _WIN32
+    #define READER_SERIAL
+#else
+    #include <pthread.h>
+#endif
+
+/** @brief One buffer of the ring with the data of one chunk
+ *
+ */
+typedef struct {
+    char   *data;
+    size_t  length;
+} reader_buffer_t;
+
+/** @brief State of the reader. The cursor in the ranges is used only by the
+ *         reading thread, the ring is shared under the lock - the buffers
+ *         from head are filled, the first of them can be returned to the
+ *         consumer
+ *
+ */
+struct reader_t {
+    sigil_t         *sgl;
+    const range_t   *range;
+    size_t           offset;
+    reader_buffer_t  buffers[READER_BUFFER_COUNT];
+    size_t           head;
+    size_t           filled;
+    int              returned;
+    int              done;
+    int              stop;
+    sigil_err_t      err;
+    int              threaded;
+    #ifndef READER_SERIAL
+        pthread_t        thread;
+        pthread_mutex_t  lock;
+        pthread_cond_t   cond_filled;
+        pthread_cond_t   cond_free;
+    #endif
+};
+
+/** @brief Reads the next chunk of the ranges into the buffer and moves the
+ *         cursor, the position in the file is changed only at the start of
+ *         a range
+ *
+ * @param reader the reader
+ * @param buffer the buffer to be filled
+ * @return ERR_NONE if success, ERR_NO_DATA after the last range
+ */
+static sigil_err_t read_chunk(reader_t *reader, reader_buffer_t *buffer)
+{
+    sigil_err_t err;
+    size_t length;
+
+    while (reader->range != NULL && reader->offset >= reader->range->length) {
+        reader->range = reader->range->next;
+        reader->offset = 0;
+    }
+
+    if (reader->range == NULL)
+        return ERR_NO_DATA;
+
+    length = MIN(READER_BUFFER_SIZE, reader->range->length - reader->offset);
+
+    if (reader->offset == 0) {
+        err = pdf_move_pos_abs(reader->sgl, reader->range->start);
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    err = pdf_read(reader->sgl, length, buffer->data, &(buffer->length));
+    // the file ends inside of the range
+    if (err == ERR_NO_DATA || (err == ERR_NONE && buffer->length != length))
+        return ERR_IO;
+    if (err != ERR_NONE)
+        return err;
+
+    reader->offset += length;
+
+    return ERR_NONE;
+}
+
+#ifndef READER_SERIAL
+static void *reader_loop(void *arg)
+{
+    reader_t *reader = arg;
+    reader_buffer_t *buffer;
+    sigil_err_t err;
+
+    while (1) {
+        pthread_mutex_lock(&(reader->lock));
+        while (reader->filled == READER_BUFFER_COUNT && !reader->stop)
+            pthread_cond_wait(&(reader->cond_free), &(reader->lock));
+
+        if (reader->stop) {
+            pthread_mutex_unlock(&(reader->lock));
+            return NULL;
+        }
+
+        buffer = &(reader->buffers[(reader->head + reader->filled) % READER_BUFFER_COUNT]);
+        pthread_mutex_unlock(&(reader->lock));
+
+        // the free buffer is not visible to the consumer until it is counted
+        err = read_chunk(reader, buffer);
+
+        pthread_mutex_lock(&(reader->lock));
+        if (err == ERR_NONE) {
+            reader->filled++;
+        } else {
+            reader->err = err;
+            reader->done = 1;
+        }
+        pthread_cond_signal(&(reader->cond_filled));
+        pthread_mutex_unlock(&(reader->lock));
+
+        if (err != ERR_NONE)
+            return NULL;
+    }
+}
+#endif /* READER_SERIAL */
+
+sigil_err_t reader_start(sigil_t *sgl, const range_t *ranges, reader_t **reader)
+{
+    reader_t *new_reader;
+
+    if (sgl == NULL || reader == NULL)
+        return ERR_PARAMETER;
+
+    new_reader = malloc(sizeof(*new_reader));
+    if (new_reader == NULL)
+        return ERR_ALLOCATION;
+
+    sigil_zeroize(new_reader, sizeof(*new_reader));
+
+    new_reader->sgl = sgl;
+    new_reader->range = ranges;
+    new_reader->err = ERR_NONE;
+
+    for (size_t i = 0; i < READER_BUFFER_COUNT; i++) {
+        new_reader->buffers[i].data = malloc(sizeof(char) * (READER_BUFFER_SIZE + 1));
+        if (new_reader->buffers[i].data == NULL) {
+            reader_stop(&new_reader);
+            return ERR_ALLOCATION;
+        }
+    }
+
+    #ifndef READER_SERIAL
+        if (pthread_mutex_init(&(new_reader->lock), NULL) != 0) {
+            reader_stop(&new_reader);
+            return ERR_ALLOCATION;
+        }
+
+        if (pthread_cond_init(&(new_reader->cond_filled), NULL) != 0) {
+            pthread_mutex_destroy(&(new_reader->lock));
+            reader_stop(&new_reader);
+            return ERR_ALLOCATION;
+        }
+
+        if (pthread_cond_init(&(new_reader->cond_free), NULL) != 0) {
+            pthread_cond_destroy(&(new_reader->cond_filled));
+            pthread_mutex_destroy(&(new_reader->lock));
+            reader_stop(&new_reader);
+            return ERR_ALLOCATION;
+        }
+
+        // if the thread fails to start, the data are read by the consumer
+        new_reader->threaded = 1;
+        if (pthread_create(&(new_reader->thread), NULL, reader_loop, new_reader) != 0) {
+            new_reader->threaded = 0;
+            pthread_cond_destroy(&(new_reader->cond_free));
+            pthread_cond_destroy(&(new_reader->cond_filled));
+            pthread_mutex_destroy(&(new_reader->lock));
+        }
+    #endif
+
+    *reader = new_reader;
+
+    return ERR_NONE;
+}
+
+sigil_err_t reader_next(reader_t *reader, const char **data, size_t *length)
+{
+    sigil_err_t err;
+    reader_buffer_t *buffer;
+
+    if (reader == NULL || data == NULL || length == NULL)
+        return ERR_PARAMETER;
+
+    if (!reader->threaded) {
+        if (reader->done)
+            return reader->err;
+
+        buffer = &(reader->buffers[0]);
+
+        err = read_chunk(reader, buffer);
+        if (err != ERR_NONE) {
+            reader->err = err;
+            reader->done = 1;
+            return err;
+        }
+
+        *data = buffer->data;
+        *length = buffer->length;
+
+        return ERR_NONE;
+    }
+
+    #ifndef READER_SERIAL
+        pthread_mutex_lock(&(reader->lock));
+
+        if (reader->returned) {
+            reader->head = (reader->head + 1) % READER_BUFFER_COUNT;
+            reader->filled--;
+            reader->returned = 0;
+            pthread_cond_signal(&(reader->cond_free));
+        }
+
+        while (reader->filled == 0 && !reader->done)
+            pthread_cond_wait(&(reader->cond_filled), &(reader->lock));
+
+        // the error comes after all the chunks read before it
+        if (reader->filled == 0) {
+            err = reader->err;
+        } else {
+            buffer = &(reader->buffers[reader->head]);
+            *data = buffer->data;
+            *length = buffer->length;
+            reader->returned = 1;
+            err = ERR_NONE;
+        }
+
+        pthread_mutex_unlock(&(reader->lock));
+
+        return err;
+    #else
+        return ERR_NOT_IMPLEMENTED;
+    #endif
+}
+
+void reader_stop(reader_t **reader)
+{
+    if (reader == NULL || *reader == NULL)
+        return;
+
+    #ifndef READER_SERIAL
+        if ((*reader)->threaded) {
+            pthread_mutex_lock(&((*reader)->lock));
+            (*reader)->stop = 1;
+            pthread_cond_signal(&((*reader)->cond_free));
+            pthread_mutex_unlock(&((*reader)->lock));
+
+            pthread_join((*reader)->thread, NULL);
+
+            pthread_cond_destroy(&((*reader)->cond_free));
+            pthread_cond_destroy(&((*reader)->cond_filled));
+            pthread_mutex_destroy(&((*reader)->lock));
+        }
+    #endif
+
+    for (size_t i = 0; i < READER_BUFFER_COUNT; i++)
+        free((*reader)->buffers[i].data);
+
+    free(*reader);
+    *reader = NULL;
+}
+
+/** @brief Prepares the context reading the PDF data only from the temporary
+ *         file with the repeating pattern
+ *
+ * @param size size of the file
+ * @return the context or NULL
+ */
+static sigil_t *test_prepare_sgl_file(size_t size)
+{
+    sigil_t *sgl;
+    FILE *file;
+
+    if ((file = tmpfile()) == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < size; i++) {
+        if (fputc((int)(i % 251), file) == EOF) {
+            fclose(file);
+            return NULL;
+        }
+    }
+
+    if (sigil_init(&sgl) != ERR_NONE) {
+        fclose(file);
+        return NULL;
+    }
+
+    sgl->pdf_data.file = file;
+    sgl->pdf_data.size = size;
+    sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+
+    return sgl;
+}
+
+/** @brief Checks that the data are the pattern of the test file
+ *
+ */
+static int test_check_pattern(const char *data, size_t length, size_t position)
+{
+    for (size_t i = 0; i < length; i++) {
+        if ((unsigned char)data[i] != (position + i) % 251)
+            return 0;
+    }
+
+    return 1;
+}
+
+int sigil_reader_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    reader_t *reader = NULL;
+    const char *data;
+    size_t length;
+
+    print_module_name("reader", verbosity);
+
+    // TEST: fn reader_next - the chunks of the ranges in their order
+    print_test_item("fn reader_next", verbosity);
+
+    {
+        const size_t size = 2 * READER_BUFFER_SIZE + 100;
+        range_t ranges[3] = {
+            { 0,  2 * READER_BUFFER_SIZE + 50, &(ranges[1]) },
+            { 5,  0,                           &(ranges[2]) },
+            { 10, 20,                          NULL },
+        };
+        const size_t expected[][2] = {
+            { 0,                       READER_BUFFER_SIZE },
+            { READER_BUFFER_SIZE,      READER_BUFFER_SIZE },
+            { 2 * READER_BUFFER_SIZE,  50 },
+            { 10,                      20 },
+        };
+
+        if ((sgl = test_prepare_sgl_file(size)) == NULL ||
+            reader_start(sgl, ranges, &reader) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        for (size_t i = 0; i < sizeof(expected) / sizeof(*expected); i++) {
+            if (reader_next(reader, &data, &length) != ERR_NONE ||
+                length != expected[i][1] ||
+                !test_check_pattern(data, length, expected[i][0]))
+            {
+                goto failed;
+            }
+        }
+
+        if (reader_next(reader, &data, &length) != ERR_NO_DATA ||
+            reader_next(reader, &data, &length) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        reader_stop(&reader);
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: the error of the reading after the data read before
+    print_test_item("error propagation", verbosity);
+
+    {
+        range_t ranges[2] = {
+            { 0,    100, &(ranges[1]) },
+            { 1000, 50,  NULL },
+        };
+
+        if ((sgl = test_prepare_sgl_file(1010)) == NULL ||
+            reader_start(sgl, ranges, &reader) != ERR_NONE ||
+            reader_next(reader, &data, &length) != ERR_NONE ||
+            length != 100 || !test_check_pattern(data, length, 0) ||
+            reader_next(reader, &data, &length) != ERR_IO)
+        {
+            goto failed;
+        }
+
+        reader_stop(&reader);
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn reader_stop - with the reading thread waiting for a buffer
+    print_test_item("fn reader_stop", verbosity);
+
+    {
+        const size_t size = (READER_BUFFER_COUNT + 2) * READER_BUFFER_SIZE;
+        range_t range = { 0, size, NULL };
+
+        if ((sgl = test_prepare_sgl_file(size)) == NULL ||
+            reader_start(sgl, &range, &reader) != ERR_NONE ||
+            reader_next(reader, &data, &length) != ERR_NONE ||
+            length != READER_BUFFER_SIZE)
+        {
+            goto failed;
+        }
+
+        reader_stop(&reader);
+        if (reader != NULL)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    reader_stop(&reader);
+    if (sgl != NULL)
+        sigil_free(&sgl);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -0,0 +1,700 @@
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "objstm.h"
+#include "reconstruct.h"
+#include "revision.h"
+#include "sigil.h"
+#include "trailer.h"
+#include "workers.h"
+#include "xref.h"
+
+// the longest object header taken into account, as in the raw scanning
+#define OBJ_HEADER_MAX          48
+#define OBJ_NUMBER_DIGITS_MAX   10
+#define OBJ_GENERATION_DIGITS_MAX 5
+#define TRAILER_KEYWORD_LEN     7
+#define RECONSTRUCT_TYPE_NAME_MAX 10
+#define RESULT_PREALLOCATION    64
+
+/** @brief Object header found in the data
+ *
+ */
+typedef struct {
+    size_t object_num;
+    size_t generation_num;
+    size_t offset;
+} found_obj_t;
+
+/** @brief One part of the data for the scanning - the keywords starting in the
+ *         range from-to are looked up, the data around the range are available
+ *         for the header and the keyword, so nothing is missed on the boundary
+ *
+ */
+typedef struct {
+    const char  *data;
+    size_t       data_len;
+    size_t       base;
+    size_t       from;
+    size_t       to;
+    found_obj_t *objects;
+    size_t       object_count;
+    size_t       object_capacity;
+    size_t      *trailers;
+    size_t       trailer_count;
+    size_t       trailer_capacity;
+    sigil_err_t  err;
+} scan_task_t;
+
+static sigil_err_t add_found_obj(scan_task_t *task, size_t object_num,
+                                 size_t generation_num, size_t offset)
+{
+    found_obj_t *tmp;
+
+    if (task->object_count >= task->object_capacity) {
+        task->object_capacity = MAX(2 * task->object_capacity, RESULT_PREALLOCATION);
+        tmp = realloc(task->objects, task->object_capacity * sizeof(found_obj_t));
+        if (tmp == NULL)
+            return ERR_ALLOCATION;
+        task->objects = tmp;
+    }
+
+    task->objects[task->object_count].object_num = object_num;
+    task->objects[task->object_count].generation_num = generation_num;
+    task->objects[task->object_count].offset = offset;
+    task->object_count++;
+
+    return ERR_NONE;
+}
+
+static sigil_err_t add_found_trailer(scan_task_t *task, size_t offset)
+{
+    size_t *tmp;
+
+    if (task->trailer_count >= task->trailer_capacity) {
+        task->trailer_capacity = MAX(2 * task->trailer_capacity, RESULT_PREALLOCATION);
+        tmp = realloc(task->trailers, task->trailer_capacity * sizeof(size_t));
+        if (tmp == NULL)
+            return ERR_ALLOCATION;
+        task->trailers = tmp;
+    }
+
+    task->trailers[task->trailer_count++] = offset;
+
+    return ERR_NONE;
+}
+
+/** @brief Reads the decimal number ending right before the position, going
+ *         backwards
+ *
+ * @return number of digits, 0 if there is none or too many of them
+ */
+static size_t parse_number_backwards(const char *data, size_t lowest, size_t pos,
+                                     size_t max_digits, size_t *number)
+{
+    size_t start = pos;
+
+    while (start > lowest && is_digit(data[start - 1]) && pos - start < max_digits)
+        start--;
+
+    if (start == pos || (start > lowest && is_digit(data[start - 1])))
+        return 0;
+
+    *number = 0;
+    for (size_t i = start; i < pos; i++) {
+        *number = 10 * (*number) + (size_t)(data[i] - '0');
+    }
+
+    return pos - start;
+}
+
+/** @brief Decides whether the "obj" keyword at the position closes the object
+ *         header "<num> <gen> obj", and parses it
+ *
+ * @return 1 if it is the object header, 0 otherwise
+ */
+static int parse_obj_header(const scan_task_t *task, size_t keyword,
+                            found_obj_t *found)
+{
+    const char *data = task->data;
+    size_t lowest = keyword - MIN(keyword, OBJ_HEADER_MAX),
+           pos = keyword,
+           digits;
+
+    // the keyword is followed by a whitespace, a delimiter or the end
+    if (keyword + 3 < task->data_len && !is_whitespace(data[keyword + 3]) &&
+        !is_delimiter(data[keyword + 3]))
+    {
+        return 0;
+    }
+
+    // whitespace, generation number, whitespace, object number
+    if (pos <= lowest || !is_whitespace(data[pos - 1]))
+        return 0;
+    while (pos > lowest && is_whitespace(data[pos - 1]))
+        pos--;
+
+    digits = parse_number_backwards(data, lowest, pos, OBJ_GENERATION_DIGITS_MAX,
+                                    &(found->generation_num));
+    if (digits == 0)
+        return 0;
+    pos -= digits;
+
+    if (pos <= lowest || !is_whitespace(data[pos - 1]))
+        return 0;
+    while (pos > lowest && is_whitespace(data[pos - 1]))
+        pos--;
+
+    digits = parse_number_backwards(data, lowest, pos, OBJ_NUMBER_DIGITS_MAX,
+                                    &(found->object_num));
+    if (digits == 0)
+        return 0;
+    pos -= digits;
+
+    // the header starts the line or follows the previous token, the data
+    // before the window are not known, unless it is the beginning of the PDF
+    if (pos > 0) {
+        if (!is_whitespace(data[pos - 1]) && !is_delimiter(data[pos - 1]))
+            return 0;
+    } else if (task->base > 0) {
+        return 0;
+    }
+
+    found->offset = task->base + pos;
+
+    return 1;
+}
+
+static int is_trailer_keyword(const scan_task_t *task, size_t keyword)
+{
+    const char *data = task->data;
+    size_t end = keyword + TRAILER_KEYWORD_LEN;
+
+    if (keyword > 0 && !is_whitespace(data[keyword - 1]))
+        return 0;
+
+    return (end >= task->data_len || is_whitespace(data[end]) || data[end] == '<');
+}
+
+/** @brief Finds all the object headers and trailers in the range of the task,
+ *         the data outside of the range are only looked at
+ *
+ * @param arg scan_task_t
+ */
+static void scan_task(void *arg)
+{
+    scan_task_t *task = arg;
+    const char *found;
+    found_obj_t obj;
+    size_t pos,
+           end;
+
+    task->err = ERR_NONE;
+
+    // the keyword starting inside of the range may end after it
+    end = MIN(task->to + 2, task->data_len);
+    pos = task->from;
+    while (pos < end &&
+           (found = sigil_memmem(task->data + pos, end - pos, "obj", 3)) != NULL)
+    {
+        pos = (size_t)(found - task->data);
+
+        if (parse_obj_header(task, pos, &obj) &&
+            (task->err = add_found_obj(task, obj.object_num, obj.generation_num,
+                                       obj.offset)) != ERR_NONE)
+        {
+            return;
+        }
+
+        pos += 3;
+    }
+
+    end = MIN(task->to + TRAILER_KEYWORD_LEN - 1, task->data_len);
+    pos = task->from;
+    while (pos < end &&
+           (found = sigil_memmem(task->data + pos, end - pos, "trailer",
+                                 TRAILER_KEYWORD_LEN)) != NULL)
+    {
+        pos = (size_t)(found - task->data);
+
+        if (is_trailer_keyword(task, pos) &&
+            (task->err = add_found_trailer(task, task->base + pos)) != ERR_NONE)
+        {
+            return;
+        }
+
+        pos += TRAILER_KEYWORD_LEN;
+    }
+}
+
+static void scan_tasks_free(scan_task_t *tasks, size_t task_count)
+{
+    if (tasks == NULL)
+        return;
+
+    for (size_t i = 0; i < task_count; i++) {
+        free(tasks[i].objects);
+        free(tasks[i].trailers);
+    }
+
+    free(tasks);
+}
+
+/** @brief Scans the buffered data split into the chunks processed in parallel
+ *
+ * @param sgl context
+ * @param chunk_size number of bytes scanned by one task
+ * @param tasks output - the finished tasks in the order of the data
+ * @param task_count output - number of the tasks
+ * @return ERR_NONE if success
+ */
+static sigil_err_t scan_buffer(sigil_t *sgl, size_t chunk_size, scan_task_t **tasks,
+                               size_t *task_count)
+{
+    sigil_err_t err;
+    const char *data = sgl->pdf_data.buffer + sgl->offset_pdf_start;
+    size_t data_len = sgl->pdf_data.size - sgl->offset_pdf_start;
+
+    *task_count = (data_len + chunk_size - 1) / chunk_size;
+    *tasks = calloc(MAX(*task_count, 1), sizeof(scan_task_t));
+    if (*tasks == NULL)
+        return ERR_ALLOCATION;
+
+    // all the tasks see the whole data, the boundaries need no stitching
+    for (size_t i = 0; i < *task_count; i++) {
+        (*tasks)[i].data = data;
+        (*tasks)[i].data_len = data_len;
+        (*tasks)[i].base = 0;
+        (*tasks)[i].from = i * chunk_size;
+        (*tasks)[i].to = MIN((i + 1) * chunk_size, data_len);
+    }
+
+    err = workers_run(sgl->thread_count, scan_task, *tasks, sizeof(scan_task_t),
+                      *task_count);
+    if (err != ERR_NONE)
+        return err;
+
+    for (size_t i = 0; i < *task_count; i++) {
+        if ((*tasks)[i].err != ERR_NONE)
+            return (*tasks)[i].err;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Scans the data read from the file, chunk by chunk on the calling
+ *         thread, each chunk is read with the preceding header window and
+ *         the rest of the keyword
+ *
+ * @param sgl context
+ * @param chunk_size number of bytes scanned at once
+ * @param tasks output - one task with all the results
+ * @param task_count output - number of the tasks
+ * @return ERR_NONE if success
+ */
+static sigil_err_t scan_file(sigil_t *sgl, size_t chunk_size, scan_task_t **tasks,
+                             size_t *task_count)
+{
+    sigil_err_t err = ERR_NONE;
+    scan_task_t *task;
+    size_t data_len = sgl->pdf_data.size - sgl->offset_pdf_start,
+           window_size = OBJ_HEADER_MAX + chunk_size + TRAILER_KEYWORD_LEN,
+           position,
+           window_start,
+           read_size;
+    char *window;
+
+    *task_count = 1;
+    *tasks = calloc(1, sizeof(scan_task_t));
+    if (*tasks == NULL)
+        return ERR_ALLOCATION;
+    task = *tasks;
+
+    window = malloc(window_size + 1);
+    if (window == NULL)
+        return ERR_ALLOCATION;
+
+    for (position = 0; position < data_len; position += chunk_size) {
+        window_start = position - MIN(position, OBJ_HEADER_MAX);
+
+        err = pdf_move_pos_abs(sgl, window_start);
+        if (err != ERR_NONE)
+            break;
+
+        err = pdf_read(sgl, MIN(window_size, data_len - window_start), window,
+                       &read_size);
+        if (err != ERR_NONE)
+            break;
+
+        task->data = window;
+        task->data_len = read_size;
+        task->base = window_start;
+        task->from = position - window_start;
+        task->to = MIN(task->from + chunk_size, read_size);
+
+        scan_task(task);
+        if ((err = task->err) != ERR_NONE)
+            break;
+    }
+
+    task->data = NULL;
+    free(window);
+
+    return err;
+}
+
+/** @brief Decides whether the reference leads to an object of the rebuilt
+ *         table with the dictionary of the specified type
+ *
+ * @return 1 if so, 0 otherwise
+ */
+static int is_obj_of_type(sigil_t *sgl, reference_t *ref, const char *type)
+{
+    dict_entry_t entries[] = {
+        { DICT_KEY_Type, 0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+    char name[RECONSTRUCT_TYPE_NAME_MAX];
+
+    if (pdf_goto_obj(sgl, ref) != ERR_NONE || skip_word(sgl, "<<") != ERR_NONE ||
+        parse_dict_projection(sgl, entries, count) != ERR_NONE ||
+        dict_projection_goto(sgl, entries, count, DICT_KEY_Type) != ERR_NONE ||
+        parse_name(sgl, name, RECONSTRUCT_TYPE_NAME_MAX) != ERR_NONE)
+    {
+        return 0;
+    }
+
+    return (strcmp(name, type) == 0);
+}
+
+/** @brief Finds the catalog - from the newest trailer referring to it, or the
+ *         newest object of type Catalog (e.g. with the cross-reference streams)
+ *
+ * @return ERR_NONE if success, ERR_NO_DATA if no catalog was found
+ */
+static sigil_err_t find_catalog(sigil_t *sgl, const scan_task_t *tasks,
+                                size_t task_count)
+{
+    reference_t ref;
+
+    for (size_t i = task_count; i-- > 0; ) {
+        for (size_t j = tasks[i].trailer_count; j-- > 0; ) {
+            sgl->ref_catalog_dict.object_num = 0;
+            sgl->ref_catalog_dict.generation_num = 0;
+
+            if (pdf_move_pos_abs(sgl, tasks[i].trailers[j]) == ERR_NONE &&
+                process_trailer(sgl) == ERR_NONE &&
+                is_obj_of_type(sgl, &(sgl->ref_catalog_dict), "Catalog"))
+            {
+                return ERR_NONE;
+            }
+        }
+    }
+
+    sgl->ref_catalog_dict.object_num = 0;
+    sgl->ref_catalog_dict.generation_num = 0;
+
+    for (size_t i = task_count; i-- > 0; ) {
+        for (size_t j = tasks[i].object_count; j-- > 0; ) {
+            ref.object_num = tasks[i].objects[j].object_num;
+            ref.generation_num = tasks[i].objects[j].generation_num;
+
+            if (is_obj_of_type(sgl, &ref, "Catalog")) {
+                sgl->ref_catalog_dict = ref;
+                return ERR_NONE;
+            }
+        }
+    }
+
+    return ERR_NO_DATA;
+}
+
+/** @brief Rebuilds the table from the data scanned in the chunks of the
+ *         provided size
+ *
+ * @param sgl context
+ * @param chunk_size number of bytes scanned at once
+ * @return ERR_NONE if success
+ */
+static sigil_err_t reconstruct_xref_chunked(sigil_t *sgl, size_t chunk_size)
+{
+    sigil_err_t err;
+    scan_task_t *tasks = NULL;
+    size_t task_count = 0,
+           data_len;
+
+    if (sgl->pdf_data.size <= sgl->offset_pdf_start)
+        return ERR_NO_DATA;
+    data_len = sgl->pdf_data.size - sgl->offset_pdf_start;
+
+    if (sgl->pdf_data.buffer != NULL) {
+        err = scan_buffer(sgl, chunk_size, &tasks, &task_count);
+    } else {
+        err = scan_file(sgl, chunk_size, &tasks, &task_count);
+    }
+    if (err != ERR_NONE)
+        goto end;
+
+    // the objects of the old table (and so the object streams) are not valid,
+    // neither are the revisions of the damaged chain
+    objstm_cache_free(sgl);
+    revisions_clear(sgl);
+    if (sgl->xref != NULL)
+        xref_free(sgl->xref);
+    sgl->xref = xref_init(sgl->pdf_data.size);
+    if (sgl->xref == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    // the later definition of the object is newer, it goes first, numbers
+    // out of any reasonable range are not objects, but a garbage
+    for (size_t i = task_count; i-- > 0; ) {
+        for (size_t j = tasks[i].object_count; j-- > 0; ) {
+            const found_obj_t *obj = &(tasks[i].objects[j]);
+
+            if (obj->object_num >= data_len)
+                continue;
+
+            err = xref_add_entry(sgl->xref, obj->object_num, XREF_ENTRY_IN_USE,
+                                 obj->offset, obj->generation_num);
+            if (err != ERR_NONE && err != ERR_PDF_CONTENT)
+                goto end;
+        }
+    }
+
+    err = find_catalog(sgl, tasks, task_count);
+
+    // nothing more to follow, the whole data were scanned
+    sgl->xref->prev_section = 0;
+
+end:
+    scan_tasks_free(tasks, task_count);
+
+    return err;
+}
+
+sigil_err_t reconstruct_xref(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    return reconstruct_xref_chunked(sgl, RECONSTRUCT_CHUNK_SIZE);
+}
+
+/** @brief Prepares the context with the test file, whose newest
+ *         cross-reference table is overwritten
+ *
+ * @return the context or NULL
+ */
+static sigil_t *test_prepare_damaged(void)
+{
+    sigil_t *sgl;
+    char *xref;
+
+    sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+    if (sgl == NULL)
+        return NULL;
+
+    if (sgl->pdf_data.buffer == NULL || sgl->pdf_data.size < 58081 ||
+        (xref = sgl->pdf_data.buffer + 58077, memcmp(xref, "xref", 4) != 0))
+    {
+        sigil_free(&sgl);
+        return NULL;
+    }
+    memcpy(xref, "XXXX", 4);
+
+    return sgl;
+}
+
+/** @brief Checks the objects from both revisions of the test file in the
+ *         rebuilt table
+ *
+ * @return 0 if success, 1 if failed
+ */
+static int test_check_reconstructed(sigil_t *sgl)
+{
+    const size_t expected[][2] = {
+        { 2,  19    }, // from the original revision only
+        { 12, 10639 }, // redefined in the update
+        { 16, 11144 },
+        { 18, 58059 },
+    };
+    reference_t ref;
+    size_t offset;
+
+    if (sgl->ref_catalog_dict.object_num != 12 ||
+        sgl->ref_catalog_dict.generation_num != 0)
+    {
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(expected) / sizeof(*expected); i++) {
+        ref.object_num = expected[i][0];
+        ref.generation_num = 0;
+
+        if (reference_to_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != expected[i][1])
+        {
+            return 1;
+        }
+    }
+
+    // no such object, "endobj" is not a header
+    ref.object_num = 19;
+    if (reference_to_offset(sgl, &ref, &offset) == ERR_NONE)
+        return 1;
+
+    return 0;
+}
+
+int sigil_reconstruct_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    FILE *file = NULL;
+    char *pdf_copy = NULL;
+
+    print_module_name("reconstruct", verbosity);
+
+    // TEST: fn reconstruct_xref
+    print_test_item("fn reconstruct_xref", verbosity);
+
+    if ((sgl = test_prepare_damaged()) == NULL)
+        goto failed;
+
+    if (read_startxref(sgl) != ERR_NONE || process_xref_chain(sgl) == ERR_NONE ||
+        reconstruct_xref(sgl) != ERR_NONE || test_check_reconstructed(sgl) != 0)
+    {
+        goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: chunks of all sizes, with the keywords on the boundaries
+    print_test_item("chunk boundaries", verbosity);
+
+    {
+        const size_t chunk_sizes[] = { 1, 2, 3, 5, 7, 64, 1000, 4099 };
+
+        for (size_t threads = 1; threads <= 4; threads += 3) {
+            if (sigil_set_thread_count(sgl, threads) != ERR_NONE)
+                goto failed;
+
+            for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes); i++) {
+                if (reconstruct_xref_chunked(sgl, chunk_sizes[i]) != ERR_NONE ||
+                    test_check_reconstructed(sgl) != 0)
+                {
+                    goto failed;
+                }
+            }
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: scanning the file chunk by chunk
+    print_test_item("reconstruction from file", verbosity);
+
+    {
+        const size_t chunk_sizes[] = { 7, 1000, RECONSTRUCT_CHUNK_SIZE };
+
+        if ((file = tmpfile()) == NULL ||
+            fwrite(sgl->pdf_data.buffer, 1, sgl->pdf_data.size, file) !=
+                sgl->pdf_data.size)
+        {
+            goto failed;
+        }
+
+        // the data are not buffered
+        sigil_free(&sgl);
+        if (sigil_init(&sgl) != ERR_NONE)
+            goto failed;
+        sgl->pdf_data.file = file;
+        sgl->pdf_data.size = (size_t)ftell(file);
+        sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+        file = NULL;
+
+        for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes); i++) {
+            if (reconstruct_xref_chunked(sgl, chunk_sizes[i]) != ERR_NONE ||
+                test_check_reconstructed(sgl) != 0)
+            {
+                goto failed;
+            }
+        }
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // TEST: verification of the damaged file
+    print_test_item("sigil_verify of damaged file", verbosity);
+
+    {
+        int result;
+        size_t size;
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL || sgl->pdf_data.buffer == NULL)
+            goto failed;
+
+        // garbage appended after the signed data hides the startxref, the
+        // damaged table itself would change the digest
+        size = sgl->pdf_data.size + 2 * XREF_SEARCH_OFFSET;
+
+        pdf_copy = malloc(size);
+        if (pdf_copy == NULL)
+            goto failed;
+        memset(pdf_copy, '~', size);
+        memcpy(pdf_copy, sgl->pdf_data.buffer, sgl->pdf_data.size);
+
+        sigil_free(&sgl);
+
+        if ((sgl = test_prepare_sgl_buffer(pdf_copy, size)) == NULL)
+            goto failed;
+        sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+        pdf_copy = NULL;
+
+        if (sigil_set_raw_scan_mode(sgl, RAW_SCAN_DISABLED) != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+            result != HASH_CMP_RESULT_MATCH || sgl->signature_count != 1 ||
+            sgl->signatures[0].ref_sig_dict.object_num != 16)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        // without the reconstruction there is nothing to find
+        if ((sgl = test_prepare_damaged()) == NULL ||
+            sigil_set_raw_scan_mode(sgl, RAW_SCAN_DISABLED) != ERR_NONE ||
+            sigil_set_xref_reconstruction(sgl, XREF_RECONSTRUCT_DISABLED) != ERR_NONE ||
+            sigil_verify(sgl) == ERR_NONE)
+        {
+            goto failed;
+        }
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    if (file != NULL)
+        fclose(file);
+    free(pdf_copy);
+    sigil_free(&sgl);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
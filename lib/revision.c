@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "revision.h"
+#include "sigil.h"
+#include "xref.h"
+
+// the "startxref" with the "%%EOF" follows the trailer closely
+#define REVISION_END_SEARCH       4096
+#define REVISION_PREALLOCATION    8
+#define EOF_MARKER                "%%EOF"
+#define EOF_MARKER_LEN            5
+
+int revision_is_visited(const sigil_t *sgl, size_t section_offset)
+{
+    if (sgl == NULL)
+        return 0;
+
+    return number_set_contains(&(sgl->revisions.visited), section_offset);
+}
+
+/** @brief Looks up the "%%EOF" marker shortly after the current position, the
+ *         position is kept
+ *
+ * @return position right after the marker and its end-of-line, 0 if not found
+ */
+static size_t find_revision_end(sigil_t *sgl)
+{
+    char window[REVISION_END_SEARCH + 1];
+    const char *found;
+    size_t position,
+           read_size,
+           i;
+
+    if (get_curr_position(sgl, &position) != ERR_NONE)
+        return 0;
+
+    if (pdf_read(sgl, REVISION_END_SEARCH, window, &read_size) != ERR_NONE ||
+        pdf_move_pos_abs(sgl, position) != ERR_NONE)
+    {
+        return 0;
+    }
+
+    found = sigil_memmem(window, read_size, EOF_MARKER, EOF_MARKER_LEN);
+    if (found == NULL)
+        return 0;
+
+    // CRLF, CR or LF
+    i = (size_t)(found - window) + EOF_MARKER_LEN;
+    if (i < read_size && window[i] == '\r')
+        i++;
+    if (i < read_size && window[i] == '\n')
+        i++;
+
+    return position + i;
+}
+
+sigil_err_t revision_append(sigil_t *sgl, const revision_t *revision)
+{
+    sigil_err_t err;
+    revision_list_t *list;
+    revision_t *entry;
+
+    if (sgl == NULL || revision == NULL)
+        return ERR_PARAMETER;
+
+    if (revision_is_visited(sgl, revision->section_offset))
+        return ERR_PDF_CONTENT;
+
+    list = &(sgl->revisions);
+
+    if (list->count >= list->capacity) {
+        size_t capacity = MAX(2 * list->capacity, REVISION_PREALLOCATION);
+
+        entry = realloc(list->entry, capacity * sizeof(revision_t));
+        if (entry == NULL)
+            return ERR_ALLOCATION;
+
+        list->entry = entry;
+        list->capacity = capacity;
+    }
+
+    err = number_set_insert(&(list->visited), revision->section_offset);
+    if (err != ERR_NONE)
+        return err;
+
+    list->entry[list->count] = *revision;
+    list->count++;
+
+    return ERR_NONE;
+}
+
+sigil_err_t revision_add(sigil_t *sgl, size_t section_offset, size_t trailer_offset)
+{
+    revision_t revision;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (revision_is_visited(sgl, section_offset))
+        return ERR_PDF_CONTENT;
+
+    revision.section_offset = section_offset;
+    revision.trailer_offset = trailer_offset;
+    revision.xref_stream_offset = (sgl->xref != NULL) ? sgl->xref->stream_section : 0;
+    revision.end_offset = find_revision_end(sgl);
+
+    return revision_append(sgl, &revision);
+}
+
+void revisions_clear(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return;
+
+    free(sgl->revisions.entry);
+    number_set_clear(&(sgl->revisions.visited));
+
+    sgl->revisions.entry = NULL;
+    sgl->revisions.count = 0;
+    sgl->revisions.capacity = 0;
+}
+
+/** @brief Builds the PDF with two table sections referring to each other
+ *         through /Prev
+ *
+ * @param size output - size of the data
+ * @param startxref output - offset of the newer section
+ * @return allocated data or NULL
+ */
+static char *test_cyclic_pdf(size_t *size, size_t *startxref)
+{
+    const char *header = "%PDF-1.4\n1 0 obj\n<</Type/Catalog>>\nendobj\n";
+    const char *section = "xref\n0 2\n0000000000 65535 f\r\n0000000009 00000 n\r\n"
+                          "trailer\n<</Size 2/Root 1 0 R/Prev %010zd>>\n"
+                          "startxref\n%010zd\n%%%%EOF\n";
+    size_t first,
+           second;
+    char *pdf,
+         c;
+
+    pdf = malloc(1024);
+    if (pdf == NULL)
+        return NULL;
+
+    first = (size_t)sprintf(pdf, "%s", header);
+    second = first + (size_t)sprintf(pdf + first, section, (size_t)0, first);
+    *size = second + (size_t)sprintf(pdf + second, section, first, second);
+
+    // the older section refers back to the newer one, of the same length
+    c = pdf[second];
+    sprintf(pdf + first, section, second, first);
+    pdf[second] = c;
+
+    *startxref = second;
+
+    return pdf;
+}
+
+int sigil_revision_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    char *pdf = NULL;
+
+    print_module_name("revision", verbosity);
+
+    // TEST: revisions of the document with the incremental update
+    print_test_item("revisions of chain", verbosity);
+
+    {
+        const size_t expected[][3] = {
+            { 58077, 58256, 58415 }, // the update, ends with the file
+            { 10155, 10445, 10639 }, // the original document
+        };
+        const int modes[] = { XREF_MODE_LAZY, XREF_MODE_EAGER };
+
+        for (size_t m = 0; m < sizeof(modes) / sizeof(*modes); m++) {
+            sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+            if (sgl == NULL ||
+                sigil_set_xref_mode(sgl, modes[m]) != ERR_NONE ||
+                sigil_set_thread_count(sgl, 1 + 3 * m) != ERR_NONE ||
+                read_startxref(sgl) != ERR_NONE ||
+                process_xref_chain(sgl) != ERR_NONE ||
+                sgl->revisions.count != 2)
+            {
+                goto failed;
+            }
+
+            for (size_t i = 0; i < 2; i++) {
+                if (sgl->revisions.entry[i].section_offset != expected[i][0] ||
+                    sgl->revisions.entry[i].trailer_offset != expected[i][1] ||
+                    sgl->revisions.entry[i].end_offset != expected[i][2])
+                {
+                    goto failed;
+                }
+            }
+
+            // the chain read again replaces the list
+            if (process_xref_chain(sgl) != ERR_NONE || sgl->revisions.count != 2 ||
+                !revision_is_visited(sgl, 10155) || revision_is_visited(sgl, 10156))
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: the cycle is detected on the first repeated section
+    print_test_item("cyclic chain", verbosity);
+
+    {
+        size_t size,
+               startxref;
+
+        if ((pdf = test_cyclic_pdf(&size, &startxref)) == NULL)
+            goto failed;
+
+        for (size_t threads = 1; threads <= 4; threads += 3) {
+            if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+                sigil_set_xref_mode(sgl, XREF_MODE_EAGER) != ERR_NONE ||
+                sigil_set_thread_count(sgl, threads) != ERR_NONE ||
+                read_startxref(sgl) != ERR_NONE || sgl->offset_startxref != startxref ||
+                process_xref_chain(sgl) != ERR_PDF_CONTENT ||
+                sgl->revisions.count != 2 ||
+                sgl->revisions.entry[0].section_offset != startxref)
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+
+        free(pdf);
+        pdf = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: many revisions, the hashed offsets are rehashed
+    print_test_item("fn revision_add", verbosity);
+
+    if ((sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf")) == NULL)
+        goto failed;
+
+    for (size_t i = 0; i < 1000; i++) {
+        if (pdf_move_pos_abs(sgl, 0) != ERR_NONE ||
+            revision_add(sgl, 7 * i, 7 * i) != ERR_NONE)
+        {
+            goto failed;
+        }
+    }
+
+    for (size_t i = 0; i < 7000; i++) {
+        if (revision_is_visited(sgl, i) != (i % 7 == 0) ||
+            (i % 7 == 0 && revision_add(sgl, i, i) != ERR_PDF_CONTENT))
+        {
+            goto failed;
+        }
+    }
+
+    if (sgl->revisions.count != 1000 || sgl->revisions.entry[999].section_offset != 6993)
+        goto failed;
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    free(pdf);
+    sigil_free(&sgl);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -0,0 +1,853 @@
+#include <openssl/sha.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <utime.h>
+#endif
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "revision.h"
+#include "sidecar.h"
+#include "sigil.h"
+#include "signature.h"
+#include "xref.h"
+
+#define SIDECAR_MAGIC           "SIGILIDX"
+#define SIDECAR_MAGIC_LEN       8
+#define SIDECAR_VERSION         5
+#define SIDECAR_EXTENSION       ".sigil"
+#define SIDECAR_TMP_SUFFIX_MAX  32
+#define SIDECAR_STATE_COUNT     23
+
+// positions of the counts in the stored state, see collect_state
+#define STATE_XREF_PRESENT      11
+#define STATE_XREF_SIZE         12
+#define STATE_XREF_CAPACITY     13
+#define STATE_XREF_EXTRAS       14
+#define STATE_XREF_SUBSECTIONS  15
+#define STATE_XREF_MATERIALIZED 16
+#define STATE_REVISIONS         17
+#define STATE_XREF_HYBRID       18
+#define STATE_SIGNATURES        19
+#define STATE_DSS_OBJECT        20
+#define STATE_DSS_GENERATION    21
+#define STATE_DSS_OFFSET        22
+
+/** @brief Identity of the PDF file - the cache entry is valid only for the
+ *         file with the same values
+ *
+ */
+typedef struct {
+    uint64_t      device;
+    uint64_t      inode;
+    uint64_t      size;
+    uint64_t      mtime;
+    unsigned char tail[SHA256_DIGEST_LENGTH];
+} sidecar_key_t;
+
+#ifndef _WIN32
+
+/** @brief Computes the identity of the PDF file, including the digest of its
+ *         last SIDECAR_TAIL_SIZE bytes
+ *
+ * @param sgl context
+ * @param key output
+ * @return ERR_NONE if success, ERR_NO_DATA if the PDF is not a file
+ */
+static sigil_err_t compute_key(sigil_t *sgl, sidecar_key_t *key)
+{
+    struct stat st;
+    size_t tail_size;
+    char *tail = NULL;
+    const char *data;
+
+    if (sgl->pdf_data.file == NULL)
+        return ERR_NO_DATA;
+
+    if (fstat(fileno(sgl->pdf_data.file), &st) != 0)
+        return ERR_IO;
+
+    // the buffer or the file was changed since it was opened
+    if ((size_t)st.st_size != sgl->pdf_data.size)
+        return ERR_NO_DATA;
+
+    sigil_zeroize(key, sizeof(*key));
+    key->device = (uint64_t)st.st_dev;
+    key->inode = (uint64_t)st.st_ino;
+    key->size = (uint64_t)st.st_size;
+    key->mtime = (uint64_t)st.st_mtime;
+
+    tail_size = MIN(sgl->pdf_data.size, SIDECAR_TAIL_SIZE);
+
+    if (sgl->pdf_data.buffer != NULL) {
+        data = sgl->pdf_data.buffer + sgl->pdf_data.size - tail_size;
+    } else {
+        tail = malloc(MAX(tail_size, 1));
+        if (tail == NULL)
+            return ERR_ALLOCATION;
+
+        if (fseek(sgl->pdf_data.file, -(long)tail_size, SEEK_END) != 0 ||
+            fread(tail, 1, tail_size, sgl->pdf_data.file) != tail_size)
+        {
+            free(tail);
+            return ERR_IO;
+        }
+        data = tail;
+    }
+
+    SHA256((const unsigned char *)data, tail_size, key->tail);
+
+    free(tail);
+
+    return ERR_NONE;
+}
+
+static int key_equal(const sidecar_key_t *a, const sidecar_key_t *b)
+{
+    return (a->device == b->device && a->inode == b->inode &&
+            a->size == b->size && a->mtime == b->mtime &&
+            memcmp(a->tail, b->tail, SHA256_DIGEST_LENGTH) == 0);
+}
+
+/** @brief Composes the path of the cache entry - named after the device and
+ *         inode only, so the entry of the changed file is replaced
+ *
+ * @param cache_dir directory of the cache entries
+ * @param key identity of the PDF file
+ * @param suffix appended after the extension, may be empty
+ * @return allocated path or NULL
+ */
+static char *sidecar_path(const char *cache_dir, const sidecar_key_t *key,
+                          const char *suffix)
+{
+    const char hex[] = "0123456789abcdef";
+    unsigned char id[2 * sizeof(uint64_t)],
+                  digest[SHA256_DIGEST_LENGTH];
+    size_t dir_len = strlen(cache_dir),
+           len;
+    char *path;
+
+    memcpy(id, &(key->device), sizeof(uint64_t));
+    memcpy(id + sizeof(uint64_t), &(key->inode), sizeof(uint64_t));
+    SHA256(id, sizeof(id), digest);
+
+    len = dir_len + 1 + 2 * SHA256_DIGEST_LENGTH + strlen(SIDECAR_EXTENSION) +
+          strlen(suffix) + 1;
+    path = malloc(len);
+    if (path == NULL)
+        return NULL;
+
+    memcpy(path, cache_dir, dir_len);
+    path[dir_len] = '/';
+    for (size_t i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        path[dir_len + 1 + 2 * i]     = hex[digest[i] >> 4];
+        path[dir_len + 1 + 2 * i + 1] = hex[digest[i] & 0x0f];
+    }
+    path[dir_len + 1 + 2 * SHA256_DIGEST_LENGTH] = '\0';
+    strcat(path, SIDECAR_EXTENSION);
+    strcat(path, suffix);
+
+    return path;
+}
+
+/** @brief Fills the values of the context stored in the cache entry, the order
+ *         is shared with apply_state
+ *
+ */
+static void collect_state(const sigil_t *sgl, uint64_t *state)
+{
+    const xref_t *xref = sgl->xref;
+    size_t i = 0;
+
+    state[i++] = (uint64_t)sgl->pdf_x;
+    state[i++] = (uint64_t)sgl->pdf_y;
+    state[i++] = sgl->offset_pdf_start;
+    state[i++] = sgl->offset_startxref;
+    state[i++] = (uint64_t)sgl->xref_type;
+    state[i++] = sgl->sig_flags;
+    state[i++] = sgl->ref_catalog_dict.object_num;
+    state[i++] = sgl->ref_catalog_dict.generation_num;
+    state[i++] = sgl->ref_acroform.object_num;
+    state[i++] = sgl->ref_acroform.generation_num;
+    state[i++] = sgl->offset_acroform;
+    state[i++] = (xref != NULL);
+    state[i++] = (xref != NULL) ? xref->size_from_trailer : 0;
+    state[i++] = (xref != NULL) ? xref->capacity : 0;
+    state[i++] = (xref != NULL) ? xref->extra_count : 0;
+    state[i++] = (xref != NULL) ? xref->subsection_count : 0;
+    state[i++] = (xref != NULL) ? (uint64_t)xref->materialized : 0;
+    state[i++] = sgl->revisions.count;
+    state[i++] = (xref != NULL) ? (uint64_t)xref->hybrid_merged : 0;
+    state[i++] = sgl->signature_count;
+    state[i++] = sgl->ref_dss.object_num;
+    state[i++] = sgl->ref_dss.generation_num;
+    state[i++] = sgl->offset_dss;
+}
+
+static void apply_state(sigil_t *sgl, const uint64_t *state)
+{
+    size_t i = 0;
+
+    sgl->pdf_x = (int)state[i++];
+    sgl->pdf_y = (int)state[i++];
+    sgl->offset_pdf_start = state[i++];
+    sgl->offset_startxref = state[i++];
+    sgl->xref_type = (int)state[i++];
+    sgl->sig_flags = state[i++];
+    sgl->ref_catalog_dict.object_num = state[i++];
+    sgl->ref_catalog_dict.generation_num = state[i++];
+    sgl->ref_acroform.object_num = state[i++];
+    sgl->ref_acroform.generation_num = state[i++];
+    sgl->offset_acroform = state[i++];
+    sgl->ref_dss.object_num = state[STATE_DSS_OBJECT];
+    sgl->ref_dss.generation_num = state[STATE_DSS_GENERATION];
+    sgl->offset_dss = state[STATE_DSS_OFFSET];
+}
+
+static int write_values(FILE *file, const uint64_t *values, size_t count)
+{
+    return (fwrite(values, sizeof(uint64_t), count, file) == count);
+}
+
+static int read_values(FILE *file, uint64_t *values, size_t count)
+{
+    return (fread(values, sizeof(uint64_t), count, file) == count);
+}
+
+/** @brief Reads the cross-reference table from the cache entry, the counts
+ *         are checked against the length of the entry in advance
+ *
+ */
+static sigil_err_t read_xref(FILE *file, const uint64_t *state, size_t data_size,
+                             xref_t **result)
+{
+    sigil_err_t err = ERR_NO_DATA;
+    xref_t *xref;
+    uint64_t values[3];
+    size_t capacity = state[STATE_XREF_CAPACITY],
+           extra_count = state[STATE_XREF_EXTRAS],
+           subsection_count = state[STATE_XREF_SUBSECTIONS];
+
+    xref = xref_init(data_size);
+    if (xref == NULL)
+        return ERR_ALLOCATION;
+
+    if (capacity > 0) {
+        if ((err = xref_reserve(xref, capacity)) != ERR_NONE)
+            goto failed;
+        err = ERR_NO_DATA;
+        // not a table the data could produce
+        if (xref->capacity < capacity)
+            goto failed;
+        if (!read_values(file, xref->entry, capacity))
+            goto failed;
+    }
+
+    if (extra_count > 0) {
+        xref->extra = malloc(extra_count * sizeof(xref_extra_t));
+        if (xref->extra == NULL) {
+            err = ERR_ALLOCATION;
+            goto failed;
+        }
+        xref->extra_capacity = extra_count;
+
+        for (size_t i = 0; i < extra_count; i++) {
+            if (!read_values(file, values, 2))
+                goto failed;
+            xref->extra[i].object_num = values[0];
+            xref->extra[i].entry = values[1];
+            xref->extra_count++;
+        }
+    }
+
+    if (subsection_count > 0) {
+        xref->subsection = malloc(subsection_count * sizeof(xref_subsection_t));
+        if (xref->subsection == NULL) {
+            err = ERR_ALLOCATION;
+            goto failed;
+        }
+        xref->subsection_capacity = subsection_count;
+
+        for (size_t i = 0; i < subsection_count; i++) {
+            if (!read_values(file, values, 3))
+                goto failed;
+            xref->subsection[i].first_object = values[0];
+            xref->subsection[i].count = values[1];
+            xref->subsection[i].offset = values[2];
+            xref->subsection_count++;
+        }
+    }
+
+    xref->size_from_trailer = state[STATE_XREF_SIZE];
+    xref->materialized = (int)state[STATE_XREF_MATERIALIZED];
+    xref->hybrid_merged = (int)state[STATE_XREF_HYBRID];
+    xref->prev_section = 0;
+
+    *result = xref;
+
+    return ERR_NONE;
+
+failed:
+    xref_free(xref);
+
+    return err;
+}
+
+sigil_err_t sidecar_load(sigil_t *sgl)
+{
+    sigil_err_t err;
+    sidecar_key_t key,
+                  stored_key;
+    uint64_t header[2],
+             state[SIDECAR_STATE_COUNT],
+             values[5];
+    char magic[SIDECAR_MAGIC_LEN];
+    revision_t revision;
+    signature_t *signature;
+    char *path = NULL;
+    FILE *file = NULL;
+    xref_t *xref = NULL;
+    struct stat st;
+    size_t expected;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->cache_dir == NULL)
+        return ERR_NO_DATA;
+
+    err = compute_key(sgl, &key);
+    if (err != ERR_NONE)
+        return err;
+
+    path = sidecar_path(sgl->cache_dir, &key, "");
+    if (path == NULL)
+        return ERR_ALLOCATION;
+
+    err = ERR_NO_DATA;
+
+    file = fopen(path, "rb");
+    if (file == NULL)
+        goto end;
+
+    if (fread(magic, 1, SIDECAR_MAGIC_LEN, file) != SIDECAR_MAGIC_LEN ||
+        memcmp(magic, SIDECAR_MAGIC, SIDECAR_MAGIC_LEN) != 0 ||
+        !read_values(file, header, 2) || header[0] != SIDECAR_VERSION ||
+        header[1] != sizeof(size_t) ||
+        fread(&stored_key, sizeof(stored_key), 1, file) != 1 ||
+        !key_equal(&key, &stored_key) ||
+        !read_values(file, state, SIDECAR_STATE_COUNT))
+    {
+        goto end;
+    }
+
+    // the counts must match the length, otherwise the entry is damaged
+    if (fstat(fileno(file), &st) != 0 ||
+        state[STATE_XREF_CAPACITY] > (uint64_t)st.st_size ||
+        state[STATE_XREF_EXTRAS] > (uint64_t)st.st_size ||
+        state[STATE_XREF_SUBSECTIONS] > (uint64_t)st.st_size ||
+        state[STATE_REVISIONS] > (uint64_t)st.st_size ||
+        state[STATE_SIGNATURES] > (uint64_t)st.st_size)
+    {
+        goto end;
+    }
+    expected = SIDECAR_MAGIC_LEN + sizeof(header) + sizeof(stored_key) +
+               sizeof(state) +
+               sizeof(uint64_t) * (state[STATE_XREF_CAPACITY] +
+                                   2 * state[STATE_XREF_EXTRAS] +
+                                   3 * state[STATE_XREF_SUBSECTIONS] +
+                                   4 * state[STATE_REVISIONS] +
+                                   5 * state[STATE_SIGNATURES]);
+    if ((size_t)st.st_size != expected)
+        goto end;
+
+    if (state[STATE_XREF_PRESENT]) {
+        err = read_xref(file, state, sgl->pdf_data.size, &xref);
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    revisions_clear(sgl);
+    for (size_t i = 0; i < state[STATE_REVISIONS]; i++) {
+        if (!read_values(file, values, 4)) {
+            err = ERR_NO_DATA;
+        } else {
+            revision.section_offset = values[0];
+            revision.trailer_offset = values[1];
+            revision.xref_stream_offset = values[2];
+            revision.end_offset = values[3];
+            err = revision_append(sgl, &revision);
+        }
+
+        if (err != ERR_NONE) {
+            revisions_clear(sgl);
+            xref_free(xref);
+            err = (err == ERR_ALLOCATION) ? err : ERR_NO_DATA;
+            goto end;
+        }
+    }
+
+    signatures_clear(sgl);
+    for (size_t i = 0; i < state[STATE_SIGNATURES]; i++) {
+        if (!read_values(file, values, 5)) {
+            err = ERR_NO_DATA;
+        } else if ((err = signature_add(sgl, &signature)) == ERR_NONE) {
+            signature->ref_sig_field.object_num = values[0];
+            signature->ref_sig_field.generation_num = values[1];
+            signature->ref_sig_dict.object_num = values[2];
+            signature->ref_sig_dict.generation_num = values[3];
+            signature->offset_sig_dict = values[4];
+        }
+
+        if (err != ERR_NONE) {
+            signatures_clear(sgl);
+            revisions_clear(sgl);
+            xref_free(xref);
+            goto end;
+        }
+    }
+
+    apply_state(sgl, state);
+
+    if (sgl->xref != NULL)
+        xref_free(sgl->xref);
+    sgl->xref = xref;
+
+    err = ERR_NONE;
+
+end:
+    if (file != NULL)
+        fclose(file);
+    free(path);
+
+    return err;
+}
+
+sigil_err_t sidecar_store(sigil_t *sgl)
+{
+    sigil_err_t err;
+    sidecar_key_t key;
+    uint64_t header[2] = { SIDECAR_VERSION, sizeof(size_t) },
+             state[SIDECAR_STATE_COUNT],
+             values[5];
+    const signature_t *signature;
+    char suffix[SIDECAR_TMP_SUFFIX_MAX];
+    char *path = NULL,
+         *tmp_path = NULL;
+    FILE *file = NULL;
+    const xref_t *xref;
+    int written;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    // no signature dictionary was found, there is nothing to skip
+    if (sgl->cache_dir == NULL || sgl->signature_count == 0)
+        return ERR_NO_DATA;
+
+    err = compute_key(sgl, &key);
+    if (err != ERR_NONE)
+        return err;
+
+    // unique per process, the concurrent writers do not mix their data
+    snprintf(suffix, SIDECAR_TMP_SUFFIX_MAX, ".%ld.tmp", (long)getpid());
+
+    path = sidecar_path(sgl->cache_dir, &key, "");
+    tmp_path = sidecar_path(sgl->cache_dir, &key, suffix);
+    if (path == NULL || tmp_path == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        err = ERR_IO;
+        goto end;
+    }
+
+    collect_state(sgl, state);
+
+    written = fwrite(SIDECAR_MAGIC, 1, SIDECAR_MAGIC_LEN, file) == SIDECAR_MAGIC_LEN &&
+              write_values(file, header, 2) &&
+              fwrite(&key, sizeof(key), 1, file) == 1 &&
+              write_values(file, state, SIDECAR_STATE_COUNT);
+
+    if ((xref = sgl->xref) != NULL) {
+        if (written && xref->capacity > 0)
+            written = write_values(file, xref->entry, xref->capacity);
+
+        for (size_t i = 0; written && i < xref->extra_count; i++) {
+            values[0] = xref->extra[i].object_num;
+            values[1] = xref->extra[i].entry;
+            written = write_values(file, values, 2);
+        }
+
+        for (size_t i = 0; written && i < xref->subsection_count; i++) {
+            values[0] = xref->subsection[i].first_object;
+            values[1] = xref->subsection[i].count;
+            values[2] = xref->subsection[i].offset;
+            written = write_values(file, values, 3);
+        }
+    }
+
+    for (size_t i = 0; written && i < sgl->revisions.count; i++) {
+        values[0] = sgl->revisions.entry[i].section_offset;
+        values[1] = sgl->revisions.entry[i].trailer_offset;
+        values[2] = sgl->revisions.entry[i].xref_stream_offset;
+        values[3] = sgl->revisions.entry[i].end_offset;
+        written = write_values(file, values, 4);
+    }
+
+    for (size_t i = 0; written && i < sgl->signature_count; i++) {
+        signature = &(sgl->signatures[i]);
+        values[0] = signature->ref_sig_field.object_num;
+        values[1] = signature->ref_sig_field.generation_num;
+        values[2] = signature->ref_sig_dict.object_num;
+        values[3] = signature->ref_sig_dict.generation_num;
+        values[4] = signature->offset_sig_dict;
+        written = write_values(file, values, 5);
+    }
+
+    if (fclose(file) != 0)
+        written = 0;
+    file = NULL;
+
+    // the complete entry replaces the old one at once
+    if (!written || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        err = ERR_IO;
+        goto end;
+    }
+
+    err = ERR_NONE;
+
+end:
+    free(path);
+    free(tmp_path);
+
+    return err;
+}
+
+#else /* _WIN32 */
+
+sigil_err_t sidecar_load(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    return ERR_NO_DATA;
+}
+
+sigil_err_t sidecar_store(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    return ERR_NO_DATA;
+}
+
+#endif /* _WIN32 */
+
+#ifndef _WIN32
+
+/** @brief Copies the test file into the directory
+ *
+ * @return allocated path of the copy or NULL
+ */
+static char *test_copy_pdf(const char *dir, const char *name)
+{
+    const char *source = "test/subtype_adbe.x509.rsa_sha1.pdf";
+    char buffer[4096];
+    FILE *in = NULL,
+         *out = NULL;
+    char *path;
+    size_t len;
+    int ok = 0;
+
+    path = malloc(strlen(dir) + strlen(name) + 2);
+    if (path == NULL)
+        return NULL;
+    strcpy(path, dir);
+    strcat(path, "/");
+    strcat(path, name);
+
+    if ((in = fopen(source, "rb")) != NULL && (out = fopen(path, "wb")) != NULL) {
+        ok = 1;
+        while (ok && (len = fread(buffer, 1, sizeof(buffer), in)) > 0)
+            ok = (fwrite(buffer, 1, len, out) == len);
+    }
+
+    if (in != NULL)
+        fclose(in);
+    if (out != NULL && fclose(out) != 0)
+        ok = 0;
+
+    if (!ok) {
+        free(path);
+        return NULL;
+    }
+
+    return path;
+}
+
+/** @brief Runs the verification of the file with the cache directory set
+ *
+ * @return the context after the verification or NULL if it did not match
+ */
+static sigil_t *test_verify_cached(const char *pdf_path, const char *cache_dir)
+{
+    sigil_t *sgl;
+    int result;
+
+    sgl = test_prepare_sgl_path(pdf_path);
+    if (sgl == NULL)
+        return NULL;
+
+    if (sigil_set_cache_dir(sgl, cache_dir) != ERR_NONE ||
+        sigil_verify(sgl) != ERR_NONE ||
+        sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+        result != HASH_CMP_RESULT_MATCH)
+    {
+        sigil_free(&sgl);
+        return NULL;
+    }
+
+    return sgl;
+}
+
+/** @brief Composes the path of the cache entry for the file on the path
+ *
+ * @return allocated path or NULL
+ */
+static char *test_entry_path(const char *pdf_path, const char *cache_dir)
+{
+    sidecar_key_t key;
+    struct stat st;
+
+    if (stat(pdf_path, &st) != 0)
+        return NULL;
+
+    key.device = (uint64_t)st.st_dev;
+    key.inode = (uint64_t)st.st_ino;
+
+    return sidecar_path(cache_dir, &key, "");
+}
+
+/** @brief Decides whether the entry for the file exists
+ *
+ * @return 1 if so, 0 otherwise
+ */
+static int test_has_entry(const char *pdf_path, const char *cache_dir)
+{
+    char *path;
+    FILE *file;
+
+    if ((path = test_entry_path(pdf_path, cache_dir)) == NULL)
+        return 0;
+
+    file = fopen(path, "rb");
+    free(path);
+    if (file == NULL)
+        return 0;
+
+    fclose(file);
+    return 1;
+}
+
+/** @brief Removes the cache entry of the file, the file itself and the
+ *         cache directory
+ *
+ */
+static void test_cleanup(char *pdf_path, const char *cache_dir)
+{
+    char *path;
+
+    if (pdf_path != NULL) {
+        if ((path = test_entry_path(pdf_path, cache_dir)) != NULL) {
+            remove(path);
+            free(path);
+        }
+        remove(pdf_path);
+        free(pdf_path);
+    }
+
+    rmdir(cache_dir);
+}
+
+#endif /* _WIN32 */
+
+int sigil_sidecar_self_test(int verbosity)
+{
+#ifndef _WIN32
+    char cache_dir[] = "/tmp/pdf_sigil_sidecar_XXXXXX";
+    sigil_t *sgl = NULL,
+            *cached = NULL;
+    char *pdf_path = NULL;
+    sidecar_key_t key;
+    int dir_created = 0;
+#endif
+
+    print_module_name("sidecar", verbosity);
+
+#ifndef _WIN32
+    // TEST: without the cache directory or for the buffer
+    print_test_item("nothing cached", verbosity);
+
+    {
+        char content[] = "%PDF-1.4\n%%EOF\n";
+
+        if ((sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf")) == NULL ||
+            sidecar_load(sgl) != ERR_NO_DATA || sidecar_store(sgl) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+        sigil_free(&sgl);
+
+        if ((sgl = test_prepare_sgl_buffer(content, sizeof(content) - 1)) == NULL ||
+            sigil_set_cache_dir(sgl, "/tmp") != ERR_NONE ||
+            sidecar_load(sgl) != ERR_NO_DATA || compute_key(sgl, &key) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: the structure stored by the first verification is used by the next
+    print_test_item("store and load", verbosity);
+
+    if (mkdtemp(cache_dir) == NULL)
+        goto failed;
+    dir_created = 1;
+
+    if ((pdf_path = test_copy_pdf(cache_dir, "signed.pdf")) == NULL ||
+        (sgl = test_verify_cached(pdf_path, cache_dir)) == NULL ||
+        !test_has_entry(pdf_path, cache_dir))
+    {
+        goto failed;
+    }
+
+    // the loaded structure is the parsed one
+    if ((cached = test_prepare_sgl_path(pdf_path)) == NULL ||
+        sigil_set_cache_dir(cached, cache_dir) != ERR_NONE ||
+        sidecar_load(cached) != ERR_NONE ||
+        cached->pdf_x != sgl->pdf_x || cached->pdf_y != sgl->pdf_y ||
+        cached->offset_startxref != sgl->offset_startxref ||
+        cached->xref_type != sgl->xref_type ||
+        cached->ref_catalog_dict.object_num != 12 ||
+        cached->signature_count != 1 ||
+        cached->signatures[0].ref_sig_field.object_num != 14 ||
+        cached->signatures[0].ref_sig_dict.object_num != 16 ||
+        cached->signatures[0].offset_sig_dict != sgl->signatures[0].offset_sig_dict ||
+        cached->offset_acroform != sgl->offset_acroform ||
+        cached->ref_dss.object_num != sgl->ref_dss.object_num ||
+        cached->offset_dss != sgl->offset_dss ||
+        cached->xref == NULL || cached->revisions.count != 2 ||
+        cached->revisions.entry[1].end_offset != 10639)
+    {
+        goto failed;
+    }
+
+    {
+        reference_t ref = { 2, 0 };
+        size_t offset;
+
+        if (reference_to_offset(cached, &ref, &offset) != ERR_NONE || offset != 19)
+            goto failed;
+    }
+    sigil_free(&cached);
+
+    // the whole verification with the cached structure
+    if ((cached = test_verify_cached(pdf_path, cache_dir)) == NULL ||
+        cached->signature_count != 1 || cached->signatures[0].ref_sig_dict.object_num != 16)
+    {
+        goto failed;
+    }
+    sigil_free(&cached);
+
+    print_test_result(1, verbosity);
+
+    // TEST: any change of the file makes the entry invalid
+    print_test_item("changed file", verbosity);
+
+    {
+        struct stat st;
+        struct utimbuf times;
+        FILE *file;
+        int c;
+
+        // appended data
+        if ((file = fopen(pdf_path, "ab")) == NULL)
+            goto failed;
+        fputc('\n', file);
+        fclose(file);
+
+        if ((cached = test_prepare_sgl_path(pdf_path)) == NULL ||
+            sigil_set_cache_dir(cached, cache_dir) != ERR_NONE ||
+            sidecar_load(cached) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+        sigil_free(&cached);
+
+        // the same size and time, only the tail differs
+        if ((cached = test_verify_cached(pdf_path, cache_dir)) == NULL ||
+            stat(pdf_path, &st) != 0)
+        {
+            goto failed;
+        }
+        sigil_free(&cached);
+
+        if ((file = fopen(pdf_path, "r+b")) == NULL)
+            goto failed;
+        if (fseek(file, -1, SEEK_END) != 0 || (c = fgetc(file)) == EOF ||
+            fseek(file, -1, SEEK_END) != 0 || fputc(c == ' ' ? '\n' : ' ', file) == EOF)
+        {
+            fclose(file);
+            goto failed;
+        }
+        fclose(file);
+
+        times.actime = st.st_atime;
+        times.modtime = st.st_mtime;
+        if (utime(pdf_path, &times) != 0)
+            goto failed;
+
+        if ((cached = test_prepare_sgl_path(pdf_path)) == NULL ||
+            sigil_set_cache_dir(cached, cache_dir) != ERR_NONE ||
+            sidecar_load(cached) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+        sigil_free(&cached);
+    }
+
+    sigil_free(&sgl);
+    test_cleanup(pdf_path, cache_dir);
+    pdf_path = NULL;
+
+    print_test_result(1, verbosity);
+#endif
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+#ifndef _WIN32
+failed:
+    sigil_free(&cached);
+    sigil_free(&sgl);
+    if (dir_created)
+        test_cleanup(pdf_path, cache_dir);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+#endif
+}
@@ -11,64 +11,50 @@
 #define SUBFILTER_MAX    30
 
 
-static sigil_err_t parse_subfilter(sigil_t *sgl)
+static sigil_err_t parse_subfilter(sigil_t *sgl, signature_t *signature)
 {
     sigil_err_t err;
-    int count = 0;
-    char tmp[SUBFILTER_MAX],
-            c;
+    char tmp[SUBFILTER_MAX];
 
-    if (sgl == NULL)
+    if (sgl == NULL || signature == NULL)
         return ERR_PARAMETER;
 
-    sigil_zeroize(tmp, SUBFILTER_MAX * sizeof(*tmp));
-
-    err = skip_word(sgl, "/");
-    if (err != ERR_NONE)
-        return err;
-
-    while ((err = pdf_peek_char(sgl, &c)) == ERR_NONE) {
-        if (is_whitespace(c)) {
-            if (count <= 0)
-                return ERR_PDF_CONTENT;
-            break;
-        } else {
-            if (count >= SUBFILTER_MAX - 1)
-                return ERR_PDF_CONTENT;
-            tmp[count++] = c;
-        }
-
-        if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
-            return err;
-    }
-
+    err = parse_name(sgl, tmp, SUBFILTER_MAX);
     if (err != ERR_NONE)
         return err;
 
-    if (strncmp(tmp, "adbe.x509.rsa_sha1", 18) == 0) {
-        sgl->subfilter_type = SUBFILTER_adbe_x509_rsa_sha1;
+    if (strcmp(tmp, "adbe.x509.rsa_sha1") == 0) {
+        signature->subfilter_type = SUBFILTER_adbe_x509_rsa_sha1;
+    } else if (strcmp(tmp, "adbe.pkcs7.detached") == 0) {
+        signature->subfilter_type = SUBFILTER_adbe_pkcs7_detached;
+    } else if (strcmp(tmp, "ETSI.CAdES.detached") == 0) {
+        signature->subfilter_type = SUBFILTER_ETSI_CAdES_detached;
+    } else if (strcmp(tmp, "adbe.pkcs7.sha1") == 0) {
+        signature->subfilter_type = SUBFILTER_adbe_pkcs7_sha1;
+    } else if (strcmp(tmp, "ETSI.RFC3161") == 0) {
+        signature->subfilter_type = SUBFILTER_ETSI_RFC3161;
     } else {
-        sgl->subfilter_type = SUBFILTER_UNKNOWN;
+        signature->subfilter_type = SUBFILTER_UNKNOWN;
     }
 
     return ERR_NONE;
 }
 
-static sigil_err_t parse_byte_range(sigil_t *sgl)
+static sigil_err_t parse_byte_range(sigil_t *sgl, signature_t *signature)
 {
     sigil_err_t err;
     range_t **byte_range;
     size_t start,
            length;
 
-    if (sgl == NULL)
+    if (sgl == NULL || signature == NULL)
         return ERR_PARAMETER;
 
     err = skip_word(sgl, "[");
     if (err != ERR_NONE)
         return err;
 
-    byte_range = &(sgl->byte_range);
+    byte_range = &(signature->byte_range);
 
     while (1) {
         if (skip_word(sgl, "]") == ERR_NONE)
@@ -99,20 +85,26 @@ static sigil_err_t parse_byte_range(sigil_t *sgl)
     }
 }
 
-sigil_err_t process_sig_dict(sigil_t *sgl)
+sigil_err_t process_sig_dict(sigil_t *sgl, signature_t *signature)
 {
     sigil_err_t err;
-    dict_key_t dict_key;
-
-    if (sgl == NULL)
+    dict_entry_t entries[] = {
+        { DICT_KEY_SubFilter, 0, 0 },
+        { DICT_KEY_Cert,      0, 0 },
+        { DICT_KEY_Contents,  0, 0 },
+        { DICT_KEY_ByteRange, 0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+
+    if (sgl == NULL || signature == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->offset_sig_dict <= 0 && sgl->ref_sig_dict.object_num > 0) {
-        err = pdf_goto_obj(sgl, &(sgl->ref_sig_dict));
+    if (signature->offset_sig_dict <= 0 && signature->ref_sig_dict.object_num > 0) {
+        err = pdf_goto_obj(sgl, &(signature->ref_sig_dict));
         if (err != ERR_NONE)
             return err;
     } else {
-        err = pdf_move_pos_abs(sgl, sgl->offset_sig_dict);
+        err = pdf_move_pos_abs(sgl, signature->offset_sig_dict);
         if (err != ERR_NONE)
             return err;
     }
@@ -121,40 +113,31 @@ sigil_err_t process_sig_dict(sigil_t *sgl)
     if (err != ERR_NONE)
         return err;
 
-    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-        switch (dict_key) {
-            case DICT_KEY_SubFilter:
-                if ((err = parse_subfilter(sgl)) != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_Cert:
-                err = parse_certs(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_Contents:
-                err = parse_contents(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_ByteRange:
-                if ((err = parse_byte_range(sgl)) != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_UNKNOWN:
-                err = skip_dict_unknown_value(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            default:
-                return ERR_PDF_CONTENT;
-        }
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_SubFilter) == ERR_NONE) {
+        if ((err = parse_subfilter(sgl, signature)) != ERR_NONE)
+            return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Cert) == ERR_NONE) {
+        if ((err = parse_certs(sgl, &(signature->certificates))) != ERR_NONE)
+            return err;
     }
 
-    if (err == ERR_END_OF_DICT)
-        return ERR_NONE;
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Contents) == ERR_NONE) {
+        if ((err = parse_contents(sgl, &(signature->contents))) != ERR_NONE)
+            return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_ByteRange) == ERR_NONE) {
+        if ((err = parse_byte_range(sgl, signature)) != ERR_NONE)
+            return err;
+    }
 
-    return err;
+    return ERR_NONE;
 }
 
 int sigil_sig_dict_self_test(int verbosity)
@@ -1,72 +1,205 @@
+#include <stdlib.h>
+#include <string.h>
 #include <types.h>
+#include "acroform.h"
 #include "auxiliary.h"
+#include "catalog.h"
+#include "config.h"
 #include "constants.h"
 #include "sig_field.h"
+#include "sigil.h"
+#include "signature.h"
+#include "xref.h"
 
 
-sigil_err_t find_sig_field(sigil_t *sgl)
+#define FIELD_TYPE_UNKNOWN  0
+#define FIELD_TYPE_SIG      1
+#define FIELD_TYPE_OTHER    2
+
+#define FIELD_TYPE_NAME_MAX 8
+
+/** @brief Type for the node of the field tree waiting for the visit, with the
+ *         attributes inherited from its ancestors
+ *
+ */
+typedef struct {
+    reference_t ref;             // the node itself
+    size_t      offset;          // position of the node, the order of visits
+    reference_t ref_field;       // the nearest ancestor-or-self with /T
+    int         field_type;      // /FT
+    reference_t ref_sig_dict;    // /V as the indirect reference
+    size_t      offset_sig_dict; // /V as the direct dictionary
+} field_node_t;
+
+/** @brief Type for the state of the field tree traversal - the nodes waiting
+ *         for the visit in the min-heap ordered by the offset, so the file is
+ *         read forward, and the object numbers already seen
+ *
+ */
+typedef struct {
+    field_node_t *node;
+    size_t        count;
+    size_t        capacity;
+    number_set_t  queued;      // object numbers of the nodes ever queued
+    number_set_t  sig_fields;  // object numbers of the fields with signature
+} field_tree_t;
+
+static sigil_err_t queue_push(field_tree_t *tree, const field_node_t *node)
 {
-    sigil_err_t err;
-    dict_key_t dict_key;
-    int other_ft;
+    field_node_t *entry,
+                  tmp;
+    size_t i,
+           parent;
 
-    if (sgl == NULL)
-        return ERR_PARAMETER;
+    if (tree->count >= tree->capacity) {
+        size_t capacity = MAX(2 * tree->capacity, FIELD_TREE_PREALLOCATION);
 
-    err = ERR_NO_DATA;
+        entry = realloc(tree->node, capacity * sizeof(field_node_t));
+        if (entry == NULL)
+            return ERR_ALLOCATION;
 
-    for (size_t i = 0; i < sgl->fields.capacity; i++) {
-        if (sgl->fields.entry[i] == NULL)
-            continue;
+        tree->node = entry;
+        tree->capacity = capacity;
+    }
 
-        err = pdf_goto_obj(sgl, sgl->fields.entry[i]);
-        if (err != ERR_NONE)
-            return err;
+    i = tree->count++;
+    tree->node[i] = *node;
 
-        err = skip_word(sgl, "<<");
-        if (err != ERR_NONE)
-            return err;
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (tree->node[parent].offset <= tree->node[i].offset)
+            break;
 
-        other_ft = 0;
-
-        while (!other_ft && (err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-            switch (dict_key) {
-                case DICT_KEY_FT:
-                    if (skip_word(sgl, "/Sig") == ERR_NONE) {
-                        sgl->ref_sig_field = *(sgl->fields.entry[i]);
-                        return ERR_NONE;
-                    } else {
-                        other_ft = 1;
-                        break;
-                    }
-                case DICT_KEY_UNKNOWN:
-                    err = skip_dict_unknown_value(sgl);
-                    if (err != ERR_NONE)
-                        return err;
-                    break;
-                default:
-                    return ERR_PDF_CONTENT;
-            }
+        tmp = tree->node[parent];
+        tree->node[parent] = tree->node[i];
+        tree->node[i] = tmp;
+        i = parent;
+    }
+
+    return ERR_NONE;
+}
+
+static void queue_pop(field_tree_t *tree, field_node_t *node)
+{
+    field_node_t tmp;
+    size_t i = 0,
+           child;
+
+    *node = tree->node[0];
+    tree->node[0] = tree->node[--tree->count];
+
+    while ((child = 2 * i + 1) < tree->count) {
+        if (child + 1 < tree->count &&
+            tree->node[child + 1].offset < tree->node[child].offset)
+        {
+            child++;
         }
+
+        if (tree->node[i].offset <= tree->node[child].offset)
+            break;
+
+        tmp = tree->node[child];
+        tree->node[child] = tree->node[i];
+        tree->node[i] = tmp;
+        i = child;
     }
+}
+
+/** @brief Queues the node of the field tree for the visit, unless it was
+ *         already queued (the reference cycle). The node inherits the
+ *         attributes of the parent, the top-level field has no parent
+ *
+ */
+static sigil_err_t queue_field(sigil_t *sgl, field_tree_t *tree,
+                               const reference_t *ref, const field_node_t *parent)
+{
+    sigil_err_t err;
+    field_node_t node;
 
+    if (number_set_contains(&(tree->queued), ref->object_num))
+        return ERR_NONE;
+
+    err = number_set_insert(&(tree->queued), ref->object_num);
     if (err != ERR_NONE)
         return err;
 
-    return ERR_NO_DATA;
+    if (parent != NULL) {
+        node = *parent;
+    } else {
+        sigil_zeroize(&node, sizeof(node));
+        node.field_type = FIELD_TYPE_UNKNOWN;
+        node.ref_field = *ref;
+    }
+
+    node.ref = *ref;
+
+    // objects of the object streams get the virtual positions beyond the file
+    err = reference_to_offset(sgl, ref, &(node.offset));
+    if (err != ERR_NONE)
+        return err;
+
+    return queue_push(tree, &node);
 }
 
-sigil_err_t process_sig_field(sigil_t *sgl)
+/** @brief Loads the /V entry of the node, either the indirect reference or the
+ *         position of the direct dictionary. The value of the field of other
+ *         type than the signature is ignored
+ *
+ */
+static sigil_err_t parse_field_value(sigil_t *sgl, field_node_t *node)
 {
     sigil_err_t err;
-    size_t offset;
-    dict_key_t dict_key;
+    reference_t ref;
+    size_t position;
     char c;
 
-    if (sgl == NULL)
-        return ERR_PARAMETER;
+    if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+        return err;
+
+    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+        return err;
+
+    if (c == '<') {
+        if (skip_word(sgl, "<<") != ERR_NONE)
+            return (node->field_type == FIELD_TYPE_SIG) ? ERR_PDF_CONTENT : ERR_NONE;
+
+        node->ref_sig_dict.object_num = 0;
+        node->ref_sig_dict.generation_num = 0;
+        node->offset_sig_dict = position;
+
+        return ERR_NONE;
+    }
 
-    err = pdf_goto_obj(sgl, &(sgl->ref_sig_field));
+    err = parse_indirect_reference(sgl, &ref);
+    if (err != ERR_NONE)
+        return (node->field_type == FIELD_TYPE_SIG) ? err : ERR_NONE;
+
+    node->ref_sig_dict = ref;
+    node->offset_sig_dict = 0;
+
+    return ERR_NONE;
+}
+
+/** @brief Visits the node of the field tree - queues its kids or, for the
+ *         terminal signature field, adds the signature. The field of more
+ *         widgets (kids without /T) gets only one signature
+ *
+ */
+static sigil_err_t visit_field(sigil_t *sgl, field_tree_t *tree, field_node_t *node)
+{
+    sigil_err_t err;
+    signature_t *signature;
+    ref_array_t kids = { NULL, 0 };
+    char name[FIELD_TYPE_NAME_MAX];
+    dict_entry_t entries[] = {
+        { DICT_KEY_FT,   0, 0 },
+        { DICT_KEY_V,    0, 0 },
+        { DICT_KEY_T,    0, 0 },
+        { DICT_KEY_Kids, 0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+
+    err = pdf_goto_obj(sgl, &(node->ref));
     if (err != ERR_NONE)
         return err;
 
@@ -74,67 +207,274 @@ sigil_err_t process_sig_field(sigil_t *sgl)
     if (err != ERR_NONE)
         return err;
 
-    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-        switch (dict_key) {
-            case DICT_KEY_FT:
-                if (skip_word(sgl, "/Sig") != ERR_NONE)
-                    return ERR_PDF_CONTENT;
-                break;
-            case DICT_KEY_V:
-                if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
-                    return err;
-                if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
-                    return err;
-                if (c == '<') {
-                    if ((err = get_curr_position(sgl, &offset)) != ERR_NONE)
-                        return err;
-
-                    sgl->offset_sig_dict = offset;
-
-                    if ((err = skip_word(sgl, "<<")) != ERR_NONE)
-                        return err;
-
-                    err = skip_dictionary(sgl);
-                    if (err != ERR_NONE)
-                        return err;
-                } else {
-                    err = parse_indirect_reference(sgl, &(sgl->ref_sig_dict));
-                    if (err != ERR_NONE)
-                        return err;
-                }
-                break;
-            case DICT_KEY_UNKNOWN:
-                err = skip_dict_unknown_value(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            default:
-                return ERR_PDF_CONTENT;
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_FT) == ERR_NONE) {
+        err = parse_name(sgl, name, sizeof(name));
+        if (err != ERR_NONE)
+            return err;
+
+        node->field_type = (strcmp(name, "Sig") == 0) ? FIELD_TYPE_SIG : FIELD_TYPE_OTHER;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_T) == ERR_NONE)
+        node->ref_field = node->ref;
+
+    if (node->field_type != FIELD_TYPE_OTHER &&
+        dict_projection_goto(sgl, entries, count, DICT_KEY_V) == ERR_NONE)
+    {
+        err = parse_field_value(sgl, node);
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Kids) == ERR_NONE) {
+        err = parse_ref_array(sgl, &kids);
+
+        for (size_t i = 0; err == ERR_NONE && i < kids.capacity; i++) {
+            if (kids.entry[i] != NULL)
+                err = queue_field(sgl, tree, kids.entry[i], node);
         }
+
+        ref_array_free(&kids);
+        return err;
     }
 
-    if (err == ERR_END_OF_DICT)
+    if (node->field_type != FIELD_TYPE_SIG ||
+        number_set_contains(&(tree->sig_fields), node->ref_field.object_num))
+    {
         return ERR_NONE;
+    }
+
+    err = number_set_insert(&(tree->sig_fields), node->ref_field.object_num);
+    if (err != ERR_NONE)
+        return err;
+
+    err = signature_add(sgl, &signature);
+    if (err != ERR_NONE)
+        return err;
+
+    signature->ref_sig_field   = node->ref_field;
+    signature->ref_sig_dict    = node->ref_sig_dict;
+    signature->offset_sig_dict = node->offset_sig_dict;
+
+    return ERR_NONE;
+}
+
+sigil_err_t find_sig_fields(sigil_t *sgl)
+{
+    sigil_err_t err = ERR_NONE;
+    field_tree_t tree;
+    field_node_t node;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    sigil_zeroize(&tree, sizeof(tree));
+
+    for (size_t i = 0; i < sgl->fields.capacity; i++) {
+        if (sgl->fields.entry[i] == NULL)
+            continue;
+
+        err = queue_field(sgl, &tree, sgl->fields.entry[i], NULL);
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    while (tree.count > 0) {
+        queue_pop(&tree, &node);
+
+        err = visit_field(sgl, &tree, &node);
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    if (sgl->signature_count == 0)
+        err = ERR_NO_DATA;
+
+end:
+    free(tree.node);
+    number_set_clear(&(tree.queued));
+    number_set_clear(&(tree.sig_fields));
+
+    return err;
+}
+
+/** @brief Appends the update with the field tree to the PDF - nested fields
+ *         inheriting /FT and /V, the field with two widgets, the reference
+ *         cycle and the signature dictionary of a kid given directly
+ *
+ * @param path path to the signed PDF
+ * @param size output - size of the data
+ * @param offset_direct output - position of the direct signature dictionary
+ * @return allocated data or NULL
+ */
+static char *test_append_field_tree(const char *path, size_t *size, size_t *offset_direct)
+{
+    const char *objects[] = {
+        "<</T (Group)/FT /Sig/Kids [32 0 R 33 0 R]>>",
+        "<</FT /Tx/T (Text)/V (value)/Kids [36 0 R]>>",
+        "<</Parent 30 0 R/T (Nested)/V 16 0 R/Kids [34 0 R 35 0 R]>>",
+        "<</Parent 30 0 R/T (Loop)/Kids [30 0 R 33 0 R 37 0 R]>>",
+        "<</Parent 32 0 R/Type /Annot/Subtype /Widget>>",
+        "<</Parent 32 0 R/Type /Annot/Subtype /Widget>>",
+        "<</Parent 31 0 R/FT /Sig/T (Direct)/V <</Type /Sig/Filter /Adobe.PPKLite>>>>",
+        "<</Parent 33 0 R/Type /Annot/Subtype /Widget>>",
+    };
+    const size_t count = sizeof(objects) / sizeof(*objects);
+    FILE *file;
+    char *pdf = NULL;
+    size_t offsets[sizeof(objects) / sizeof(*objects)],
+           table_offset;
+    long file_size;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0 ||
+        (pdf = malloc((size_t)file_size + 2048)) == NULL ||
+        fread(pdf, 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+        fclose(file);
+        free(pdf);
+        return NULL;
+    }
+    fclose(file);
+
+    *size = (size_t)file_size;
+    *size += (size_t)sprintf(pdf + *size, "\n");
+    *size += (size_t)sprintf(pdf + *size, "12 0 obj\n<</Type /Catalog/Pages 4 0 R"
+                             "/AcroForm <</Fields [30 0 R 14 0 R 31 0 R]"
+                             "/SigFlags 3>>>>\nendobj\n");
+
+    for (size_t i = 0; i < count; i++) {
+        offsets[i] = *size;
+        *size += (size_t)sprintf(pdf + *size, "%zd 0 obj\n%s\nendobj\n", 30 + i, objects[i]);
+    }
+
+    // the value of /V in the object 36
+    *offset_direct = offsets[6] + strlen("36 0 obj\n") +
+                     (size_t)(strstr(objects[6], "/V <<") - objects[6]) + strlen("/V ");
+
+    table_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "xref\n0 1\n0000000000 65535 f\r\n"
+                             "12 1\n%010zd 00000 n\r\n30 %zd\n", (size_t)file_size + 1, count);
+    for (size_t i = 0; i < count; i++) {
+        *size += (size_t)sprintf(pdf + *size, "%010zd 00000 n\r\n", offsets[i]);
+    }
+    *size += (size_t)sprintf(pdf + *size, "trailer\n<</Size 38/Root 12 0 R/Prev 58077>>\n"
+                             "startxref\n%zd\n%%%%EOF\n", table_offset);
+
+    return pdf;
+}
 
-    return err;;
+/** @brief Loads the document structure up to the Fields of the AcroForm
+ *
+ */
+static sigil_err_t test_load_fields(sigil_t *sgl)
+{
+    sigil_err_t err;
+
+    if ((err = read_startxref(sgl)) != ERR_NONE ||
+        (err = process_xref_chain(sgl)) != ERR_NONE ||
+        (err = process_catalog(sgl)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    return process_acroform(sgl);
 }
 
 int sigil_sig_field_self_test(int verbosity)
 {
+    sigil_t *sgl = NULL;
+    char *pdf = NULL;
+
     print_module_name("sig_field", verbosity);
 
-    // place for possible later tests
-    // ...
+    // TEST: the only top-level signature field
+    print_test_item("fn find_sig_fields", verbosity);
+
+    sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+    if (sgl == NULL ||
+        test_load_fields(sgl) != ERR_NONE ||
+        find_sig_fields(sgl) != ERR_NONE ||
+        sgl->signature_count != 1 ||
+        sgl->signatures[0].ref_sig_field.object_num != 14 ||
+        sgl->signatures[0].ref_sig_dict.object_num != 16 ||
+        sgl->signatures[0].ref_sig_dict.generation_num != 0 ||
+        sgl->signatures[0].offset_sig_dict != 0)
+    {
+        goto failed;
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // TEST: nested fields with the inherited attributes and the cycle
+    print_test_item("field tree", verbosity);
+
+    {
+        size_t size,
+               offset_direct;
+        // field, referenced dictionary, visited in the order of positions
+        const size_t expected[][2] = {
+            { 14, 16 }, // top-level field before the update
+            { 32, 16 }, // /FT from the parent, two widgets of one field
+            { 36, 0  }, // /FT overriding the parent, direct dictionary
+            { 33, 0  }, // widget inheriting /FT through the cycle, unsigned
+        };
+
+        pdf = test_append_field_tree("test/subtype_adbe.x509.rsa_sha1.pdf",
+                                     &size, &offset_direct);
+        if (pdf == NULL ||
+            (sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+            test_load_fields(sgl) != ERR_NONE ||
+            find_sig_fields(sgl) != ERR_NONE ||
+            sgl->signature_count != 4)
+        {
+            goto failed;
+        }
+
+        for (size_t i = 0; i < 4; i++) {
+            if (sgl->signatures[i].ref_sig_field.object_num != expected[i][0] ||
+                sgl->signatures[i].ref_sig_dict.object_num != expected[i][1])
+            {
+                goto failed;
+            }
+        }
+
+        if (sgl->signatures[0].offset_sig_dict != 0 ||
+            sgl->signatures[2].offset_sig_dict != offset_direct ||
+            sgl->signatures[3].offset_sig_dict != 0 ||
+            signatures_remove_unsigned(sgl) != ERR_NONE ||
+            sgl->signature_count != 3)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+        free(pdf);
+        pdf = NULL;
+    }
+
+    print_test_result(1, verbosity);
 
     // all tests done
     print_module_result(1, verbosity);
+
     return 0;
 
-/*
 failed:
+    free(pdf);
+    sigil_free(&sgl);
+
     print_test_result(0, verbosity);
     print_module_result(0, verbosity);
 
     return 1;
-*/
-}
\ No newline at end of file
+}
@@ -0,0 +1,590 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "sig_scan.h"
+#include "sigil.h"
+#include "types.h"
+
+#define OBJ_HEADER_MAX   48
+
+
+/** @brief Provides the PDF data from the specified range. Points directly into
+ *         the buffer if available, otherwise reads the data into tmp
+ *
+ * @param sgl context
+ * @param position position in the PDF
+ * @param length requested number of bytes
+ * @param tmp buffer with at least length + 1 bytes for the file reading
+ * @param data output - pointer to the data
+ * @param data_len output - number of bytes available (can be lower than length
+ *                 at the end of the PDF)
+ * @return ERR_NONE if success, ERR_NO_DATA if nothing is available
+ */
+static sigil_err_t scan_window(sigil_t *sgl, size_t position, size_t length,
+                               char *tmp, const char **data, size_t *data_len)
+{
+    sigil_err_t err;
+
+    err = pdf_span(sgl, position, length, data, data_len);
+    if (err != ERR_PARAMETER)
+        return err;
+
+    if (sgl->pdf_data.size <= sgl->offset_pdf_start + position)
+        return ERR_NO_DATA;
+
+    length = MIN(length, sgl->pdf_data.size - sgl->offset_pdf_start - position);
+    if (length == 0)
+        return ERR_NO_DATA;
+
+    if ((err = pdf_move_pos_abs(sgl, position)) != ERR_NONE)
+        return err;
+
+    if ((err = pdf_read(sgl, length, tmp, data_len)) != ERR_NONE)
+        return err;
+
+    *data = tmp;
+
+    return ERR_NONE;
+}
+
+sigil_err_t scan_find(sigil_t *sgl, size_t from, const char *needle, size_t *result)
+{
+    sigil_err_t err;
+    char *tmp = NULL;
+    const char *data,
+               *found;
+    size_t needle_len,
+           data_len,
+           position,
+           window;
+
+    if (sgl == NULL || needle == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    needle_len = strlen(needle);
+    if (needle_len == 0 || needle_len > SCAN_CHUNK_SIZE)
+        return ERR_PARAMETER;
+
+    if (sgl->pdf_data.buffer == NULL) {
+        tmp = malloc(sizeof(*tmp) * (SCAN_CHUNK_SIZE + 1));
+        if (tmp == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    position = from;
+
+    // the buffer is searched at once, the file in the overlapping chunks
+    window = (sgl->pdf_data.buffer != NULL) ? SIZE_MAX : SCAN_CHUNK_SIZE;
+
+    while ((err = scan_window(sgl, position, window, tmp, &data,
+                              &data_len)) == ERR_NONE)
+    {
+        found = sigil_memmem(data, data_len, needle, needle_len);
+        if (found != NULL) {
+            *result = position + (size_t)(found - data);
+            break;
+        }
+
+        // the whole buffer searched, file ends with the partial chunk
+        if (data_len < SCAN_CHUNK_SIZE || sgl->pdf_data.buffer != NULL) {
+            err = ERR_NO_DATA;
+            break;
+        }
+
+        // overlap the chunks, so the needle on the boundary is not missed
+        position += data_len - (needle_len - 1);
+    }
+
+    if (tmp != NULL)
+        free(tmp);
+
+    return err;
+}
+
+/** @brief Decides whether the "obj" keyword on the provided position is a part
+ *         of the object header "<number> <generation> obj"
+ *
+ * @param sgl context
+ * @param obj_position position of the "obj" keyword
+ * @param header_start output - position of the object number
+ * @return 1 if it is the object header, 0 otherwise
+ */
+static int is_obj_header(sigil_t *sgl, size_t obj_position, size_t *header_start)
+{
+    char tmp[OBJ_HEADER_MAX + 1];
+    const char *data;
+    size_t window,
+           data_len,
+           pos;
+
+    window = MIN(obj_position, OBJ_HEADER_MAX);
+    if (window == 0)
+        return 0;
+
+    if (scan_window(sgl, obj_position - window, window, tmp, &data,
+                    &data_len) != ERR_NONE || data_len != window)
+    {
+        return 0;
+    }
+
+    pos = window;
+
+    // whitespace, generation number, whitespace, object number
+    for (int part = 0; part < 4; part++) {
+        size_t part_end = pos;
+
+        while (pos > 0 && (part % 2 == 0 ? is_whitespace(data[pos - 1])
+                                         : is_digit(data[pos - 1])))
+        {
+            pos--;
+        }
+
+        if (pos == part_end)
+            return 0;
+    }
+
+    *header_start = obj_position - window + pos;
+
+    return 1;
+}
+
+/** @brief Finds the header of the object containing the provided position by
+ *         searching backwards for the "obj" keyword
+ *
+ * @param sgl context
+ * @param before position inside of the object
+ * @param result output - position of the object header
+ * @return ERR_NONE if success
+ */
+static sigil_err_t scan_obj_header(sigil_t *sgl, size_t before, size_t *result)
+{
+    sigil_err_t err;
+    char *tmp = NULL;
+    const char *data;
+    size_t start,
+           end,
+           data_len;
+
+    if (sgl->pdf_data.buffer == NULL) {
+        tmp = malloc(sizeof(*tmp) * (SCAN_CHUNK_SIZE + 1));
+        if (tmp == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    err = ERR_NO_DATA;
+    end = before;
+
+    while (end >= 3) {
+        start = (end > SCAN_CHUNK_SIZE) ? end - SCAN_CHUNK_SIZE : 0;
+
+        if ((err = scan_window(sgl, start, end - start, tmp, &data,
+                               &data_len)) != ERR_NONE)
+        {
+            break;
+        }
+
+        err = ERR_NO_DATA;
+
+        for (size_t i = data_len - 3; data_len >= 3; i--) {
+            if (memcmp(data + i, "obj", 3) == 0 &&
+                (i + 3 >= data_len || is_whitespace(data[i + 3]) ||
+                 data[i + 3] == '<' || data[i + 3] == '[') &&
+                is_obj_header(sgl, start + i, result))
+            {
+                err = ERR_NONE;
+                break;
+            }
+
+            if (i == 0)
+                break;
+        }
+
+        if (err == ERR_NONE || start == 0)
+            break;
+
+        // overlap, so the keyword on the boundary is not missed
+        end = start + 2;
+    }
+
+    if (tmp != NULL)
+        free(tmp);
+
+    return err;
+}
+
+/** @brief Parses the dictionary from the current position and looks for the
+ *         one containing the key on the target position (also in the nested
+ *         dictionaries)
+ *
+ * @param sgl context
+ * @param target position of the key
+ * @param dict_offset output - position of the dictionary containing the key
+ * @return ERR_NONE if found, ERR_END_OF_DICT if the dictionary ended without
+ *         finding the key
+ */
+static sigil_err_t find_enclosing_dict(sigil_t *sgl, size_t target,
+                                       size_t *dict_offset)
+{
+    sigil_err_t err;
+    dict_key_t dict_key;
+    size_t dict_position,
+           key_position,
+           value_position;
+    char c;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+        return err;
+
+    if ((err = get_curr_position(sgl, &dict_position)) != ERR_NONE)
+        return err;
+
+    if ((err = skip_word(sgl, "<<")) != ERR_NONE)
+        return err;
+
+    while (1) {
+        if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+            return err;
+
+        if ((err = get_curr_position(sgl, &key_position)) != ERR_NONE)
+            return err;
+
+        if (key_position > target)
+            return ERR_NO_DATA;
+
+        if ((err = parse_dict_key(sgl, &dict_key)) != ERR_NONE)
+            return err;
+
+        if (key_position == target) {
+            *dict_offset = dict_position;
+            return ERR_NONE;
+        }
+
+        if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+            return err;
+
+        if ((err = get_curr_position(sgl, &value_position)) != ERR_NONE)
+            return err;
+
+        if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
+            return err;
+
+        if (c == '<' && (err = pdf_peek_char(sgl, &c)) == ERR_NONE && c == '<') {
+            if ((err = pdf_move_pos_abs(sgl, value_position)) != ERR_NONE)
+                return err;
+
+            err = find_enclosing_dict(sgl, target, dict_offset);
+            if (err != ERR_END_OF_DICT)
+                return err;
+        } else {
+            if ((err = pdf_move_pos_abs(sgl, value_position)) != ERR_NONE)
+                return err;
+
+            if ((err = skip_dict_unknown_value(sgl)) != ERR_NONE)
+                return err;
+        }
+    }
+}
+
+sigil_err_t scan_sig_dict(sigil_t *sgl, size_t from, size_t *sig_dict_offset,
+                          size_t *next)
+{
+    sigil_err_t err;
+    size_t found,
+           obj_start,
+           tmp;
+    char c;
+
+    if (sgl == NULL || sig_dict_offset == NULL || next == NULL)
+        return ERR_PARAMETER;
+
+    while ((err = scan_find(sgl, from, "/ByteRange", &found)) == ERR_NONE) {
+        from = found + 10;
+
+        // the key needs to be followed by the array
+        if (pdf_move_pos_abs(sgl, from) != ERR_NONE ||
+            skip_leading_whitespaces(sgl) != ERR_NONE ||
+            pdf_peek_char(sgl, &c) != ERR_NONE || c != '[')
+        {
+            continue;
+        }
+
+        err = scan_obj_header(sgl, found, &obj_start);
+        if (err == ERR_ALLOCATION)
+            return err;
+        if (err != ERR_NONE)
+            continue;
+
+        if (pdf_move_pos_abs(sgl, obj_start) != ERR_NONE ||
+            parse_number(sgl, &tmp) != ERR_NONE ||
+            parse_number(sgl, &tmp) != ERR_NONE ||
+            skip_word(sgl, "obj") != ERR_NONE)
+        {
+            continue;
+        }
+
+        if (find_enclosing_dict(sgl, found, sig_dict_offset) == ERR_NONE) {
+            *next = from;
+            return ERR_NONE;
+        }
+    }
+
+    if (err == ERR_NO_DATA)
+        return ERR_NO_SIGNATURE;
+
+    return err;
+}
+
+sigil_err_t scan_is_signed(sigil_t *sgl, int *result)
+{
+    sigil_err_t err;
+    size_t from,
+           found;
+    char c;
+
+    if (sgl == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    *result = 0;
+    from = 0;
+
+    while ((err = scan_find(sgl, from, "/ByteRange", &found)) == ERR_NONE) {
+        from = found + 10;
+
+        if (pdf_move_pos_abs(sgl, from) == ERR_NONE &&
+            skip_leading_whitespaces(sgl) == ERR_NONE &&
+            pdf_peek_char(sgl, &c) == ERR_NONE && c == '[')
+        {
+            *result = 1;
+            return ERR_NONE;
+        }
+    }
+
+    if (err == ERR_NO_DATA)
+        return ERR_NONE;
+
+    return err;
+}
+
+int sigil_sig_scan_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    char *pdf_copy = NULL;
+
+    print_module_name("sig_scan", verbosity);
+
+    // TEST: fn scan_find
+    print_test_item("fn scan_find", verbosity);
+
+    {
+        size_t result;
+
+        char *sstream = "abc /ByteRange /ByteRange";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (scan_find(sgl, 0, "/ByteRange", &result) != ERR_NONE ||
+            result != 4)
+        {
+            goto failed;
+        }
+
+        if (scan_find(sgl, 5, "/ByteRange", &result) != ERR_NONE ||
+            result != 15)
+        {
+            goto failed;
+        }
+
+        if (scan_find(sgl, 16, "/ByteRange", &result) != ERR_NO_DATA)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn scan_sig_dict
+    print_test_item("fn scan_sig_dict", verbosity);
+
+    {
+        size_t offset,
+               next;
+
+        char *sstream = "7 0 obj\n"                                   \
+                        "<</FT /Sig /T (Signature1) /V <</Type /Sig " \
+                        "/ByteRange [0 10 20 30] /Contents <00>>> >>\n"\
+                        "endobj\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (scan_sig_dict(sgl, 0, &offset, &next) != ERR_NONE ||
+            offset != (size_t)(strstr(sstream, "<</Type") - sstream))
+        {
+            goto failed;
+        }
+
+        if (scan_sig_dict(sgl, next, &offset, &next) != ERR_NO_SIGNATURE)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn scan_is_signed
+    print_test_item("fn scan_is_signed", verbosity);
+
+    {
+        int result;
+
+        char *sstream = "\x25PDF-1.4\n1 0 obj\n<</ByteRange 5 0 R>>\nendobj\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (scan_is_signed(sgl, &result) != ERR_NONE || result != 0)
+            goto failed;
+
+        sigil_free(&sgl);
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        if (sigil_is_signed(sgl, &result) != ERR_NONE || result != 1)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: the signature far behind the first chunk, buffered and in the file
+    print_test_item("scan past the first chunk", verbosity);
+
+    {
+        const char *dict = "7 0 obj\n"                                   \
+                           "<</FT /Sig /T (Signature1) /V <</Type /Sig " \
+                           "/ByteRange [0 10 20 30] /Contents <00>>> >>\n"\
+                           "endobj\n";
+        const size_t offset = 3 * SCAN_CHUNK_SIZE / 2 + 1000,
+                     size = 3 * SCAN_CHUNK_SIZE;
+        size_t result;
+        int is_signed;
+
+        pdf_copy = malloc(size);
+        if (pdf_copy == NULL)
+            goto failed;
+        memset(pdf_copy, ' ', size);
+        memcpy(pdf_copy, "\x25PDF-1.4\n", 9);
+        memcpy(pdf_copy + offset, dict, strlen(dict));
+
+        for (int mode = 0; mode < 2; mode++) {
+            if (mode == 0) {
+                sgl = test_prepare_sgl_buffer(pdf_copy, size);
+            } else {
+                FILE *file = tmpfile();
+
+                if (file == NULL || fwrite(pdf_copy, 1, size, file) != size ||
+                    sigil_init(&sgl) != ERR_NONE)
+                {
+                    if (file != NULL)
+                        fclose(file);
+                    goto failed;
+                }
+
+                sgl->pdf_data.file = file;
+                sgl->pdf_data.size = size;
+                sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+            }
+
+            if (sgl == NULL ||
+                scan_find(sgl, 0, "/ByteRange", &result) != ERR_NONE ||
+                result != (size_t)(strstr(dict, "/ByteRange") - dict) + offset ||
+                scan_is_signed(sgl, &is_signed) != ERR_NONE || is_signed != 1)
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+
+        free(pdf_copy);
+        pdf_copy = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fallback to the raw scan with damaged startxref
+    print_test_item("damaged startxref fallback", verbosity);
+
+    {
+        int result;
+        size_t size;
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL || sgl->pdf_data.buffer == NULL)
+            goto failed;
+
+        // garbage appended after the signed data hides the startxref
+        size = sgl->pdf_data.size + 2 * XREF_SEARCH_OFFSET;
+
+        pdf_copy = malloc(size);
+        if (pdf_copy == NULL)
+            goto failed;
+        memset(pdf_copy, '~', size);
+        memcpy(pdf_copy, sgl->pdf_data.buffer, sgl->pdf_data.size);
+
+        sigil_free(&sgl);
+
+        if ((sgl = test_prepare_sgl_buffer(pdf_copy, size)) == NULL)
+            goto failed;
+
+        // the rebuilt cross-reference table would find it as well
+        if (sigil_set_raw_scan_mode(sgl, RAW_SCAN_DISABLED) != ERR_NONE ||
+            sigil_set_xref_reconstruction(sgl, XREF_RECONSTRUCT_DISABLED) != ERR_NONE ||
+            sigil_verify(sgl) == ERR_NONE)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        if ((sgl = test_prepare_sgl_buffer(pdf_copy, size)) == NULL)
+            goto failed;
+
+        if (sigil_set_xref_reconstruction(sgl, XREF_RECONSTRUCT_DISABLED) != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        if (sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+            result != HASH_CMP_RESULT_MATCH)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+        free(pdf_copy);
+        pdf_copy = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+    return 0;
+
+failed:
+    if (sgl)
+        sigil_free(&sgl);
+    if (pdf_copy)
+        free(pdf_copy);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -6,16 +6,26 @@
 #include "auxiliary.h"
 #include "catalog.h"
 #include "cert.h"
+#include "cms.h"
 #include "config.h"
 #include "constants.h"
 #include "contents.h"
 #include "cryptography.h"
+#include "dss.h"
 #include "header.h"
+#include "objstm.h"
+#include "reconstruct.h"
+#include "revision.h"
 #include "sig_dict.h"
 #include "sig_field.h"
+#include "sidecar.h"
+#include "sig_scan.h"
+#include "signature.h"
 #include "sigil.h"
+#include "timestamp.h"
 #include "trailer.h"
 #include "types.h"
+#include "workers.h"
 #include "xref.h"
 
 sigil_err_t sigil_init(sigil_t **sgl)
@@ -36,36 +46,44 @@ sigil_err_t sigil_init(sigil_t **sgl)
     (*sgl)->pdf_data.buf_pos                = 0;
     (*sgl)->pdf_data.size                   = 0;
     (*sgl)->pdf_data.deallocation_info      = 0;
+    (*sgl)->pdf_data.objstm                 = NULL;
+    (*sgl)->pdf_data.objstm_pos             = 0;
     (*sgl)->pdf_x                           = 0;
     (*sgl)->pdf_y                           = 0;
     (*sgl)->sig_flags                       = 0;
-    (*sgl)->subfilter_type                  = SUBFILTER_UNKNOWN;
     (*sgl)->xref_type                       = XREF_TYPE_UNSET;
-    (*sgl)->hash_fn                         = HASH_FN_UNKNOWN;
+    (*sgl)->raw_scan_mode                   = RAW_SCAN_FALLBACK;
+    (*sgl)->xref_reconstruction             = XREF_RECONSTRUCT_FALLBACK;
+    (*sgl)->xref_mode                       = XREF_MODE_LAZY;
+    (*sgl)->chain_mode                      = CHAIN_MODE_SERIAL;
+    (*sgl)->thread_count                    = 1;
+    (*sgl)->cache_dir                       = NULL;
     (*sgl)->ref_acroform.object_num         = 0;
     (*sgl)->ref_acroform.generation_num     = 0;
     (*sgl)->ref_catalog_dict.object_num     = 0;
     (*sgl)->ref_catalog_dict.generation_num = 0;
-    (*sgl)->ref_sig_dict.object_num         = 0;
-    (*sgl)->ref_sig_dict.generation_num     = 0;
-    (*sgl)->ref_sig_field.object_num        = 0;
-    (*sgl)->ref_sig_field.generation_num    = 0;
+    (*sgl)->ref_dss.object_num              = 0;
+    (*sgl)->ref_dss.generation_num          = 0;
     (*sgl)->offset_acroform                 = 0;
+    (*sgl)->offset_dss                      = 0;
     (*sgl)->offset_pdf_start                = 0;
-    (*sgl)->offset_sig_dict                 = 0;
     (*sgl)->offset_startxref                = 0;
-    (*sgl)->digest_algorithm                = NULL;
-    (*sgl)->digest_computed                 = NULL;
-    (*sgl)->digest_original                 = NULL;
     (*sgl)->fields.capacity                 = 0;
     (*sgl)->fields.entry                    = NULL;
-    (*sgl)->byte_range                      = NULL;
-    (*sgl)->certificates                    = NULL;
-    (*sgl)->contents                        = NULL;
     (*sgl)->xref                            = NULL;
+    (*sgl)->revisions.entry                 = NULL;
+    (*sgl)->revisions.count                 = 0;
+    (*sgl)->revisions.capacity              = 0;
+    (*sgl)->revisions.visited.slot          = NULL;
+    (*sgl)->revisions.visited.count         = 0;
+    (*sgl)->revisions.visited.capacity      = 0;
+    (*sgl)->objstm_cache                    = NULL;
+    (*sgl)->dss                             = NULL;
     (*sgl)->trusted_store                   = X509_STORE_new();
-    (*sgl)->result_cert_verification        = CERT_STATUS_UNKNOWN;
-    (*sgl)->result_digest_comparison        = HASH_CMP_RESULT_UNKNOWN;
+    (*sgl)->signatures                      = NULL;
+    (*sgl)->signature_count                 = 0;
+    (*sgl)->signature_capacity              = 0;
+    (*sgl)->signature_selected              = 0;
 
     return ERR_NONE;
 }
@@ -82,6 +100,8 @@ sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file)
     if (sgl->pdf_data.file != NULL && sgl->pdf_data.file != pdf_file)
         fclose(sgl->pdf_data.file);
 
+    pdf_unmap_file(sgl);
+
     sgl->pdf_data.file = pdf_file;
 
     // get file size
@@ -130,6 +150,9 @@ sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file)
 
         sgl->pdf_data.buffer = content;
         sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+    } else {
+        // the larger files are mapped, fallback to using the file
+        pdf_map_file(sgl);
     }
 
     return ERR_NONE;
@@ -234,73 +257,157 @@ sigil_err_t sigil_set_trusted_dir(sigil_t *sgl, const char *path_to_dir)
     return ERR_NONE;
 }
 
-static sigil_err_t sigil_verify_adbe_x509_rsa_sha1(sigil_t *sgl)
+sigil_err_t sigil_set_raw_scan_mode(sigil_t *sgl, int mode)
 {
-    sigil_err_t err;
+    if (sgl == NULL)
+        return ERR_PARAMETER;
 
-    err = load_certificates(sgl);
-    if (err != ERR_NONE)
-        return err;
+    switch (mode) {
+        case RAW_SCAN_DISABLED:
+        case RAW_SCAN_FALLBACK:
+        case RAW_SCAN_ONLY:
+            sgl->raw_scan_mode = mode;
+            return ERR_NONE;
+        default:
+            return ERR_PARAMETER;
+    }
+}
 
-    err = verify_signing_certificate(sgl);
-    if (err != ERR_NONE)
-        return err;
+sigil_err_t sigil_set_xref_reconstruction(sigil_t *sgl, int mode)
+{
+    if (sgl == NULL)
+        return ERR_PARAMETER;
 
-    err = load_digest(sgl);
-    if (err != ERR_NONE)
-        return err;
+    switch (mode) {
+        case XREF_RECONSTRUCT_DISABLED:
+        case XREF_RECONSTRUCT_FALLBACK:
+            sgl->xref_reconstruction = mode;
+            return ERR_NONE;
+        default:
+            return ERR_PARAMETER;
+    }
+}
 
-    err = compute_digest_pkcs1(sgl);
-    if (err != ERR_NONE)
-        return err;
+sigil_err_t sigil_set_xref_mode(sigil_t *sgl, int mode)
+{
+    if (sgl == NULL)
+        return ERR_PARAMETER;
 
-    return compare_digest(sgl);
+    switch (mode) {
+        case XREF_MODE_EAGER:
+        case XREF_MODE_LAZY:
+            sgl->xref_mode = mode;
+            return ERR_NONE;
+        default:
+            return ERR_PARAMETER;
+    }
 }
 
-sigil_err_t sigil_verify(sigil_t *sgl)
+sigil_err_t sigil_set_chain_mode(sigil_t *sgl, int mode)
 {
-    sigil_err_t err;
+    if (sgl == NULL)
+        return ERR_PARAMETER;
 
-    // function parameter checks
+    switch (mode) {
+        case CHAIN_MODE_SERIAL:
+        case CHAIN_MODE_CONCURRENT:
+            sgl->chain_mode = mode;
+            return ERR_NONE;
+        default:
+            return ERR_PARAMETER;
+    }
+}
+
+sigil_err_t sigil_set_thread_count(sigil_t *sgl, size_t count)
+{
     if (sgl == NULL)
         return ERR_PARAMETER;
 
-    // process header - %PDF-<pdf_x>.<pdf_y>
-    err = process_header(sgl);
-    if (err != ERR_NONE)
-        return err;
+    if (count == 0)
+        count = workers_default_count();
 
-    // determine offset to the first cross-reference section
-    err = read_startxref(sgl);
+    sgl->thread_count = MIN(count, MAX_THREAD_COUNT);
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_set_cache_dir(sigil_t *sgl, const char *path_to_dir)
+{
+    char *copy = NULL;
+    size_t len;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (path_to_dir != NULL) {
+        len = strlen(path_to_dir);
+        copy = malloc(len + 1);
+        if (copy == NULL)
+            return ERR_ALLOCATION;
+        memcpy(copy, path_to_dir, len + 1);
+    }
+
+    free(sgl->cache_dir);
+    sgl->cache_dir = copy;
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_is_signed(sigil_t *sgl, int *result)
+{
+    if (sgl == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    return scan_is_signed(sgl, result);
+}
+
+static sigil_err_t sigil_verify_cert_adbe_x509_rsa_sha1(sigil_t *sgl, signature_t *signature)
+{
+    return verify_signing_certificate(sgl, signature);
+}
+
+static sigil_err_t sigil_verify_cert_adbe_pkcs7_detached(sigil_t *sgl, signature_t *signature)
+{
+    sigil_err_t err;
+
+    err = timestamp_verify_embedded(sgl, signature);
     if (err != ERR_NONE)
         return err;
 
-    if (sgl->xref != NULL)
-        xref_free(sgl->xref);
-    sgl->xref = xref_init();
-    if (sgl->xref == NULL)
-        return ERR_ALLOCATION;
+    return verify_signing_certificate(sgl, signature);
+}
 
-    sgl->xref->prev_section = sgl->offset_startxref;
+static sigil_err_t sigil_verify_cert_etsi_cades_detached(sigil_t *sgl, signature_t *signature)
+{
+    sigil_err_t err;
+
+    err = sigil_verify_cert_adbe_pkcs7_detached(sgl, signature);
+    if (err != ERR_NONE)
+        return err;
 
-    size_t max_file_updates = MAX_FILE_UPDATES;
+    return cms_verify_signing_cert_binding(signature);
+}
 
-    while (sgl->xref->prev_section > 0 && (max_file_updates--) > 0) {
-        // go to the position of the beginning of next cross-reference section
-        err = pdf_move_pos_abs(sgl, sgl->xref->prev_section);
-        if (err != ERR_NONE)
-            return err;
+static sigil_err_t sigil_verify_cert_etsi_rfc3161(sigil_t *sgl, signature_t *signature)
+{
+    sigil_err_t err;
 
-        sgl->xref->prev_section = 0;
+    err = sigil_verify_cert_adbe_pkcs7_detached(sgl, signature);
+    if (err != ERR_NONE)
+        return err;
 
-        err = process_xref(sgl);
-        if (err != ERR_NONE)
-            return err;
+    return cms_verify_tsa_certificate(signature);
+}
 
-        err = process_trailer(sgl);
-        if (err != ERR_NONE)
-            return err;
-    }
+/** @brief Finds the signature dictionaries by following the document structure
+ *         from the catalog - AcroForm and Fields
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t locate_sig_dict_catalog(sigil_t *sgl)
+{
+    sigil_err_t err;
 
     err = process_catalog(sgl);
     if (err != ERR_NONE)
@@ -313,28 +420,443 @@ sigil_err_t sigil_verify(sigil_t *sgl)
     if ((sgl->sig_flags & 0x01) == 0)
         return ERR_NO_SIGNATURE;
 
-    err = find_sig_field(sgl);
+    err = find_sig_fields(sgl);
     if (err != ERR_NONE)
         return err;
 
-    err = process_sig_field(sgl);
+    return signatures_remove_unsigned(sgl);
+}
+
+/** @brief Finds the signature dictionary by following the document structure
+ *         - cross-reference sections, trailer, catalog, AcroForm and Fields.
+ *         The damaged cross-reference table is rebuilt, if enabled
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t locate_sig_dict(sigil_t *sgl)
+{
+    sigil_err_t err;
+
+    // determine offset to the first cross-reference section
+    err = read_startxref(sgl);
+
+    // read all the cross-reference sections and trailers
+    if (err == ERR_NONE)
+        err = process_xref_chain(sgl);
+
+    if (err == ERR_NONE)
+        err = locate_sig_dict_catalog(sgl);
+
+    if (err == ERR_NONE || err == ERR_NO_SIGNATURE || err == ERR_ALLOCATION ||
+        sgl->xref_reconstruction != XREF_RECONSTRUCT_FALLBACK)
+    {
+        return err;
+    }
+
+    // forget everything found through the damaged structure
+    sgl->ref_catalog_dict.object_num = 0;
+    sgl->ref_catalog_dict.generation_num = 0;
+    sgl->ref_acroform.object_num = 0;
+    sgl->ref_acroform.generation_num = 0;
+    sgl->offset_acroform = 0;
+    sgl->ref_dss.object_num = 0;
+    sgl->ref_dss.generation_num = 0;
+    sgl->offset_dss = 0;
+    sgl->sig_flags = 0;
+    signatures_clear(sgl);
+
+    err = reconstruct_xref(sgl);
     if (err != ERR_NONE)
         return err;
 
-    err = process_sig_dict(sgl);
+    return locate_sig_dict_catalog(sgl);
+}
+
+/** @brief Finds all the signature dictionaries by scanning the raw PDF data
+ *
+ * @param sgl context
+ * @return ERR_NONE if success, ERR_NO_SIGNATURE if none was found
+ */
+static sigil_err_t locate_sig_dict_raw(sigil_t *sgl)
+{
+    sigil_err_t err;
+    signature_t *signature;
+    size_t offset,
+           next = 0;
+
+    signatures_clear(sgl);
+
+    while ((err = scan_sig_dict(sgl, next, &offset, &next)) == ERR_NONE) {
+        err = signature_add(sgl, &signature);
+        if (err != ERR_NONE)
+            return err;
+
+        signature->offset_sig_dict = offset;
+    }
+
+    if (err == ERR_NO_SIGNATURE && sgl->signature_count > 0)
+        return ERR_NONE;
+
+    return err;
+}
+
+/** @brief Processes the header and finds the signature dictionary, through
+ *         the document structure or by scanning the raw data
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t locate_document(sigil_t *sgl)
+{
+    sigil_err_t err;
+
+    // process header - %PDF-<pdf_x>.<pdf_y>
+    err = process_header(sgl);
     if (err != ERR_NONE)
         return err;
 
-    switch (sgl->subfilter_type) {
+    if (sgl->raw_scan_mode == RAW_SCAN_ONLY)
+        return locate_sig_dict_raw(sgl);
+
+    err = locate_sig_dict(sgl);
+
+    // damaged document structure, look for the signature directly
+    if (err != ERR_NONE && err != ERR_NO_SIGNATURE && err != ERR_ALLOCATION &&
+        sgl->raw_scan_mode == RAW_SCAN_FALLBACK)
+    {
+        err = locate_sig_dict_raw(sgl);
+    }
+
+    return err;
+}
+
+/** @brief Decodes the certificates of the signature from its contents
+ *
+ * @param signature the signature with the processed dictionary
+ * @return ERR_NONE if success
+ */
+static sigil_err_t load_signature(signature_t *signature)
+{
+    switch (signature->subfilter_type) {
         case SUBFILTER_adbe_x509_rsa_sha1:
-            err = sigil_verify_adbe_x509_rsa_sha1(sgl);
-            if (err != ERR_NONE)
-                return err;
+            return load_certificates(signature);
+        case SUBFILTER_adbe_pkcs7_detached:
+        case SUBFILTER_adbe_pkcs7_sha1:
+        case SUBFILTER_ETSI_CAdES_detached:
+        case SUBFILTER_ETSI_RFC3161:
+            return cms_load(signature);
+        default:
+            return ERR_NOT_IMPLEMENTED;
+    }
+}
 
+/** @brief Loads the original digest of the signature with the loaded
+ *         certificates, needed before its digest can be computed
+ *
+ * @param signature the signature
+ * @return ERR_NONE if success
+ */
+static sigil_err_t load_signature_digest(signature_t *signature)
+{
+    switch (signature->subfilter_type) {
+        case SUBFILTER_adbe_x509_rsa_sha1:
+            // the digest algorithm is known only from the decrypted signature
+            return load_digest(signature);
+        default:
+            // known from the signed data loaded with the certificates
             return ERR_NONE;
+    }
+}
+
+static sigil_err_t verify_signature_cert(sigil_t *sgl, signature_t *signature)
+{
+    switch (signature->subfilter_type) {
+        case SUBFILTER_adbe_x509_rsa_sha1:
+            return sigil_verify_cert_adbe_x509_rsa_sha1(sgl, signature);
+        case SUBFILTER_adbe_pkcs7_detached:
+        case SUBFILTER_adbe_pkcs7_sha1:
+            return sigil_verify_cert_adbe_pkcs7_detached(sgl, signature);
+        case SUBFILTER_ETSI_CAdES_detached:
+            return sigil_verify_cert_etsi_cades_detached(sgl, signature);
+        case SUBFILTER_ETSI_RFC3161:
+            return sigil_verify_cert_etsi_rfc3161(sgl, signature);
+        default:
+            return ERR_NOT_IMPLEMENTED;
+    }
+}
+
+static sigil_err_t verify_signature_digest(signature_t *signature)
+{
+    switch (signature->subfilter_type) {
+        case SUBFILTER_adbe_x509_rsa_sha1:
+            return compare_digest(signature);
+        case SUBFILTER_adbe_pkcs7_detached:
+        case SUBFILTER_ETSI_CAdES_detached:
+        case SUBFILTER_adbe_pkcs7_sha1:
+        case SUBFILTER_ETSI_RFC3161:
+            return cms_verify_digest(signature);
         default:
             return ERR_NOT_IMPLEMENTED;
     }
+}
+
+static void verify_signature_task(void *arg)
+{
+    signature_t *signature = *(signature_t **)arg;
+
+    signature->error = verify_signature_digest(signature);
+}
+
+/** @brief Validation of the certificate chain of one signature, the result
+ *         is kept aside as the signatures are written by the computation of
+ *         the digests at the same time
+ *
+ */
+typedef struct {
+    sigil_t     *sgl;
+    signature_t *signature;
+    sigil_err_t  err;
+} chain_task_t;
+
+static void verify_chain_task(void *arg)
+{
+    chain_task_t *task = arg;
+
+    task->err = verify_signature_cert(task->sgl, task->signature);
+}
+
+/** @brief One of the two independent phases of the verification - the
+ *         validation of all the certificate chains on the pool of threads
+ *         or the computation of the digests
+ *
+ */
+typedef struct {
+    sigil_t      *sgl;
+    chain_task_t *chain_tasks;
+    size_t        chain_count;
+    sigil_err_t   err;
+} verify_phase_t;
+
+static void verify_phase_task(void *arg)
+{
+    verify_phase_t *phase = arg;
+
+    if (phase->chain_tasks == NULL) {
+        phase->err = compute_digests(phase->sgl);
+        return;
+    }
+
+    phase->err = ERR_NONE;
+
+    if (phase->chain_count == 0)
+        return;
+
+    // the first chain alone caches the trusted certificates looked up lazily
+    // from the directory, usually the same for the other chains (see
+    // cache_certificate_extensions)
+    verify_chain_task(&(phase->chain_tasks[0]));
+
+    phase->err = workers_run(phase->sgl->thread_count, verify_chain_task,
+                             phase->chain_tasks + 1, sizeof(*(phase->chain_tasks)),
+                             phase->chain_count - 1);
+}
+
+/** @brief Verifies the signatures with the processed dictionary. The
+ *         certificates and the digest algorithms are loaded and the DSS is
+ *         read first. Then the certificate chains are validated in parallel
+ *         while the digests of all the signatures are computed in one read
+ *         pass through the PDF data - the two phases run side by side with
+ *         CHAIN_MODE_CONCURRENT, one after the other otherwise. The digests
+ *         are compared in parallel at the end, the cross-reference table and
+ *         the object streams are not touched anymore
+ *
+ * @param sgl context
+ * @return ERR_NONE if success (the errors of the signatures are kept in them)
+ */
+static sigil_err_t verify_signatures(sigil_t *sgl)
+{
+    sigil_err_t err;
+    signature_t *signature;
+    signature_t **tasks;
+    chain_task_t *chain_tasks;
+    verify_phase_t phases[2];
+    size_t task_count = 0,
+           chain_count = 0;
+
+    if (sgl->signature_count == 0)
+        return ERR_NONE;
+
+    tasks = malloc(sgl->signature_count * sizeof(*tasks));
+    chain_tasks = malloc(sgl->signature_count * sizeof(*chain_tasks));
+    if (tasks == NULL || chain_tasks == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    // the chain is validated only for the signature with the certificates,
+    // its error takes precedence over the errors of the digest
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        signature = &(sgl->signatures[i]);
+
+        if (signature->error == ERR_NONE)
+            signature->error = load_signature(signature);
+
+        if (signature->error == ERR_NONE)
+            chain_tasks[chain_count++] = (chain_task_t){ sgl, signature, ERR_NONE };
+
+        if (signature->error == ERR_NONE)
+            signature->error = load_signature_digest(signature);
+
+        if (signature->error == ERR_ALLOCATION) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+    }
+
+    // the DSS is read from the PDF data before they are taken by the digests,
+    // its error is reported by every validated chain
+    if (chain_count > 0) {
+        if (dss_load(sgl) == ERR_ALLOCATION) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+
+        cache_trusted_certificates(sgl);
+    }
+
+    phases[0] = (verify_phase_t){ sgl, chain_tasks, chain_count, ERR_NONE };
+    phases[1] = (verify_phase_t){ sgl, NULL, 0, ERR_NONE };
+
+    err = workers_run((sgl->chain_mode == CHAIN_MODE_CONCURRENT) ? 2 : 1,
+                      verify_phase_task, phases, sizeof(*phases), 2);
+    if (err != ERR_NONE)
+        goto end;
+
+    for (size_t i = 0; i < 2; i++) {
+        if (phases[i].err != ERR_NONE) {
+            err = phases[i].err;
+            goto end;
+        }
+    }
+
+    for (size_t i = 0; i < chain_count; i++) {
+        if (chain_tasks[i].err == ERR_ALLOCATION) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+
+        if (chain_tasks[i].err != ERR_NONE)
+            chain_tasks[i].signature->error = chain_tasks[i].err;
+    }
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        if (sgl->signatures[i].error == ERR_NONE)
+            tasks[task_count++] = &(sgl->signatures[i]);
+    }
+
+    err = workers_run(sgl->thread_count, verify_signature_task, tasks, sizeof(*tasks),
+                      task_count);
+
+end:
+    free(tasks);
+    free(chain_tasks);
+
+    return err;
+}
+
+sigil_err_t sigil_verify(sigil_t *sgl)
+{
+    sigil_err_t err;
+    signature_t *signature;
+
+    // function parameter checks
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    // the structure of the unchanged file is known from the previous run
+    err = sidecar_load(sgl);
+    if (err == ERR_ALLOCATION)
+        return err;
+
+    if (err != ERR_NONE) {
+        signatures_clear(sgl);
+
+        err = locate_document(sgl);
+        if (err != ERR_NONE)
+            return err;
+
+        // the document is verified even if the structure cannot be cached
+        sidecar_store(sgl);
+    }
+
+    // the dictionaries are read serially, they can be inside of the object
+    // streams or need the lazily decoded cross-reference table
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        signature = &(sgl->signatures[i]);
+
+        signature->error = process_sig_dict(sgl, signature);
+        if (signature->error == ERR_ALLOCATION)
+            return ERR_ALLOCATION;
+    }
+
+    err = verify_signatures(sgl);
+    if (err != ERR_NONE)
+        return err;
+
+    // the results of the other signatures are available even after the error
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        if (sgl->signatures[i].error != ERR_NONE)
+            return sgl->signatures[i].error;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_signature_count(sigil_t *sgl, size_t *count)
+{
+    if (sgl == NULL || count == NULL)
+        return ERR_PARAMETER;
+
+    *count = sgl->signature_count;
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_select_signature(sigil_t *sgl, size_t index)
+{
+    if (sgl == NULL || index >= sgl->signature_count)
+        return ERR_PARAMETER;
+
+    sgl->signature_selected = index;
+
+    return ERR_NONE;
+}
+
+/** @brief Returns the signature the results are taken from
+ *
+ * @param sgl context
+ * @return the selected signature, NULL if there is no signature
+ */
+static signature_t *selected_signature(sigil_t *sgl)
+{
+    if (sgl->signature_selected >= sgl->signature_count)
+        return NULL;
+
+    return &(sgl->signatures[sgl->signature_selected]);
+}
+
+sigil_err_t sigil_get_signature_error(sigil_t *sgl, sigil_err_t *error)
+{
+    signature_t *signature;
+
+    if (sgl == NULL || error == NULL)
+        return ERR_PARAMETER;
+
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    *error = signature->error;
 
     return ERR_NONE;
 }
@@ -342,6 +864,7 @@ sigil_err_t sigil_verify(sigil_t *sgl)
 sigil_err_t sigil_get_result(sigil_t *sgl, int *result)
 {
     sigil_err_t err;
+    signature_t *signature;
     int cert_res;
     int digest_res;
 
@@ -350,8 +873,15 @@ sigil_err_t sigil_get_result(sigil_t *sgl, int *result)
 
     *result = 0;
 
-    switch (sgl->subfilter_type) {
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    switch (signature->subfilter_type) {
         case SUBFILTER_adbe_x509_rsa_sha1:
+        case SUBFILTER_adbe_pkcs7_detached:
+        case SUBFILTER_ETSI_CAdES_detached:
+        case SUBFILTER_adbe_pkcs7_sha1:
+        case SUBFILTER_ETSI_RFC3161:
             err = sigil_get_cert_validation_result(sgl, &cert_res);
             if (err != ERR_NONE)
                 return err;
@@ -360,8 +890,10 @@ sigil_err_t sigil_get_result(sigil_t *sgl, int *result)
             if (err != ERR_NONE)
                 return err;
 
+            // the signature timestamp is optional, but it needs to hold if present
             if (cert_res == CERT_STATUS_VERIFIED &&
-                digest_res == HASH_CMP_RESULT_MATCH)
+                digest_res == HASH_CMP_RESULT_MATCH &&
+                signature->result_timestamp != TIMESTAMP_STATUS_FAILED)
             {
                 *result = VERIFY_SUCCESS;
             } else {
@@ -376,66 +908,119 @@ sigil_err_t sigil_get_result(sigil_t *sgl, int *result)
 
 sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result)
 {
+    signature_t *signature;
+
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
-    *result = sgl->result_cert_verification;
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    *result = signature->result_cert_verification;
 
     return ERR_NONE;
 }
 
 sigil_err_t sigil_get_data_integrity_result(sigil_t *sgl, int *result)
 {
+    signature_t *signature;
+
+    if (sgl == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    *result = signature->result_digest_comparison;
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_timestamp_result(sigil_t *sgl, int *result)
+{
+    signature_t *signature;
+
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
-    *result = sgl->result_digest_comparison;
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    *result = signature->result_timestamp;
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_revisions(sigil_t *sgl, const revision_t **revisions,
+                                size_t *count)
+{
+    if (sgl == NULL || revisions == NULL || count == NULL)
+        return ERR_PARAMETER;
+
+    *revisions = sgl->revisions.entry;
+    *count = sgl->revisions.count;
 
     return ERR_NONE;
 }
 
 sigil_err_t sigil_get_subfilter(sigil_t *sgl, int *subfilter)
 {
+    signature_t *signature;
+
     if (sgl == NULL || subfilter == NULL)
         return ERR_PARAMETER;
 
-    *subfilter = sgl->subfilter_type;
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    *subfilter = signature->subfilter_type;
 
     return ERR_NONE;
 }
 
 sigil_err_t sigil_get_hash_fn(sigil_t *sgl, int *hash_fn)
 {
+    signature_t *signature;
+
     if (sgl == NULL || hash_fn == NULL)
         return ERR_PARAMETER;
 
-    *hash_fn = sgl->hash_fn;
+    if ((signature = selected_signature(sgl)) == NULL)
+        return ERR_NO_DATA;
+
+    *hash_fn = signature->hash_fn;
 
     return ERR_NONE;
 }
 
 sigil_err_t sigil_get_original_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest)
 {
+    signature_t *signature;
+
     if (sgl == NULL || digest == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->digest_original == NULL)
+    signature = selected_signature(sgl);
+    if (signature == NULL || signature->digest_original == NULL)
         return ERR_NO_DATA;
 
-    *digest = ASN1_OCTET_STRING_dup(sgl->digest_original);
+    *digest = ASN1_OCTET_STRING_dup(signature->digest_original);
 
     return ERR_NONE;
 }
 
 sigil_err_t sigil_get_computed_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest)
 {
+    signature_t *signature;
+
     if (sgl == NULL || digest == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->digest_computed == NULL)
+    signature = selected_signature(sgl);
+    if (signature == NULL || signature->digest_computed == NULL)
         return ERR_NO_DATA;
 
-    *digest = ASN1_OCTET_STRING_dup(sgl->digest_computed);
+    *digest = ASN1_OCTET_STRING_dup(signature->digest_computed);
 
     return ERR_NONE;
 }
@@ -493,6 +1078,18 @@ void sigil_print_subfilter(sigil_t *sgl)
         case SUBFILTER_adbe_x509_rsa_sha1:
             printf("adbe.x509.rsa_sha1 (PKCS#1)");
             break;
+        case SUBFILTER_adbe_pkcs7_detached:
+            printf("adbe.pkcs7.detached (PKCS#7)");
+            break;
+        case SUBFILTER_ETSI_CAdES_detached:
+            printf("ETSI.CAdES.detached (PAdES)");
+            break;
+        case SUBFILTER_adbe_pkcs7_sha1:
+            printf("adbe.pkcs7.sha1 (PKCS#7)");
+            break;
+        case SUBFILTER_ETSI_RFC3161:
+            printf("ETSI.RFC3161 (document timestamp)");
+            break;
         default:
             printf("unknown");
     }
@@ -532,24 +1129,20 @@ void sigil_print_hash_fn(sigil_t *sgl)
 
 void sigil_print_cert_info(sigil_t *sgl)
 {
-    BIO *out = BIO_new_fp(stdout,BIO_NOCLOSE);
+    signature_t *signature;
+    BIO *out;
 
-    if (sgl == NULL || sgl->certificates == NULL || sgl->certificates->x509 == NULL)
+    if (sgl == NULL || (signature = selected_signature(sgl)) == NULL ||
+        signature->certificates == NULL || signature->certificates->x509 == NULL)
+    {
         return;
+    }
 
-    X509_print_ex(out, sgl->certificates->x509, XN_FLAG_COMPAT, X509_FLAG_COMPAT);
-
-    BIO_free_all(out);
-}
+    out = BIO_new_fp(stdout, BIO_NOCLOSE);
 
-static void range_free(range_t *range)
-{
-    if (range == NULL)
-        return;
+    X509_print_ex(out, signature->certificates->x509, XN_FLAG_COMPAT, X509_FLAG_COMPAT);
 
-    range_free(range->next);
-    sigil_zeroize(range, sizeof(*range));
-    free(range);
+    BIO_free_all(out);
 }
 
 void sigil_free(sigil_t **sgl)
@@ -561,6 +1154,8 @@ void sigil_free(sigil_t **sgl)
         fclose((*sgl)->pdf_data.file);
         (*sgl)->pdf_data.deallocation_info ^= DEALLOCATE_FILE;
     }
+    if ((*sgl)->pdf_data.deallocation_info & DEALLOCATE_MAPPING)
+        pdf_unmap_file(*sgl);
     if ((*sgl)->pdf_data.deallocation_info & DEALLOCATE_BUFFER) {
         sigil_zeroize((*sgl)->pdf_data.buffer, (*sgl)->pdf_data.size);
         free((*sgl)->pdf_data.buffer);
@@ -570,39 +1165,15 @@ void sigil_free(sigil_t **sgl)
     if ((*sgl)->xref != NULL)
         xref_free((*sgl)->xref);
 
-    if ((*sgl)->fields.capacity > 0) {
-        for (size_t i = 0; i < (*sgl)->fields.capacity; i++) {
-            if ((*sgl)->fields.entry[i] != NULL) {
-                sigil_zeroize((*sgl)->fields.entry[i],
-                              sizeof(*(*sgl)->fields.entry[i]));
-                free((*sgl)->fields.entry[i]);
-            }
-        }
-
-        if ((*sgl)->fields.entry != NULL) {
-            sigil_zeroize((*sgl)->fields.entry,
-                          sizeof(*(*sgl)->fields.entry) * (*sgl)->fields.capacity);
-            free((*sgl)->fields.entry);
-        }
-    }
-
-    if ((*sgl)->byte_range != NULL)
-        range_free((*sgl)->byte_range);
-
-    if ((*sgl)->certificates != NULL)
-        cert_free((*sgl)->certificates);
+    objstm_cache_free(*sgl);
+    dss_free(*sgl);
+    revisions_clear(*sgl);
 
-    if ((*sgl)->contents != NULL)
-        contents_free(*sgl);
+    free((*sgl)->cache_dir);
 
-    if ((*sgl)->digest_computed != NULL)
-        ASN1_OCTET_STRING_free((*sgl)->digest_computed);
+    ref_array_free(&((*sgl)->fields));
 
-    if ((*sgl)->digest_algorithm != NULL)
-        X509_ALGOR_free((*sgl)->digest_algorithm);
-
-    if ((*sgl)->digest_original != NULL)
-        ASN1_OCTET_STRING_free((*sgl)->digest_original);
+    signatures_clear(*sgl);
 
     if ((*sgl)->trusted_store != NULL)
         X509_STORE_free((*sgl)->trusted_store);
@@ -642,10 +1213,194 @@ const char *sigil_err_string(sigil_err_t err)
     }
 }
 
+/** @brief Appends the update with more signature fields to the PDF with the
+ *         DSS, all of them with the value of the first field 4 0 R - the same
+ *         signature verified against the same revocation data
+ *
+ * @param path path to the signed PDF with the catalog 1 0 obj
+ * @param count number of the signature fields
+ * @param size output - size of the data
+ * @return allocated data or NULL
+ */
+static char *test_share_signature(const char *path, size_t count, size_t *size)
+{
+    const char *fields = "/Fields [4 0 R";
+    FILE *file;
+    char *pdf = NULL,
+         *catalog = NULL,
+         *catalog_end = NULL,
+         *fields_end = NULL,
+         *found;
+    size_t prev_offset = 0,
+           catalog_offset,
+           table_offset,
+           fields_offset;
+    long file_size;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0 ||
+        (pdf = malloc(2 * (size_t)file_size + 128 * count + 1024)) == NULL ||
+        fread(pdf, 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+        fclose(file);
+        free(pdf);
+        return NULL;
+    }
+    fclose(file);
+
+    *size = (size_t)file_size;
+    pdf[*size] = '\0';
+
+    // the catalog and the cross-reference table of the last revision
+    for (found = pdf; (found = (char *)sigil_memmem(found, *size - (size_t)(found - pdf),
+                                                    "\n1 0 obj", 8)) != NULL; found++)
+    {
+        catalog = found + 8;
+    }
+    for (found = pdf; (found = (char *)sigil_memmem(found, *size - (size_t)(found - pdf),
+                                                    "startxref\n", 10)) != NULL; found++)
+    {
+        prev_offset = strtoul(found + 10, NULL, 10);
+    }
+
+    if (catalog != NULL)
+        catalog_end = (char *)sigil_memmem(catalog, *size - (size_t)(catalog - pdf), "endobj", 6);
+    if (catalog_end != NULL)
+        fields_end = (char *)sigil_memmem(catalog, (size_t)(catalog_end - catalog),
+                                          fields, strlen(fields));
+    if (catalog_end == NULL || fields_end == NULL || prev_offset == 0 || count < 2) {
+        free(pdf);
+        return NULL;
+    }
+    fields_end += strlen(fields);
+
+    *size += (size_t)sprintf(pdf + *size, "\n");
+
+    catalog_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "1 0 obj");
+    memcpy(pdf + *size, catalog, (size_t)(fields_end - catalog));
+    *size += (size_t)(fields_end - catalog);
+    for (size_t i = 1; i < count; i++) {
+        *size += (size_t)sprintf(pdf + *size, " %zu 0 R", 9 + i);
+    }
+    memcpy(pdf + *size, fields_end, (size_t)(catalog_end - fields_end));
+    *size += (size_t)(catalog_end - fields_end);
+    *size += (size_t)sprintf(pdf + *size, "endobj\n");
+
+    fields_offset = *size;
+    for (size_t i = 1; i < count; i++) {
+        *size += (size_t)sprintf(pdf + *size, "%zu 0 obj\n<</FT /Sig /T (Signature%zu)"
+                                 " /V 5 0 R>>\nendobj\n", 9 + i, i + 1);
+    }
+
+    table_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "xref\n0 1\n0000000000 65535 f\r\n"
+                             "1 1\n%010zu 00000 n\r\n10 %zu\n", catalog_offset, count - 1);
+    // the field objects have the same length up to the number of digits
+    for (size_t i = 1; i < count; i++) {
+        *size += (size_t)sprintf(pdf + *size, "%010zu 00000 n\r\n", fields_offset);
+        fields_offset += (size_t)snprintf(NULL, 0, "%zu 0 obj\n<</FT /Sig /T (Signature%zu)"
+                                          " /V 5 0 R>>\nendobj\n", 9 + i, i + 1);
+    }
+    *size += (size_t)sprintf(pdf + *size, "trailer\n<</Size %zu /Root 1 0 R /Prev %zu>>\n"
+                             "startxref\n%zu\n%%%%EOF\n", 9 + count, prev_offset, table_offset);
+
+    return pdf;
+}
+
+/** @brief Appends the update with two more signature fields to the PDF - the
+ *         second signature with the shortened byte range, an unsigned field
+ *         and a text field in between
+ *
+ * @param path path to the signed PDF
+ * @param size output - size of the data
+ * @return allocated data or NULL
+ */
+static char *test_append_signatures(const char *path, size_t *size)
+{
+    const char *range = "57912 503]";
+    FILE *file;
+    char *pdf = NULL,
+         *dict,
+         *dict_end = NULL,
+         *found;
+    size_t dict_len,
+           offsets[4],
+           table_offset;
+    long file_size;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0 ||
+        (pdf = malloc(2 * (size_t)file_size + 1024)) == NULL ||
+        fread(pdf, 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+        fclose(file);
+        free(pdf);
+        return NULL;
+    }
+    fclose(file);
+
+    *size = (size_t)file_size;
+
+    // the dictionary of the first signature is copied
+    dict = (char *)sigil_memmem(pdf, *size, "16 0 obj", 8);
+    if (dict != NULL)
+        dict_end = (char *)sigil_memmem(dict, *size - (size_t)(dict - pdf), "endobj", 6);
+    if (dict == NULL || dict_end == NULL) {
+        free(pdf);
+        return NULL;
+    }
+    dict += 8;
+    dict_len = (size_t)(dict_end - dict);
+
+    *size += (size_t)sprintf(pdf + *size, "\n");
+    *size += (size_t)sprintf(pdf + *size, "12 0 obj\n<</Type /Catalog/Pages 4 0 R"
+                             "/AcroForm <</Fields [14 0 R 19 0 R 20 0 R 21 0 R]"
+                             "/SigFlags 3>>>>\nendobj\n");
+
+    offsets[0] = *size;
+    *size += (size_t)sprintf(pdf + *size, "19 0 obj\n<</FT /Sig/T (Second)/V 22 0 R>>\nendobj\n");
+    offsets[1] = *size;
+    *size += (size_t)sprintf(pdf + *size, "20 0 obj\n<</FT /Tx/T (Name)/V (text)>>\nendobj\n");
+    offsets[2] = *size;
+    *size += (size_t)sprintf(pdf + *size, "21 0 obj\n<</FT /Sig/T (Unsigned)>>\nendobj\n");
+    offsets[3] = *size;
+    *size += (size_t)sprintf(pdf + *size, "22 0 obj");
+    memcpy(pdf + *size, dict, dict_len);
+
+    found = (char *)sigil_memmem(pdf + *size, dict_len, range, strlen(range));
+    if (found == NULL) {
+        free(pdf);
+        return NULL;
+    }
+    found[strlen(range) - 2] = '2';
+
+    *size += dict_len;
+    *size += (size_t)sprintf(pdf + *size, "endobj\n");
+
+    table_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "xref\n0 1\n0000000000 65535 f\r\n"
+                             "12 1\n%010zd 00000 n\r\n19 4\n", (size_t)file_size + 1);
+    for (size_t i = 0; i < 4; i++) {
+        *size += (size_t)sprintf(pdf + *size, "%010zd 00000 n\r\n", offsets[i]);
+    }
+    *size += (size_t)sprintf(pdf + *size, "trailer\n<</Size 23/Root 12 0 R/Prev 58077>>\n"
+                             "startxref\n%zd\n%%%%EOF\n", table_offset);
+
+    return pdf;
+}
+
 int sigil_sigil_self_test(int verbosity)
 {
     sigil_err_t err;
     sigil_t *sgl = NULL;
+    char *pdf = NULL;
 
     print_module_name("sigil", verbosity);
 
@@ -679,6 +1434,401 @@ int sigil_sigil_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: all the signatures of the document, verified in parallel
+    print_test_item("VERIFY multiple signatures", verbosity);
+
+    {
+        size_t size,
+               count;
+        int result,
+            cert_result;
+
+        if ((pdf = test_append_signatures("test/subtype_adbe.x509.rsa_sha1.pdf",
+                                          &size)) == NULL)
+        {
+            goto failed;
+        }
+
+        for (size_t threads = 1; threads <= 4; threads += 3) {
+            if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+                sigil_set_thread_count(sgl, threads) != ERR_NONE ||
+                sigil_set_trusted_system(sgl) != ERR_NONE ||
+                sigil_verify(sgl) != ERR_NONE ||
+                sigil_get_signature_count(sgl, &count) != ERR_NONE || count != 2 ||
+                sigil_select_signature(sgl, 2) != ERR_PARAMETER)
+            {
+                goto failed;
+            }
+
+            // the first one signs the original document
+            if (sgl->signatures[0].ref_sig_field.object_num != 14 ||
+                sigil_select_signature(sgl, 0) != ERR_NONE ||
+                sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+                result != HASH_CMP_RESULT_MATCH ||
+                sigil_get_cert_validation_result(sgl, &cert_result) != ERR_NONE)
+            {
+                goto failed;
+            }
+
+            // the second one has the same signer, but covers different data
+            if (sgl->signatures[1].ref_sig_field.object_num != 19 ||
+                sigil_select_signature(sgl, 1) != ERR_NONE ||
+                sigil_get_signature_error(sgl, &err) != ERR_NONE || err != ERR_NONE ||
+                sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+                result != HASH_CMP_RESULT_DIFFER ||
+                sigil_get_cert_validation_result(sgl, &result) != ERR_NONE ||
+                result != cert_result ||
+                sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_FAILED)
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+
+        free(pdf);
+        pdf = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with subfilter pkcs7.detached
+    print_test_item("VERIFY PKCS#7 detached", verbosity);
+
+    {
+        // signed attributes with SHA-256, the plain signature with SHA-384
+        const char *paths[] = {
+            "test/subtype_adbe.pkcs7.detached.pdf",
+            "test/subtype_adbe.pkcs7.detached_noattr.pdf",
+        };
+        const int hash_fns[] = { HASH_FN_sha256, HASH_FN_sha384 };
+        int result;
+
+        for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+            sgl = test_prepare_sgl_path(paths[i]);
+            if (sgl == NULL ||
+                sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+                sigil_verify(sgl) != ERR_NONE ||
+                sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS ||
+                sigil_get_subfilter(sgl, &result) != ERR_NONE ||
+                result != SUBFILTER_adbe_pkcs7_detached ||
+                sigil_get_hash_fn(sgl, &result) != ERR_NONE || result != hash_fns[i])
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+
+        // untrusted signer
+        sgl = test_prepare_sgl_path(paths[0]);
+        if (sgl == NULL ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_FAILED ||
+            sigil_get_cert_validation_result(sgl, &result) != ERR_NONE ||
+            result != CERT_STATUS_FAILED ||
+            sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+            result != HASH_CMP_RESULT_MATCH)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with subfilter CAdES.detached
+    print_test_item("VERIFY CAdES detached", verbosity);
+
+    {
+        int result;
+
+        sgl = test_prepare_sgl_path("test/subtype_ETSI.CAdES.detached.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS ||
+            sigil_get_subfilter(sgl, &result) != ERR_NONE ||
+            result != SUBFILTER_ETSI_CAdES_detached)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with subfilter pkcs7.sha1
+    print_test_item("VERIFY PKCS#7 SHA-1", verbosity);
+
+    {
+        int result;
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.pkcs7.sha1.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS ||
+            sigil_get_subfilter(sgl, &result) != ERR_NONE ||
+            result != SUBFILTER_adbe_pkcs7_sha1 ||
+            sigil_get_hash_fn(sgl, &result) != ERR_NONE || result != HASH_FN_sha1)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with the document timestamp
+    print_test_item("VERIFY document timestamp", verbosity);
+
+    {
+        const int subfilters[] = { SUBFILTER_adbe_pkcs7_detached, SUBFILTER_ETSI_RFC3161 };
+        size_t count;
+        int result;
+
+        sgl = test_prepare_sgl_path("test/subtype_ETSI.RFC3161.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS ||
+            sigil_get_subfilter(sgl, &result) != ERR_NONE ||
+            result != SUBFILTER_ETSI_RFC3161 ||
+            sigil_get_hash_fn(sgl, &result) != ERR_NONE || result != HASH_FN_sha256)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        // the timestamp stacked over the signed document, both in one run
+        sgl = test_prepare_sgl_path("test/subtype_adbe.pkcs7.detached_timestamped.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_signature_count(sgl, &count) != ERR_NONE || count != 2)
+        {
+            goto failed;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (sigil_select_signature(sgl, i) != ERR_NONE ||
+                sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS ||
+                sigil_get_subfilter(sgl, &result) != ERR_NONE || result != subfilters[i])
+            {
+                goto failed;
+            }
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: signature with the embedded signature timestamp
+    print_test_item("VERIFY signature timestamp", verbosity);
+
+    {
+        int result;
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.pkcs7.detached_sigts.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS ||
+            sigil_get_timestamp_result(sgl, &result) != ERR_NONE ||
+            result != TIMESTAMP_STATUS_VERIFIED)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        // the signed data are intact, but the token is over another value
+        sgl = test_prepare_sgl_path("test/modified_sigts.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_FAILED ||
+            sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+            result != HASH_CMP_RESULT_MATCH ||
+            sigil_get_timestamp_result(sgl, &result) != ERR_NONE ||
+            result != TIMESTAMP_STATUS_FAILED)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with the revocation data in the DSS
+    print_test_item("VERIFY revocation from DSS", verbosity);
+
+    {
+        const char *revoked[] = {
+            "test/dss_revoked_crl.pdf",
+            "test/dss_revoked_ocsp.pdf"
+        };
+        int result;
+
+        sgl = test_prepare_sgl_path("test/dss_valid.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        for (int i = 0; i < 2; i++) {
+            sgl = test_prepare_sgl_path(revoked[i]);
+            if (sgl == NULL ||
+                sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+                sigil_verify(sgl) != ERR_NONE ||
+                sigil_get_cert_validation_result(sgl, &result) != ERR_NONE ||
+                result != CERT_STATUS_FAILED)
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+
+        // revoked only after the time of the verified signature timestamp
+        sgl = test_prepare_sgl_path("test/dss_revoked_later.pdf");
+        if (sgl == NULL ||
+            sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_result(sgl, &result) != ERR_NONE || result != VERIFY_SUCCESS)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with the chains validated during the hashing
+    print_test_item("VERIFY concurrent chains", verbosity);
+
+    {
+        const char *paths[] = {
+            "test/dss_valid.pdf",
+            "test/dss_revoked_ocsp.pdf",
+            "test/modified_sigts.pdf",
+            "test/subtype_ETSI.CAdES.detached.pdf",
+            "test/subtype_adbe.pkcs7.detached_sigts.pdf"
+        };
+        sigil_err_t verify_err[2];
+        int results[2][3];
+
+        for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+            for (int mode = CHAIN_MODE_SERIAL; mode <= CHAIN_MODE_CONCURRENT; mode++) {
+                sgl = test_prepare_sgl_path(paths[i]);
+                if (sgl == NULL ||
+                    sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+                    sigil_set_chain_mode(sgl, mode) != ERR_NONE ||
+                    sigil_set_thread_count(sgl, 4) != ERR_NONE)
+                {
+                    goto failed;
+                }
+
+                verify_err[mode] = sigil_verify(sgl);
+
+                if (sigil_get_result(sgl, &(results[mode][0])) != ERR_NONE ||
+                    sigil_get_cert_validation_result(sgl, &(results[mode][1])) != ERR_NONE ||
+                    sigil_get_data_integrity_result(sgl, &(results[mode][2])) != ERR_NONE)
+                {
+                    goto failed;
+                }
+
+                sigil_free(&sgl);
+            }
+
+            if (verify_err[0] != verify_err[1] ||
+                memcmp(results[0], results[1], sizeof(results[0])) != 0)
+            {
+                goto failed;
+            }
+        }
+
+        sgl = test_prepare_sgl_path("test/dss_valid.pdf");
+        if (sgl == NULL ||
+            sigil_set_chain_mode(sgl, 2) != ERR_PARAMETER ||
+            sgl->chain_mode != CHAIN_MODE_SERIAL)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with the chains of many signatures validated in
+    // parallel against the shared revocation data
+    print_test_item("VERIFY parallel chains", verbosity);
+
+    {
+        const char *paths[] = {
+            "test/dss_valid.pdf",
+            "test/dss_revoked_crl.pdf",
+            "test/dss_revoked_ocsp.pdf"
+        };
+        const int expected[] = {
+            CERT_STATUS_VERIFIED, CERT_STATUS_FAILED, CERT_STATUS_FAILED
+        };
+        const size_t fields = 8;
+        size_t size,
+               count;
+        int result;
+
+        for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+            if ((pdf = test_share_signature(paths[i], fields, &size)) == NULL)
+                goto failed;
+
+            for (int mode = CHAIN_MODE_SERIAL; mode <= CHAIN_MODE_CONCURRENT; mode++) {
+                if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL ||
+                    sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE ||
+                    sigil_set_chain_mode(sgl, mode) != ERR_NONE ||
+                    sigil_set_thread_count(sgl, 4) != ERR_NONE ||
+                    sigil_verify(sgl) != ERR_NONE ||
+                    sigil_get_signature_count(sgl, &count) != ERR_NONE || count != fields)
+                {
+                    goto failed;
+                }
+
+                for (size_t j = 0; j < count; j++) {
+                    if (sigil_select_signature(sgl, j) != ERR_NONE ||
+                        sigil_get_signature_error(sgl, &err) != ERR_NONE || err != ERR_NONE ||
+                        sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+                        result != HASH_CMP_RESULT_MATCH ||
+                        sigil_get_cert_validation_result(sgl, &result) != ERR_NONE ||
+                        result != expected[i])
+                    {
+                        goto failed;
+                    }
+                }
+
+                sigil_free(&sgl);
+            }
+
+            free(pdf);
+            pdf = NULL;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn sigil_verify with subfilter x509.rsa_sha1 (correct)
     print_test_item("VERIFY PKCS#1 (correct)", verbosity);
 
@@ -743,6 +1893,7 @@ int sigil_sigil_self_test(int verbosity)
     return 0;
 
 failed:
+    free(pdf);
     if (sgl)
         sigil_free(&sgl);
 
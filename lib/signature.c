@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "cert.h"
+#include "config.h"
+#include "constants.h"
+#include "contents.h"
+#include "signature.h"
+#include "sigil.h"
+
+
+static void range_free(range_t *range)
+{
+    if (range == NULL)
+        return;
+
+    range_free(range->next);
+    sigil_zeroize(range, sizeof(*range));
+    free(range);
+}
+
+static void signature_free(signature_t *signature)
+{
+    if (signature->byte_range != NULL)
+        range_free(signature->byte_range);
+
+    if (signature->certificates != NULL)
+        cert_free(signature->certificates);
+
+    if (signature->contents != NULL)
+        contents_free(signature->contents);
+
+    if (signature->digest_computed != NULL)
+        ASN1_OCTET_STRING_free(signature->digest_computed);
+
+    if (signature->digest_algorithm != NULL)
+        X509_ALGOR_free(signature->digest_algorithm);
+
+    if (signature->digest_original != NULL)
+        ASN1_OCTET_STRING_free(signature->digest_original);
+
+    if (signature->cms != NULL)
+        CMS_ContentInfo_free(signature->cms);
+
+    if (signature->tst_info != NULL)
+        TS_TST_INFO_free(signature->tst_info);
+
+    sigil_zeroize(signature, sizeof(*signature));
+}
+
+sigil_err_t signature_add(sigil_t *sgl, signature_t **signature)
+{
+    signature_t *entry;
+
+    if (sgl == NULL || signature == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->signature_count >= sgl->signature_capacity) {
+        size_t capacity = MAX(2 * sgl->signature_capacity, SIGNATURE_PREALLOCATION);
+
+        entry = realloc(sgl->signatures, capacity * sizeof(signature_t));
+        if (entry == NULL)
+            return ERR_ALLOCATION;
+
+        sgl->signatures = entry;
+        sgl->signature_capacity = capacity;
+    }
+
+    entry = &(sgl->signatures[sgl->signature_count]);
+    sigil_zeroize(entry, sizeof(*entry));
+
+    entry->subfilter_type           = SUBFILTER_UNKNOWN;
+    entry->hash_fn                  = HASH_FN_UNKNOWN;
+    entry->error                    = ERR_NONE;
+    entry->result_cert_verification = CERT_STATUS_UNKNOWN;
+    entry->result_digest_comparison = HASH_CMP_RESULT_UNKNOWN;
+    entry->result_timestamp         = TIMESTAMP_STATUS_NONE;
+
+    sgl->signature_count++;
+    *signature = entry;
+
+    return ERR_NONE;
+}
+
+sigil_err_t signatures_remove_unsigned(sigil_t *sgl)
+{
+    signature_t *signature;
+    size_t kept = 0;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        signature = &(sgl->signatures[i]);
+
+        if (signature->ref_sig_dict.object_num == 0 && signature->offset_sig_dict == 0) {
+            signature_free(signature);
+            continue;
+        }
+
+        if (kept != i)
+            sgl->signatures[kept] = *signature;
+        kept++;
+    }
+
+    sgl->signature_count = kept;
+    sgl->signature_selected = 0;
+
+    return (kept > 0) ? ERR_NONE : ERR_NO_SIGNATURE;
+}
+
+void signatures_clear(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return;
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        signature_free(&(sgl->signatures[i]));
+    }
+
+    free(sgl->signatures);
+
+    sgl->signatures = NULL;
+    sgl->signature_count = 0;
+    sgl->signature_capacity = 0;
+    sgl->signature_selected = 0;
+}
+
+int sigil_signature_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    signature_t *signature;
+
+    print_module_name("signature", verbosity);
+
+    // TEST: the array grows, the new signatures have the default values
+    print_test_item("fn signature_add", verbosity);
+
+    if (sigil_init(&sgl) != ERR_NONE)
+        goto failed;
+
+    for (size_t i = 0; i < 100; i++) {
+        if (signature_add(sgl, &signature) != ERR_NONE ||
+            signature != &(sgl->signatures[i]) ||
+            signature->subfilter_type != SUBFILTER_UNKNOWN ||
+            signature->hash_fn != HASH_FN_UNKNOWN ||
+            signature->result_cert_verification != CERT_STATUS_UNKNOWN ||
+            signature->result_digest_comparison != HASH_CMP_RESULT_UNKNOWN ||
+            signature->result_timestamp != TIMESTAMP_STATUS_NONE ||
+            signature->byte_range != NULL || signature->certificates != NULL)
+        {
+            goto failed;
+        }
+
+        signature->ref_sig_field.object_num = i + 1;
+    }
+
+    if (sgl->signature_count != 100 || sgl->signature_capacity < 100 ||
+        sgl->signatures[99].ref_sig_field.object_num != 100)
+    {
+        goto failed;
+    }
+
+    signatures_clear(sgl);
+
+    if (sgl->signatures != NULL || sgl->signature_count != 0)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: only the fields with the signature dictionary remain
+    print_test_item("fn signatures_remove_unsigned", verbosity);
+
+    for (size_t i = 0; i < 10; i++) {
+        if (signature_add(sgl, &signature) != ERR_NONE)
+            goto failed;
+
+        signature->ref_sig_field.object_num = i + 1;
+        if (i % 3 == 0)
+            signature->ref_sig_dict.object_num = 100 + i;
+        if (i % 3 == 1)
+            signature->offset_sig_dict = 1000 + i;
+    }
+
+    sgl->signature_selected = 5;
+
+    if (signatures_remove_unsigned(sgl) != ERR_NONE ||
+        sgl->signature_count != 7 || sgl->signature_selected != 0)
+    {
+        goto failed;
+    }
+
+    {
+        const size_t expected[] = { 1, 2, 4, 5, 7, 8, 10 };
+
+        for (size_t i = 0; i < sizeof(expected) / sizeof(*expected); i++) {
+            if (sgl->signatures[i].ref_sig_field.object_num != expected[i])
+                goto failed;
+        }
+    }
+
+    // nothing signed
+    signatures_clear(sgl);
+
+    if (signature_add(sgl, &signature) != ERR_NONE ||
+        signatures_remove_unsigned(sgl) != ERR_NO_SIGNATURE ||
+        sgl->signature_count != 0)
+    {
+        goto failed;
+    }
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    sigil_free(&sgl);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -0,0 +1,694 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "sigil.h"
+#include "stream.h"
+
+#define FILTER_NAME_MAX   20
+
+struct stream_reader_t {
+    sigil_t       *sgl;
+    stream_info_t  info;
+    z_stream       zs;
+    int            zs_ready;
+    int            finished;    // all the data decoded
+    size_t         in_offset;   // next encoded byte to be consumed
+    unsigned char *in;          // encoded data read from a file
+    unsigned char *row;         // current row with the filter type byte
+    unsigned char *prev_row;
+    size_t         row_size;
+    size_t         row_pos;     // next byte of the row to be returned
+    size_t         bpp;         // bytes per complete pixel
+};
+
+void stream_info_init(stream_info_t *info)
+{
+    if (info == NULL)
+        return;
+
+    info->data_offset = 0;
+    info->length = 0;
+    info->filter = STREAM_FILTER_NONE;
+    info->predictor = PREDICTOR_NONE;
+    info->colors = 1;
+    info->bits_per_component = 8;
+    info->columns = 1;
+}
+
+sigil_err_t parse_stream_filter(sigil_t *sgl, stream_info_t *info)
+{
+    sigil_err_t err;
+    char name[FILTER_NAME_MAX];
+    int array = 0;
+    char c;
+
+    if (sgl == NULL || info == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+        return err;
+    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+        return err;
+
+    if (c == '[') {
+        if ((err = skip_word(sgl, "[")) != ERR_NONE)
+            return err;
+        array = 1;
+    }
+
+    err = parse_name(sgl, name, FILTER_NAME_MAX);
+    if (err != ERR_NONE)
+        return err;
+
+    // only the single filter is supported
+    if (array && skip_word(sgl, "]") != ERR_NONE)
+        return ERR_NOT_IMPLEMENTED;
+
+    if (strcmp(name, "FlateDecode") == 0 || strcmp(name, "Fl") == 0) {
+        info->filter = STREAM_FILTER_FLATE;
+    } else {
+        return ERR_NOT_IMPLEMENTED;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t parse_stream_decode_parms(sigil_t *sgl, stream_info_t *info)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Predictor,        0, 0 },
+        { DICT_KEY_Colors,           0, 0 },
+        { DICT_KEY_BitsPerComponent, 0, 0 },
+        { DICT_KEY_Columns,          0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+    size_t *values[] = {
+        &(info->predictor),
+        &(info->colors),
+        &(info->bits_per_component),
+        &(info->columns),
+    };
+    char c;
+
+    if (sgl == NULL || info == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+        return err;
+    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+        return err;
+
+    switch (c) {
+        case 'n':
+            return skip_word(sgl, "null");
+        case '[':
+            // parameters of the single filter
+            if ((err = skip_word(sgl, "[")) != ERR_NONE)
+                return err;
+            if ((err = parse_stream_decode_parms(sgl, info)) != ERR_NONE)
+                return err;
+            return skip_array(sgl);
+        default:
+            break;
+    }
+
+    if ((err = skip_word(sgl, "<<")) != ERR_NONE)
+        return err;
+
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    for (size_t i = 0; i < count; i++) {
+        if (dict_projection_goto(sgl, entries, count, entries[i].key) != ERR_NONE)
+            continue;
+
+        if ((err = parse_number(sgl, values[i])) != ERR_NONE)
+            return err;
+    }
+
+    if (info->colors < 1 || info->columns < 1 ||
+        (info->bits_per_component != 1 && info->bits_per_component != 2 &&
+         info->bits_per_component != 4 && info->bits_per_component != 8 &&
+         info->bits_per_component != 16))
+    {
+        return ERR_PDF_CONTENT;
+    }
+
+    if (info->columns > STREAM_ROW_MAX ||
+        info->colors * info->bits_per_component > STREAM_ROW_MAX / info->columns)
+    {
+        return ERR_PDF_CONTENT;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t parse_stream_length(sigil_t *sgl, stream_info_t *info)
+{
+    sigil_err_t err;
+    reference_t ref;
+    size_t position;
+
+    if (sgl == NULL || info == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+        return err;
+    if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+        return err;
+
+    if (parse_indirect_reference(sgl, &ref) == ERR_NONE) {
+        if ((err = pdf_goto_obj(sgl, &ref)) != ERR_NONE)
+            return err;
+    } else {
+        if ((err = pdf_move_pos_abs(sgl, position)) != ERR_NONE)
+            return err;
+    }
+
+    return parse_number(sgl, &(info->length));
+}
+
+sigil_err_t locate_stream_data(sigil_t *sgl, stream_info_t *info)
+{
+    sigil_err_t err;
+    char c;
+
+    if (sgl == NULL || info == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = skip_word(sgl, "stream")) != ERR_NONE)
+        return err;
+
+    // the keyword is followed by CRLF or LF
+    if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
+        return err;
+    if (c == '\r') {
+        if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+            return err;
+        if (c == '\n' && (err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
+            return err;
+    } else if (c != '\n') {
+        return ERR_PDF_CONTENT;
+    }
+
+    return get_curr_position(sgl, &(info->data_offset));
+}
+
+sigil_err_t stream_reader_open(sigil_t *sgl, const stream_info_t *info,
+                               stream_reader_t **reader)
+{
+    stream_reader_t *r;
+
+    if (sgl == NULL || info == NULL || reader == NULL)
+        return ERR_PARAMETER;
+
+    if (info->predictor == PREDICTOR_TIFF)
+        return ERR_NOT_IMPLEMENTED;
+
+    if (info->data_offset + info->length < info->data_offset ||
+        sgl->offset_pdf_start + info->data_offset + info->length > sgl->pdf_data.size)
+    {
+        return ERR_PDF_CONTENT;
+    }
+
+    r = malloc(sizeof(stream_reader_t));
+    if (r == NULL)
+        return ERR_ALLOCATION;
+    memset(r, 0, sizeof(*r));
+
+    r->sgl = sgl;
+    r->info = *info;
+
+    if (sgl->pdf_data.buffer == NULL) {
+        r->in = malloc(STREAM_CHUNK_SIZE + 1);
+        if (r->in == NULL)
+            goto failed;
+    }
+
+    if (info->filter == STREAM_FILTER_FLATE) {
+        if (inflateInit(&(r->zs)) != Z_OK)
+            goto failed;
+        r->zs_ready = 1;
+    }
+
+    if (info->predictor >= PREDICTOR_PNG) {
+        r->bpp = MAX(1, info->colors * info->bits_per_component / 8);
+        r->row_size = 1 + (info->colors * info->bits_per_component * info->columns + 7) / 8;
+        r->row_pos = r->row_size;
+
+        r->row = calloc(r->row_size, 1);
+        r->prev_row = calloc(r->row_size, 1);
+        if (r->row == NULL || r->prev_row == NULL)
+            goto failed;
+    }
+
+    *reader = r;
+
+    return ERR_NONE;
+
+failed:
+    stream_reader_free(&r);
+
+    return ERR_ALLOCATION;
+}
+
+void stream_reader_free(stream_reader_t **reader)
+{
+    if (reader == NULL || *reader == NULL)
+        return;
+
+    if ((*reader)->zs_ready)
+        inflateEnd(&((*reader)->zs));
+
+    free((*reader)->in);
+    free((*reader)->row);
+    free((*reader)->prev_row);
+    free(*reader);
+
+    *reader = NULL;
+}
+
+/** @brief Provides the next part of the encoded data in the z_stream input,
+ *         directly from the buffer, or read from the file
+ *
+ * @param r stream reader
+ * @return ERR_NONE if success, ERR_NO_DATA at the end of the encoded data
+ */
+static sigil_err_t refill_input(stream_reader_t *r)
+{
+    sigil_err_t err;
+    size_t remaining = r->info.length - r->in_offset,
+           read_size;
+
+    if (remaining == 0)
+        return ERR_NO_DATA;
+
+    if (r->sgl->pdf_data.buffer != NULL) {
+        read_size = MIN(remaining, UINT_MAX);
+        r->zs.next_in = (unsigned char *)r->sgl->pdf_data.buffer +
+                        r->sgl->offset_pdf_start + r->info.data_offset + r->in_offset;
+    } else {
+        err = pdf_move_pos_abs(r->sgl, r->info.data_offset + r->in_offset);
+        if (err != ERR_NONE)
+            return err;
+
+        err = pdf_read(r->sgl, MIN(remaining, STREAM_CHUNK_SIZE), (char *)r->in,
+                       &read_size);
+        if (err != ERR_NONE)
+            return err;
+
+        r->zs.next_in = r->in;
+    }
+
+    r->zs.avail_in = (uInt)read_size;
+    r->in_offset += read_size;
+
+    return ERR_NONE;
+}
+
+/** @brief Decodes the next part of the data without the predictor applied
+ *
+ * @param r stream reader
+ * @param out output - the data
+ * @param size number of bytes requested
+ * @param produced output - number of bytes decoded, lower than size only at
+ *                 the end of the data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t decode_raw(stream_reader_t *r, unsigned char *out, size_t size,
+                              size_t *produced)
+{
+    sigil_err_t err;
+    size_t chunk;
+    int ret;
+
+    *produced = 0;
+
+    while (*produced < size && !r->finished) {
+        if (r->zs.avail_in == 0) {
+            err = refill_input(r);
+            if (err == ERR_NO_DATA) {
+                r->finished = 1;
+                break;
+            }
+            if (err != ERR_NONE)
+                return err;
+        }
+
+        chunk = MIN(size - *produced, UINT_MAX);
+
+        if (r->info.filter == STREAM_FILTER_NONE) {
+            chunk = MIN(chunk, r->zs.avail_in);
+            memcpy(out + *produced, r->zs.next_in, chunk);
+            r->zs.next_in += chunk;
+            r->zs.avail_in -= (uInt)chunk;
+            *produced += chunk;
+            continue;
+        }
+
+        r->zs.next_out = out + *produced;
+        r->zs.avail_out = (uInt)chunk;
+
+        ret = inflate(&(r->zs), Z_NO_FLUSH);
+
+        *produced += chunk - r->zs.avail_out;
+
+        if (ret == Z_STREAM_END) {
+            r->finished = 1;
+        } else if (ret != Z_OK && !(ret == Z_BUF_ERROR && r->zs.avail_in == 0)) {
+            return ERR_PDF_CONTENT;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+static unsigned char paeth(unsigned char a, unsigned char b, unsigned char c)
+{
+    int p = a + b - c,
+        pa = abs(p - a),
+        pb = abs(p - b),
+        pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+/** @brief Decodes the next row and reverts the PNG filter applied on it
+ *
+ * @param r stream reader
+ * @return ERR_NONE if success, ERR_NO_DATA if there is no other complete row
+ */
+static sigil_err_t next_row(stream_reader_t *r)
+{
+    sigil_err_t err;
+    unsigned char *tmp,
+                  *row,
+                  *prev,
+                  left,
+                  up_left;
+    size_t produced;
+
+    tmp = r->prev_row;
+    r->prev_row = r->row;
+    r->row = tmp;
+
+    err = decode_raw(r, r->row, r->row_size, &produced);
+    if (err != ERR_NONE)
+        return err;
+    if (produced < r->row_size)
+        return ERR_NO_DATA;
+
+    // data bytes start at index 1, after the filter type
+    row = r->row;
+    prev = r->prev_row;
+
+    for (size_t i = 1; i < r->row_size; i++) {
+        left = (i > r->bpp) ? row[i - r->bpp] : 0;
+        up_left = (i > r->bpp) ? prev[i - r->bpp] : 0;
+
+        switch (row[0]) {
+            case PNG_FILTER_NONE:
+                break;
+            case PNG_FILTER_SUB:
+                row[i] += left;
+                break;
+            case PNG_FILTER_UP:
+                row[i] += prev[i];
+                break;
+            case PNG_FILTER_AVERAGE:
+                row[i] += (unsigned char)((left + prev[i]) / 2);
+                break;
+            case PNG_FILTER_PAETH:
+                row[i] += paeth(left, prev[i], up_left);
+                break;
+            default:
+                return ERR_PDF_CONTENT;
+        }
+    }
+
+    r->row_pos = 1;
+
+    return ERR_NONE;
+}
+
+sigil_err_t stream_read(stream_reader_t *reader, unsigned char *out, size_t size,
+                        size_t *read_size)
+{
+    sigil_err_t err;
+    size_t chunk;
+
+    if (reader == NULL || out == NULL || read_size == NULL)
+        return ERR_PARAMETER;
+
+    *read_size = 0;
+
+    if (reader->row == NULL)
+        return decode_raw(reader, out, size, read_size);
+
+    while (*read_size < size) {
+        if (reader->row_pos >= reader->row_size) {
+            err = next_row(reader);
+            if (err == ERR_NO_DATA)
+                break;
+            if (err != ERR_NONE)
+                return err;
+        }
+
+        chunk = MIN(size - *read_size, reader->row_size - reader->row_pos);
+        memcpy(out + *read_size, reader->row + reader->row_pos, chunk);
+        reader->row_pos += chunk;
+        *read_size += chunk;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Applies the PNG filter on one row, reverse of the decoding
+ *
+ */
+static void test_png_filter(int type, const unsigned char *row,
+                            const unsigned char *prev, size_t bpp, size_t len,
+                            unsigned char *out)
+{
+    unsigned char left,
+                  up_left;
+
+    out[0] = (unsigned char)type;
+
+    for (size_t i = 0; i < len; i++) {
+        left = (i >= bpp) ? row[i - bpp] : 0;
+        up_left = (i >= bpp) ? prev[i - bpp] : 0;
+
+        switch (type) {
+            case PNG_FILTER_SUB:
+                out[i + 1] = row[i] - left;
+                break;
+            case PNG_FILTER_UP:
+                out[i + 1] = row[i] - prev[i];
+                break;
+            case PNG_FILTER_AVERAGE:
+                out[i + 1] = row[i] - (unsigned char)((left + prev[i]) / 2);
+                break;
+            case PNG_FILTER_PAETH:
+                out[i + 1] = row[i] - paeth(left, prev[i], up_left);
+                break;
+            default:
+                out[i + 1] = row[i];
+                break;
+        }
+    }
+}
+
+/** @brief Reads the stream dictionary from the current position, up to the
+ *         beginning of the data
+ *
+ */
+static sigil_err_t test_parse_stream_dict(sigil_t *sgl, stream_info_t *info)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Filter,      0, 0 },
+        { DICT_KEY_DecodeParms, 0, 0 },
+        { DICT_KEY_Length,      0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+
+    stream_info_init(info);
+
+    if ((err = skip_word(sgl, "<<")) != ERR_NONE)
+        return err;
+    if ((err = parse_dict_projection(sgl, entries, count)) != ERR_NONE)
+        return err;
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Filter) == ERR_NONE &&
+        (err = parse_stream_filter(sgl, info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_DecodeParms) == ERR_NONE &&
+        (err = parse_stream_decode_parms(sgl, info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Length)) != ERR_NONE)
+        return err;
+    if ((err = parse_stream_length(sgl, info)) != ERR_NONE)
+        return err;
+
+    if ((err = pdf_move_pos_abs(sgl, 2)) != ERR_NONE)
+        return err;
+    if ((err = skip_dictionary(sgl)) != ERR_NONE)
+        return err;
+
+    return locate_stream_data(sgl, info);
+}
+
+int sigil_stream_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    stream_reader_t *reader = NULL;
+    char *pdf = NULL;
+
+    print_module_name("stream", verbosity);
+
+    // TEST: stream without filter
+    print_test_item("stream without filter", verbosity);
+
+    {
+        stream_info_t info;
+        unsigned char out[16];
+        size_t read_size;
+
+        char *sstream = "<</Length 10/Other [1 2]>>\n" \
+                        "stream\r\n"                   \
+                        "0123456789\n"                 \
+                        "endstream";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (test_parse_stream_dict(sgl, &info) != ERR_NONE ||
+            info.filter != STREAM_FILTER_NONE || info.length != 10 ||
+            stream_reader_open(sgl, &info, &reader) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        if (stream_read(reader, out, 4, &read_size) != ERR_NONE || read_size != 4 ||
+            stream_read(reader, out + 4, 16, &read_size) != ERR_NONE || read_size != 6 ||
+            memcmp(out, "0123456789", 10) != 0)
+        {
+            goto failed;
+        }
+
+        stream_reader_free(&reader);
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: FlateDecode with PNG predictors
+    print_test_item("FlateDecode with PNG predictors", verbosity);
+
+    {
+        const size_t columns = 7,
+                     bpp = 1,
+                     rows = 10;
+        unsigned char data[10 * 7],
+                      filtered[10 * (7 + 1)],
+                      zero[7] = { 0 },
+                      compressed[256],
+                      out[10 * 7];
+        uLongf compressed_len = sizeof(compressed);
+        stream_info_t info;
+        size_t pdf_len,
+               read_size,
+               total = 0;
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = (unsigned char)((i * 37 + i / 5) & 0xff);
+        }
+
+        // every row with a different filter type
+        for (size_t r = 0; r < rows; r++) {
+            test_png_filter((int)(r % 5), data + r * columns,
+                            r > 0 ? data + (r - 1) * columns : zero, bpp, columns,
+                            filtered + r * (columns + 1));
+        }
+
+        if (compress(compressed, &compressed_len, filtered, sizeof(filtered)) != Z_OK)
+            goto failed;
+
+        pdf = malloc(256 + compressed_len);
+        if (pdf == NULL)
+            goto failed;
+
+        pdf_len = (size_t)sprintf(pdf, "<</DecodeParms<</Columns %zd/Predictor 12>>"
+                                  "/Filter/FlateDecode/Length %lu>>\nstream\n",
+                                  columns, (unsigned long)compressed_len);
+        memcpy(pdf + pdf_len, compressed, compressed_len);
+        pdf_len += compressed_len;
+        pdf_len += (size_t)sprintf(pdf + pdf_len, "\nendstream");
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, pdf_len + 1)) == NULL)
+            goto failed;
+
+        if (test_parse_stream_dict(sgl, &info) != ERR_NONE ||
+            info.filter != STREAM_FILTER_FLATE || info.predictor != 12 ||
+            info.columns != columns ||
+            stream_reader_open(sgl, &info, &reader) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        // odd chunks crossing the row boundaries
+        while (total < sizeof(out)) {
+            if (stream_read(reader, out + total, MIN(3, sizeof(out) - total),
+                            &read_size) != ERR_NONE || read_size == 0)
+            {
+                goto failed;
+            }
+            total += read_size;
+        }
+
+        if (memcmp(out, data, sizeof(data)) != 0 ||
+            stream_read(reader, out, 1, &read_size) != ERR_NONE || read_size != 0)
+        {
+            goto failed;
+        }
+
+        stream_reader_free(&reader);
+        sigil_free(&sgl);
+        free(pdf);
+        pdf = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    stream_reader_free(&reader);
+    if (sgl)
+        sigil_free(&sgl);
+    free(pdf);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -0,0 +1,513 @@
+#include <openssl/cms.h>
+#include <openssl/evp.h>
+#include <openssl/ts.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "cms.h"
+#include "config.h"
+#include "constants.h"
+#include "cryptography.h"
+#include "sigil.h"
+#include "timestamp.h"
+
+#ifdef _WIN32
+    #define TSA_CACHE_UNLOCKED
+#else
+    #include <pthread.h>
+#endif
+
+#define TSA_CHAIN_ID_SIZE 32
+
+/** @brief One verified chain of the timestamping authority, identified by the
+ *         digest of the certificates from the token. It is reused until the
+ *         first certificate of the chain expires and only while its trust
+ *         anchor is trusted by the verifying context
+ *
+ */
+typedef struct {
+    unsigned char  chain_id[TSA_CHAIN_ID_SIZE];
+    unsigned char  anchor_id[TSA_CHAIN_ID_SIZE];
+    X509_NAME     *anchor_name;
+    ASN1_TIME     *not_after;
+} tsa_cache_entry_t;
+
+/** @brief Verified chains shared by all the contexts of the process, the
+ *         oldest entry is replaced when full
+ *
+ */
+static tsa_cache_entry_t tsa_cache[TSA_CACHE_SIZE];
+static size_t tsa_cache_count = 0;
+static size_t tsa_cache_next = 0;
+
+#ifndef TSA_CACHE_UNLOCKED
+    static pthread_mutex_t tsa_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void tsa_cache_acquire(void)
+{
+    #ifndef TSA_CACHE_UNLOCKED
+        pthread_mutex_lock(&tsa_cache_lock);
+    #endif
+}
+
+static void tsa_cache_release(void)
+{
+    #ifndef TSA_CACHE_UNLOCKED
+        pthread_mutex_unlock(&tsa_cache_lock);
+    #endif
+}
+
+static void tsa_cache_entry_free(tsa_cache_entry_t *entry)
+{
+    X509_NAME_free(entry->anchor_name);
+    ASN1_TIME_free(entry->not_after);
+
+    sigil_zeroize(entry, sizeof(*entry));
+}
+
+void timestamp_cache_clear(void)
+{
+    tsa_cache_acquire();
+
+    for (size_t i = 0; i < tsa_cache_count; i++) {
+        tsa_cache_entry_free(&(tsa_cache[i]));
+    }
+
+    tsa_cache_count = 0;
+    tsa_cache_next = 0;
+
+    tsa_cache_release();
+}
+
+/** @brief Finds the unexpired chain in the cache
+ *
+ * @param chain_id identifier of the chain
+ * @param anchor_name output - allocated copy of the subject of the anchor
+ * @param anchor_id output - digest of the anchor
+ * @return 1 if found, 0 otherwise
+ */
+static int tsa_cache_lookup(const unsigned char *chain_id, X509_NAME **anchor_name,
+                            unsigned char *anchor_id)
+{
+    int found = 0;
+
+    tsa_cache_acquire();
+
+    for (size_t i = 0; i < tsa_cache_count; i++) {
+        if (memcmp(tsa_cache[i].chain_id, chain_id, TSA_CHAIN_ID_SIZE) != 0)
+            continue;
+
+        if (X509_cmp_time(tsa_cache[i].not_after, NULL) > 0) {
+            *anchor_name = X509_NAME_dup(tsa_cache[i].anchor_name);
+            memcpy(anchor_id, tsa_cache[i].anchor_id, TSA_CHAIN_ID_SIZE);
+            found = (*anchor_name != NULL);
+        }
+        break;
+    }
+
+    tsa_cache_release();
+
+    return found;
+}
+
+/** @brief Stores the verified chain to the cache, the same chain is replaced
+ *
+ * @param chain_id identifier of the chain
+ * @param chain the verified chain ending with the trust anchor
+ */
+static void tsa_cache_store(const unsigned char *chain_id, STACK_OF(X509) *chain)
+{
+    tsa_cache_entry_t entry,
+                     *slot = NULL;
+    const ASN1_TIME *not_after;
+    X509 *anchor;
+
+    sigil_zeroize(&entry, sizeof(entry));
+    memcpy(entry.chain_id, chain_id, TSA_CHAIN_ID_SIZE);
+
+    anchor = sk_X509_value(chain, sk_X509_num(chain) - 1);
+    if (anchor == NULL ||
+        X509_digest(anchor, EVP_sha256(), entry.anchor_id, NULL) != 1 ||
+        (entry.anchor_name = X509_NAME_dup(X509_get_subject_name(anchor))) == NULL)
+    {
+        tsa_cache_entry_free(&entry);
+        return;
+    }
+
+    // the whole chain is valid until its first certificate expires
+    for (int i = 0; i < sk_X509_num(chain); i++) {
+        not_after = X509_get0_notAfter(sk_X509_value(chain, i));
+        if (i == 0 || ASN1_TIME_compare(not_after, entry.not_after) < 0) {
+            ASN1_TIME_free(entry.not_after);
+            entry.not_after = ASN1_STRING_dup(not_after);
+            if (entry.not_after == NULL) {
+                tsa_cache_entry_free(&entry);
+                return;
+            }
+        }
+    }
+
+    tsa_cache_acquire();
+
+    for (size_t i = 0; i < tsa_cache_count; i++) {
+        if (memcmp(tsa_cache[i].chain_id, chain_id, TSA_CHAIN_ID_SIZE) == 0) {
+            slot = &(tsa_cache[i]);
+            break;
+        }
+    }
+
+    if (slot == NULL) {
+        if (tsa_cache_count < TSA_CACHE_SIZE) {
+            slot = &(tsa_cache[tsa_cache_count++]);
+        } else {
+            slot = &(tsa_cache[tsa_cache_next]);
+            tsa_cache_next = (tsa_cache_next + 1) % TSA_CACHE_SIZE;
+        }
+    }
+
+    tsa_cache_entry_free(slot);
+    *slot = entry;
+
+    tsa_cache_release();
+}
+
+/** @brief Computes the identifier of the chain - digest over the digests of
+ *         the TSA certificate and all the certificates of the token
+ *
+ * @return 1 if success, 0 otherwise
+ */
+static int compute_chain_id(X509 *tsa_cert, STACK_OF(X509) *certs, unsigned char *chain_id)
+{
+    EVP_MD_CTX *ctx;
+    unsigned char cert_id[TSA_CHAIN_ID_SIZE];
+    int ok;
+
+    ctx = EVP_MD_CTX_new();
+    if (ctx == NULL)
+        return 0;
+
+    ok = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+         X509_digest(tsa_cert, EVP_sha256(), cert_id, NULL) == 1 &&
+         EVP_DigestUpdate(ctx, cert_id, TSA_CHAIN_ID_SIZE) == 1;
+
+    for (int i = 0; ok && i < sk_X509_num(certs); i++) {
+        ok = X509_digest(sk_X509_value(certs, i), EVP_sha256(), cert_id, NULL) == 1 &&
+             EVP_DigestUpdate(ctx, cert_id, TSA_CHAIN_ID_SIZE) == 1;
+    }
+
+    ok = ok && EVP_DigestFinal_ex(ctx, chain_id, NULL) == 1;
+
+    EVP_MD_CTX_free(ctx);
+
+    return ok;
+}
+
+/** @brief Decides whether the cached trust anchor is trusted by the store
+ *
+ * @return 1 if trusted, 0 otherwise
+ */
+static int anchor_trusted(X509_STORE *store, const X509_NAME *anchor_name,
+                          const unsigned char *anchor_id)
+{
+    X509_STORE_CTX *ctx;
+    X509_OBJECT *obj = NULL;
+    unsigned char cert_id[TSA_CHAIN_ID_SIZE];
+    int trusted = 0;
+
+    ctx = X509_STORE_CTX_new();
+    if (ctx == NULL)
+        return 0;
+
+    if (X509_STORE_CTX_init(ctx, store, NULL, NULL) == 1)
+        obj = X509_STORE_CTX_get_obj_by_subject(ctx, X509_LU_X509, anchor_name);
+
+    if (obj != NULL &&
+        X509_digest(X509_OBJECT_get0_X509(obj), EVP_sha256(), cert_id, NULL) == 1 &&
+        memcmp(cert_id, anchor_id, TSA_CHAIN_ID_SIZE) == 0)
+    {
+        trusted = 1;
+    }
+
+    X509_OBJECT_free(obj);
+    X509_STORE_CTX_free(ctx);
+
+    return trusted;
+}
+
+/** @brief Verifies the chain of the timestamping authority for the purpose of
+ *         timestamping, the cached result is used for the already seen chain
+ *
+ * @return 1 if verified, 0 otherwise
+ */
+static int verify_tsa_chain(X509_STORE *store, X509 *tsa_cert, STACK_OF(X509) *certs)
+{
+    X509_STORE_CTX *ctx;
+    X509_NAME *anchor_name = NULL;
+    unsigned char chain_id[TSA_CHAIN_ID_SIZE],
+                  anchor_id[TSA_CHAIN_ID_SIZE];
+    int verified;
+
+    if (store == NULL || compute_chain_id(tsa_cert, certs, chain_id) != 1)
+        return 0;
+
+    if (tsa_cache_lookup(chain_id, &anchor_name, anchor_id)) {
+        verified = anchor_trusted(store, anchor_name, anchor_id);
+        X509_NAME_free(anchor_name);
+
+        if (verified)
+            return 1;
+    }
+
+    ctx = X509_STORE_CTX_new();
+    if (ctx == NULL)
+        return 0;
+
+    verified = X509_STORE_CTX_init(ctx, store, tsa_cert, certs) == 1 &&
+               X509_STORE_CTX_set_purpose(ctx, X509_PURPOSE_TIMESTAMP_SIGN) == 1 &&
+               X509_verify_cert(ctx) == 1;
+
+    if (verified)
+        tsa_cache_store(chain_id, X509_STORE_CTX_get0_chain(ctx));
+
+    X509_STORE_CTX_free(ctx);
+
+    return verified;
+}
+
+/** @brief Compares the message imprint of the token with the digest of the
+ *         signature value, the value is short and it is hashed at once
+ *
+ * @return 1 if the imprint matches, 0 otherwise
+ */
+static int imprint_matches(const signature_t *signature, TS_TST_INFO *tst_info)
+{
+    TS_MSG_IMPRINT *imprint;
+    ASN1_OCTET_STRING *value,
+                      *message;
+    const ASN1_OBJECT *md_obj = NULL;
+    const EVP_MD *evp_md;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len;
+
+    imprint = TS_TST_INFO_get_msg_imprint(tst_info);
+    message = TS_MSG_IMPRINT_get_msg(imprint);
+    value = CMS_SignerInfo_get0_signature(signature->signer_info);
+    if (message == NULL || value == NULL)
+        return 0;
+
+    X509_ALGOR_get0(&md_obj, NULL, NULL, TS_MSG_IMPRINT_get_algo(imprint));
+    if ((evp_md = EVP_get_digestbyobj(md_obj)) == NULL)
+        return 0;
+
+    if (EVP_Digest(ASN1_STRING_get0_data(value), (size_t)ASN1_STRING_length(value),
+                   digest, &digest_len, evp_md, NULL) != 1)
+    {
+        return 0;
+    }
+
+    return (int)digest_len == ASN1_STRING_length(message) &&
+           memcmp(digest, ASN1_STRING_get0_data(message), digest_len) == 0;
+}
+
+/** @brief Converts the genTime of the token to the time in seconds since
+ *         the epoch
+ *
+ * @return 1 if success, 0 otherwise
+ */
+static int gen_time_to_time(const ASN1_GENERALIZEDTIME *gen_time, time_t *time)
+{
+    ASN1_TIME *epoch;
+    int days,
+        seconds,
+        ok;
+
+    epoch = ASN1_TIME_set(NULL, 0);
+    if (epoch == NULL)
+        return 0;
+
+    ok = ASN1_TIME_diff(&days, &seconds, epoch, gen_time);
+    if (ok)
+        *time = (time_t)days * 86400 + seconds;
+
+    ASN1_TIME_free(epoch);
+
+    return ok;
+}
+
+sigil_err_t timestamp_verify_embedded(sigil_t *sgl, signature_t *signature)
+{
+    ASN1_STRING *value;
+    const unsigned char *const_data;
+    CMS_ContentInfo *token = NULL;
+    TS_TST_INFO *tst_info = NULL;
+    STACK_OF(X509) *signers = NULL,
+                   *certs = NULL;
+    X509 *tsa_cert;
+
+    if (sgl == NULL || signature == NULL || signature->signer_info == NULL)
+        return ERR_PARAMETER;
+
+    signature->result_timestamp = TIMESTAMP_STATUS_NONE;
+
+    value = CMS_unsigned_get0_data_by_OBJ(signature->signer_info,
+                                          OBJ_nid2obj(NID_id_smime_aa_timeStampToken),
+                                          -3, V_ASN1_SEQUENCE);
+    if (value == NULL)
+        return ERR_NONE;
+
+    signature->result_timestamp = TIMESTAMP_STATUS_FAILED;
+
+    const_data = ASN1_STRING_get0_data(value);
+    token = d2i_CMS_ContentInfo(NULL, &const_data, ASN1_STRING_length(value));
+    if (token == NULL)
+        goto end;
+
+    tst_info = cms_decode_tst_info(token);
+    if (tst_info == NULL || !imprint_matches(signature, tst_info))
+        goto end;
+
+    // the timestamp info is signed by the only signer of the token
+    if (CMS_verify(token, NULL, NULL, NULL, NULL,
+                   CMS_BINARY | CMS_NO_SIGNER_CERT_VERIFY) != 1)
+    {
+        goto end;
+    }
+
+    signers = CMS_get0_signers(token);
+    if (signers == NULL || sk_X509_num(signers) != 1)
+        goto end;
+
+    tsa_cert = sk_X509_value(signers, 0);
+    certs = CMS_get1_certs(token);
+
+    if (verify_tsa_chain(sgl->trusted_store, tsa_cert, certs) &&
+        gen_time_to_time(TS_TST_INFO_get_time(tst_info), &(signature->timestamp_time)))
+    {
+        signature->result_timestamp = TIMESTAMP_STATUS_VERIFIED;
+    }
+
+end:
+    sk_X509_pop_free(certs, X509_free);
+    sk_X509_free(signers);
+    TS_TST_INFO_free(tst_info);
+    CMS_ContentInfo_free(token);
+
+    return ERR_NONE;
+}
+
+/** @brief Prepares the context for the whole verification of the document
+ *
+ */
+static sigil_t *test_prepare_sgl(const char *path, int trusted)
+{
+    sigil_t *sgl = NULL;
+
+    if (sigil_init(&sgl) != ERR_NONE ||
+        sigil_set_pdf_path(sgl, path) != ERR_NONE ||
+        (trusted && sigil_set_trusted_file(sgl, "test/test_ca.pem") != ERR_NONE) ||
+        sigil_verify(sgl) != ERR_NONE ||
+        sgl->signature_count != 1)
+    {
+        sigil_free(&sgl);
+        return NULL;
+    }
+
+    return sgl;
+}
+
+int sigil_timestamp_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    signature_t *signature;
+
+    print_module_name("timestamp", verbosity);
+
+    timestamp_cache_clear();
+
+    // TEST: the token over the signature value with the trusted TSA
+    print_test_item("fn timestamp_verify_embedded", verbosity);
+
+    sgl = test_prepare_sgl("test/subtype_adbe.pkcs7.detached_sigts.pdf", 1);
+    if (sgl == NULL)
+        goto failed;
+
+    signature = &(sgl->signatures[0]);
+    if (signature->result_timestamp != TIMESTAMP_STATUS_VERIFIED ||
+        signature->result_cert_verification != CERT_STATUS_VERIFIED ||
+        signature->timestamp_time < 1700000000 ||
+        signature->timestamp_time > time(NULL))
+    {
+        goto failed;
+    }
+
+    // the time of the certificate verification is the genTime
+    signature->timestamp_time = 0;
+    if (verify_signing_certificate(sgl, signature) != ERR_NONE ||
+        signature->result_cert_verification != CERT_STATUS_FAILED)
+    {
+        goto failed;
+    }
+
+    sigil_free(&sgl);
+
+    // the imprint of another signature value
+    sgl = test_prepare_sgl("test/modified_sigts.pdf", 1);
+    if (sgl == NULL || sgl->signatures[0].result_timestamp != TIMESTAMP_STATUS_FAILED)
+        goto failed;
+
+    sigil_free(&sgl);
+
+    // no token at all
+    sgl = test_prepare_sgl("test/subtype_adbe.pkcs7.detached.pdf", 1);
+    if (sgl == NULL || sgl->signatures[0].result_timestamp != TIMESTAMP_STATUS_NONE)
+        goto failed;
+
+    sigil_free(&sgl);
+
+    print_test_result(1, verbosity);
+
+    // TEST: the verified chain is reused by the other documents
+    print_test_item("TSA chain cache", verbosity);
+
+    if (tsa_cache_count != 1)
+        goto failed;
+
+    sgl = test_prepare_sgl("test/subtype_adbe.pkcs7.detached_sigts.pdf", 1);
+    if (sgl == NULL || tsa_cache_count != 1 ||
+        sgl->signatures[0].result_timestamp != TIMESTAMP_STATUS_VERIFIED)
+    {
+        goto failed;
+    }
+
+    sigil_free(&sgl);
+
+    // the cached chain is not used without its anchor trusted
+    sgl = test_prepare_sgl("test/subtype_adbe.pkcs7.detached_sigts.pdf", 0);
+    if (sgl == NULL || sgl->signatures[0].result_timestamp != TIMESTAMP_STATUS_FAILED)
+        goto failed;
+
+    sigil_free(&sgl);
+
+    timestamp_cache_clear();
+
+    if (tsa_cache_count != 0)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    sigil_free(&sgl);
+    timestamp_cache_clear();
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -6,7 +6,13 @@
 sigil_err_t process_trailer(sigil_t *sgl)
 {
     sigil_err_t err;
-    dict_key_t dict_key;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Size, 0, 0 },
+        { DICT_KEY_Prev, 0, 0 },
+        { DICT_KEY_Root, 0, 0 },
+        { DICT_KEY_XRefStm, 0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
 
     if (sgl == NULL)
         return ERR_PARAMETER;
@@ -19,47 +25,53 @@ sigil_err_t process_trailer(sigil_t *sgl)
     if (err != ERR_NONE)
         return err;
 
-    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-        switch (dict_key) {
-            case DICT_KEY_Size:
-                if (sgl->xref->size_from_trailer > 0) {
-                    err = skip_dict_unknown_value(sgl);
-                } else {
-                    err = parse_number(sgl, &(sgl->xref->size_from_trailer));
-                }
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_Prev:
-                err = parse_number(sgl, &(sgl->xref->prev_section));
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_Root:
-                if (sgl->ref_catalog_dict.object_num > 0 ||
-                    sgl->ref_catalog_dict.generation_num > 0)
-                {
-                    err = skip_dict_unknown_value(sgl);
-                } else {
-                    err = parse_indirect_reference(sgl, &(sgl->ref_catalog_dict));
-                }
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_UNKNOWN:
-                err = skip_dict_unknown_value(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            default:
-                return ERR_PDF_CONTENT;
-        }
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    return process_trailer_entries(sgl, entries, count);
+}
+
+sigil_err_t process_trailer_entries(sigil_t *sgl, dict_entry_t *entries,
+                                    size_t count)
+{
+    sigil_err_t err;
+
+    if (sgl == NULL || sgl->xref == NULL || entries == NULL)
+        return ERR_PARAMETER;
+
+    // values from the newest trailer are used, the previous ones are ignored
+    if (sgl->xref->size_from_trailer <= 0 &&
+        dict_projection_goto(sgl, entries, count, DICT_KEY_Size) == ERR_NONE)
+    {
+        err = parse_number(sgl, &(sgl->xref->size_from_trailer));
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Prev) == ERR_NONE) {
+        err = parse_number(sgl, &(sgl->xref->prev_section));
+        if (err != ERR_NONE)
+            return err;
     }
 
-    if (err == ERR_END_OF_DICT)
-        return ERR_NONE;
+    // the cross-reference stream of the hybrid-reference file
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_XRefStm) == ERR_NONE) {
+        err = parse_number(sgl, &(sgl->xref->stream_section));
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    if (sgl->ref_catalog_dict.object_num <= 0 &&
+        sgl->ref_catalog_dict.generation_num <= 0 &&
+        dict_projection_goto(sgl, entries, count, DICT_KEY_Root) == ERR_NONE)
+    {
+        err = parse_indirect_reference(sgl, &(sgl->ref_catalog_dict));
+        if (err != ERR_NONE)
+            return err;
+    }
 
-    return err;
+    return ERR_NONE;
 }
 
 int sigil_trailer_self_test(int verbosity)
@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "workers.h"
+
+#ifdef _WIN32
+    #define WORKERS_SERIAL
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+/** @brief Shared state of one workers_run call, the tasks are handed out one
+ *         by one to the first free thread
+ *
+ */
+typedef struct {
+    worker_fn_t fn;
+    char       *tasks;
+    size_t      task_size;
+    size_t      task_count;
+    size_t      next_task;
+    #ifndef WORKERS_SERIAL
+        pthread_mutex_t lock;
+    #endif
+} workers_batch_t;
+
+size_t workers_default_count(void)
+{
+    #ifdef WORKERS_SERIAL
+        return 1;
+    #else
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+        if (count < 1)
+            return 1;
+
+        return MIN((size_t)count, MAX_THREAD_COUNT);
+    #endif
+}
+
+#ifndef WORKERS_SERIAL
+static void *worker_loop(void *arg)
+{
+    workers_batch_t *batch = arg;
+    size_t task;
+
+    while (1) {
+        pthread_mutex_lock(&(batch->lock));
+        task = batch->next_task++;
+        pthread_mutex_unlock(&(batch->lock));
+
+        if (task >= batch->task_count)
+            return NULL;
+
+        batch->fn(batch->tasks + task * batch->task_size);
+    }
+}
+#endif /* WORKERS_SERIAL */
+
+sigil_err_t workers_run(size_t thread_count, worker_fn_t fn, void *tasks,
+                        size_t task_size, size_t task_count)
+{
+    workers_batch_t batch;
+
+    if (fn == NULL || (tasks == NULL && task_count > 0) || task_size == 0)
+        return ERR_PARAMETER;
+
+    batch.fn = fn;
+    batch.tasks = tasks;
+    batch.task_size = task_size;
+    batch.task_count = task_count;
+    batch.next_task = 0;
+
+    thread_count = MIN(MIN(thread_count, task_count), MAX_THREAD_COUNT);
+
+    #ifdef WORKERS_SERIAL
+        for (size_t i = 0; i < task_count; i++) {
+            fn(batch.tasks + i * task_size);
+        }
+    #else
+        pthread_t threads[MAX_THREAD_COUNT];
+        size_t started = 0;
+
+        if (pthread_mutex_init(&(batch.lock), NULL) != 0)
+            return ERR_ALLOCATION;
+
+        // the calling thread is one of the workers, the rest is started here,
+        // if some of them fails to start, the others do its work
+        for (size_t i = 1; i < thread_count; i++) {
+            if (pthread_create(&(threads[started]), NULL, worker_loop, &batch) != 0)
+                break;
+            started++;
+        }
+
+        worker_loop(&batch);
+
+        for (size_t i = 0; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        pthread_mutex_destroy(&(batch.lock));
+    #endif
+
+    return ERR_NONE;
+}
+
+static void test_square_task(void *task)
+{
+    size_t *value = task;
+
+    *value = *value * *value;
+}
+
+int sigil_workers_self_test(int verbosity)
+{
+    print_module_name("workers", verbosity);
+
+    // TEST: fn workers_default_count
+    print_test_item("fn workers_default_count", verbosity);
+
+    if (workers_default_count() < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn workers_run
+    print_test_item("fn workers_run", verbosity);
+
+    {
+        size_t values[100];
+
+        for (size_t threads = 1; threads <= 4; threads++) {
+            for (size_t i = 0; i < 100; i++) {
+                values[i] = i;
+            }
+
+            if (workers_run(threads, test_square_task, values, sizeof(*values),
+                            100) != ERR_NONE)
+            {
+                goto failed;
+            }
+
+            for (size_t i = 0; i < 100; i++) {
+                if (values[i] != i * i)
+                    goto failed;
+            }
+        }
+
+        if (workers_run(4, test_square_task, NULL, sizeof(*values), 0) != ERR_NONE)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
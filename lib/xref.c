@@ -1,12 +1,49 @@
 #include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
 #include <types.h>
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
+#include "revision.h"
 #include "sigil.h"
+#include "stream.h"
+#include "trailer.h"
+#include "workers.h"
 #include "xref.h"
 
+/** @brief Destination of the decoded records - either the table itself, or an
+ *         array of the decoded entries, merged into the table later
+ *
+ */
+typedef struct {
+    xref_t       *xref;
+    xref_extra_t *decoded;
+    size_t        decoded_count;
+} xref_sink_t;
+
+/** @brief One cross-reference section for the parallel decoding
+ *
+ */
+typedef struct {
+    const sigil_t *sgl;
+    xref_t        *xref;
+    xref_sink_t    sink;
+    sigil_err_t    err;
+} xref_section_task_t;
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XREF_DECODE_SSE2
+#endif
+
+#define XREF_STREAM_FIELDS      3
+#define XREF_STREAM_FIELD_MAX   8
+#define XREF_TYPE_NAME_MAX      10
+// the smallest object - "1 0" pair in the object stream and the value
+#define XREF_OBJECT_SIZE_MIN    4
+
 // Determine whether this file is using Cross-reference table or stream
 static sigil_err_t determine_xref_type(sigil_t *sgl)
 {
@@ -30,72 +67,573 @@ static sigil_err_t determine_xref_type(sigil_t *sgl)
     return ERR_NONE;
 }
 
-static sigil_err_t
-add_xref_entry(xref_t *xref, size_t obj, size_t offset, size_t generation)
+/** @brief Generation number of the object from the entry, the compressed
+ *         objects have always 0 and the field holds their index in the object
+ *         stream instead
+ *
+ */
+static size_t entry_generation(xref_entry_t entry)
+{
+    if (XREF_ENTRY_TYPE(entry) == XREF_ENTRY_COMPRESSED)
+        return 0;
+
+    return XREF_ENTRY_GENERATION(entry);
+}
+
+/** @brief Number of the directly indexed objects, neither the size from the
+ *         trailer nor the number of objects fitting into the data is exceeded
+ *
+ * @return the limit, 0 if there is none
+ */
+static size_t dense_limit(const xref_t *xref)
+{
+    if (xref->size_from_trailer == 0)
+        return xref->object_limit;
+    if (xref->object_limit == 0)
+        return xref->size_from_trailer;
+
+    return MIN(xref->size_from_trailer, xref->object_limit);
+}
+
+sigil_err_t xref_reserve(xref_t *xref, size_t count)
 {
-    int resize_factor = 1;
+    xref_entry_t *entry;
+    size_t capacity,
+           limit;
 
     if (xref == NULL)
         return ERR_PARAMETER;
 
-    // resize if needed
-    while (obj > resize_factor * xref->capacity - 1) {
-        resize_factor *= 2;
+    limit = dense_limit(xref);
+    if (limit > 0)
+        count = MIN(count, limit);
+
+    if (count <= xref->capacity)
+        return ERR_NONE;
+
+    capacity = MAX(xref->capacity, 1);
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    if (limit > 0)
+        capacity = MIN(capacity, limit);
+
+    entry = realloc(xref->entry, sizeof(xref_entry_t) * capacity);
+    if (entry == NULL)
+        return ERR_ALLOCATION;
+
+    memset(entry + xref->capacity, 0,
+           sizeof(xref_entry_t) * (capacity - xref->capacity));
+
+    xref->entry = entry;
+    xref->capacity = capacity;
+
+    return ERR_NONE;
+}
+
+static sigil_err_t
+add_xref_extra(xref_t *xref, size_t obj, xref_entry_t packed)
+{
+    xref_extra_t *extra;
+    size_t capacity;
+
+    for (size_t i = 0; i < xref->extra_count; i++) {
+        if (xref->extra[i].object_num == obj &&
+            entry_generation(xref->extra[i].entry) == entry_generation(packed))
+        {
+            return ERR_NONE;
+        }
     }
 
-    if (resize_factor != 1) {
-        xref->entry = realloc(xref->entry, sizeof(xref_entry_t *) * xref->capacity * resize_factor);
-        if (xref->entry == NULL)
+    if (xref->extra_count >= xref->extra_capacity) {
+        capacity = MAX(xref->extra_capacity * 2, XREF_EXTRA_PREALLOCATION);
+
+        extra = realloc(xref->extra, sizeof(xref_extra_t) * capacity);
+        if (extra == NULL)
             return ERR_ALLOCATION;
-        sigil_zeroize(xref->entry + xref->capacity, sizeof(xref_entry_t *) * (xref->capacity * (resize_factor - 1)));
-        xref->capacity *= resize_factor;
+
+        xref->extra = extra;
+        xref->extra_capacity = capacity;
+    }
+
+    xref->extra[xref->extra_count].object_num = obj;
+    xref->extra[xref->extra_count].entry = packed;
+    xref->extra_count++;
+
+    return ERR_NONE;
+}
+
+sigil_err_t xref_add_entry(xref_t *xref, size_t obj, int type, size_t offset,
+                           size_t generation)
+{
+    sigil_err_t err;
+    xref_entry_t current,
+                 packed;
+    size_t limit;
+
+    if (xref == NULL || type == XREF_ENTRY_EMPTY)
+        return ERR_PARAMETER;
+
+    if (offset > XREF_ENTRY_OFFSET_MAX || generation > XREF_ENTRY_GENERATION_MAX)
+        return ERR_PDF_CONTENT;
+
+    packed = XREF_ENTRY_PACK(type, offset, generation);
+    limit = dense_limit(xref);
+
+    if (obj >= xref->capacity && limit > 0 && obj >= limit) {
+        // not a number of any object the data or the trailer could declare
+        if (xref->object_limit > 0 && obj >= xref->object_limit &&
+            obj >= xref->size_from_trailer)
+        {
+            return ERR_PDF_CONTENT;
+        }
+
+        return add_xref_extra(xref, obj, packed);
     }
 
-    xref_entry_t **xref_entry = &(xref->entry[obj]);
+    err = xref_reserve(xref, obj + 1);
+    if (err != ERR_NONE)
+        return err;
+
+    current = xref->entry[obj];
+
+    if (XREF_ENTRY_TYPE(current) == XREF_ENTRY_EMPTY) {
+        xref->entry[obj] = packed;
+        return ERR_NONE;
+    }
+
+    if (entry_generation(current) == entry_generation(packed))
+        return ERR_NONE;
+
+    return add_xref_extra(xref, obj, packed);
+}
+
+sigil_err_t xref_lookup(const xref_t *xref, const reference_t *ref,
+                        xref_entry_t *result)
+{
+    xref_entry_t entry;
+
+    if (xref == NULL || ref == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    // the objects above the directly indexed ones are all kept aside
+    if (ref->object_num < xref->capacity) {
+        entry = xref->entry[ref->object_num];
+        if (XREF_ENTRY_TYPE(entry) == XREF_ENTRY_EMPTY)
+            return ERR_NO_DATA;
 
-    while (*xref_entry != NULL) {
-        if ((*xref_entry)->generation_num == generation)
+        if (entry_generation(entry) == ref->generation_num) {
+            *result = entry;
             return ERR_NONE;
+        }
+    }
 
-        xref_entry = &(*xref_entry)->next;
+    for (size_t i = 0; i < xref->extra_count; i++) {
+        if (xref->extra[i].object_num == ref->object_num &&
+            entry_generation(xref->extra[i].entry) == ref->generation_num)
+        {
+            *result = xref->extra[i].entry;
+            return ERR_NONE;
+        }
     }
 
-    *xref_entry = malloc(sizeof(xref_entry_t));
-    if (*xref_entry == NULL)
-        return ERR_ALLOCATION;
-    sigil_zeroize(*xref_entry, sizeof(xref_entry_t));
+    return ERR_NO_DATA;
+}
+
+static sigil_err_t
+add_xref_subsection(xref_t *xref, size_t first, size_t count, size_t offset)
+{
+    xref_subsection_t *subsection;
+    size_t capacity;
+
+    if (xref->subsection_count >= xref->subsection_capacity) {
+        capacity = MAX(xref->subsection_capacity * 2, XREF_SUBSECTION_PREALLOCATION);
+
+        subsection = realloc(xref->subsection, sizeof(xref_subsection_t) * capacity);
+        if (subsection == NULL)
+            return ERR_ALLOCATION;
+
+        xref->subsection = subsection;
+        xref->subsection_capacity = capacity;
+    }
+
+    xref->subsection[xref->subsection_count].first_object = first;
+    xref->subsection[xref->subsection_count].count = count;
+    xref->subsection[xref->subsection_count].offset = offset;
+    xref->subsection_count++;
+
+    return ERR_NONE;
+}
+
+static size_t decode_digits_10(const char *p)
+{
+    size_t high = (size_t)(p[0] - '0') * 10000 + (size_t)(p[1] - '0') * 1000 +
+                  (size_t)(p[2] - '0') * 100 + (size_t)(p[3] - '0') * 10 +
+                  (size_t)(p[4] - '0');
+    size_t low = (size_t)(p[5] - '0') * 10000 + (size_t)(p[6] - '0') * 1000 +
+                 (size_t)(p[7] - '0') * 100 + (size_t)(p[8] - '0') * 10 +
+                 (size_t)(p[9] - '0');
+
+    return high * 100000 + low;
+}
+
+static size_t decode_digits_5(const char *p)
+{
+    return (size_t)(p[0] - '0') * 10000 + (size_t)(p[1] - '0') * 1000 +
+           (size_t)(p[2] - '0') * 100 + (size_t)(p[3] - '0') * 10 +
+           (size_t)(p[4] - '0');
+}
+
+/** @brief Decodes one 20-byte record "nnnnnnnnnn ggggg n<EOL>" of the
+ *         cross-reference table
+ *
+ * @param record the record data
+ * @param offset output - byte offset of the object
+ * @param generation output - generation number of the object
+ * @param type output - 'n' for objects in use, 'f' for free ones
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the record is malformed
+ */
+static sigil_err_t parse_xref_record(const char *record, size_t *offset,
+                                     size_t *generation, char *type)
+{
+    for (int i = 0; i < 16; i++) {
+        if (i != 10 && !is_digit(record[i]))
+            return ERR_PDF_CONTENT;
+    }
+
+    if (record[10] != ' ' || record[16] != ' ' ||
+        (record[17] != 'n' && record[17] != 'f') ||
+        !is_whitespace(record[18]) || !is_whitespace(record[19]))
+    {
+        return ERR_PDF_CONTENT;
+    }
+
+    *offset = decode_digits_10(record);
+    *generation = decode_digits_5(record + 11);
+    *type = record[17];
+
+    return ERR_NONE;
+}
+
+#ifdef XREF_DECODE_SSE2
+/** @brief Validates the layout of 4 consecutive records (80 bytes, 5 vectors)
+ *         at once, the character classes repeat every 20 bytes, so every vector
+ *         has its own mask of the positions for digits, spaces, the entry type
+ *         and the end of line
+ *
+ * @param data 4 records
+ * @param in_use output - bit i set if the record i is in use
+ * @return 1 if all 4 records are well-formed, 0 otherwise
+ */
+static int validate_xref_records_4(const char *data, unsigned int *in_use)
+{
+    static const unsigned int digit_mask[5] = { 0xfbff, 0xbff0, 0xff0f, 0xf0fb, 0x0fbf };
+    static const unsigned int space_mask[5] = { 0x0400, 0x4001, 0x0010, 0x0104, 0x1040 };
+    static const unsigned int type_mask[5]  = { 0x0000, 0x0002, 0x0020, 0x0200, 0x2000 };
+    static const unsigned int eol_mask[5]   = { 0x0000, 0x000c, 0x00c0, 0x0c00, 0xc000 };
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    __m128i block,
+            digits;
+    unsigned int digit,
+                 space,
+                 eol,
+                 used,
+                 type;
+
+    *in_use = 0;
+
+    for (int i = 0; i < 5; i++) {
+        block = _mm_loadu_si128((const __m128i *)(data + 16 * i));
+
+        // unsigned (c - '0') <= 9 only for the digits
+        digits = _mm_sub_epi8(block, zero);
+        digit = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_min_epu8(digits, nine), digits));
+        space = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+        eol = space | (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')),
+            _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+        used = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(block, _mm_set1_epi8('n')));
+        type = used | (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(block, _mm_set1_epi8('f')));
+
+        if ((digit & digit_mask[i]) != digit_mask[i] ||
+            (space & space_mask[i]) != space_mask[i] ||
+            (eol & eol_mask[i]) != eol_mask[i] ||
+            (type & type_mask[i]) != type_mask[i])
+        {
+            return 0;
+        }
+
+        // the type of the record (i - 1) is at the bit 4 * (i - 1) + 1
+        if (i > 0 && (used & type_mask[i]) != 0)
+            *in_use |= 1u << (i - 1);
+    }
+
+    return 1;
+}
+#endif /* XREF_DECODE_SSE2 */
+
+static sigil_err_t sink_xref_entry(xref_sink_t *sink, size_t obj, size_t offset,
+                                   size_t generation)
+{
+    if (sink->decoded == NULL)
+        return xref_add_entry(sink->xref, obj, XREF_ENTRY_IN_USE, offset, generation);
+
+    if (offset > XREF_ENTRY_OFFSET_MAX || generation > XREF_ENTRY_GENERATION_MAX)
+        return ERR_PDF_CONTENT;
+
+    sink->decoded[sink->decoded_count].object_num = obj;
+    sink->decoded[sink->decoded_count].entry =
+        XREF_ENTRY_PACK(XREF_ENTRY_IN_USE, offset, generation);
+    sink->decoded_count++;
+
+    return ERR_NONE;
+}
+
+/** @brief Decodes the consecutive records of one subsection
+ *
+ * @param sink destination of the entries in use
+ * @param first object number of the first record
+ * @param data the records
+ * @param count number of the records
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if some record is malformed
+ */
+static sigil_err_t decode_xref_records(xref_sink_t *sink, size_t first,
+                                       const char *data, size_t count)
+{
+    sigil_err_t err;
+    const char *record;
+    size_t i = 0,
+           offset,
+           generation;
+    char type;
+
+    #ifdef XREF_DECODE_SSE2
+        unsigned int in_use;
+
+        for (; i + 4 <= count; i += 4) {
+            if (!validate_xref_records_4(data + XREF_RECORD_SIZE * i, &in_use))
+                return ERR_PDF_CONTENT;
+
+            for (size_t j = 0; j < 4; j++) {
+                if ((in_use & (1u << j)) == 0)
+                    continue;
+
+                record = data + XREF_RECORD_SIZE * (i + j);
+
+                err = sink_xref_entry(sink, first + i + j, decode_digits_10(record),
+                                      decode_digits_5(record + 11));
+                if (err != ERR_NONE)
+                    return err;
+            }
+        }
+    #endif
+
+    for (; i < count; i++) {
+        record = data + XREF_RECORD_SIZE * i;
 
-    (*xref_entry)->byte_offset = offset;
-    (*xref_entry)->generation_num = generation;
+        err = parse_xref_record(record, &offset, &generation, &type);
+        if (err != ERR_NONE)
+            return err;
+
+        if (type != 'n')
+            continue;
+
+        err = sink_xref_entry(sink, first + i, offset, generation);
+        if (err != ERR_NONE)
+            return err;
+    }
 
     return ERR_NONE;
 }
 
-static void free_xref_entry(xref_entry_t *entry)
+/** @brief Decodes the whole subsection directly from the buffer, does not
+ *         change the position, so it can run in parallel
+ *
+ * @param sgl context with the buffered PDF data
+ * @param subsection the subsection to be decoded
+ * @param sink destination of the entries in use
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if some record is malformed
+ */
+static sigil_err_t decode_xref_subsection(const sigil_t *sgl,
+                                          const xref_subsection_t *subsection,
+                                          xref_sink_t *sink)
+{
+    size_t available;
+
+    if (sgl->pdf_data.buffer == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->offset_pdf_start + subsection->offset > sgl->pdf_data.size)
+        return ERR_PDF_CONTENT;
+
+    available = sgl->pdf_data.size - sgl->offset_pdf_start - subsection->offset;
+    if (available / XREF_RECORD_SIZE < subsection->count)
+        return ERR_PDF_CONTENT;
+
+    return decode_xref_records(sink, subsection->first_object, sgl->pdf_data.buffer +
+                               sgl->offset_pdf_start + subsection->offset,
+                               subsection->count);
+}
+
+/** @brief Decodes the whole subsection of fixed-size records starting at the
+ *         provided position, leaves the position right after the last record
+ *
+ * @param sgl context
+ * @param first object number of the first record
+ * @param count number of the records
+ * @param position position of the first record
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if some record is malformed
+ */
+static sigil_err_t read_xref_subsection(sigil_t *sgl, size_t first, size_t count,
+                                        size_t position)
+{
+    sigil_err_t err;
+    xref_sink_t sink = { sgl->xref, NULL, 0 };
+    xref_subsection_t subsection = { first, count, position };
+    char *chunk;
+    size_t chunk_count,
+           read_size,
+           available = 0;
+
+    // the records have to be present before the table is sized by them
+    if (sgl->offset_pdf_start + position < sgl->pdf_data.size)
+        available = sgl->pdf_data.size - sgl->offset_pdf_start - position;
+    if (available / XREF_RECORD_SIZE < count || first > SIZE_MAX - count)
+        return ERR_PDF_CONTENT;
+
+    err = xref_reserve(sgl->xref, first + count);
+    if (err != ERR_NONE)
+        return err;
+
+    if (sgl->pdf_data.buffer != NULL) {
+        err = decode_xref_subsection(sgl, &subsection, &sink);
+        if (err != ERR_NONE)
+            return err;
+
+        return pdf_move_pos_abs(sgl, position + XREF_RECORD_SIZE * count);
+    }
+
+    err = pdf_move_pos_abs(sgl, position);
+    if (err != ERR_NONE)
+        return err;
+
+    chunk = malloc(XREF_RECORD_SIZE * XREF_DECODE_CHUNK + 1);
+    if (chunk == NULL)
+        return ERR_ALLOCATION;
+
+    while (count > 0) {
+        chunk_count = MIN(count, XREF_DECODE_CHUNK);
+
+        err = pdf_read(sgl, XREF_RECORD_SIZE * chunk_count, chunk, &read_size);
+        if (err == ERR_NONE && read_size != XREF_RECORD_SIZE * chunk_count)
+            err = ERR_PDF_CONTENT;
+        if (err != ERR_NONE)
+            break;
+
+        err = decode_xref_records(&sink, first, chunk, chunk_count);
+        if (err != ERR_NONE)
+            break;
+
+        first += chunk_count;
+        count -= chunk_count;
+    }
+
+    free(chunk);
+
+    return err;
+}
+
+static sigil_err_t read_xref_record(sigil_t *sgl, size_t position,
+                                    size_t *offset, size_t *generation, char *type)
+{
+    sigil_err_t err;
+    char record[XREF_RECORD_SIZE + 1];
+    size_t read_size;
+
+    err = pdf_move_pos_abs(sgl, position);
+    if (err != ERR_NONE)
+        return err;
+
+    err = pdf_read(sgl, XREF_RECORD_SIZE, record, &read_size);
+    if (err != ERR_NONE)
+        return err;
+    if (read_size != XREF_RECORD_SIZE)
+        return ERR_PDF_CONTENT;
+
+    return parse_xref_record(record, offset, generation, type);
+}
+
+/** @brief Decodes the entry from the lazily read subsections
+ *
+ * @param sgl context
+ * @param ref reference to the object
+ * @param result output - the packed entry
+ * @return ERR_NONE if success, ERR_NO_DATA if the object is not present
+ */
+static sigil_err_t find_in_subsections(sigil_t *sgl, const reference_t *ref,
+                                       xref_entry_t *result)
 {
-    if (entry != NULL) {
-        free_xref_entry(entry->next);
-        sigil_zeroize(entry, sizeof(*entry));
-        free(entry);
+    sigil_err_t err;
+    xref_subsection_t *subsection;
+    size_t original_position,
+           offset,
+           generation;
+    char type;
+
+    err = get_curr_position(sgl, &original_position);
+    if (err != ERR_NONE)
+        return err;
+
+    // subsections are stored from the newest one, the first match is valid
+    err = ERR_NO_DATA;
+    for (size_t i = 0; i < sgl->xref->subsection_count; i++) {
+        subsection = &(sgl->xref->subsection[i]);
+
+        if (ref->object_num < subsection->first_object ||
+            ref->object_num - subsection->first_object >= subsection->count)
+        {
+            continue;
+        }
+
+        err = read_xref_record(sgl, subsection->offset + XREF_RECORD_SIZE *
+                               (ref->object_num - subsection->first_object),
+                               &offset, &generation, &type);
+        if (err != ERR_NONE)
+            break;
+
+        err = ERR_NO_DATA;
+        if (type == 'n' && generation == ref->generation_num) {
+            *result = XREF_ENTRY_PACK(XREF_ENTRY_IN_USE, offset, generation);
+            err = ERR_NONE;
+            break;
+        }
     }
+
+    if (pdf_move_pos_abs(sgl, original_position) != ERR_NONE)
+        return ERR_IO;
+
+    return err;
 }
 
-xref_t *xref_init(void)
+xref_t *xref_init(size_t data_size)
 {
     xref_t *xref = malloc(sizeof(xref_t));
     if (xref == NULL)
         return NULL;
     sigil_zeroize(xref, sizeof(*xref));
 
-    xref->entry = malloc(sizeof(xref_entry_t *) * XREF_PREALLOCATION);
-    if (xref->entry == NULL) {
+    if (data_size > 0)
+        xref->object_limit = MAX(data_size / XREF_OBJECT_SIZE_MIN, 1);
+
+    if (xref_reserve(xref, XREF_PREALLOCATION) != ERR_NONE) {
         free(xref);
         return NULL;
     }
-    sigil_zeroize(xref->entry, sizeof(*(xref->entry)) * XREF_PREALLOCATION);
-    xref->capacity = XREF_PREALLOCATION;
-    xref->size_from_trailer = 0;
-    xref->prev_section = 0;
 
     return xref;
 }
@@ -105,14 +643,9 @@ void xref_free(xref_t *xref)
     if (xref == NULL)
         return;
 
-    if (xref->entry != NULL) {
-        for (size_t i = 0; i < xref->capacity; i++) {
-            free_xref_entry(xref->entry[i]);
-        }
-        free(xref->entry);
-    }
-
-    sigil_zeroize(xref, sizeof(*xref));
+    free(xref->entry);
+    free(xref->extra);
+    free(xref->subsection);
     free(xref);
 }
 
@@ -159,7 +692,8 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
     size_t section_start = 0,
            section_cnt = 0,
            obj_offset,
-           obj_generation;
+           obj_generation,
+           position;
     int xref_end = 0;
     sigil_err_t err;
 
@@ -167,7 +701,7 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
         return ERR_PARAMETER;
 
     if (sgl->xref == NULL) {
-        sgl->xref = xref_init();
+        sgl->xref = xref_init(sgl->pdf_data.size);
         if (sgl->xref == NULL)
             return ERR_ALLOCATION;
     }
@@ -189,6 +723,22 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
             if (section_start < 0 || section_cnt < 1)
                 return 1;
 
+            if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+                return err;
+            if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+                return err;
+
+            // fixed-size records decoded at once
+            err = read_xref_subsection(sgl, section_start, section_cnt, position);
+            if (err == ERR_NONE)
+                continue;
+            if (err != ERR_PDF_CONTENT)
+                return err;
+
+            // not a well-formed subsection, read it entry by entry
+            if ((err = pdf_move_pos_abs(sgl, position)) != ERR_NONE)
+                return err;
+
             // for all entries in one section
             for (size_t section_offset = 0; section_offset < section_cnt; section_offset++) {
                 err = parse_number(sgl, &obj_offset);
@@ -207,7 +757,8 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
 
                 size_t obj_num = section_start + section_offset;
 
-                err = add_xref_entry(sgl->xref, obj_num, obj_offset, obj_generation);
+                err = xref_add_entry(sgl->xref, obj_num, XREF_ENTRY_IN_USE,
+                                     obj_offset, obj_generation);
                 if (err != ERR_NONE)
                     return err;
             }
@@ -217,46 +768,1051 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
     return ERR_NONE;
 }
 
-sigil_err_t process_xref(sigil_t *sgl)
+/** @brief Records only the position of each subsection of the cross-reference
+ *         table, the entries are decoded on demand by xref_find. The fixed
+ *         record size is checked on the first and the last record, and by
+ *         finding the next subsection or the trailer right after the last one
+ *
+ * @param sgl context
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the table does not follow
+ *         the fixed record layout
+ */
+static sigil_err_t read_xref_table_lazy(sigil_t *sgl)
 {
     sigil_err_t err;
+    size_t section_start,
+           section_cnt,
+           position,
+           offset,
+           generation;
+    char c;
 
-    if (sgl == NULL)
-        return ERR_PARAMETER;
-
-    err = determine_xref_type(sgl);
-    if (err != ERR_NONE)
+    if ((err = skip_word(sgl, "xref")) != ERR_NONE)
         return err;
 
-    switch (sgl->xref_type) {
-        case XREF_TYPE_TABLE:
-            read_xref_table(sgl);
-            break;
-        case XREF_TYPE_STREAM:
-            return ERR_NOT_IMPLEMENTED;
-        default:
+    while (1) {
+        if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+            return err;
+
+        if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+            return err;
+        if (c == 't')
+            return ERR_NONE;
+
+        if (parse_number(sgl, &section_start) != ERR_NONE ||
+            parse_number(sgl, &section_cnt) != ERR_NONE ||
+            section_cnt < 1)
+        {
+            return ERR_PDF_CONTENT;
+        }
+
+        if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+            return err;
+        if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+            return err;
+
+        err = read_xref_record(sgl, position, &offset, &generation, &c);
+        if (err != ERR_NONE)
+            return ERR_PDF_CONTENT;
+
+        err = read_xref_record(sgl, position + XREF_RECORD_SIZE * (section_cnt - 1),
+                               &offset, &generation, &c);
+        if (err != ERR_NONE)
+            return ERR_PDF_CONTENT;
+
+        err = add_xref_subsection(sgl->xref, section_start, section_cnt, position);
+        if (err != ERR_NONE)
+            return err;
+    }
+}
+
+/** @brief Decodes all the lazily recorded subsections into the table, used
+ *         when some older section has to be read entry by entry, so the newer
+ *         entries keep their priority
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t materialize_xref(sigil_t *sgl)
+{
+    sigil_err_t err;
+    xref_subsection_t *subsection;
+
+    for (size_t i = 0; i < sgl->xref->subsection_count; i++) {
+        subsection = &(sgl->xref->subsection[i]);
+
+        err = read_xref_subsection(sgl, subsection->first_object,
+                                   subsection->count, subsection->offset);
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    sgl->xref->subsection_count = 0;
+    sgl->xref->materialized = 1;
+
+    return ERR_NONE;
+}
+
+/** @brief Parses the /Index array of the cross-reference stream - pairs of the
+ *         first object number and the number of entries
+ *
+ * @param sgl context
+ * @param index output - allocated array of the subsections
+ * @param index_count output - number of the subsections
+ * @return ERR_NONE if success
+ */
+static sigil_err_t parse_xref_stream_index(sigil_t *sgl, xref_subsection_t **index,
+                                           size_t *index_count)
+{
+    sigil_err_t err;
+    xref_subsection_t *tmp;
+    size_t capacity = 0;
+    char c;
+
+    if ((err = skip_word(sgl, "[")) != ERR_NONE)
+        return err;
+
+    while (1) {
+        if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+            return err;
+        if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+            return err;
+
+        if (c == ']')
+            return pdf_move_pos_rel(sgl, 1);
+
+        if (*index_count >= capacity) {
+            capacity = MAX(capacity * 2, XREF_SUBSECTION_PREALLOCATION);
+
+            tmp = realloc(*index, sizeof(xref_subsection_t) * capacity);
+            if (tmp == NULL)
+                return ERR_ALLOCATION;
+            *index = tmp;
+        }
+
+        tmp = &((*index)[*index_count]);
+        tmp->offset = 0;
+
+        if ((err = parse_number(sgl, &(tmp->first_object))) != ERR_NONE)
+            return err;
+        if ((err = parse_number(sgl, &(tmp->count))) != ERR_NONE)
+            return err;
+
+        (*index_count)++;
+    }
+}
+
+/** @brief Decodes the entries of one subsection of the cross-reference stream
+ *
+ * @param sgl context
+ * @param reader reader of the decoded stream data
+ * @param subsection first object and the number of entries
+ * @param widths widths of the entry fields in bytes
+ * @param chunk buffer for the decoded data
+ * @param chunk_entries capacity of the buffer in entries
+ * @return ERR_NONE if success
+ */
+static sigil_err_t decode_xref_stream_entries(sigil_t *sgl, stream_reader_t *reader,
+                                              const xref_subsection_t *subsection,
+                                              const size_t *widths,
+                                              unsigned char *chunk,
+                                              size_t chunk_entries)
+{
+    sigil_err_t err;
+    const unsigned char *entry;
+    const size_t entry_size = widths[0] + widths[1] + widths[2];
+    size_t remaining = subsection->count,
+           obj = subsection->first_object,
+           fields[XREF_STREAM_FIELDS],
+           entries,
+           read_size;
+
+    err = xref_reserve(sgl->xref, MIN(subsection->first_object + subsection->count,
+                                      sgl->pdf_data.size));
+    if (err != ERR_NONE)
+        return err;
+
+    while (remaining > 0) {
+        entries = MIN(remaining, chunk_entries);
+
+        err = stream_read(reader, chunk, entries * entry_size, &read_size);
+        if (err != ERR_NONE)
+            return err;
+        if (read_size != entries * entry_size)
+            return ERR_PDF_CONTENT;
+
+        entry = chunk;
+        for (size_t i = 0; i < entries; i++) {
+            // big-endian fields, the type defaults to 1 if its width is 0
+            for (size_t f = 0; f < XREF_STREAM_FIELDS; f++) {
+                fields[f] = 0;
+                for (size_t b = 0; b < widths[f]; b++) {
+                    fields[f] = (fields[f] << 8) | *entry++;
+                }
+            }
+            if (widths[0] == 0)
+                fields[0] = 1;
+
+            switch (fields[0]) {
+                case 1:
+                    err = xref_add_entry(sgl->xref, obj, XREF_ENTRY_IN_USE,
+                                         fields[1], fields[2]);
+                    break;
+                case 2:
+                    err = xref_add_entry(sgl->xref, obj, XREF_ENTRY_COMPRESSED,
+                                         fields[1], fields[2]);
+                    break;
+                default: // free and unknown entries
+                    err = ERR_NONE;
+                    break;
+            }
+            if (err != ERR_NONE)
+                return err;
+
+            obj++;
+        }
+
+        remaining -= entries;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Reads the cross-reference stream - the stream object with its
+ *         dictionary serving also as the trailer. The data are decoded
+ *         in chunks directly into the table
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_xref_stream(sigil_t *sgl)
+{
+    sigil_err_t err;
+    dict_entry_t entries[] = {
+        { DICT_KEY_Size,        0, 0 },
+        { DICT_KEY_Prev,        0, 0 },
+        { DICT_KEY_Root,        0, 0 },
+        { DICT_KEY_Type,        0, 0 },
+        { DICT_KEY_W,           0, 0 },
+        { DICT_KEY_Index,       0, 0 },
+        { DICT_KEY_Filter,      0, 0 },
+        { DICT_KEY_DecodeParms, 0, 0 },
+        { DICT_KEY_Length,      0, 0 },
+    };
+    const size_t count = sizeof(entries) / sizeof(*entries);
+    stream_info_t info;
+    stream_reader_t *reader = NULL;
+    xref_subsection_t *index = NULL;
+    unsigned char *chunk = NULL;
+    size_t index_count = 0,
+           widths[XREF_STREAM_FIELDS],
+           width_count,
+           entry_size,
+           chunk_entries,
+           dict_position,
+           size,
+           tmp;
+    char type[XREF_TYPE_NAME_MAX];
+
+    stream_info_init(&info);
+
+    // object header "<num> <gen> obj"
+    if ((err = parse_number(sgl, &tmp)) != ERR_NONE ||
+        (err = parse_number(sgl, &tmp)) != ERR_NONE ||
+        (err = skip_word(sgl, "obj")) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if ((err = get_curr_position(sgl, &dict_position)) != ERR_NONE)
+        return err;
+
+    err = parse_dict_projection(sgl, entries, count);
+    if (err != ERR_NONE)
+        return err;
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Type)) != ERR_NONE ||
+        (err = parse_name(sgl, type, XREF_TYPE_NAME_MAX)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+    if (strcmp(type, "XRef") != 0)
+        return ERR_PDF_CONTENT;
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Size)) != ERR_NONE ||
+        (err = parse_number(sgl, &size)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_W)) != ERR_NONE ||
+        (err = parse_number_array(sgl, widths, XREF_STREAM_FIELDS, &width_count)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+    if (width_count != XREF_STREAM_FIELDS)
+        return ERR_PDF_CONTENT;
+
+    entry_size = 0;
+    for (size_t i = 0; i < XREF_STREAM_FIELDS; i++) {
+        if (widths[i] > XREF_STREAM_FIELD_MAX)
+            return ERR_PDF_CONTENT;
+        entry_size += widths[i];
+    }
+    if (entry_size == 0)
+        return ERR_PDF_CONTENT;
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Filter) == ERR_NONE &&
+        (err = parse_stream_filter(sgl, &info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_DecodeParms) == ERR_NONE &&
+        (err = parse_stream_decode_parms(sgl, &info)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if ((err = dict_projection_goto(sgl, entries, count, DICT_KEY_Length)) != ERR_NONE ||
+        (err = parse_stream_length(sgl, &info)) != ERR_NONE)
+    {
+        return (err == ERR_NO_DATA) ? ERR_PDF_CONTENT : err;
+    }
+
+    // the stream dictionary is the trailer as well
+    if ((err = process_trailer_entries(sgl, entries, count)) != ERR_NONE)
+        return err;
+
+    if (dict_projection_goto(sgl, entries, count, DICT_KEY_Index) == ERR_NONE) {
+        err = parse_xref_stream_index(sgl, &index, &index_count);
+    } else {
+        index = malloc(sizeof(xref_subsection_t));
+        if (index == NULL)
+            return ERR_ALLOCATION;
+
+        index->first_object = 0;
+        index->count = size;
+        index->offset = 0;
+        index_count = 1;
+    }
+    if (err != ERR_NONE)
+        goto end;
+
+    // the data follow the end of the dictionary
+    if ((err = pdf_move_pos_abs(sgl, dict_position)) != ERR_NONE ||
+        (err = skip_dictionary(sgl)) != ERR_NONE ||
+        (err = locate_stream_data(sgl, &info)) != ERR_NONE)
+    {
+        goto end;
+    }
+
+    // the lazily read newer tables have priority over the decoded entries
+    if (sgl->xref->subsection_count > 0 && (err = materialize_xref(sgl)) != ERR_NONE)
+        goto end;
+
+    if ((err = stream_reader_open(sgl, &info, &reader)) != ERR_NONE)
+        goto end;
+
+    chunk_entries = MAX(1, STREAM_CHUNK_SIZE / entry_size);
+    chunk = malloc(chunk_entries * entry_size);
+    if (chunk == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    for (size_t i = 0; i < index_count; i++) {
+        err = decode_xref_stream_entries(sgl, reader, &(index[i]), widths, chunk,
+                                         chunk_entries);
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    // the end of the revision follows the data
+    err = pdf_move_pos_abs(sgl, info.data_offset + info.length);
+
+end:
+    stream_reader_free(&reader);
+    free(chunk);
+    free(index);
+
+    return err;
+}
+
+sigil_err_t process_xref(sigil_t *sgl)
+{
+    sigil_err_t err;
+    size_t section_position,
+           subsection_count;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->xref == NULL) {
+        sgl->xref = xref_init(sgl->pdf_data.size);
+        if (sgl->xref == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    err = determine_xref_type(sgl);
+    if (err != ERR_NONE)
+        return err;
+
+    switch (sgl->xref_type) {
+        case XREF_TYPE_TABLE:
+            if (sgl->xref_mode == XREF_MODE_LAZY && !sgl->xref->materialized) {
+                err = get_curr_position(sgl, &section_position);
+                if (err != ERR_NONE)
+                    return err;
+
+                subsection_count = sgl->xref->subsection_count;
+
+                err = read_xref_table_lazy(sgl);
+                if (err == ERR_NONE)
+                    break;
+                if (err != ERR_PDF_CONTENT)
+                    return err;
+
+                // not a well-formed table, read it entry by entry
+                sgl->xref->subsection_count = subsection_count;
+
+                err = materialize_xref(sgl);
+                if (err != ERR_NONE)
+                    return err;
+
+                err = pdf_move_pos_abs(sgl, section_position);
+                if (err != ERR_NONE)
+                    return err;
+            }
+
+            return read_xref_table(sgl);
+        case XREF_TYPE_STREAM:
+            return read_xref_stream(sgl);
+        default:
+            return ERR_PDF_CONTENT;
+    }
+
+    return ERR_NONE;
+}
+
+static void decode_xref_section_task(void *arg)
+{
+    xref_section_task_t *task = arg;
+
+    task->err = ERR_NONE;
+
+    for (size_t i = 0; i < task->xref->subsection_count; i++) {
+        task->err = decode_xref_subsection(task->sgl, &(task->xref->subsection[i]),
+                                           &(task->sink));
+        if (task->err != ERR_NONE)
+            return;
+    }
+}
+
+/** @brief Reads one section for the parallel processing - only the positions
+ *         of its subsections and the trailer, the section is read entry by
+ *         entry only if it does not follow the fixed record layout
+ *
+ * @param sgl context
+ * @param task output - the section
+ * @return ERR_NONE if success
+ */
+static sigil_err_t prepare_xref_section_task(sigil_t *sgl, xref_section_task_t *task)
+{
+    sigil_err_t err;
+    size_t section_position,
+           trailer_position,
+           records = 0;
+
+    err = get_curr_position(sgl, &section_position);
+    if (err != ERR_NONE)
+        return err;
+
+    err = determine_xref_type(sgl);
+    if (err != ERR_NONE)
+        return err;
+
+    // the stream has to be inflated, it is decoded right away
+    if (sgl->xref_type == XREF_TYPE_STREAM) {
+        err = read_xref_stream(sgl);
+        if (err != ERR_NONE)
+            return err;
+
+        return revision_add(sgl, section_position, section_position);
+    }
+
+    err = read_xref_table_lazy(sgl);
+    if (err == ERR_PDF_CONTENT) {
+        sgl->xref->subsection_count = 0;
+
+        err = pdf_move_pos_abs(sgl, section_position);
+        if (err != ERR_NONE)
+            return err;
+
+        err = read_xref_table(sgl);
+    }
+    if (err != ERR_NONE)
+        return err;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE ||
+        (err = get_curr_position(sgl, &trailer_position)) != ERR_NONE ||
+        (err = process_trailer(sgl)) != ERR_NONE ||
+        (err = revision_add(sgl, section_position, trailer_position)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    for (size_t i = 0; i < sgl->xref->subsection_count; i++) {
+        records += sgl->xref->subsection[i].count;
+    }
+
+    if (records > 0) {
+        task->sink.decoded = malloc(sizeof(xref_extra_t) * records);
+        if (task->sink.decoded == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    return ERR_NONE;
+}
+
+static sigil_err_t merge_xref_entry(xref_t *xref, size_t obj, xref_entry_t entry)
+{
+    if (XREF_ENTRY_TYPE(entry) == XREF_ENTRY_EMPTY)
+        return ERR_NONE;
+
+    return xref_add_entry(xref, obj, XREF_ENTRY_TYPE(entry),
+                          XREF_ENTRY_OFFSET(entry), XREF_ENTRY_GENERATION(entry));
+}
+
+/** @brief Walks the chain of sections reading only the trailers and the
+ *         positions of the subsections, then decodes all the sections in
+ *         parallel and merges them from the newest one
+ *
+ * @param sgl context with the buffered PDF data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t process_xref_chain_parallel(sigil_t *sgl)
+{
+    sigil_err_t err = ERR_NONE;
+    xref_t *xref = sgl->xref;
+    xref_section_task_t *tasks = NULL,
+                        *task,
+                        *tmp;
+    size_t task_count = 0,
+           task_capacity = 0,
+           prev_section = xref->prev_section;
+
+    while (prev_section > 0) {
+        // the cyclic chain is not followed again
+        if (revision_is_visited(sgl, prev_section)) {
+            err = ERR_PDF_CONTENT;
+            goto end;
+        }
+
+        if (task_count >= task_capacity) {
+            task_capacity = MAX(task_capacity * 2, XREF_SUBSECTION_PREALLOCATION);
+
+            tmp = realloc(tasks, sizeof(xref_section_task_t) * task_capacity);
+            if (tmp == NULL) {
+                err = ERR_ALLOCATION;
+                goto end;
+            }
+            tasks = tmp;
+        }
+
+        task = &(tasks[task_count]);
+        sigil_zeroize(task, sizeof(*task));
+        task->sgl = sgl;
+        task->xref = xref_init(sgl->pdf_data.size);
+        if (task->xref == NULL) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+        task->sink.xref = task->xref;
+        task_count++;
+
+        err = pdf_move_pos_abs(sgl, prev_section);
+        if (err != ERR_NONE)
+            goto end;
+
+        // the trailer and the entries read entry by entry go to the section
+        sgl->xref = task->xref;
+        err = prepare_xref_section_task(sgl, task);
+        sgl->xref = xref;
+        if (err != ERR_NONE)
+            goto end;
+
+        prev_section = task->xref->prev_section;
+    }
+
+    err = workers_run(sgl->thread_count, decode_xref_section_task, tasks,
+                      sizeof(xref_section_task_t), task_count);
+    if (err != ERR_NONE)
+        goto end;
+
+    if (task_count > 0) {
+        xref->size_from_trailer = tasks[0].xref->size_from_trailer;
+
+        err = xref_reserve(xref, MIN(xref->size_from_trailer, sgl->pdf_data.size));
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    // newest section first, the entries already present are kept
+    for (size_t i = 0; i < task_count; i++) {
+        task = &(tasks[i]);
+
+        if ((err = task->err) != ERR_NONE)
+            goto end;
+
+        for (size_t j = 0; j < task->xref->capacity; j++) {
+            if ((err = merge_xref_entry(xref, j, task->xref->entry[j])) != ERR_NONE)
+                goto end;
+        }
+
+        for (size_t j = 0; j < task->xref->extra_count; j++) {
+            err = merge_xref_entry(xref, task->xref->extra[j].object_num,
+                                   task->xref->extra[j].entry);
+            if (err != ERR_NONE)
+                goto end;
+        }
+
+        for (size_t j = 0; j < task->sink.decoded_count; j++) {
+            err = merge_xref_entry(xref, task->sink.decoded[j].object_num,
+                                   task->sink.decoded[j].entry);
+            if (err != ERR_NONE)
+                goto end;
+        }
+    }
+
+    xref->prev_section = 0;
+
+end:
+    for (size_t i = 0; i < task_count; i++) {
+        xref_free(tasks[i].xref);
+        free(tasks[i].sink.decoded);
+    }
+    free(tasks);
+
+    return err;
+}
+
+/** @brief Reads the cross-reference stream of the hybrid section, right after
+ *         its table, so its entries take precedence over the older sections
+ *         only - the /Prev of the table is kept
+ *
+ * @param sgl context
+ * @param offset position of the stream
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_hidden_xref_stream(sigil_t *sgl, size_t offset)
+{
+    sigil_err_t err;
+    size_t prev_section = sgl->xref->prev_section;
+
+    if ((err = pdf_move_pos_abs(sgl, offset)) != ERR_NONE ||
+        (err = determine_xref_type(sgl)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    if (sgl->xref_type != XREF_TYPE_STREAM)
+        return ERR_PDF_CONTENT;
+
+    err = read_xref_stream(sgl);
+
+    sgl->xref->prev_section = prev_section;
+    sgl->xref_type = XREF_TYPE_TABLE;
+
+    return err;
+}
+
+/** @brief Walks the chain of sections from the one set in the table, on the
+ *         calling thread
+ *
+ * @param sgl context
+ * @param hybrid whether the streams of the hybrid sections are merged
+ * @return ERR_NONE if success
+ */
+static sigil_err_t process_xref_chain_serial(sigil_t *sgl, int hybrid)
+{
+    sigil_err_t err;
+    size_t section_offset,
+           trailer_offset;
+
+    while (sgl->xref->prev_section > 0) {
+        section_offset = sgl->xref->prev_section;
+
+        // the cyclic chain is not followed again
+        if (revision_is_visited(sgl, section_offset))
             return ERR_PDF_CONTENT;
+
+        // go to the position of the beginning of next cross-reference section
+        err = pdf_move_pos_abs(sgl, section_offset);
+        if (err != ERR_NONE)
+            return err;
+
+        sgl->xref->prev_section = 0;
+        sgl->xref->stream_section = 0;
+
+        err = process_xref(sgl);
+        if (err != ERR_NONE)
+            return err;
+
+        // the cross-reference stream contains the trailer entries itself
+        trailer_offset = section_offset;
+        if (sgl->xref_type == XREF_TYPE_TABLE) {
+            if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE ||
+                (err = get_curr_position(sgl, &trailer_offset)) != ERR_NONE ||
+                (err = process_trailer(sgl)) != ERR_NONE)
+            {
+                return err;
+            }
+        }
+
+        err = revision_add(sgl, section_offset, trailer_offset);
+        if (err != ERR_NONE)
+            return err;
+
+        if (hybrid && sgl->xref->stream_section > 0) {
+            err = read_hidden_xref_stream(sgl, sgl->xref->stream_section);
+            if (err != ERR_NONE)
+                return err;
+        }
+
+        // presize the table from the newest trailer, so the older sections do
+        // not reallocate it, the value is not trusted beyond the data size
+        if (sgl->xref_mode == XREF_MODE_EAGER || sgl->xref->materialized) {
+            err = xref_reserve(sgl->xref, MIN(sgl->xref->size_from_trailer,
+                                              sgl->pdf_data.size));
+            if (err != ERR_NONE)
+                return err;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t process_xref_chain(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->xref != NULL)
+        xref_free(sgl->xref);
+    sgl->xref = xref_init(sgl->pdf_data.size);
+    if (sgl->xref == NULL)
+        return ERR_ALLOCATION;
+
+    sgl->xref->prev_section = sgl->offset_startxref;
+
+    revisions_clear(sgl);
+
+    if (sgl->thread_count > 1 && sgl->xref_mode == XREF_MODE_EAGER &&
+        sgl->pdf_data.buffer != NULL)
+    {
+        return process_xref_chain_parallel(sgl);
+    }
+
+    return process_xref_chain_serial(sgl, 0);
+}
+
+/** @brief Decides whether the chain contains any hybrid section, whose stream
+ *         was not merged yet
+ *
+ */
+static int has_unmerged_streams(const sigil_t *sgl)
+{
+    if (sgl->xref->hybrid_merged)
+        return 0;
+
+    for (size_t i = 0; i < sgl->revisions.count; i++) {
+        if (sgl->revisions.entry[i].xref_stream_offset > 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/** @brief Reads the whole chain again with the streams of the hybrid sections,
+ *         the original table is kept if it fails
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t merge_hybrid_streams(sigil_t *sgl)
+{
+    sigil_err_t err;
+    xref_t *classic = sgl->xref;
+    revision_list_t classic_revisions = sgl->revisions;
+    size_t original_position;
+
+    err = get_curr_position(sgl, &original_position);
+    if (err != ERR_NONE)
+        return err;
+
+    sigil_zeroize(&(sgl->revisions), sizeof(sgl->revisions));
+    sgl->xref = xref_init(sgl->pdf_data.size);
+    if (sgl->xref == NULL) {
+        err = ERR_ALLOCATION;
+    } else {
+        sgl->xref->prev_section = sgl->offset_startxref;
+        err = process_xref_chain_serial(sgl, 1);
+    }
+
+    if (err == ERR_NONE) {
+        xref_free(classic);
+        free(classic_revisions.entry);
+        number_set_clear(&(classic_revisions.visited));
+    } else {
+        xref_free(sgl->xref);
+        revisions_clear(sgl);
+        sgl->xref = classic;
+        sgl->revisions = classic_revisions;
+    }
+
+    // no more attempts, whatever the result
+    sgl->xref->hybrid_merged = 1;
+
+    if (pdf_move_pos_abs(sgl, original_position) != ERR_NONE)
+        return ERR_IO;
+
+    return err;
+}
+
+sigil_err_t xref_find(sigil_t *sgl, const reference_t *ref, xref_entry_t *result)
+{
+    sigil_err_t err;
+
+    if (sgl == NULL || sgl->xref == NULL || ref == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    err = xref_lookup(sgl->xref, ref, result);
+    if (err == ERR_NO_DATA && sgl->xref->subsection_count > 0)
+        err = find_in_subsections(sgl, ref, result);
+
+    // the object may be in the stream of the hybrid section
+    if (err == ERR_NO_DATA && has_unmerged_streams(sgl)) {
+        err = merge_hybrid_streams(sgl);
+        if (err != ERR_NONE)
+            return (err == ERR_ALLOCATION || err == ERR_IO) ? err : ERR_NO_DATA;
+
+        return xref_find(sgl, ref, result);
     }
 
-    return ERR_NONE;
+    return err;
 }
 
 void print_xref(xref_t *xref)
 {
-    xref_entry_t *xref_entry;
+    xref_entry_t entry;
+
     if (xref == NULL)
         return;
 
     printf("\nXREF\n");
     for (size_t i = 0; i < xref->capacity; i++) {
-        xref_entry = xref->entry[i];
+        entry = xref->entry[i];
+        if (XREF_ENTRY_TYPE(entry) == XREF_ENTRY_EMPTY)
+            continue;
+
+        printf("obj %zd (gen %zd) | offset %zd\n", i,
+               XREF_ENTRY_GENERATION(entry), XREF_ENTRY_OFFSET(entry));
+    }
+
+    for (size_t i = 0; i < xref->extra_count; i++) {
+        entry = xref->extra[i].entry;
+
+        printf("obj %zd (gen %zd) | offset %zd\n", xref->extra[i].object_num,
+               XREF_ENTRY_GENERATION(entry), XREF_ENTRY_OFFSET(entry));
+    }
+
+    for (size_t i = 0; i < xref->subsection_count; i++) {
+        printf("objs %zd-%zd | not decoded, records at offset %zd\n",
+               xref->subsection[i].first_object,
+               xref->subsection[i].first_object + xref->subsection[i].count - 1,
+               xref->subsection[i].offset);
+    }
+}
+
+static sigil_t *test_load_xref(const char *path, int mode, size_t threads)
+{
+    sigil_t *sgl = test_prepare_sgl_path(path);
+
+    if (sgl == NULL)
+        return NULL;
+
+    if (sigil_set_xref_mode(sgl, mode) != ERR_NONE ||
+        sigil_set_thread_count(sgl, threads) != ERR_NONE ||
+        read_startxref(sgl) != ERR_NONE ||
+        process_xref_chain(sgl) != ERR_NONE)
+    {
+        sigil_free(&sgl);
+        return NULL;
+    }
+
+    return sgl;
+}
+
+/** @brief Appends an incremental update with the cross-reference stream to the
+ *         test file - the catalog 12 (from the original file), the stream
+ *         itself 19 and the object 20 compressed in the stream 19 (index 3),
+ *         which is not an object stream
+ *
+ * @return the new PDF data or NULL, the size and the stream offset are set
+ */
+static char *test_append_xref_stream(const char *path, size_t catalog_offset,
+                                     size_t prev, size_t *size, size_t *offset)
+{
+    unsigned char rows[3][6] = { { 0 } },
+                  data[3 * 7],
+                  compressed[64];
+    uLongf compressed_len = sizeof(compressed);
+    FILE *file;
+    char *pdf = NULL;
+    size_t values[3][3];
+    long file_size;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0 ||
+        (pdf = malloc((size_t)file_size + 512)) == NULL ||
+        fread(pdf, 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+        fclose(file);
+        free(pdf);
+        return NULL;
+    }
+    fclose(file);
+
+    *offset = (size_t)file_size + 1;
 
-        while (xref_entry != NULL) {
-            printf("obj %zd (gen %zd) | offset %zd\n", i,
-                   xref_entry->generation_num, xref_entry->byte_offset);
-            xref_entry = xref_entry->next;
+    values[0][0] = 1; values[0][1] = catalog_offset; values[0][2] = 0;
+    values[1][0] = 1; values[1][1] = *offset;        values[1][2] = 0;
+    values[2][0] = 2; values[2][1] = 19;             values[2][2] = 3;
+
+    // W [1 4 1] with PNG Up predictor
+    for (int r = 0; r < 3; r++) {
+        rows[r][0] = (unsigned char)values[r][0];
+        for (int b = 0; b < 4; b++) {
+            rows[r][1 + b] = (unsigned char)(values[r][1] >> (8 * (3 - b)));
+        }
+        rows[r][5] = (unsigned char)values[r][2];
+
+        data[r * 7] = PNG_FILTER_UP;
+        for (int b = 0; b < 6; b++) {
+            data[r * 7 + 1 + b] = rows[r][b] - (r > 0 ? rows[r - 1][b] : 0);
+        }
+    }
+
+    if (compress(compressed, &compressed_len, data, sizeof(data)) != Z_OK) {
+        free(pdf);
+        return NULL;
+    }
+
+    *size = (size_t)file_size;
+    *size += (size_t)sprintf(pdf + *size, "\n19 0 obj\n<</Type/XRef/Size 21"
+                             "/W[1 4 1]/Index[12 1 19 2]/Root 12 0 R/Prev %zd"
+                             "/Filter/FlateDecode/DecodeParms<</Columns 6"
+                             "/Predictor 12>>/Length %lu>>\nstream\r\n",
+                             prev, (unsigned long)compressed_len);
+    memcpy(pdf + *size, compressed, compressed_len);
+    *size += compressed_len;
+    *size += (size_t)sprintf(pdf + *size, "\r\nendstream\nendobj\n"
+                             "startxref\n%zd\n%%%%EOF\n", *offset);
+
+    return pdf;
+}
+
+/** @brief Compares the offsets of all the objects from two contexts
+ *
+ * @return number of objects in use, -1 if the contexts differ
+ */
+/** @brief Appends the hybrid update to the test file - the classic table with
+ *         /XRefStm of the stream hiding the new object 20, and also objects 2
+ *         and 18 (the latter is in the table too)
+ *
+ * @return the PDF data or NULL
+ */
+static char *test_append_hybrid(const char *path, size_t *size, size_t *stream_offset,
+                                size_t *object_offset)
+{
+    const size_t objects[] = { 2, 18, 20 };
+    FILE *file;
+    char *pdf = NULL;
+    size_t table_offset;
+    long file_size;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0 ||
+        (pdf = malloc((size_t)file_size + 512)) == NULL ||
+        fread(pdf, 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+        fclose(file);
+        free(pdf);
+        return NULL;
+    }
+    fclose(file);
+
+    *size = (size_t)file_size;
+    *size += (size_t)sprintf(pdf + *size, "\n");
+
+    *object_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "20 0 obj\n(hidden)\nendobj\n");
+
+    // W [1 4 1] without any filter
+    *stream_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "21 0 obj\n<</Type/XRef/Size 22/W[1 4 1]"
+                             "/Index[2 1 18 1 20 1]/Length 18>>\nstream\n");
+    for (size_t i = 0; i < sizeof(objects) / sizeof(*objects); i++) {
+        pdf[(*size)++] = 1;
+        for (int b = 0; b < 4; b++) {
+            pdf[(*size)++] = (char)(*object_offset >> (8 * (3 - b)));
+        }
+        pdf[(*size)++] = 0;
+    }
+    *size += (size_t)sprintf(pdf + *size, "\nendstream\nendobj\n");
+
+    table_offset = *size;
+    *size += (size_t)sprintf(pdf + *size, "xref\n0 1\n0000000000 65535 f\r\n"
+                             "18 1\n0000058059 00000 n\r\n"
+                             "trailer\n<</Size 22/Root 12 0 R/Prev 58077/XRefStm %zd>>\n"
+                             "startxref\n%zd\n%%%%EOF\n", *stream_offset, table_offset);
+
+    return pdf;
+}
+
+static int test_compare_xref(sigil_t *sgl_a, sigil_t *sgl_b)
+{
+    reference_t ref;
+    size_t offset_a,
+           offset_b;
+    int found = 0;
+
+    for (size_t i = 0; i < sgl_a->xref->size_from_trailer; i++) {
+        ref.object_num = i;
+        ref.generation_num = 0;
+
+        if (reference_to_offset(sgl_a, &ref, &offset_a) != ERR_NONE) {
+            offset_a = 0;
+        } else {
+            found++;
         }
+
+        if (reference_to_offset(sgl_b, &ref, &offset_b) != ERR_NONE)
+            offset_b = 0;
+
+        if (offset_a != offset_b)
+            return -1;
     }
+
+    return found;
 }
 
 int sigil_xref_self_test(int verbosity)
@@ -290,6 +1846,452 @@ int sigil_xref_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn xref_add_entry, xref_lookup
+    print_test_item("fn xref_add_entry", verbosity);
+
+    {
+        xref_t *xref = xref_init(0);
+        xref_entry_t entry;
+        reference_t ref;
+
+        if (xref == NULL)
+            goto failed;
+
+        // newer sections are added first, the older entry is ignored
+        if (xref_add_entry(xref, 1000, XREF_ENTRY_IN_USE, 1234, 0) != ERR_NONE ||
+            xref_add_entry(xref, 1000, XREF_ENTRY_IN_USE, 5678, 0) != ERR_NONE ||
+            xref_add_entry(xref, 1000, XREF_ENTRY_IN_USE, 9012, 3) != ERR_NONE ||
+            xref->capacity < 1001 || xref->extra_count != 1)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 1000;
+        ref.generation_num = 0;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_TYPE(entry) != XREF_ENTRY_IN_USE ||
+            XREF_ENTRY_OFFSET(entry) != 1234)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.generation_num = 3;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_OFFSET(entry) != 9012 ||
+            XREF_ENTRY_GENERATION(entry) != 3)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.generation_num = 1;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NO_DATA) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 999;
+        ref.generation_num = 0;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NO_DATA) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        xref_free(xref);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: the directly indexed objects are limited by the data size
+    print_test_item("limited xref", verbosity);
+
+    {
+        // 100 objects at most fit into 400 bytes
+        xref_t *xref = xref_init(400);
+        xref_entry_t entry;
+        reference_t ref;
+
+        if (xref == NULL)
+            goto failed;
+
+        if (xref_add_entry(xref, 50, XREF_ENTRY_IN_USE, 123, 0) != ERR_NONE ||
+            xref_add_entry(xref, 4000000000, XREF_ENTRY_IN_USE, 456, 0) != ERR_PDF_CONTENT ||
+            xref_reserve(xref, 300000000) != ERR_NONE ||
+            xref->capacity > 100)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        // the objects declared by the trailer are kept aside
+        xref->size_from_trailer = 5000;
+        if (xref_add_entry(xref, 4000, XREF_ENTRY_IN_USE, 789, 0) != ERR_NONE ||
+            xref_add_entry(xref, 4000, XREF_ENTRY_IN_USE, 987, 0) != ERR_NONE ||
+            xref_add_entry(xref, 70, XREF_ENTRY_COMPRESSED, 10, 2) != ERR_NONE ||
+            xref_add_entry(xref, 6000, XREF_ENTRY_IN_USE, 654, 0) != ERR_PDF_CONTENT ||
+            xref->capacity > 100 || xref->extra_count != 1)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 4000;
+        ref.generation_num = 0;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_OFFSET(entry) != 789)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 70;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_TYPE(entry) != XREF_ENTRY_COMPRESSED)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 4001;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NO_DATA) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        xref_free(xref);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn decode_xref_records
+    print_test_item("fn decode_xref_records", verbosity);
+
+    {
+        xref_t *xref = xref_init(0);
+        xref_sink_t sink = { xref, NULL, 0 };
+        xref_entry_t entry;
+        reference_t ref;
+
+        // 4 records for the vectorized part and 2 for the rest
+        char records[] = "0000000000 65535 f\r\n" \
+                         "0000000017 00000 n\r\n" \
+                         "0000000081 00000 n \n"  \
+                         "0000000000 00001 f \r"  \
+                         "9876543210 00003 n\r\n" \
+                         "0000001234 00000 n\r\n";
+
+        if (xref == NULL)
+            goto failed;
+
+        if (decode_xref_records(&sink, 10, records, 6) != ERR_NONE) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 14;
+        ref.generation_num = 3;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_OFFSET(entry) != 9876543210)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 15;
+        ref.generation_num = 0;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_OFFSET(entry) != 1234)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 11;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_OFFSET(entry) != 17)
+        {
+            xref_free(xref);
+            goto failed;
+        }
+
+        ref.object_num = 13;
+        ref.generation_num = 1;
+        if (xref_lookup(xref, &ref, &entry) != ERR_NO_DATA) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        records[20 + 5] = 'x';
+        if (decode_xref_records(&sink, 10, records, 6) != ERR_PDF_CONTENT) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        records[20 + 5] = '0';
+        records[4 * 20 + 17] = 'x';
+        if (decode_xref_records(&sink, 10, records, 6) != ERR_PDF_CONTENT) {
+            xref_free(xref);
+            goto failed;
+        }
+
+        xref_free(xref);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: lazy and eager xref give the same offsets
+    print_test_item("lazy xref", verbosity);
+
+    {
+        sigil_t *sgl_eager;
+        reference_t ref;
+        size_t offset_lazy;
+
+        sgl_eager = test_load_xref("test/subtype_adbe.x509.rsa_sha1.pdf",
+                                   XREF_MODE_EAGER, 1);
+        if (sgl_eager == NULL)
+            goto failed;
+
+        sgl = test_load_xref("test/subtype_adbe.x509.rsa_sha1.pdf", XREF_MODE_LAZY, 1);
+        if (sgl == NULL || sgl->xref->subsection_count < 1 ||
+            sgl_eager->xref->subsection_count != 0 ||
+            test_compare_xref(sgl_eager, sgl) < 10)
+        {
+            sigil_free(&sgl_eager);
+            goto failed;
+        }
+
+        sigil_free(&sgl_eager);
+        sigil_free(&sgl);
+
+        // records with one-byte line ends, read entry by entry
+        char *sstream = "xref\n"                   \
+                        "0 3\n"                     \
+                        "0000000000 65535 f\n"      \
+                        "0000000010 00000 n\n"      \
+                        "0000000020 00002 n\n"      \
+                        "trailer\n"                 \
+                        "<</Size 3>>\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        ref.object_num = 2;
+        ref.generation_num = 2;
+        if (process_xref(sgl) != ERR_NONE ||
+            sgl->xref->subsection_count != 0 ||
+            reference_to_offset(sgl, &ref, &offset_lazy) != ERR_NONE ||
+            offset_lazy != 20)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: subsection with more records than the data holds
+    print_test_item("oversized xref subsection", verbosity);
+
+    {
+        char *sstream = "xref\n"                   \
+                        "0 300000000\n"            \
+                        "0000000000 65535 f\r\n"  \
+                        "0000000010 00000 n\r\n"  \
+                        "trailer\n"                \
+                        "<</Size 2>>\n";
+        int modes[] = { XREF_MODE_EAGER, XREF_MODE_LAZY };
+        FILE *file;
+
+        for (int i = 0; i < 4; i++) {
+            if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+                goto failed;
+
+            // the same for the data in the file
+            if (i >= 2) {
+                if ((file = tmpfile()) == NULL)
+                    goto failed;
+                sgl->pdf_data.buffer = NULL;
+                sgl->pdf_data.file = file;
+                sgl->pdf_data.deallocation_info |= DEALLOCATE_FILE;
+                if (fputs(sstream, file) < 0 || fflush(file) != 0 ||
+                    fseek(file, 0, SEEK_SET) != 0)
+                {
+                    goto failed;
+                }
+            }
+
+            if (sigil_set_xref_mode(sgl, modes[i % 2]) != ERR_NONE ||
+                process_xref(sgl) != ERR_PDF_CONTENT ||
+                sgl->xref->capacity > strlen(sstream))
+            {
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: parallel and serial xref give the same offsets
+    print_test_item("parallel xref", verbosity);
+
+    {
+        sigil_t *sgl_serial;
+
+        sgl_serial = test_load_xref("test/subtype_adbe.x509.rsa_sha1.pdf",
+                                    XREF_MODE_EAGER, 1);
+        if (sgl_serial == NULL)
+            goto failed;
+
+        sgl = test_load_xref("test/subtype_adbe.x509.rsa_sha1.pdf", XREF_MODE_EAGER, 4);
+        if (sgl == NULL || sgl->thread_count != 4 ||
+            sgl->xref->size_from_trailer != sgl_serial->xref->size_from_trailer ||
+            test_compare_xref(sgl_serial, sgl) < 10)
+        {
+            sigil_free(&sgl_serial);
+            goto failed;
+        }
+
+        sigil_free(&sgl_serial);
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: cross-reference stream in the incremental update
+    print_test_item("xref stream", verbosity);
+
+    {
+        char *pdf;
+        size_t size,
+               offset,
+               result;
+        reference_t ref;
+        xref_entry_t entry;
+
+        pdf = test_append_xref_stream("test/subtype_adbe.x509.rsa_sha1.pdf",
+                                      10639, 58077, &size, &offset);
+        if (pdf == NULL)
+            goto failed;
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL) {
+            free(pdf);
+            goto failed;
+        }
+        sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+
+        if (read_startxref(sgl) != ERR_NONE || sgl->offset_startxref != offset ||
+            process_xref_chain(sgl) != ERR_NONE ||
+            sgl->xref->size_from_trailer != 21 ||
+            sgl->ref_catalog_dict.object_num != 12)
+        {
+            goto failed;
+        }
+
+        // from the stream, and from the original tables
+        ref.generation_num = 0;
+        ref.object_num = 19;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != offset)
+            goto failed;
+
+        ref.object_num = 12;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != 10639)
+            goto failed;
+
+        ref.object_num = 16;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != 11144)
+            goto failed;
+
+        ref.object_num = 20;
+        if (xref_lookup(sgl->xref, &ref, &entry) != ERR_NONE ||
+            XREF_ENTRY_TYPE(entry) != XREF_ENTRY_COMPRESSED ||
+            XREF_ENTRY_OFFSET(entry) != 19 || XREF_ENTRY_GENERATION(entry) != 3 ||
+            reference_to_offset(sgl, &ref, &result) != ERR_PDF_CONTENT)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: hybrid-reference file, the stream is merged on the first miss
+    print_test_item("hybrid xref", verbosity);
+
+    for (size_t threads = 1; threads <= 4; threads += 3) {
+        char *pdf;
+        size_t size,
+               stream_offset,
+               object_offset,
+               result;
+        reference_t ref = { 2, 0 };
+
+        pdf = test_append_hybrid("test/subtype_adbe.x509.rsa_sha1.pdf", &size,
+                                 &stream_offset, &object_offset);
+        if (pdf == NULL)
+            goto failed;
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, size)) == NULL) {
+            free(pdf);
+            goto failed;
+        }
+        sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+
+        if (sigil_set_thread_count(sgl, threads) != ERR_NONE ||
+            sigil_set_xref_mode(sgl, threads > 1 ? XREF_MODE_EAGER : XREF_MODE_LAZY) != ERR_NONE ||
+            read_startxref(sgl) != ERR_NONE || process_xref_chain(sgl) != ERR_NONE ||
+            sgl->revisions.count != 3 ||
+            sgl->revisions.entry[0].xref_stream_offset != stream_offset ||
+            sgl->revisions.entry[1].xref_stream_offset != 0)
+        {
+            goto failed;
+        }
+
+        // found in the classic tables, the stream is not read
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != 19 ||
+            sgl->xref->hybrid_merged)
+        {
+            goto failed;
+        }
+
+        // only in the stream
+        ref.object_num = 20;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE ||
+            result != object_offset || !sgl->xref->hybrid_merged ||
+            sgl->revisions.count != 3)
+        {
+            goto failed;
+        }
+
+        // the table of the section goes first, then its stream, then the
+        // older sections
+        ref.object_num = 18;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != 58059)
+            goto failed;
+
+        ref.object_num = 2;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != object_offset)
+            goto failed;
+
+        ref.object_num = 16;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NONE || result != 11144)
+            goto failed;
+
+        // the miss after the merge does not read anything again
+        ref.object_num = 99;
+        if (reference_to_offset(sgl, &ref, &result) != ERR_NO_DATA)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn read_startxref
     print_test_item("fn read_startxref", verbosity);
 
@@ -32,6 +32,9 @@ void print_help(void)
             "         Output a program usage message and exit.                \n"
             "     -q, --quiet                                                 \n"
             "         Do not print anything to standard/error output.         \n"
+            "     -s, --is-signed                                             \n"
+            "         Only decide quickly whether the file contains a         \n"
+            "         signature, without verifying it.                        \n"
             "     -td, --trusted-dir                                          \n"
             "         Load all the certificates from a specified folder to a  \n"
             "         storage of the trusted certificates. The certificates   \n"
@@ -45,24 +48,159 @@ void print_help(void)
             "         the verification.                                       \n"
             "                                                                 \n"
             " EXIT STATUS                                                     \n"
-            "     0 ... the provided file was successfuly verified            \n"
+            "     0 ... all the signatures of the provided file were          \n"
+            "           successfuly verified (or it is signed with            \n"
+            "           --is-signed)                                          \n"
             "     1 ... the signature is invalid/could not be verified/other  \n"
             "           error occured                                         \n"
     );
 }
 
-int main(int argc, char *argv[])
+/** @brief Prints the result of the selected signature
+ *
+ * @return 0 if the signature was successfully verified, 1 otherwise
+ */
+int report_signature(sigil_t *sgl, int quiet, int cert_info)
 {
-    sigil_t *sgl = NULL;
     sigil_err_t err;
     int result = VERIFY_FAILED;
     int result_integrity = HASH_CMP_RESULT_UNKNOWN;
     int result_certificate = CERT_STATUS_UNKNOWN;
+    int result_timestamp = TIMESTAMP_STATUS_NONE;
+    int ret_code = 1;
+
+    if (sigil_get_signature_error(sgl, &err) != ERR_NONE)
+        return 1;
+
+    if (err != ERR_NONE) {
+        if (!quiet) {
+            if (err == ERR_NOT_IMPLEMENTED) {
+                fprintf(stderr, COLOR_RED
+                        " ERROR Unable to verify signature: Uses feature that is not implemented\n\n"COLOR_RESET);
+            } else {
+                fprintf(stderr, COLOR_RED
+                        " ERROR Unable to verify signature: %s\n\n"COLOR_RESET,
+                        sigil_err_string(err));
+            }
+        }
+        return 1;
+    }
+
+    err = sigil_get_result(sgl, &result);
+    if (err != ERR_NONE) {
+        if (!quiet) {
+            if (err == ERR_NOT_IMPLEMENTED) {
+                fprintf(stderr, COLOR_RED
+                        " ERROR file uses feature that is not implemented\n"COLOR_RESET);
+            } else {
+                fprintf(stderr, COLOR_RED
+                        " ERROR obtaining verification result from the context\n"COLOR_RESET);
+            }
+        }
+        return 1;
+    }
+
+    if (sigil_get_data_integrity_result(sgl, &result_integrity) != ERR_NONE && !quiet) {
+        fprintf(stderr, COLOR_RED
+                " ERROR failed to obtain data integrity result\n"COLOR_RESET);
+    }
+
+    if (sigil_get_cert_validation_result(sgl, &result_certificate) != ERR_NONE && !quiet) {
+        fprintf(stderr, COLOR_RED
+                " ERROR failed to obtain certificate validation result\n"COLOR_RESET);
+    }
+
+    if (sigil_get_timestamp_result(sgl, &result_timestamp) != ERR_NONE && !quiet) {
+        fprintf(stderr, COLOR_RED
+                " ERROR failed to obtain timestamp result\n"COLOR_RESET);
+    }
+
+    // print verification result
+    if (result == VERIFY_SUCCESS) {
+        if (!quiet)
+            printf(COLOR_GREEN" VERIFICATION SUCCESSFUL\n\n"COLOR_RESET);
+        ret_code = 0;
+    } else {
+        if (!quiet)
+            printf(COLOR_RED" VERIFICATION FAILED\n\n"COLOR_RESET);
+    }
+
+    // print verification details
+    if (!quiet) {
+        printf("     %-20s", "subfilter:");
+        sigil_print_subfilter(sgl);
+        printf("\n");
+        printf("     %-20s", "hash function:");
+        sigil_print_hash_fn(sgl);
+        printf("\n\n");
+        printf("     DATA INTEGRITY\n");
+        printf("     --------------\n");
+        printf("     %-20s", "original digest:");
+        sigil_print_original_digest(sgl);
+        printf("\n");
+        printf("     %-20s", "computed digest:");
+        sigil_print_computed_digest(sgl);
+        printf("\n");
+        printf("     %-20s", "digest match:");
+        switch (result_integrity) {
+            case HASH_CMP_RESULT_MATCH:
+                printf(COLOR_GREEN"YES\n"COLOR_RESET);
+                break;
+            case HASH_CMP_RESULT_DIFFER:
+                printf(COLOR_RED"NO\n"COLOR_RESET);
+                break;
+            default:
+                printf(COLOR_RED"UNKNOWN\n"COLOR_RESET);
+                break;
+        }
+        printf("\n");
+
+        printf("     CERTIFICATE\n");
+        printf("     -----------\n");
+        printf("     %-20s", "verified:");
+        switch (result_certificate) {
+            case CERT_STATUS_VERIFIED:
+                printf(COLOR_GREEN"YES\n"COLOR_RESET);
+                break;
+            case CERT_STATUS_FAILED:
+                printf(COLOR_RED"NO\n"COLOR_RESET);
+                break;
+            default:
+                printf(COLOR_RED"UNKNOWN\n"COLOR_RESET);
+                break;
+        }
+        printf("     %-20s", "timestamp:");
+        switch (result_timestamp) {
+            case TIMESTAMP_STATUS_VERIFIED:
+                printf(COLOR_GREEN"YES\n"COLOR_RESET);
+                break;
+            case TIMESTAMP_STATUS_FAILED:
+                printf(COLOR_RED"NO\n"COLOR_RESET);
+                break;
+            default:
+                printf("NONE\n");
+                break;
+        }
+        printf("\n");
+        if (cert_info)
+            sigil_print_cert_info(sgl);
+    }
+
+    return ret_code;
+}
+
+int main(int argc, char *argv[])
+{
+    sigil_t *sgl = NULL;
+    sigil_err_t err;
+    size_t count;
     int ret_code = 1;
     int help = 0;
     int quiet = 0;
     int trusted_system = 0;
     int cert_info = 0;
+    int is_signed_only = 0;
+    int is_signed = 0;
     const char *trusted_file = NULL;
     const char *trusted_dir = NULL;
     const char *file = NULL;
@@ -93,6 +231,8 @@ int main(int argc, char *argv[])
             file = argv[pos];
         } else if (strcmp(argv[pos], "-ci") == 0 || strcmp(argv[pos], "--cert-info") == 0) {
             cert_info = 1;
+        } else if (strcmp(argv[pos], "-s") == 0 || strcmp(argv[pos], "--is-signed") == 0) {
+            is_signed_only = 1;
         } else {
             if (!quiet) {
                 fprintf(stderr, COLOR_RED
@@ -136,6 +276,22 @@ int main(int argc, char *argv[])
         goto end;
     }
 
+    if (is_signed_only) {
+        if (sigil_is_signed(sgl, &is_signed) != ERR_NONE) {
+            if (!quiet) {
+                fprintf(stderr, COLOR_RED
+                        " ERROR while scanning the file\n"COLOR_RESET);
+            }
+            goto end;
+        }
+
+        if (!quiet)
+            printf(" %s\n\n", is_signed ? "SIGNED" : "NOT SIGNED");
+
+        ret_code = is_signed ? 0 : 1;
+        goto end;
+    }
+
     // set trusted CA certificates
     if (trusted_system) {
         if (sigil_set_trusted_system(sgl) != ERR_NONE) {
@@ -163,9 +319,9 @@ int main(int argc, char *argv[])
         }
     }
 
-    // verify and save the result to the context
+    // verify and save the results to the context
     err = sigil_verify(sgl);
-    if (err != ERR_NONE) {
+    if (sigil_get_signature_count(sgl, &count) != ERR_NONE || count == 0) {
         if (!quiet) {
             if (err == ERR_NOT_IMPLEMENTED) {
                 fprintf(stderr, COLOR_RED
@@ -178,87 +334,20 @@ int main(int argc, char *argv[])
         goto end;
     }
 
-    err = sigil_get_result(sgl, &result);
-    if (err != ERR_NONE) {
-        if (!quiet) {
-            if (err == ERR_NOT_IMPLEMENTED) {
-                fprintf(stderr, COLOR_RED
-                        " ERROR file uses feature that is not implemented\n"COLOR_RESET);
-            } else {
-                fprintf(stderr, COLOR_RED
-                        " ERROR obtaining verification result from the context\n"COLOR_RESET);
-            }
-        }
-        goto end;
-    }
-
-    if (sigil_get_data_integrity_result(sgl, &result_integrity) != ERR_NONE && !quiet) {
-        fprintf(stderr, COLOR_RED
-                " ERROR failed to obtain data integrity result\n"COLOR_RESET);
-    }
-
-    if (sigil_get_cert_validation_result(sgl, &result_certificate) != ERR_NONE && !quiet) {
-        fprintf(stderr, COLOR_RED
-                " ERROR failed to obtain certificate validation result\n"COLOR_RESET);
-    }
+    // the file is verified only if all of its signatures are
+    ret_code = 0;
 
-    // print verification result
-    if (result == VERIFY_SUCCESS) {
-        if (!quiet)
-            printf(COLOR_GREEN" VERIFICATION SUCCESSFUL\n\n"COLOR_RESET);
-        ret_code = 0;
-    } else {
-        if (!quiet)
-            printf(COLOR_RED" VERIFICATION FAILED\n\n"COLOR_RESET);
-    }
-
-    // print verification details
-    if (!quiet) {
-        printf("     %-20s", "subfilter:");
-        sigil_print_subfilter(sgl);
-        printf("\n");
-        printf("     %-20s", "hash function:");
-        sigil_print_hash_fn(sgl);
-        printf("\n\n");
-        printf("     DATA INTEGRITY\n");
-        printf("     --------------\n");
-        printf("     %-20s", "original digest:");
-        sigil_print_original_digest(sgl);
-        printf("\n");
-        printf("     %-20s", "computed digest:");
-        sigil_print_computed_digest(sgl);
-        printf("\n");
-        printf("     %-20s", "digest match:");
-        switch (result_integrity) {
-            case HASH_CMP_RESULT_MATCH:
-                printf(COLOR_GREEN"YES\n"COLOR_RESET);
-                break;
-            case HASH_CMP_RESULT_DIFFER:
-                printf(COLOR_RED"NO\n"COLOR_RESET);
-                break;
-            default:
-                printf(COLOR_RED"UNKNOWN\n"COLOR_RESET);
-                break;
+    for (size_t i = 0; i < count; i++) {
+        if (sigil_select_signature(sgl, i) != ERR_NONE) {
+            ret_code = 1;
+            break;
         }
-        printf("\n");
 
-        printf("     CERTIFICATE\n");
-        printf("     -----------\n");
-        printf("     %-20s", "verified:");
-        switch (result_certificate) {
-            case CERT_STATUS_VERIFIED:
-                printf(COLOR_GREEN"YES\n"COLOR_RESET);
-                break;
-            case CERT_STATUS_FAILED:
-                printf(COLOR_RED"NO\n"COLOR_RESET);
-                break;
-            default:
-                printf(COLOR_RED"UNKNOWN\n"COLOR_RESET);
-                break;
-        }
-        printf("\n");
-        if (cert_info)
-            sigil_print_cert_info(sgl);
+        if (!quiet && count > 1)
+            printf(" SIGNATURE %zu OF %zu\n\n", i + 1, count);
+
+        if (report_signature(sgl, quiet, cert_info) != 0)
+            ret_code = 1;
     }
 
     end:
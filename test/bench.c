@@ -0,0 +1,905 @@
+#ifdef __linux__
+    // fopencookie for the file with the simulated latency of the storage
+    #define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "auxiliary.h"
+#include "constants.h"
+#include "config.h"
+#include "cryptography.h"
+#include "reconstruct.h"
+#include "sigil.h"
+#include "signature.h"
+#include "workers.h"
+#include "xref.h"
+
+#define HEX_BENCH_SIZE      (1024 * 1024)
+#define HEX_BENCH_ROUNDS    200
+#define XREF_BENCH_OBJECTS  (1024 * 1024)
+#define XREF_BENCH_ROUNDS   5
+#define CHAIN_BENCH_UPDATES 200
+#define CHAIN_BENCH_OBJECTS 5000
+#define STREAM_BENCH_COLUMNS 7
+#define RECONSTRUCT_BENCH_SIZE (64 * 1024 * 1024)
+#define DIGEST_BENCH_SIZE   (64 * 1024 * 1024)
+#define DIGEST_BENCH_SIGNATURES 8
+#define DIGEST_BENCH_CONTENTS 16384
+#define DIGEST_FILE_BENCH_SIZE (512 * 1024 * 1024)
+#define DIGEST_FILE_BENCH_CHUNK (1024 * 1024)
+#define DIGEST_FILE_BENCH_ROUNDS 2
+#define PIPELINE_BENCH_SIZE (64 * 1024 * 1024)
+#define PIPELINE_BENCH_LATENCY_NS 2000000
+
+static double time_now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void print_bench_result(const char *name, double seconds, size_t bytes)
+{
+    printf("    - %-32s %8.3f ms %10.1f MB/s\n", name, seconds * 1e3,
+           (double)bytes / seconds / (1024 * 1024));
+}
+
+/** @brief The original per-nibble implementation of sigil_hex_to_dec, kept as
+ *         a reference for the comparison
+ *
+ */
+static sigil_err_t hex_to_dec_reference(const char *in, size_t in_len,
+                                        unsigned char *out, size_t *out_len)
+{
+    int first,
+        second;
+
+    if (in == NULL || (in_len % 2) != 0 || out == NULL || out_len == NULL)
+        return ERR_PARAMETER;
+
+    *out_len = 0;
+
+    for (size_t i = 0; i < in_len; i += 2) {
+        if (is_digit(in[i])) {
+            first = (in[i] - '0') << 4;
+        } else if (in[i] >= 'A' && in[i] <= 'F') {
+            first = (in[i] - 55) << 4;
+        } else if (in[i] >= 'a' && in[i] <= 'f') {
+            first = (in[i] - 87) << 4;
+        } else {
+            return ERR_PDF_CONTENT;
+        }
+
+        if (is_digit(in[i + 1])) {
+            second = in[i + 1] - '0';
+        } else if (in[i + 1] >= 'A' && in[i + 1] <= 'F') {
+            second = in[i + 1] - 55;
+        } else if (in[i + 1] >= 'a' && in[i + 1] <= 'f') {
+            second = in[i + 1] - 87;
+        } else {
+            return ERR_PDF_CONTENT;
+        }
+
+        out[*out_len] = (unsigned char)(first + second);
+
+        (*out_len)++;
+    }
+
+    out[*out_len] = '\0';
+
+    return ERR_NONE;
+}
+
+static int bench_hex_to_dec(void)
+{
+    const char digits[] = "0123456789abcdefABCDEF";
+    char *hex;
+    unsigned char *out_ref,
+                  *out_new;
+    size_t out_ref_len,
+           out_new_len;
+    double start,
+           time_ref,
+           time_new;
+    int ret = 1;
+
+    printf("\n + hex_to_dec (%d KB of hexadecimal digits)\n", HEX_BENCH_SIZE / 1024);
+
+    hex = malloc(HEX_BENCH_SIZE);
+    out_ref = malloc(HEX_BENCH_SIZE / 2 + 1);
+    out_new = malloc(HEX_BENCH_SIZE / 2 + 1);
+    if (hex == NULL || out_ref == NULL || out_new == NULL)
+        goto end;
+
+    srand(42);
+    for (size_t i = 0; i < HEX_BENCH_SIZE; i++)
+        hex[i] = digits[rand() % (sizeof(digits) - 1)];
+
+    start = time_now();
+    for (int round = 0; round < HEX_BENCH_ROUNDS; round++) {
+        if (hex_to_dec_reference(hex, HEX_BENCH_SIZE, out_ref, &out_ref_len) != ERR_NONE)
+            goto end;
+    }
+    time_ref = (time_now() - start) / HEX_BENCH_ROUNDS;
+
+    start = time_now();
+    for (int round = 0; round < HEX_BENCH_ROUNDS; round++) {
+        if (sigil_hex_to_dec(hex, HEX_BENCH_SIZE, out_new, &out_new_len) != ERR_NONE)
+            goto end;
+    }
+    time_new = (time_now() - start) / HEX_BENCH_ROUNDS;
+
+    if (out_ref_len != out_new_len || memcmp(out_ref, out_new, out_new_len) != 0) {
+        printf("    results differ\n");
+        goto end;
+    }
+
+    print_bench_result("reference (per nibble)", time_ref, HEX_BENCH_SIZE);
+    print_bench_result("hex_to_dec", time_new, HEX_BENCH_SIZE);
+    printf("    speedup %.2fx\n", time_ref / time_new);
+
+    ret = 0;
+
+end:
+    free(hex);
+    free(out_ref);
+    free(out_new);
+
+    return ret;
+}
+
+/** @brief The original per-entry tokenizing reader of the cross-reference
+ *         table, kept as a reference for the comparison
+ *
+ */
+static sigil_err_t read_xref_table_reference(sigil_t *sgl)
+{
+    sigil_err_t err;
+    size_t section_start,
+           section_cnt,
+           obj_offset,
+           obj_generation;
+
+    if ((err = skip_word(sgl, "xref")) != ERR_NONE)
+        return err;
+
+    while (parse_number(sgl, &section_start) == ERR_NONE) {
+        if ((err = parse_number(sgl, &section_cnt)) != ERR_NONE)
+            return err;
+
+        for (size_t i = 0; i < section_cnt; i++) {
+            if ((err = parse_number(sgl, &obj_offset)) != ERR_NONE)
+                return err;
+            if ((err = parse_number(sgl, &obj_generation)) != ERR_NONE)
+                return err;
+
+            if (skip_word(sgl, "f") == ERR_NONE)
+                continue;
+            if ((err = skip_word(sgl, "n")) != ERR_NONE)
+                return err;
+
+            err = xref_add_entry(sgl->xref, section_start + i, XREF_ENTRY_IN_USE,
+                                 obj_offset, obj_generation);
+            if (err != ERR_NONE)
+                return err;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+static int bench_xref_table_round(char *table, size_t size, int reference, double *time)
+{
+    sigil_t *sgl = NULL;
+    sigil_err_t err;
+    double start;
+
+    if (sigil_init(&sgl) != ERR_NONE ||
+        sigil_set_pdf_buffer(sgl, table, size) != ERR_NONE ||
+        sigil_set_xref_mode(sgl, XREF_MODE_EAGER) != ERR_NONE ||
+        (sgl->xref = xref_init(size)) == NULL)
+    {
+        sigil_free(&sgl);
+        return 1;
+    }
+
+    start = time_now();
+    if (reference) {
+        err = read_xref_table_reference(sgl);
+    } else {
+        err = process_xref(sgl);
+    }
+    *time += time_now() - start;
+
+    // the buffer is owned by the benchmark
+    sgl->pdf_data.buffer = NULL;
+    sigil_free(&sgl);
+
+    return (err != ERR_NONE);
+}
+
+static int bench_xref_table(void)
+{
+    char *table;
+    size_t size = 0;
+    double time_ref = 0,
+           time_new = 0;
+    int ret = 1;
+
+    printf("\n + eager xref table (%d objects)\n", XREF_BENCH_OBJECTS);
+
+    table = malloc(32 + XREF_RECORD_SIZE * XREF_BENCH_OBJECTS + 32);
+    if (table == NULL)
+        return 1;
+
+    size += sprintf(table, "xref\n0 %d\n", XREF_BENCH_OBJECTS);
+    for (size_t i = 0; i < XREF_BENCH_OBJECTS; i++) {
+        size += sprintf(table + size, "%010zu %05d %c\r\n", i * 97,
+                        0, (i % 16 == 0) ? 'f' : 'n');
+    }
+    size += sprintf(table + size, "trailer\n<<>>\n");
+
+    for (int round = 0; round < XREF_BENCH_ROUNDS; round++) {
+        if (bench_xref_table_round(table, size, 1, &time_ref) != 0 ||
+            bench_xref_table_round(table, size, 0, &time_new) != 0)
+        {
+            goto end;
+        }
+    }
+    time_ref /= XREF_BENCH_ROUNDS;
+    time_new /= XREF_BENCH_ROUNDS;
+
+    print_bench_result("reference (per token)", time_ref, size);
+    print_bench_result("process_xref", time_new, size);
+    printf("    speedup %.2fx\n", time_ref / time_new);
+
+    ret = 0;
+
+end:
+    free(table);
+
+    return ret;
+}
+
+static int bench_xref_chain_round(char *pdf, size_t size, size_t startxref,
+                                  size_t threads, double *time)
+{
+    sigil_t *sgl = NULL;
+    sigil_err_t err;
+    double start;
+
+    if (sigil_init(&sgl) != ERR_NONE ||
+        sigil_set_pdf_buffer(sgl, pdf, size) != ERR_NONE ||
+        sigil_set_xref_mode(sgl, XREF_MODE_EAGER) != ERR_NONE ||
+        sigil_set_thread_count(sgl, threads) != ERR_NONE)
+    {
+        sigil_free(&sgl);
+        return 1;
+    }
+
+    sgl->offset_startxref = startxref;
+
+    start = time_now();
+    err = process_xref_chain(sgl);
+    *time += time_now() - start;
+
+    // the buffer is owned by the benchmark
+    sgl->pdf_data.buffer = NULL;
+    sigil_free(&sgl);
+
+    return (err != ERR_NONE);
+}
+
+static int bench_xref_chain(void)
+{
+    char *pdf;
+    size_t size = 0,
+           prev = 0,
+           threads = workers_default_count();
+    double time_serial = 0,
+           time_parallel = 0;
+    int ret = 1;
+
+    printf("\n + xref chain (%d updates of %d objects, %zd threads)\n",
+           CHAIN_BENCH_UPDATES, CHAIN_BENCH_OBJECTS, threads);
+
+    pdf = malloc((size_t)CHAIN_BENCH_UPDATES * (XREF_RECORD_SIZE * CHAIN_BENCH_OBJECTS + 128));
+    if (pdf == NULL)
+        return 1;
+
+    // every update redefines the objects of the previous one and adds new ones
+    for (size_t update = 0; update < CHAIN_BENCH_UPDATES; update++) {
+        size_t section = size;
+        size_t first = update * CHAIN_BENCH_OBJECTS / 2;
+
+        size += sprintf(pdf + size, "xref\n%zd %d\n", first, CHAIN_BENCH_OBJECTS);
+        for (size_t i = 0; i < CHAIN_BENCH_OBJECTS; i++) {
+            size += sprintf(pdf + size, "%010zd %05d n\r\n", section + i, 0);
+        }
+        size += sprintf(pdf + size, "trailer\n<</Size %zd",
+                        first + CHAIN_BENCH_OBJECTS);
+        if (update > 0)
+            size += sprintf(pdf + size, " /Prev %zd", prev);
+        size += sprintf(pdf + size, ">>\n");
+
+        prev = section;
+    }
+
+    for (int round = 0; round < XREF_BENCH_ROUNDS; round++) {
+        if (bench_xref_chain_round(pdf, size, prev, 1, &time_serial) != 0 ||
+            bench_xref_chain_round(pdf, size, prev, threads, &time_parallel) != 0)
+        {
+            goto end;
+        }
+    }
+    time_serial /= XREF_BENCH_ROUNDS;
+    time_parallel /= XREF_BENCH_ROUNDS;
+
+    print_bench_result("serial", time_serial, size);
+    print_bench_result("parallel", time_parallel, size);
+    printf("    speedup %.2fx\n", time_serial / time_parallel);
+
+    ret = 0;
+
+end:
+    free(pdf);
+
+    return ret;
+}
+
+static int bench_xref_stream(void)
+{
+    unsigned char *rows = NULL,
+                  *compressed = NULL;
+    unsigned char previous[STREAM_BENCH_COLUMNS] = { 0 },
+                  current[STREAM_BENCH_COLUMNS];
+    char *pdf = NULL;
+    size_t rows_size = (size_t)XREF_BENCH_OBJECTS * (STREAM_BENCH_COLUMNS + 1),
+           size;
+    uLongf compressed_len;
+    double time = 0;
+    int ret = 1;
+
+    printf("\n + xref stream (%d objects, W [1 4 2], PNG Up predictor)\n",
+           XREF_BENCH_OBJECTS);
+
+    compressed_len = compressBound(rows_size);
+    rows = malloc(rows_size);
+    compressed = malloc(compressed_len);
+    pdf = malloc(compressed_len + 256);
+    if (rows == NULL || compressed == NULL || pdf == NULL)
+        goto end;
+
+    // each row stores the in-use entry of its object with the Up filter
+    // applied, the offsets are not checked against the data
+    for (size_t i = 0; i < XREF_BENCH_OBJECTS; i++) {
+        size_t offset = 128 * i;
+        unsigned char *row = rows + i * (STREAM_BENCH_COLUMNS + 1);
+
+        current[0] = 1;
+        for (int b = 0; b < 4; b++) {
+            current[1 + b] = (unsigned char)(offset >> (8 * (3 - b)));
+        }
+        current[5] = 0;
+        current[6] = 0;
+
+        row[0] = PNG_FILTER_UP;
+        for (int b = 0; b < STREAM_BENCH_COLUMNS; b++) {
+            row[1 + b] = current[b] - previous[b];
+        }
+        memcpy(previous, current, STREAM_BENCH_COLUMNS);
+    }
+
+    if (compress2(compressed, &compressed_len, rows, rows_size,
+                  Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        goto end;
+    }
+
+    size = (size_t)sprintf(pdf, "%%PDF-1.7\n0 0 obj\n<</Type/XRef/Size %d/W[1 4 2]/Root 1 0 R"
+                           "/Filter/FlateDecode/DecodeParms<</Columns %d"
+                           "/Predictor 12>>/Length %lu>>\nstream\r\n",
+                           XREF_BENCH_OBJECTS, STREAM_BENCH_COLUMNS,
+                           (unsigned long)compressed_len);
+    memcpy(pdf + size, compressed, compressed_len);
+    size += compressed_len;
+    size += (size_t)sprintf(pdf + size, "\r\nendstream\nendobj\n");
+
+    for (int round = 0; round < XREF_BENCH_ROUNDS; round++) {
+        if (bench_xref_chain_round(pdf, size, 9, 1, &time) != 0)
+            goto end;
+    }
+    time /= XREF_BENCH_ROUNDS;
+
+    print_bench_result("process_xref_chain", time, rows_size);
+    printf("    compressed size %lu bytes\n", (unsigned long)compressed_len);
+
+    ret = 0;
+
+end:
+    free(rows);
+    free(compressed);
+    free(pdf);
+
+    return ret;
+}
+
+static int bench_reconstruct_round(char *pdf, size_t size, size_t threads,
+                                   double *time)
+{
+    sigil_t *sgl = NULL;
+    sigil_err_t err;
+    double start;
+
+    if (sigil_init(&sgl) != ERR_NONE ||
+        sigil_set_pdf_buffer(sgl, pdf, size) != ERR_NONE ||
+        sigil_set_thread_count(sgl, threads) != ERR_NONE)
+    {
+        sigil_free(&sgl);
+        return 1;
+    }
+
+    start = time_now();
+    err = reconstruct_xref(sgl);
+    *time += time_now() - start;
+
+    // the buffer is owned by the benchmark
+    sgl->pdf_data.buffer = NULL;
+    sigil_free(&sgl);
+
+    return (err != ERR_NONE);
+}
+
+static int bench_reconstruct(void)
+{
+    char *pdf;
+    size_t size = 0,
+           objects = 0,
+           threads = workers_default_count();
+    double time_serial = 0,
+           time_parallel = 0;
+    int ret = 1;
+
+    printf("\n + xref reconstruction (%d MB, %zd threads)\n",
+           RECONSTRUCT_BENCH_SIZE / (1024 * 1024), threads);
+
+    pdf = malloc(RECONSTRUCT_BENCH_SIZE + 256);
+    if (pdf == NULL)
+        return 1;
+
+    // objects with a content stream like padding, the catalog at the end
+    size += sprintf(pdf, "%%PDF-1.4\n");
+    while (size < RECONSTRUCT_BENCH_SIZE - 512) {
+        size += sprintf(pdf + size, "%zd 0 obj\n<</Length 300>>\nstream\n", ++objects);
+        memset(pdf + size, 'q', 300);
+        size += 300;
+        size += sprintf(pdf + size, "\nendstream\nendobj\n");
+    }
+    size += sprintf(pdf + size, "%zd 0 obj\n<</Type /Catalog>>\nendobj\n"
+                    "trailer\n<</Size %zd /Root %zd 0 R>>\n%%%%EOF\n",
+                    objects + 1, objects + 2, objects + 1);
+
+    for (int round = 0; round < XREF_BENCH_ROUNDS; round++) {
+        if (bench_reconstruct_round(pdf, size, 1, &time_serial) != 0 ||
+            bench_reconstruct_round(pdf, size, threads, &time_parallel) != 0)
+        {
+            goto end;
+        }
+    }
+    time_serial /= XREF_BENCH_ROUNDS;
+    time_parallel /= XREF_BENCH_ROUNDS;
+
+    print_bench_result("serial", time_serial, size);
+    print_bench_result("parallel", time_parallel, size);
+    printf("    speedup %.2fx\n", time_serial / time_parallel);
+
+    ret = 0;
+
+end:
+    free(pdf);
+
+    return ret;
+}
+
+/** @brief Adds the signature of the revision ending at the provided position,
+ *         it covers all the data before except for its Contents
+ *
+ */
+static int bench_digests_add(sigil_t *sgl, size_t end)
+{
+    signature_t *signature;
+    range_t *first,
+            *second;
+
+    first = calloc(1, sizeof(*first));
+    second = calloc(1, sizeof(*second));
+    if (first == NULL || second == NULL || signature_add(sgl, &signature) != ERR_NONE) {
+        free(first);
+        free(second);
+        return 1;
+    }
+
+    first->length = end - 2 * DIGEST_BENCH_CONTENTS;
+    first->next = second;
+    second->start = first->length + DIGEST_BENCH_CONTENTS;
+    second->length = DIGEST_BENCH_CONTENTS;
+
+    signature->byte_range = first;
+    signature->digest_algorithm = X509_ALGOR_new();
+    if (signature->digest_algorithm == NULL)
+        return 1;
+    X509_ALGOR_set_md(signature->digest_algorithm, EVP_sha256());
+
+    return 0;
+}
+
+/** @brief Prepares the context with the nested signatures of the incremental
+ *         updates - each one covers the whole file up to the end of its
+ *         revision except for its Contents
+ *
+ */
+static sigil_t *bench_digests_prepare(char *pdf, size_t size)
+{
+    sigil_t *sgl = NULL;
+    size_t revision = size / DIGEST_BENCH_SIGNATURES;
+
+    if (sigil_init(&sgl) != ERR_NONE ||
+        sigil_set_pdf_buffer(sgl, pdf, size) != ERR_NONE)
+    {
+        sigil_free(&sgl);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < DIGEST_BENCH_SIGNATURES; i++) {
+        if (bench_digests_add(sgl, revision * (i + 1)) != 0) {
+            sigil_free(&sgl);
+            return NULL;
+        }
+    }
+
+    return sgl;
+}
+
+static void bench_digests_release(sigil_t **sgl)
+{
+    // the buffer is owned by the benchmark
+    (*sgl)->pdf_data.buffer = NULL;
+    sigil_free(sgl);
+}
+
+static int bench_digests(void)
+{
+    sigil_t *sgl = NULL;
+    char *pdf;
+    size_t size = DIGEST_BENCH_SIZE;
+    double start,
+           time_separate = 0,
+           time_single = 0;
+    int ret = 1;
+
+    printf("\n + digests (%d MB, %d nested signatures, SHA-256)\n",
+           DIGEST_BENCH_SIZE / (1024 * 1024), DIGEST_BENCH_SIGNATURES);
+
+    pdf = malloc(size);
+    if (pdf == NULL)
+        return 1;
+
+    for (size_t i = 0; i < size; i++)
+        pdf[i] = (char)(i * 31);
+
+    for (int round = 0; round < XREF_BENCH_ROUNDS; round++) {
+        if ((sgl = bench_digests_prepare(pdf, size)) == NULL)
+            goto end;
+
+        start = time_now();
+        for (size_t i = 0; i < sgl->signature_count; i++) {
+            if (compute_digest(sgl, &(sgl->signatures[i])) != ERR_NONE)
+                goto end;
+        }
+        time_separate += time_now() - start;
+
+        bench_digests_release(&sgl);
+
+        if ((sgl = bench_digests_prepare(pdf, size)) == NULL)
+            goto end;
+
+        start = time_now();
+        if (compute_digests(sgl) != ERR_NONE)
+            goto end;
+        time_single += time_now() - start;
+
+        for (size_t i = 0; i < sgl->signature_count; i++) {
+            if (sgl->signatures[i].error != ERR_NONE)
+                goto end;
+        }
+
+        bench_digests_release(&sgl);
+    }
+    time_separate /= XREF_BENCH_ROUNDS;
+    time_single /= XREF_BENCH_ROUNDS;
+
+    print_bench_result("per signature", time_separate, size);
+    print_bench_result("single pass", time_single, size);
+    printf("    speedup %.2fx\n", time_separate / time_single);
+
+    ret = 0;
+
+end:
+    if (sgl != NULL)
+        bench_digests_release(&sgl);
+    free(pdf);
+
+    return ret;
+}
+
+/** @brief Hashes the whole file as one signature and compares the time with
+ *         the plain SHA-256 of the same data in memory
+ *
+ */
+static int bench_digest_file(void)
+{
+    sigil_t *sgl = NULL;
+    FILE *file;
+    char *chunk = NULL;
+    unsigned char md[EVP_MAX_MD_SIZE];
+    double start,
+           time_sha = 0,
+           time_read = 0,
+           time_mapped = 0;
+    int ret = 1;
+
+    printf("\n + digest of file (%d MB, SHA-256)\n",
+           DIGEST_FILE_BENCH_SIZE / (1024 * 1024));
+
+    file = tmpfile();
+    chunk = malloc(DIGEST_FILE_BENCH_CHUNK);
+    if (file == NULL || chunk == NULL)
+        goto end;
+
+    for (size_t i = 0; i < DIGEST_FILE_BENCH_CHUNK; i++)
+        chunk[i] = (char)(i * 31);
+
+    for (size_t i = 0; i < DIGEST_FILE_BENCH_SIZE / DIGEST_FILE_BENCH_CHUNK; i++) {
+        if (fwrite(chunk, 1, DIGEST_FILE_BENCH_CHUNK, file) != DIGEST_FILE_BENCH_CHUNK)
+            goto end;
+    }
+    if (fflush(file) != 0)
+        goto end;
+
+    for (int round = 0; round < DIGEST_FILE_BENCH_ROUNDS; round++) {
+        // read through the file in chunks
+        if (sigil_init(&sgl) != ERR_NONE)
+            goto end;
+        sgl->pdf_data.file = file;
+        sgl->pdf_data.size = DIGEST_FILE_BENCH_SIZE;
+
+        if (bench_digests_add(sgl, DIGEST_FILE_BENCH_SIZE) != 0)
+            goto end;
+
+        start = time_now();
+        if (compute_digest(sgl, &(sgl->signatures[0])) != ERR_NONE)
+            goto end;
+        time_read += time_now() - start;
+
+        sigil_free(&sgl);
+
+        // mapped and hashed without copying
+        if (sigil_init(&sgl) != ERR_NONE ||
+            sigil_set_pdf_file(sgl, file) != ERR_NONE ||
+            sgl->pdf_data.buffer == NULL ||
+            bench_digests_add(sgl, DIGEST_FILE_BENCH_SIZE) != 0)
+        {
+            goto end;
+        }
+
+        start = time_now();
+        if (compute_digest(sgl, &(sgl->signatures[0])) != ERR_NONE)
+            goto end;
+        time_mapped += time_now() - start;
+
+        start = time_now();
+        if (EVP_Digest(sgl->pdf_data.buffer, DIGEST_FILE_BENCH_SIZE, md, NULL,
+                       EVP_sha256(), NULL) != 1)
+        {
+            goto end;
+        }
+        time_sha += time_now() - start;
+
+        sigil_free(&sgl);
+    }
+    time_read /= DIGEST_FILE_BENCH_ROUNDS;
+    time_mapped /= DIGEST_FILE_BENCH_ROUNDS;
+    time_sha /= DIGEST_FILE_BENCH_ROUNDS;
+
+    print_bench_result("EVP_Digest of memory", time_sha, DIGEST_FILE_BENCH_SIZE);
+    print_bench_result("pdf_read chunks", time_read, DIGEST_FILE_BENCH_SIZE);
+    print_bench_result("mapped spans", time_mapped, DIGEST_FILE_BENCH_SIZE);
+    printf("    speedup %.2fx\n", time_read / time_mapped);
+
+    ret = 0;
+
+end:
+    sigil_free(&sgl);
+    if (file != NULL)
+        fclose(file);
+    free(chunk);
+
+    return ret;
+}
+
+#ifdef __GLIBC__
+/** @brief Data of the file with the simulated latency of the network storage,
+ *         each read waits before the data are returned
+ *
+ */
+typedef struct {
+    const char *data;
+    size_t      size;
+    size_t      position;
+} slow_file_t;
+
+static ssize_t slow_file_read(void *cookie, char *buf, size_t size)
+{
+    slow_file_t *slow = cookie;
+    struct timespec latency = { 0, PIPELINE_BENCH_LATENCY_NS };
+
+    nanosleep(&latency, NULL);
+
+    size = MIN(size, slow->size - slow->position);
+    memcpy(buf, slow->data + slow->position, size);
+    slow->position += size;
+
+    return (ssize_t)size;
+}
+
+static int slow_file_seek(void *cookie, off64_t *offset, int whence)
+{
+    slow_file_t *slow = cookie;
+    off64_t base = 0;
+
+    if (whence == SEEK_CUR) {
+        base = (off64_t)slow->position;
+    } else if (whence == SEEK_END) {
+        base = (off64_t)slow->size;
+    }
+
+    if (base + *offset < 0 || base + *offset > (off64_t)slow->size)
+        return -1;
+
+    slow->position = (size_t)(base + *offset);
+    *offset = (off64_t)slow->position;
+
+    return 0;
+}
+
+static int bench_digest_pipeline_round(slow_file_t *slow, size_t threads, double *time)
+{
+    cookie_io_functions_t io = { slow_file_read, NULL, slow_file_seek, NULL };
+    sigil_t *sgl = NULL;
+    FILE *file;
+    char *buffer;
+    double start;
+    int ret = 1;
+
+    slow->position = 0;
+
+    // the stream cannot be mapped, it stays read through the file, glibc
+    // uses the size of the stdio buffer only with the provided buffer
+    buffer = malloc(READER_BUFFER_SIZE);
+    file = fopencookie(slow, "r", io);
+    if (buffer == NULL || file == NULL ||
+        setvbuf(file, buffer, _IOFBF, READER_BUFFER_SIZE) != 0 ||
+        sigil_init(&sgl) != ERR_NONE ||
+        sigil_set_pdf_file(sgl, file) != ERR_NONE ||
+        sgl->pdf_data.buffer != NULL ||
+        sigil_set_thread_count(sgl, threads) != ERR_NONE ||
+        bench_digests_add(sgl, PIPELINE_BENCH_SIZE) != 0)
+    {
+        goto end;
+    }
+
+    start = time_now();
+    if (compute_digest(sgl, &(sgl->signatures[0])) != ERR_NONE)
+        goto end;
+    *time += time_now() - start;
+
+    ret = 0;
+
+end:
+    sigil_free(&sgl);
+    if (file != NULL)
+        fclose(file);
+    free(buffer);
+
+    return ret;
+}
+
+static int bench_digest_pipeline(void)
+{
+    slow_file_t slow = { NULL, PIPELINE_BENCH_SIZE, 0 };
+    char *data;
+    double time_serial = 0,
+           time_pipelined = 0;
+    int ret = 1;
+
+    printf("\n + digest of slow file (%d MB, %.1f ms per read, SHA-256)\n",
+           PIPELINE_BENCH_SIZE / (1024 * 1024), PIPELINE_BENCH_LATENCY_NS / 1e6);
+
+    data = malloc(PIPELINE_BENCH_SIZE);
+    if (data == NULL)
+        return 1;
+
+    for (size_t i = 0; i < PIPELINE_BENCH_SIZE; i++)
+        data[i] = (char)(i * 31);
+    slow.data = data;
+
+    for (int round = 0; round < DIGEST_FILE_BENCH_ROUNDS; round++) {
+        if (bench_digest_pipeline_round(&slow, 1, &time_serial) != 0 ||
+            bench_digest_pipeline_round(&slow, 2, &time_pipelined) != 0)
+        {
+            goto end;
+        }
+    }
+    time_serial /= DIGEST_FILE_BENCH_ROUNDS;
+    time_pipelined /= DIGEST_FILE_BENCH_ROUNDS;
+
+    print_bench_result("serial", time_serial, PIPELINE_BENCH_SIZE);
+    print_bench_result("reading thread", time_pipelined, PIPELINE_BENCH_SIZE);
+    printf("    speedup %.2fx\n", time_serial / time_pipelined);
+
+    ret = 0;
+
+end:
+    free(data);
+
+    return ret;
+}
+#endif /* __GLIBC__ */
+
+int main(int argc, char **argv)
+{
+    const char *filter = NULL;
+    int failed = 0;
+
+    if (argc == 2) {
+        filter = argv[1];
+    } else if (argc > 2) {
+        fprintf(stderr, " USAGE\n");
+        fprintf(stderr, "     $ %s [BENCHMARK]\n", argv[0]);
+        return 1;
+    }
+
+    if (filter == NULL || strcmp(filter, "hex_to_dec") == 0)
+        failed += bench_hex_to_dec();
+
+    if (filter == NULL || strcmp(filter, "xref_table") == 0)
+        failed += bench_xref_table();
+
+    if (filter == NULL || strcmp(filter, "xref_chain") == 0)
+        failed += bench_xref_chain();
+
+    if (filter == NULL || strcmp(filter, "xref_stream") == 0)
+        failed += bench_xref_stream();
+
+    if (filter == NULL || strcmp(filter, "reconstruct") == 0)
+        failed += bench_reconstruct();
+
+    if (filter == NULL || strcmp(filter, "digests") == 0)
+        failed += bench_digests();
+
+    if (filter == NULL || strcmp(filter, "digest_file") == 0)
+        failed += bench_digest_file();
+
+    #ifdef __GLIBC__
+        if (filter == NULL || strcmp(filter, "digest_pipeline") == 0)
+            failed += bench_digest_pipeline();
+    #endif
+
+    return (failed != 0);
+}
@@ -4,14 +4,26 @@
 #include "auxiliary.h"
 #include "catalog.h"
 #include "cert.h"
+#include "cms.h"
 #include "config.h"
 #include "contents.h"
 #include "cryptography.h"
+#include "dss.h"
 #include "header.h"
+#include "objstm.h"
+#include "reader.h"
+#include "reconstruct.h"
+#include "revision.h"
+#include "sidecar.h"
 #include "sig_dict.h"
 #include "sig_field.h"
+#include "sig_scan.h"
+#include "signature.h"
 #include "sigil.h"
+#include "stream.h"
+#include "timestamp.h"
 #include "trailer.h"
+#include "workers.h"
 #include "xref.h"
 
 static void print_usage(const char *prog)
@@ -60,8 +72,20 @@ int main(int argc, char **argv)
         failed++;
     if (sigil_trailer_self_test(verbosity) != 0)
         failed++;
+    if (sigil_workers_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_reader_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_stream_self_test(verbosity) != 0)
+        failed++;
     if (sigil_xref_self_test(verbosity) != 0)
         failed++;
+    if (sigil_objstm_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_revision_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_reconstruct_self_test(verbosity) != 0)
+        failed++;
     if (sigil_acroform_self_test(verbosity) != 0)
         failed++;
     if (sigil_catalog_self_test(verbosity) != 0)
@@ -72,10 +96,22 @@ int main(int argc, char **argv)
         failed++;
     if (sigil_cryptography_self_test(verbosity) != 0)
         failed++;
+    if (sigil_cms_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_timestamp_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_dss_self_test(verbosity) != 0)
+        failed++;
     if (sigil_sig_dict_self_test(verbosity) != 0)
         failed++;
     if (sigil_sig_field_self_test(verbosity) != 0)
         failed++;
+    if (sigil_sig_scan_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_signature_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_sidecar_self_test(verbosity) != 0)
+        failed++;
     if (sigil_sigil_self_test(verbosity) != 0)
         failed++;
 